@@ -0,0 +1,166 @@
+/* <base/crc32c.cc>
+
+   Implements <base/crc32c.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <base/crc32c.h>
+
+#include <cassert>
+#include <cstring>
+
+#include <nmmintrin.h>
+#include <wmmintrin.h>
+
+using namespace std;
+
+/* The Castagnoli polynomial, bit-reflected. */
+static const uint32_t Poly = 0x82F63B78U;
+
+/* Tables for the slice-by-8 software implementation. */
+class TTables {
+  public:
+
+  TTables() {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t crc = i;
+      for (int j = 0; j < 8; ++j) {
+        crc = (crc >> 1) ^ ((crc & 1U) ? Poly : 0U);
+      }
+      Table[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+      for (int k = 1; k < 8; ++k) {
+        Table[k][i] = (Table[k - 1][i] >> 8) ^ Table[0][Table[k - 1][i] & 0xFF];
+      }
+    }
+  }
+
+  uint32_t Table[8][256];
+
+};  // TTables
+
+static const TTables Tables;
+
+/* Advance a crc (without the pre- and post-inversion) over the given bytes, in software. */
+static uint32_t SoftUpdate(uint32_t crc, const uint8_t *data, size_t size) {
+  const auto &t = Tables.Table;
+  for (; size >= 8; size -= 8, data += 8) {
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+    word ^= crc;
+    crc = t[7][word & 0xFF] ^ t[6][(word >> 8) & 0xFF] ^ t[5][(word >> 16) & 0xFF] ^ t[4][(word >> 24) & 0xFF] ^
+          t[3][(word >> 32) & 0xFF] ^ t[2][(word >> 40) & 0xFF] ^ t[1][(word >> 48) & 0xFF] ^ t[0][word >> 56];
+  }
+  for (; size; --size, ++data) {
+    crc = (crc >> 8) ^ t[0][(crc ^ *data) & 0xFF];
+  }
+  return crc;
+}
+
+/* x^n mod Poly, bit-reflected. */
+static uint32_t XPowMod(size_t n) {
+  uint32_t val = 0x80000000U;  // x^0
+  for (; n; --n) {
+    val = (val >> 1) ^ ((val & 1U) ? Poly : 0U);
+  }
+  return val;
+}
+
+/* The hardware path runs three streams of this many words each per round, falling back to the short rounds and then a
+   single stream as the buffer runs out. */
+static const size_t LongWords = 64, ShortWords = 16;
+
+/* The constants which shift a crc past one and two streams' worth of data.  A crc c shifted over n bytes is
+   c * x^(8n) mod Poly; a carry-less multiply by x^(8n - 33) followed by a crc32 of the product gets us there, since
+   crc32 multiplies by x^32 and the reflected multiply contributes one more x. */
+class TShifts {
+  public:
+
+  TShifts()
+      : Long1(XPowMod(LongWords * 64 - 33)),
+        Long2(XPowMod(LongWords * 128 - 33)),
+        Short1(XPowMod(ShortWords * 64 - 33)),
+        Short2(XPowMod(ShortWords * 128 - 33)) {}
+
+  const uint32_t Long1, Long2, Short1, Short2;
+
+};  // TShifts
+
+static const TShifts Shifts;
+
+/* Shift a crc over the bytes represented by 'k' (see TShifts). */
+__attribute__((target("sse4.2,pclmul")))
+static inline uint64_t Shift(uint32_t crc, uint32_t k) {
+  return _mm_cvtsi128_si64(_mm_clmulepi64_si128(_mm_cvtsi32_si128(static_cast<int>(crc)), _mm_cvtsi32_si128(static_cast<int>(k)), 0));
+}
+
+/* Run three streams of 'num_words' words each, starting at 'words', and fold them into one crc. */
+__attribute__((target("sse4.2,pclmul")))
+static inline uint32_t Triple(uint32_t crc, const uint64_t *words, size_t num_words, uint32_t k1, uint32_t k2) {
+  uint64_t crc_a = crc, crc_b = 0, crc_c = 0;
+  const uint64_t *a = words, *b = words + num_words, *c = words + num_words * 2;
+  for (size_t i = 0; i < num_words; ++i) {
+    crc_a = _mm_crc32_u64(crc_a, a[i]);
+    crc_b = _mm_crc32_u64(crc_b, b[i]);
+    crc_c = _mm_crc32_u64(crc_c, c[i]);
+  }
+  return static_cast<uint32_t>(crc_c ^ _mm_crc32_u64(0, Shift(static_cast<uint32_t>(crc_a), k2) ^ Shift(static_cast<uint32_t>(crc_b), k1)));
+}
+
+/* Advance a crc (without the pre- and post-inversion) over the given bytes, using the crc32 instruction. */
+__attribute__((target("sse4.2,pclmul")))
+static uint32_t HardUpdate(uint32_t crc, const uint8_t *data, size_t size) {
+  for (; size && (reinterpret_cast<uintptr_t>(data) & 7); --size, ++data) {
+    crc = _mm_crc32_u8(crc, *data);
+  }
+  const uint64_t *words = reinterpret_cast<const uint64_t *>(data);
+  size_t num_words = size / 8;
+  for (; num_words >= LongWords * 3; num_words -= LongWords * 3, words += LongWords * 3) {
+    crc = Triple(crc, words, LongWords, Shifts.Long1, Shifts.Long2);
+  }
+  for (; num_words >= ShortWords * 3; num_words -= ShortWords * 3, words += ShortWords * 3) {
+    crc = Triple(crc, words, ShortWords, Shifts.Short1, Shifts.Short2);
+  }
+  uint64_t crc64 = crc;
+  for (; num_words; --num_words, ++words) {
+    crc64 = _mm_crc32_u64(crc64, *words);
+  }
+  crc = static_cast<uint32_t>(crc64);
+  data = reinterpret_cast<const uint8_t *>(words);
+  for (size = size % 8; size; --size, ++data) {
+    crc = _mm_crc32_u8(crc, *data);
+  }
+  return crc;
+}
+
+/* True iff. we can use HardUpdate(). */
+static bool HasHardware() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("pclmul");
+}
+
+static const bool UseHardware = HasHardware();
+
+uint32_t Base::Crc32c(const void *data, size_t size, uint32_t crc) {
+  assert(data || !size);
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+  return ~(UseHardware ? HardUpdate(~crc, bytes, size) : SoftUpdate(~crc, bytes, size));
+}
+
+uint32_t Base::SoftCrc32c(const void *data, size_t size, uint32_t crc) {
+  assert(data || !size);
+  return ~SoftUpdate(~crc, reinterpret_cast<const uint8_t *>(data), size);
+}
@@ -0,0 +1,38 @@
+/* <base/crc32c.h>
+
+   Compute a CRC-32C (Castagnoli) checksum.
+
+   On CPUs with SSE4.2 and PCLMUL we run three independent crc32 instruction streams side by side and fold them
+   together with carry-less multiplies, which keeps the crc32 unit busy every cycle instead of waiting out its latency.
+   Elsewhere we fall back to a table-driven implementation.  Both produce the same values, so checksums written on one
+   machine verify on any other.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Base {
+
+  /* The CRC-32C of 'size' bytes at 'data', continuing from a previous result 'crc'.  Crc32c(b, Crc32c(a)) is the
+     checksum of a followed by b. */
+  uint32_t Crc32c(const void *data, size_t size, uint32_t crc = 0);
+
+  /* The same as Crc32c(), but never uses the hardware.  Exposed so we can test one against the other. */
+  uint32_t SoftCrc32c(const void *data, size_t size, uint32_t crc = 0);
+
+}  // Base
@@ -0,0 +1,65 @@
+/* <base/crc32c.test.cc>
+
+   Unit test for <base/crc32c.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <base/crc32c.h>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Base;
+
+FIXTURE(KnownValues) {
+  EXPECT_EQ(Crc32c("", 0), 0U);
+  EXPECT_EQ(Crc32c("123456789", 9), 0xE3069283U);
+  EXPECT_EQ(SoftCrc32c("123456789", 9), 0xE3069283U);
+  /* 32 bytes of zeros, from RFC 3720 */
+  char zeros[32];
+  memset(zeros, 0, sizeof(zeros));
+  EXPECT_EQ(Crc32c(zeros, sizeof(zeros)), 0x8A9136AAU);
+}
+
+FIXTURE(MatchesSoftware) {
+  /* cover every path: unaligned heads, short and long rounds, and odd tails */
+  mt19937_64 engine;
+  vector<uint8_t> buf(70000);
+  for (auto &byte : buf) {
+    byte = static_cast<uint8_t>(engine());
+  }
+  size_t num_bad = 0UL;
+  for (size_t size : { 1UL, 7UL, 8UL, 100UL, 383UL, 384UL, 385UL, 504UL, 1535UL, 1536UL, 4088UL, 4096UL, 65528UL, 69999UL }) {
+    for (size_t start = 0; start < 8; ++start) {
+      if (Crc32c(&buf[start], size) != SoftCrc32c(&buf[start], size)) {
+        ++num_bad;
+      }
+    }
+  }
+  EXPECT_EQ(num_bad, 0UL);
+}
+
+FIXTURE(Chained) {
+  const char *text = "The quick brown fox jumps over the lazy dog";
+  const size_t size = strlen(text);
+  const uint32_t whole = Crc32c(text, size);
+  for (size_t split = 0; split <= size; ++split) {
+    EXPECT_EQ(Crc32c(text + split, size - split, Crc32c(text, split)), whole);
+  }
+}
@@ -84,7 +84,7 @@ namespace Io {
     template <typename TVal, typename TCompare, typename TAlloc>
     void Write(const std::multiset<TVal, TCompare, TAlloc> &that) { WriteContainer(that); }
     template <typename TFirst, typename TSecond>
-    void Write(const std::pair<TFirst, TSecond> &that) { Write(that.first); Write(that.second); }
+    void Write(const std::pair<TFirst, TSecond> &that) { *this << that.first << that.second; }
     template <typename TVal, typename TCompare, typename TAlloc>
     void Write(const std::set<TVal, TCompare, TAlloc> &that) { WriteContainer(that); }
     template <typename TKey, typename TVal, typename THash, typename TEq, typename TAlloc>
@@ -156,7 +156,7 @@ namespace Io {
       assert(&that);
       Write(that.size());
       for (const typename TThat::value_type &val: that) {
-        Write(val);
+        *this << val;
       }
     }
 
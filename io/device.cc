@@ -18,7 +18,16 @@
 
 #include <io/device.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
 #include <io/chunk_and_pool.h>
+#include <util/error.h>
 #include <util/io.h>
 
 using namespace Io;
@@ -32,19 +41,199 @@ void TDevice::ConsumeOutput(const shared_ptr<const TChunk> &chunk) {
   assert(this);
   assert(&chunk);
   assert(chunk);
-  const char *start, *limit;
-  chunk->GetData(start, limit);
-  WriteExactly(Fd, start, limit - start);
+  WriteChunks(&chunk, 1);
+}
+
+void TDevice::ConsumeOutputChunks(const vector<shared_ptr<const TChunk>> &chunks) {
+  assert(this);
+  assert(&chunks);
+  WriteChunks(chunks.data(), chunks.size());
+}
+
+bool TDevice::FlushBacklog() {
+  assert(this);
+  lock_guard<mutex> lock(BacklogMutex);
+  size_t old_size = BacklogSize;
+  SendBacklog();
+  if (OnBacklog && BacklogSize != old_size) {
+    OnBacklog(BacklogSize);
+  }
+  return BacklogSize != 0;
 }
 
 shared_ptr<const TChunk> TDevice::TryProduceInput() {
   assert(this);
+  /* If our last read filled more than one chunk, hand out the next one before reading again. */
+  if (!ReadChunks.empty()) {
+    auto chunk = move(ReadChunks.front());
+    ReadChunks.pop_front();
+    return chunk;
+  }
   if (Timeout >= 0 && !Fd.IsReadable(Timeout)) {
     throw TTimeout();
   }
-  auto chunk = Pool->AcquireChunk();
-  if (!chunk->Store(Fd)) {
-    chunk.reset();
+  if (WaitForInput && !Fd.IsReadable()) {
+    WaitForInput(Fd);
+  }
+  shared_ptr<TChunk> chunks[MaxReadChunkCount];
+  iovec iovs[MaxReadChunkCount];
+  for (size_t i = 0; i < ReadChunkCount; ++i) {
+    chunks[i] = Pool->AcquireChunk();
+    iovs[i].iov_base = chunks[i]->GetBuffer();
+    iovs[i].iov_len = chunks[i]->GetRemainingSize();
+  }
+  size_t size = IfLt0(readv(Fd, iovs, ReadChunkCount));
+  if (!size) {
+    return shared_ptr<const TChunk>();
+  }
+  /* Commit what we read to the chunks, in order.  Any we didn't reach go back to the pool. */
+  size_t filled_count = 0;
+  for (size_t i = 0; i < ReadChunkCount && size; ++i) {
+    size_t commit_size = min(size, iovs[i].iov_len);
+    chunks[i]->Commit(commit_size);
+    size -= commit_size;
+    if (commit_size == iovs[i].iov_len) {
+      ++filled_count;
+    }
+    ReadChunks.push_back(move(chunks[i]));
+  }
+  if (filled_count == ReadChunkCount) {
+    ReadChunkCount = min(ReadChunkCount * 2, MaxReadChunkCount);
+  } else if (!filled_count) {
+    ReadChunkCount = 1;
   }
+  auto chunk = move(ReadChunks.front());
+  ReadChunks.pop_front();
   return chunk;
 }
+
+bool TDevice::HasBufferedInput() const {
+  assert(this);
+  return !ReadChunks.empty();
+}
+
+bool TDevice::IsSocketFd(int fd) {
+  struct stat stat;
+  return fstat(fd, &stat) == 0 && S_ISSOCK(stat.st_mode);
+}
+
+void TDevice::SendBacklog() {
+  assert(this);
+  static const size_t MaxIovCount = 64;
+  iovec iovs[MaxIovCount];
+  while (!Backlog.empty()) {
+    size_t iov_count = min(Backlog.size(), MaxIovCount);
+    for (size_t i = 0; i < iov_count; ++i) {
+      const char *start, *limit;
+      Backlog[i]->GetData(start, limit);
+      if (!i) {
+        start += BacklogOffset;
+      }
+      iovs[i].iov_base = const_cast<char *>(start);
+      iovs[i].iov_len = limit - start;
+    }
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iovs;
+    msg.msg_iovlen = iov_count;
+    ssize_t result = sendmsg(Fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (result < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        break;
+      }
+      if (errno == EINTR) {
+        continue;
+      }
+      ThrowSystemError(errno);
+    }
+    if (!result) {
+      throw TUnexpectedEnd();
+    }
+    /* Retire whatever the socket took, picking up next time where it left off. */
+    size_t actual_size = result;
+    BacklogSize -= actual_size;
+    while (actual_size) {
+      const char *start, *limit;
+      Backlog.front()->GetData(start, limit);
+      size_t remaining_size = (limit - start) - BacklogOffset;
+      if (actual_size < remaining_size) {
+        BacklogOffset += actual_size;
+        break;
+      }
+      actual_size -= remaining_size;
+      BacklogOffset = 0;
+      Backlog.pop_front();
+    }
+  }
+}
+
+void TDevice::WriteChunks(const shared_ptr<const TChunk> *chunks, size_t chunk_count) {
+  assert(this);
+  assert(chunks || !chunk_count);
+  /* If we're keeping a backlog, the chunks join the end of it and we send what we can without blocking. */
+  /* extra */ {
+    lock_guard<mutex> lock(BacklogMutex);
+    if (OnBacklog) {
+      size_t old_size = BacklogSize;
+      for (size_t i = 0; i < chunk_count; ++i) {
+        const char *start, *limit;
+        chunks[i]->GetData(start, limit);
+        if (limit > start) {
+          Backlog.push_back(chunks[i]);
+          BacklogSize += limit - start;
+        }
+      }
+      SendBacklog();
+      if (BacklogSize != old_size) {
+        OnBacklog(BacklogSize);
+      }
+      return;
+    }
+  }
+  static const size_t MaxIovCount = 64;
+  iovec iovs[MaxIovCount];
+  while (chunk_count) {
+    /* Gather as many chunks as we can into a single write. */
+    size_t iov_count = min(chunk_count, MaxIovCount);
+    for (size_t i = 0; i < iov_count; ++i) {
+      const char *start, *limit;
+      chunks[i]->GetData(start, limit);
+      iovs[i].iov_base = const_cast<char *>(start);
+      iovs[i].iov_len = limit - start;
+    }
+    chunks += iov_count;
+    chunk_count -= iov_count;
+    /* Write until they're gone, picking up where any short write left off. */
+    iovec *csr = iovs, *end = iovs + iov_count;
+    for (;;) {
+      while (csr < end && !csr->iov_len) {
+        ++csr;
+      }
+      if (csr == end) {
+        break;
+      }
+      size_t actual_size;
+      if (IsSocket) {
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = csr;
+        msg.msg_iovlen = end - csr;
+        actual_size = IfLt0(sendmsg(Fd, &msg, MSG_NOSIGNAL));
+      } else {
+        actual_size = IfLt0(writev(Fd, csr, end - csr));
+      }
+      if (!actual_size) {
+        throw TUnexpectedEnd();
+      }
+      for (; actual_size; ++csr) {
+        size_t consumed_size = min(actual_size, csr->iov_len);
+        csr->iov_base = static_cast<char *>(csr->iov_base) + consumed_size;
+        csr->iov_len -= consumed_size;
+        actual_size -= consumed_size;
+        if (csr->iov_len) {
+          break;
+        }
+      }
+    }
+  }
+}
@@ -19,7 +19,11 @@
 #pragma once
 
 #include <cassert>
+#include <deque>
+#include <functional>
+#include <mutex>
 #include <stdexcept>
+#include <vector>
 
 #include <base/class_traits.h>
 #include <base/fd.h>
@@ -36,6 +40,13 @@ namespace Io {
     NO_COPY(TDevice);
     public:
 
+    /* Called with our fd when we're about to read and nothing is waiting to be read.  It should return once there is
+       (or once the fd has hung up), presumably having done something more useful than block in the meantime. */
+    using TWaitForInput = std::function<void (int fd)>;
+
+    /* Called with the size of our backlog whenever it changes.  See SetOnBacklog(). */
+    using TOnBacklog = std::function<void (size_t backlog_size)>;
+
     /* Thrown when TryProduceInput() times out while trying to read. */
     class TTimeout
         : public std::runtime_error {
@@ -49,30 +60,45 @@ namespace Io {
     /* Use the given file descriptor for I/O.  It must already be open.
        Construct our own pool. */
     explicit TDevice(const Base::TFd &fd, const TPool::TArgs &args = TPool::TArgs())
-        : Timeout(-1), Fd(fd), Pool(std::make_shared<TPool>(args)) {}
+        : Timeout(-1), Fd(fd), Pool(std::make_shared<TPool>(args)), IsSocket(IsSocketFd(Fd)), ReadChunkCount(1),
+          BacklogOffset(0), BacklogSize(0) {}
 
     /* Use the given file descriptor for I/O.  It must already be open.
        Construct our own pool. */
     explicit TDevice(Base::TFd &&fd, const TPool::TArgs &args = TPool::TArgs())
-        : Timeout(-1), Fd(std::move(fd)), Pool(std::make_shared<TPool>(args)) {}
+        : Timeout(-1), Fd(std::move(fd)), Pool(std::make_shared<TPool>(args)), IsSocket(IsSocketFd(Fd)),
+          ReadChunkCount(1), BacklogOffset(0), BacklogSize(0) {}
 
     /* Use the given file descriptor for I/O.  It must already be open.
        Use the given pool, which must not be null. */
     TDevice(const Base::TFd &fd, const std::shared_ptr<TPool> &pool)
-        : Timeout(-1), Fd(fd), Pool(pool) {
+        : Timeout(-1), Fd(fd), Pool(pool), IsSocket(IsSocketFd(Fd)), ReadChunkCount(1),
+          BacklogOffset(0), BacklogSize(0) {
       assert(pool);
     }
 
     /* Use the given file descriptor for I/O.  It must already be open.
        Use the given pool, which must not be null. */
     TDevice(Base::TFd &&fd, const std::shared_ptr<TPool> &pool)
-        : Timeout(-1), Fd(std::move(fd)), Pool(pool) {
+        : Timeout(-1), Fd(std::move(fd)), Pool(pool), IsSocket(IsSocketFd(Fd)), ReadChunkCount(1),
+          BacklogOffset(0), BacklogSize(0) {
       assert(pool);
     }
 
     /* Do-little. */
     virtual ~TDevice() {}
 
+    /* Write as much of our backlog as the socket will take without blocking.  Returns true iff. some is left.  See
+       SetOnBacklog(). */
+    bool FlushBacklog();
+
+    /* The number of bytes we've been given to write but haven't yet written.  See SetOnBacklog(). */
+    size_t GetBacklogSize() const {
+      assert(this);
+      std::lock_guard<std::mutex> lock(BacklogMutex);
+      return BacklogSize;
+    }
+
     /* The file descriptor which we wrap. */
     const Base::TFd &GetFd() const {
       assert(this);
@@ -82,28 +108,99 @@ namespace Io {
     /* See TOutputConsumer::ConsumeOutput(). */
     virtual void ConsumeOutput(const std::shared_ptr<const TChunk> &chunk);
 
+    /* See TOutputConsumer::ConsumeOutputChunks().  We write the chunks with as few calls to writev() as we can. */
+    virtual void ConsumeOutputChunks(const std::vector<std::shared_ptr<const TChunk>> &chunks);
+
     /* The pool from which we acquire chunks.  Never null. */
     const std::shared_ptr<TPool> &GetPool() const {
       assert(this);
       return Pool;
     }
 
+    /* Rather than blocking when a socket won't take everything we're given to write, keep the rest in a backlog and
+       return.  Whoever owns the socket should watch it for writability whenever the backlog isn't empty and call
+       FlushBacklog() when it is.  The given function is called with the backlog's new size every time it changes,
+       with the backlog locked, so calls to it are never out of order; it mustn't write to us.  Pass an empty
+       function to go back to blocking, which is only safe while the backlog is empty.  Our writers hold thread locks
+       while they write, so this is how to keep a peer who won't read from holding up their thread. */
+    void SetOnBacklog(const TOnBacklog &on_backlog) {
+      assert(this);
+      assert(IsSocket || !on_backlog);
+      std::lock_guard<std::mutex> lock(BacklogMutex);
+      assert(on_backlog || Backlog.empty());
+      OnBacklog = on_backlog;
+    }
+
+    /* Use the given function, instead of a blocking read, to wait for input.  Pass an empty function to go back to
+       blocking.  This has no effect on Timeout, which, if non-negative, still blocks.
+       Writes block unless we're keeping a backlog.  See SetOnBacklog(). */
+    void SetWaitForInput(const TWaitForInput &wait_for_input) {
+      assert(this);
+      WaitForInput = wait_for_input;
+    }
+
     /* See TInputProducer::ProduceInput().
-       If TImeout is non-negative, then this function can throw TTimeout. */
+       If TImeout is non-negative, then this function can throw TTimeout.
+       When input is arriving faster than a chunk at a time, we read it into several chunks with a single readv() and
+       hand them out one per call. */
     virtual std::shared_ptr<const TChunk> TryProduceInput();
 
+    /* See TInputProducer::HasBufferedInput().  True iff. our last read filled chunks we haven't yet handed out. */
+    virtual bool HasBufferedInput() const override;
+
     /* The maximum number of milliseconds to wait for data to become available.
        A negative value here means to wait forever. */
     int Timeout;
 
     private:
 
+    /* The most chunks we'll read with a single readv(). */
+    static const size_t MaxReadChunkCount = 8;
+
+    /* True iff. the fd is a socket. */
+    static bool IsSocketFd(int fd);
+
+    /* Write as much of the backlog as the socket will take right now.  The caller must hold BacklogMutex. */
+    void SendBacklog();
+
+    /* Write the data in the given chunks, blocking until it's all gone, or, if we're keeping a backlog, until the
+       socket won't take any more. */
+    void WriteChunks(const std::shared_ptr<const TChunk> *chunks, size_t chunk_count);
+
     /* See accessor. */
     Base::TFd Fd;
 
     /* See accessor. */
     std::shared_ptr<TPool> Pool;
 
+    /* See SetWaitForInput().  May be empty. */
+    TWaitForInput WaitForInput;
+
+    /* If true, we write with sendmsg() so we can ask not to be signaled if the peer has hung up; otherwise, with
+       writev(). */
+    bool IsSocket;
+
+    /* The number of chunks we'll offer the next readv().  We double it, up to MaxReadChunkCount, each time a read
+       fills all the chunks we offered, and drop it back to one when a read doesn't fill the first. */
+    size_t ReadChunkCount;
+
+    /* Chunks filled by our last read which we haven't yet handed out. */
+    std::deque<std::shared_ptr<const TChunk>> ReadChunks;
+
+    /* Covers OnBacklog, Backlog, BacklogOffset, and BacklogSize. */
+    mutable std::mutex BacklogMutex;
+
+    /* See SetOnBacklog().  May be empty. */
+    TOnBacklog OnBacklog;
+
+    /* Chunks we've been given to write but which the socket hasn't yet taken, oldest first, and the number of bytes at
+       the start of the oldest which it has. */
+    std::deque<std::shared_ptr<const TChunk>> Backlog;
+    size_t BacklogOffset;
+
+    /* See accessor. */
+    size_t BacklogSize;
+
   };  // TDevice
 
 }  // Io
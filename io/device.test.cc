@@ -99,3 +99,114 @@ FIXTURE(Typical) {
       make_tuple(1, 2, 3)));
   RoundTrip<const char *, string>(out_strm, in_strm, "mofo");
 }
+
+FIXTURE(WaitForInput) {
+  TFd readable_fd, writeable_fd;
+  TFd::Pipe(readable_fd, writeable_fd);
+  TBinaryOutputOnlyStream out_strm(make_shared<TDevice>(writeable_fd));
+  auto in_device = make_shared<TDevice>(readable_fd);
+  /* The pipe is empty, so the first read has to wait; we take the chance to write something for it to find. */
+  size_t wait_count = 0;
+  in_device->SetWaitForInput([&](int fd) {
+    EXPECT_EQ(fd, static_cast<int>(in_device->GetFd()));
+    ++wait_count;
+    out_strm << 101 << 202;
+    out_strm.Flush();
+  });
+  TBinaryInputOnlyStream in_strm(in_device);
+  int a, b;
+  in_strm >> a >> b;
+  EXPECT_EQ(a, 101);
+  EXPECT_EQ(b, 202);
+  EXPECT_EQ(wait_count, 1UL);
+  /* Something's already waiting, so this read goes straight through. */
+  out_strm << 303;
+  out_strm.Flush();
+  in_strm >> a;
+  EXPECT_EQ(a, 303);
+  EXPECT_EQ(wait_count, 1UL);
+}
+
+FIXTURE(ScatterGather) {
+  TFd fd_a, fd_b;
+  TFd::SocketPair(fd_a, fd_b, AF_UNIX, SOCK_STREAM, 0);
+  /* Tiny chunks at both ends, so a message spans many of them.  The output side queues them and writes them in
+     batches; the input side reads several at once. */
+  TBinaryOutputOnlyStream out_strm(make_shared<TDevice>(fd_a), TPool::TArgs(64));
+  TBinaryInputOnlyStream in_strm(make_shared<TDevice>(fd_b, TPool::TArgs(64)));
+  vector<int64_t> expected;
+  for (int64_t i = 0; i < 10000; ++i) {
+    expected.push_back(i * 7);
+  }
+  for (int i = 0; i < 3; ++i) {
+    RoundTrip(out_strm, in_strm, expected);
+    RoundTrip(out_strm, in_strm, string("mofo"));
+  }
+}
+
+FIXTURE(Backlog) {
+  TFd fd_a, fd_b;
+  TFd::SocketPair(fd_a, fd_b, AF_UNIX, SOCK_STREAM, 0);
+  auto out_device = make_shared<TDevice>(fd_a);
+  vector<size_t> backlog_sizes;
+  out_device->SetOnBacklog([&](size_t backlog_size) { backlog_sizes.push_back(backlog_size); });
+  TBinaryOutputOnlyStream out_strm(out_device);
+  TBinaryInputOnlyStream in_strm(make_shared<TDevice>(fd_b));
+  /* Nobody's reading, so this is far more than the socket will take, yet we don't block. */
+  static const int64_t Count = 1000000;
+  for (int64_t i = 0; i < Count; ++i) {
+    out_strm << i * 7;
+  }
+  out_strm.Flush();
+  EXPECT_TRUE(out_device->GetBacklogSize());
+  EXPECT_FALSE(backlog_sizes.empty());
+  EXPECT_EQ(backlog_sizes.back(), out_device->GetBacklogSize());
+  /* Read it all back, flushing the backlog as the socket makes room. */
+  int64_t mismatch_count = 0;
+  for (int64_t i = 0; i < Count; ++i) {
+    if (i % 1000 == 0) {
+      out_device->FlushBacklog();
+    }
+    int64_t actual;
+    in_strm >> actual;
+    if (actual != i * 7) {
+      ++mismatch_count;
+    }
+  }
+  EXPECT_FALSE(out_device->FlushBacklog());
+  EXPECT_EQ(backlog_sizes.back(), 0UL);
+  EXPECT_EQ(mismatch_count, 0);
+}
+
+FIXTURE(ReadAhead) {
+  TFd fd_a, fd_b;
+  TFd::SocketPair(fd_a, fd_b, AF_UNIX, SOCK_STREAM, 0);
+  TBinaryOutputOnlyStream out_strm(make_shared<TDevice>(fd_a));
+  TBinaryInputOnlyStream in_strm(make_shared<TDevice>(fd_b, TPool::TArgs(64)));
+  /* Fill one chunk exactly, so the next read offers two. */
+  int64_t actual;
+  for (int64_t i = 0; i < 8; ++i) {
+    out_strm << i;
+  }
+  out_strm.Flush();
+  for (int64_t i = 0; i < 8; ++i) {
+    in_strm >> actual;
+  }
+  EXPECT_FALSE(in_strm.HasBufferedData());
+  /* Now fill two chunks, which arrive in a single read.  When we're done with the first, the socket is empty, but
+     the second is still waiting for us. */
+  for (int64_t i = 0; i < 16; ++i) {
+    out_strm << i;
+  }
+  out_strm.Flush();
+  for (int64_t i = 0; i < 8; ++i) {
+    in_strm >> actual;
+  }
+  EXPECT_FALSE(fd_b.IsReadable(0));
+  EXPECT_TRUE(in_strm.HasBufferedData());
+  for (int64_t i = 8; i < 16; ++i) {
+    in_strm >> actual;
+    EXPECT_EQ(actual, i);
+  }
+  EXPECT_FALSE(in_strm.HasBufferedData());
+}
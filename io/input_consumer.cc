@@ -27,7 +27,7 @@ using namespace Io;
 
 bool TInputConsumer::HasBufferedData() const {
   assert(this);
-  return Cursor < Limit;// || ChunkIdx < Chunks.size();
+  return Cursor < Limit || InputProducer->HasBufferedInput();
 }
 
 void TInputConsumer::PeekAndDump(string &out) {
@@ -73,7 +73,8 @@ namespace Io {
       return InputProducer;
     }
 
-    /* TODO */
+    /* True iff. we can read more without waiting on our producer's source, either because we're still working on a
+       chunk or because our producer has read ahead. */
     bool HasBufferedData() const;
 
     /* True iff. we have reached the end of the input stream. */
@@ -20,4 +20,9 @@
 
 using namespace Io;
 
+bool TInputProducer::HasBufferedInput() const {
+  assert(this);
+  return false;
+}
+
 TInputProducer::~TInputProducer() {}
@@ -34,6 +34,11 @@ namespace Io {
        If there is no more data, return null. */
     virtual std::shared_ptr<const TChunk> TryProduceInput() = 0;
 
+    /* True iff. we're holding input which the next call to TryProduceInput() will hand out without waiting.
+       A producer which reads ahead must override this, or a consumer waiting on the underlying fd could wait forever
+       for input we already have. */
+    virtual bool HasBufferedInput() const;
+
     protected:
 
     /* Do-little. */
@@ -22,3 +22,11 @@ using namespace std;
 using namespace Io;
 
 TOutputConsumer::~TOutputConsumer() {}
+
+void TOutputConsumer::ConsumeOutputChunks(const vector<shared_ptr<const TChunk>> &chunks) {
+  assert(this);
+  assert(&chunks);
+  for (const auto &chunk: chunks) {
+    ConsumeOutput(chunk);
+  }
+}
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include <base/class_traits.h>
 #include <io/chunk_and_pool.h>
@@ -33,6 +34,10 @@ namespace Io {
     /* Consume the next chunk of data. */
     virtual void ConsumeOutput(const std::shared_ptr<const TChunk> &chunk) = 0;
 
+    /* Consume the next several chunks of data, in order.  By default, we consume them one at a time.  Override this if
+       you can do better with them all at once. */
+    virtual void ConsumeOutputChunks(const std::vector<std::shared_ptr<const TChunk>> &chunks);
+
     protected:
 
     /* Do-little. */
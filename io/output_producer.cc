@@ -37,10 +37,18 @@ TOutputProducer::~TOutputProducer() {
 void TOutputProducer::Flush() {
   assert(this);
   if (CurrentChunk) {
+    QueuedChunks.push_back(move(CurrentChunk));
+    CurrentChunk.reset();
+  }
+  if (!QueuedChunks.empty()) {
     if (OutputConsumer) {
-      OutputConsumer->ConsumeOutput(CurrentChunk);
+      if (QueuedChunks.size() == 1) {
+        OutputConsumer->ConsumeOutput(QueuedChunks.front());
+      } else {
+        OutputConsumer->ConsumeOutputChunks(QueuedChunks);
+      }
     }
-    CurrentChunk.reset();
+    QueuedChunks.clear();
   }
 }
 
@@ -52,7 +60,11 @@ void TOutputProducer::WriteExactly(const void *buf, size_t size) {
       CurrentChunk = Pool->AcquireChunk();
     }
     if (!CurrentChunk->Store(csr, size)) {
-      Flush();
+      QueuedChunks.push_back(move(CurrentChunk));
+      CurrentChunk.reset();
+      if (QueuedChunks.size() >= MaxQueuedChunkCount) {
+        Flush();
+      }
     }
   }
 }
@@ -20,6 +20,7 @@
 
 #include <cassert>
 #include <memory>
+#include <vector>
 
 #include <base/class_traits.h>
 #include <io/chunk_and_pool.h>
@@ -56,12 +57,12 @@ namespace Io {
     /* Flushes automatically before destruction. */
     virtual ~TOutputProducer();
 
-    /* Push our current chunk to our consumer.
-       If we have no current chunk, do nothing. */
+    /* Push our queued chunks, and then our current chunk, to our consumer, all at once.
+       If we have no chunks, do nothing. */
     void Flush();
 
     /* Write the contents of the given buffer to our current chunk.
-       If there is too much data for our chunk, flush to our consumer and begin a new chunk. */
+       If there is too much data for our chunk, queue it and begin a new chunk.  If the queue is full, flush. */
     void WriteExactly(const void *buf, size_t size);
 
     private:
@@ -72,9 +73,16 @@ namespace Io {
     /* See accessor. */
     std::shared_ptr<TPool> Pool;
 
+    /* The most full chunks we'll queue before we flush them. */
+    static const size_t MaxQueuedChunkCount = 8;
+
     /* The chunk we are current filling, if any. */
     std::shared_ptr<TChunk> CurrentChunk;
 
+    /* Full chunks, in the order we filled them, which we haven't yet pushed to our consumer.  We push them in a batch
+       so a consumer which can write them with a single call, as a device can, gets the chance. */
+    std::vector<std::shared_ptr<const TChunk>> QueuedChunks;
+
   };  // TOutputProducer
 
 }  // Io
@@ -0,0 +1,105 @@
+/* <orly/atom/core_vector_reader.cc>
+
+   Implements <orly/atom/core_vector_reader.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/atom/core_vector_reader.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <memory>
+#include <system_error>
+
+#include <sys/mman.h>
+
+#include <base/tmp_file.h>
+#include <util/io.h>
+
+using namespace std;
+using namespace Io;
+using namespace Orly::Atom;
+
+/* The most we'll hold on the heap at once while spooling. */
+static const size_t SpoolChunkSize = 1024UL * 1024UL;
+
+TCoreVectorReader::TCoreVectorReader(TBinaryInputStream &strm, const char *spool_template)
+    : Strm(strm), Arena(strm, spool_template) {
+  uint32_t size;
+  strm >> size;
+  Size = size;
+  NumRemaining = size;
+}
+
+bool TCoreVectorReader::TryRead(TCore &core) {
+  assert(this);
+  assert(&core);
+  if (!NumRemaining) {
+    return false;
+  }
+  Strm.ReadExactly(&core, sizeof(TCore));
+  --NumRemaining;
+  return true;
+}
+
+TCoreVectorReader::TMappedArena::TMappedArena(TBinaryInputStream &strm, const char *spool_template)
+    : TCore::TArena(false), RawData(nullptr) {
+  assert(&strm);
+  assert(spool_template);
+  uint32_t raw_size;
+  strm >> raw_size;
+  RawSize = raw_size;
+  if (!RawSize) {
+    return;
+  }
+  /* The spool file is unlinked when it goes out of scope, but our mapping of it lives on. */
+  Base::TTmpFile spool(spool_template, true);
+  /* spool */ {
+    unique_ptr<char[]> buf(new char[min(RawSize, SpoolChunkSize)]);
+    for (size_t left = RawSize; left;) {
+      const size_t size = min(left, SpoolChunkSize);
+      strm.ReadExactly(buf.get(), size);
+      Util::WriteExactly(spool.GetFd(), buf.get(), size);
+      left -= size;
+    }
+  }
+  void *ptr = mmap(nullptr, RawSize, PROT_READ, MAP_SHARED, spool.GetFd(), 0);
+  if (ptr == MAP_FAILED) {
+    throw system_error(errno, system_category(), "mmap core vector spool");
+  }
+  RawData = static_cast<char *>(ptr);
+}
+
+TCoreVectorReader::TMappedArena::~TMappedArena() {
+  assert(this);
+  if (RawData) {
+    munmap(RawData, RawSize);
+  }
+}
+
+void TCoreVectorReader::TMappedArena::ReleaseNote(const TNote *, TOffset, void *, void *, void *) {}
+
+const TCoreVectorReader::TNote *TCoreVectorReader::TMappedArena::TryAcquireNote(TOffset offset, void *&/*data1*/, void *&/*data2*/, void *&/*data3*/) {
+  assert(this);
+  assert(offset < RawSize);
+  return reinterpret_cast<TNote *>(RawData + offset);
+}
+
+const TCoreVectorReader::TNote *TCoreVectorReader::TMappedArena::TryAcquireNote(TOffset offset, size_t /*known_size*/, void *&/*data1*/, void *&/*data2*/, void *&/*data3*/) {
+  assert(this);
+  assert(offset < RawSize);
+  return reinterpret_cast<TNote *>(RawData + offset);
+}
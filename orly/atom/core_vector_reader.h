@@ -0,0 +1,122 @@
+/* <orly/atom/core_vector_reader.h>
+
+   Streams in a vector of cores, one core at a time.
+
+   A core vector is written as its notes, packed together, followed by the cores, and any core may refer to any note,
+   so the notes must stay addressable until the last core has been read.  Rather than holding them on the heap, as
+   TCoreVector does, we spool them out to an unlinked temporary file and map it, leaving it to the kernel to page them
+   in and out.  The cores themselves are read from the stream only as they are asked for, so the memory we need doesn't
+   grow with the number of cores.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+
+#include <base/class_traits.h>
+#include <io/binary_input_stream.h>
+#include <orly/atom/kit2.h>
+
+namespace Orly {
+
+  namespace Atom {
+
+    /* Streams in a vector of cores, one core at a time. */
+    class TCoreVectorReader final {
+      NO_COPY(TCoreVectorReader);
+      public:
+
+      /* Conveniences. */
+      using TArena  = TCore::TArena;
+      using TNote   = TCore::TNote;
+      using TOffset = TCore::TOffset;
+
+      /* Read the notes from the given stream, spooling them to a temporary file made from the given template, then
+         stop at the first core.  The stream must outlive us. */
+      explicit TCoreVectorReader(Io::TBinaryInputStream &strm, const char *spool_template = "/var/tmp/orly_core_vector_XXXXXX.tmp");
+
+      /* The arena to which the cores we read refer.  Never null.  Valid for as long as we are. */
+      TArena *GetArena() const {
+        assert(this);
+        return &Arena;
+      }
+
+      /* The number of cores we have yet to read. */
+      size_t GetNumRemaining() const {
+        assert(this);
+        return NumRemaining;
+      }
+
+      /* The number of cores in the vector. */
+      size_t GetSize() const {
+        assert(this);
+        return Size;
+      }
+
+      /* If there's another core, read it into 'core' and return true; otherwise, return false. */
+      bool TryRead(TCore &core);
+
+      private:
+
+      /* The arena we stream in.  It maps the spooled notes. */
+      class TMappedArena final
+          : public TCore::TArena {
+        NO_COPY(TMappedArena);
+        public:
+
+        /* Spool the notes from the given stream and map them. */
+        TMappedArena(Io::TBinaryInputStream &strm, const char *spool_template);
+
+        /* Unmaps the notes. */
+        virtual ~TMappedArena();
+
+        private:
+
+        /* See base class.  Does nothing. */
+        virtual void ReleaseNote(const TNote *note, TOffset offset, void *data1, void *data2, void *data3) override;
+
+        /* See base class.  Finds the requested offset in the mapping. */
+        virtual const TNote *TryAcquireNote(TOffset offset, void *&data1, void *&data2, void *&data3) override;
+
+        /* See base class.  Finds the requested offset in the mapping. */
+        virtual const TNote *TryAcquireNote(TOffset offset, size_t known_size, void *&data1, void *&data2, void *&data3) override;
+
+        /* Our notes, packed together, as mapped from the spool file.  Null if there are none. */
+        char *RawData;
+
+        /* The number of bytes of raw data we contain. */
+        size_t RawSize;
+
+      };  // TCoreVectorReader::TMappedArena
+
+      /* The stream from which we read the cores. */
+      Io::TBinaryInputStream &Strm;
+
+      /* See accessor. */
+      mutable TMappedArena Arena;
+
+      /* See accessor. */
+      size_t Size;
+
+      /* See accessor. */
+      size_t NumRemaining;
+
+    };  // TCoreVectorReader
+
+  }  // Atom
+
+}  // Orly
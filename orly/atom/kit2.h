@@ -33,6 +33,7 @@
 #include <orly/sabot/order_states.h>
 #include <orly/sabot/state.h>
 #include <orly/sabot/type.h>
+#include <orly/shared_enum.h>
 
 namespace Orly {
 
@@ -480,6 +481,14 @@ namespace Orly {
       /* size of our pins */
       friend class Orly::Sabot::TSizeChecker;
 
+      /* See <orly/atom/mutate.h>.  These build their results directly. */
+      friend bool TryMutate(
+          TExtensibleArena *arena, void *state_alloc, TCore &out,
+          TArena *lhs_arena, const TCore &lhs, TMutator mutator, TArena *rhs_arena, const TCore &rhs);
+      friend size_t TryMutateRecord(
+          TExtensibleArena *arena, void *state_alloc, TCore &out,
+          TArena *that_arena, const TCore &that, const std::function<bool (const std::string &, const TCore &, TCore &)> &cb);
+
     };  // TCore
 
     /* Verify the sizeof(TCore). */
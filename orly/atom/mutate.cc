@@ -0,0 +1,270 @@
+/* <orly/atom/mutate.cc>
+
+   Implements <orly/atom/mutate.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/atom/mutate.h>
+
+#include <vector>
+
+using namespace std;
+using namespace Orly;
+using namespace Orly::Atom;
+using namespace Orly::Sabot;
+
+/* Numeric add, subtract, and multiply, as the Var types do them. */
+template <typename TVal>
+static bool TryMutateScalar(TMutator mutator, const TVal &lhs, const TVal &rhs, TVal &out) {
+  switch (mutator) {
+    case TMutator::Add: {
+      out = static_cast<TVal>(lhs + rhs);
+      return true;
+    }
+    case TMutator::Sub: {
+      out = static_cast<TVal>(lhs - rhs);
+      return true;
+    }
+    case TMutator::Mult: {
+      out = static_cast<TVal>(lhs * rhs);
+      return true;
+    }
+    default: {
+      return false;
+    }
+  }
+}
+
+/* True iff. the two states are of exactly the same type. */
+static bool IsSameType(const State::TAny &lhs, const State::TAny &rhs) {
+  void *lhs_type_alloc = alloca(Type::GetMaxTypeSize());
+  void *rhs_type_alloc = alloca(Type::GetMaxTypeSize());
+  return IsEq(OrderTypes(*Type::TAny::TWrapper(lhs.GetType(lhs_type_alloc)),
+                         *Type::TAny::TWrapper(rhs.GetType(rhs_type_alloc))));
+}
+
+/* Merge two sorted runs of elements, calling back with the order in which to take them.  The order is encoded as
+   (idx << 1) | is_rhs.  Where the runs have equal elements, we take only one of the two, the lhs unless told
+   otherwise. */
+static void Merge(
+    size_t lhs_count, size_t rhs_count, const function<TComparison (size_t lhs_idx, size_t rhs_idx)> &compare,
+    bool prefer_rhs, vector<size_t> &plan) {
+  plan.reserve(lhs_count + rhs_count);
+  size_t lhs_idx = 0, rhs_idx = 0;
+  while (lhs_idx < lhs_count && rhs_idx < rhs_count) {
+    switch (compare(lhs_idx, rhs_idx)) {
+      case TComparison::Lt: {
+        plan.push_back(lhs_idx++ << 1);
+        break;
+      }
+      case TComparison::Gt: {
+        plan.push_back((rhs_idx++ << 1) | 1);
+        break;
+      }
+      default: {
+        plan.push_back(prefer_rhs ? ((rhs_idx << 1) | 1) : (lhs_idx << 1));
+        ++lhs_idx;
+        ++rhs_idx;
+      }
+    }
+  }
+  for (; lhs_idx < lhs_count; ++lhs_idx) {
+    plan.push_back(lhs_idx << 1);
+  }
+  for (; rhs_idx < rhs_count; ++rhs_idx) {
+    plan.push_back((rhs_idx << 1) | 1);
+  }
+}
+
+bool Orly::Atom::TryMutate(
+    TCore::TExtensibleArena *arena, void *state_alloc, TCore &out,
+    TCore::TArena *lhs_arena, const TCore &lhs, TMutator mutator, TCore::TArena *rhs_arena, const TCore &rhs) {
+  assert(arena);
+  assert(&out);
+  assert(&lhs);
+  assert(&rhs);
+  using TTycon = TCore::TTycon;
+  /* Strings are either direct, with a range of tycons, or indirect. */
+  auto is_str = [](TTycon tycon) {
+    return tycon == TTycon::Str || (tycon >= TTycon::MinDirectStr && tycon <= TTycon::MaxDirectStr);
+  };
+  if (is_str(lhs.Tycon) && is_str(rhs.Tycon)) {
+    if (mutator != TMutator::Add) {
+      return false;
+    }
+    string lhs_str, rhs_str;
+    lhs.CopyOut(lhs_arena, lhs_str);
+    rhs.CopyOut(rhs_arena, rhs_str);
+    lhs_str += rhs_str;
+    out.InitStr(arena, lhs_str.data(), lhs_str.data() + lhs_str.size());
+    return true;
+  }
+  if (lhs.Tycon != rhs.Tycon) {
+    return false;
+  }
+  switch (lhs.Tycon) {
+    #define SCALAR(tycon, val_t)  \
+      case TTycon::tycon: {  \
+        val_t val;  \
+        if (!TryMutateScalar(mutator, lhs.ForceAs<val_t>(), rhs.ForceAs<val_t>(), val)) {  \
+          return false;  \
+        }  \
+        out.InitDirect(TTycon::tycon, val);  \
+        return true;  \
+      }
+    SCALAR(Int8, int8_t)
+    SCALAR(Int16, int16_t)
+    SCALAR(Int32, int32_t)
+    SCALAR(Int64, int64_t)
+    SCALAR(UInt8, uint8_t)
+    SCALAR(UInt16, uint16_t)
+    SCALAR(UInt32, uint32_t)
+    SCALAR(UInt64, uint64_t)
+    SCALAR(Float, float)
+    SCALAR(Double, double)
+    #undef SCALAR
+    case TTycon::Vector:
+    case TTycon::Set:
+    case TTycon::Map: {
+      if (mutator != ((lhs.Tycon == TTycon::Set) ? TMutator::Union : TMutator::Add)) {
+        return false;
+      }
+      void *lhs_state_alloc = alloca(State::GetMaxStateSize());
+      void *rhs_state_alloc = alloca(State::GetMaxStateSize());
+      State::TAny::TWrapper
+          lhs_state(lhs.NewState(lhs_arena, lhs_state_alloc)),
+          rhs_state(rhs.NewState(rhs_arena, rhs_state_alloc));
+      if (!IsSameType(*lhs_state, *rhs_state)) {
+        return false;
+      }
+      bool success;
+      if (lhs.Tycon == TTycon::Vector) {
+        /* Appending a list is just concatenation. */
+        success = out.TryInitIndirectCoreArray(
+            TTycon::Vector, arena,
+            dynamic_cast<const State::TArrayOfSingleStates &>(*lhs_state),
+            dynamic_cast<const State::TArrayOfSingleStates &>(*rhs_state));
+      } else if (lhs.Tycon == TTycon::Set) {
+        /* A set's elements are kept in order, so a union is a merge. */
+        const auto &lhs_set = dynamic_cast<const State::TArrayOfSingleStates &>(*lhs_state);
+        const auto &rhs_set = dynamic_cast<const State::TArrayOfSingleStates &>(*rhs_state);
+        void *lhs_pin_alloc = alloca(State::GetMaxStatePinSize());
+        void *rhs_pin_alloc = alloca(State::GetMaxStatePinSize());
+        State::TArrayOfSingleStates::TPin::TWrapper
+            lhs_pin(lhs_set.Pin(lhs_pin_alloc)),
+            rhs_pin(rhs_set.Pin(rhs_pin_alloc));
+        vector<size_t> plan;
+        Merge(
+            lhs_pin->GetElemCount(), rhs_pin->GetElemCount(),
+            [&lhs_pin, &rhs_pin](size_t lhs_idx, size_t rhs_idx) {
+              void *lhs_elem_alloc = alloca(State::GetMaxStateSize());
+              void *rhs_elem_alloc = alloca(State::GetMaxStateSize());
+              return OrderStates(*State::TAny::TWrapper(lhs_pin->NewElem(lhs_idx, lhs_elem_alloc)),
+                                 *State::TAny::TWrapper(rhs_pin->NewElem(rhs_idx, rhs_elem_alloc)));
+            }, false, plan);
+        success = !plan.empty();
+        if (success) {
+          TCore::TInit1 init1 =
+              [arena, &lhs_pin, &rhs_pin, &plan](size_t elem_idx, void *elem) {
+                void *elem_alloc = alloca(State::GetMaxStateSize());
+                const size_t code = plan[elem_idx];
+                const auto &pin = (code & 1) ? rhs_pin : lhs_pin;
+                new (elem) TCore(arena, State::TAny::TWrapper(pin->NewElem(code >> 1, elem_alloc)));
+              };
+          out.InitIndirectCoreArray(
+              TTycon::Set, arena->Propose(TCore::TNote::New(TTycon::Set, plan.size(), false, init1)), plan.size(), false);
+        }
+      } else {
+        /* Likewise a dict's keys, and where both sides have a key, the rhs wins. */
+        const auto &lhs_map = dynamic_cast<const State::TArrayOfPairsOfStates &>(*lhs_state);
+        const auto &rhs_map = dynamic_cast<const State::TArrayOfPairsOfStates &>(*rhs_state);
+        void *lhs_pin_alloc = alloca(State::GetMaxStatePinSize());
+        void *rhs_pin_alloc = alloca(State::GetMaxStatePinSize());
+        State::TArrayOfPairsOfStates::TPin::TWrapper
+            lhs_pin(lhs_map.Pin(lhs_pin_alloc)),
+            rhs_pin(rhs_map.Pin(rhs_pin_alloc));
+        vector<size_t> plan;
+        Merge(
+            lhs_pin->GetElemCount(), rhs_pin->GetElemCount(),
+            [&lhs_pin, &rhs_pin](size_t lhs_idx, size_t rhs_idx) {
+              void *lhs_elem_alloc = alloca(State::GetMaxStateSize());
+              void *rhs_elem_alloc = alloca(State::GetMaxStateSize());
+              return OrderStates(*State::TAny::TWrapper(lhs_pin->NewLhs(lhs_idx, lhs_elem_alloc)),
+                                 *State::TAny::TWrapper(rhs_pin->NewLhs(rhs_idx, rhs_elem_alloc)));
+            }, true, plan);
+        success = !plan.empty();
+        if (success) {
+          TCore::TInit2 init2 =
+              [arena, &lhs_pin, &rhs_pin, &plan](size_t elem_idx, void *key, void *val) {
+                void *elem_alloc = alloca(State::GetMaxStateSize());
+                const size_t code = plan[elem_idx];
+                const auto &pin = (code & 1) ? rhs_pin : lhs_pin;
+                new (key) TCore(arena, State::TAny::TWrapper(pin->NewLhs(code >> 1, elem_alloc)));
+                new (val) TCore(arena, State::TAny::TWrapper(pin->NewRhs(code >> 1, elem_alloc)));
+              };
+          out.InitIndirectCoreArray(
+              TTycon::Map, arena->Propose(TCore::TNote::New(TTycon::Map, plan.size(), false, init2)), plan.size(), false);
+        }
+      }
+      if (!success) {
+        /* Both sides were empty, so the result is too. */
+        out = TCore(arena, state_alloc, lhs_arena, lhs);
+      }
+      return true;
+    }
+    default: {
+      return false;
+    }
+  }
+}
+
+size_t Orly::Atom::TryMutateRecord(
+    TCore::TExtensibleArena *arena, void *state_alloc, TCore &out,
+    TCore::TArena *that_arena, const TCore &that, const TFieldMutator &cb) {
+  assert(arena);
+  assert(&out);
+  assert(&that);
+  assert(&cb);
+  if (that.Tycon != TCore::TTycon::Record || that.IndirectCoreArray.IsExemplar || !that.IndirectCoreArray.ElemCount) {
+    return 0;
+  }
+  const size_t elem_count = that.IndirectCoreArray.ElemCount;
+  void *pin_alloc = alloca(sizeof(TCore::TArena::TFinalPin));
+  TCore::TArena::TFinalPin::TWrapper pin(that_arena->Pin(
+      that.IndirectCoreArray.Offset, sizeof(TCore::TNote) + (sizeof(TCore) * 2 * elem_count), pin_alloc));
+  const TCore::TNote::TPairOfCores *start, *limit;
+  pin->GetNote()->Get(start, limit);
+  if (static_cast<size_t>(limit - start) < elem_count) {
+    throw TCore::TCorrupt();
+  }
+  size_t change_count = 0;
+  string name;
+  TCore::TInit2 init2 =
+      [arena, state_alloc, that_arena, start, &cb, &change_count, &name](size_t elem_idx, void *lhs, void *rhs) {
+        const TCore &field_name = start[elem_idx].first, &field = start[elem_idx].second;
+        field_name.CopyOut(that_arena, name);
+        new (lhs) TCore(arena, state_alloc, that_arena, field_name);
+        TCore *new_field = new (rhs) TCore();
+        if (cb(name, field, *new_field)) {
+          ++change_count;
+        } else {
+          *new_field = TCore(arena, state_alloc, that_arena, field);
+        }
+      };
+  out.InitIndirectCoreArray(
+      TCore::TTycon::Record, arena->Propose(TCore::TNote::New(TCore::TTycon::Record, elem_count, false, init2)),
+      elem_count, false);
+  return change_count;
+}
@@ -0,0 +1,57 @@
+/* <orly/atom/mutate.h>
+
+   Applies field-call mutations (+=, -=, and friends) directly to cores.
+
+   The general way to mutate a stored value is to convert it to a Var, mutate the Var, and convert the result back to
+   a core.  That costs a heap allocation per node of the value, in both directions.  The functions here handle the
+   common cases without leaving the core representation: numeric add, subtract, and multiply; string append; list
+   append; set union; dict insertion; and changes to the fields of records.  They build their results in the arena
+   they're given.  Anything they don't handle, they decline, and the caller falls back to the Var path, which also
+   reports the errors.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include <orly/atom/kit2.h>
+#include <orly/shared_enum.h>
+
+namespace Orly {
+
+  namespace Atom {
+
+    /* Apply the mutator to the lhs with the rhs and set out to the result, built in the given arena, then return true.
+       If the mutator isn't one we handle for cores of these types, leave out alone and return false. */
+    bool TryMutate(
+        TCore::TExtensibleArena *arena, void *state_alloc, TCore &out,
+        TCore::TArena *lhs_arena, const TCore &lhs, TMutator mutator, TCore::TArena *rhs_arena, const TCore &rhs);
+
+    /* Called for each field of a record, with the field's name and value.  To change the field, set the new value,
+       built in the record's new arena, and return true.  To keep the field as it is, return false. */
+    using TFieldMutator = std::function<bool (const std::string &name, const TCore &field, TCore &new_field)>;
+
+    /* If the core is a record, set out to a copy of it, built in the given arena, with its fields changed as the
+       callback says, then return the number of fields the callback changed.  If the core isn't a record (or is an empty
+       one), leave out alone and return zero. */
+    size_t TryMutateRecord(
+        TCore::TExtensibleArena *arena, void *state_alloc, TCore &out,
+        TCore::TArena *that_arena, const TCore &that, const TFieldMutator &cb);
+
+  }  // Atom
+
+}  // Orly
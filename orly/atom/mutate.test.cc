@@ -0,0 +1,134 @@
+/* <orly/atom/mutate.test.cc>
+
+   Unit test for <orly/atom/mutate.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/atom/mutate.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <orly/atom/suprena.h>
+#include <orly/sabot/to_native.h>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Orly;
+using namespace Orly::Atom;
+
+/* Mutate a native value with another and return the result as a native value, or leave it alone and return false. */
+template <typename TVal>
+static bool Mutate(const TVal &lhs, TMutator mutator, const TVal &rhs, TVal &result) {
+  TSuprena lhs_arena, rhs_arena, arena;
+  void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+  TCore out;
+  if (!TryMutate(
+          &arena, state_alloc, out,
+          &lhs_arena, TCore(lhs, &lhs_arena, state_alloc), mutator, &rhs_arena, TCore(rhs, &rhs_arena, state_alloc))) {
+    return false;
+  }
+  result = Sabot::AsNative<TVal>(*Sabot::State::TAny::TWrapper(out.NewState(&arena, state_alloc)));
+  return true;
+}
+
+FIXTURE(Numbers) {
+  int64_t i = 0;
+  if (EXPECT_TRUE(Mutate<int64_t>(101, TMutator::Add, 202, i))) {
+    EXPECT_EQ(i, 303);
+  }
+  if (EXPECT_TRUE(Mutate<int64_t>(101, TMutator::Sub, 202, i))) {
+    EXPECT_EQ(i, -101);
+  }
+  if (EXPECT_TRUE(Mutate<int64_t>(3, TMutator::Mult, 4, i))) {
+    EXPECT_EQ(i, 12);
+  }
+  double d = 0;
+  if (EXPECT_TRUE(Mutate(1.5, TMutator::Add, 2.25, d))) {
+    EXPECT_EQ(d, 3.75);
+  }
+  /* Division is left to Var, which knows what to do about zero. */
+  EXPECT_FALSE(Mutate<int64_t>(1, TMutator::Div, 0, i));
+  bool b;
+  EXPECT_FALSE(Mutate(true, TMutator::Add, false, b));
+}
+
+FIXTURE(Strings) {
+  string s;
+  if (EXPECT_TRUE(Mutate<string>("hello", TMutator::Add, ", doctor", s))) {
+    EXPECT_EQ(s, "hello, doctor");
+  }
+  /* Long enough to be stored indirectly. */
+  const string long_str(100, 'x');
+  if (EXPECT_TRUE(Mutate<string>(long_str, TMutator::Add, long_str, s))) {
+    EXPECT_EQ(s, long_str + long_str);
+  }
+  if (EXPECT_TRUE(Mutate<string>("", TMutator::Add, "", s))) {
+    EXPECT_EQ(s, "");
+  }
+  EXPECT_FALSE(Mutate<string>("a", TMutator::Sub, "b", s));
+}
+
+FIXTURE(Lists) {
+  vector<int64_t> v;
+  if (EXPECT_TRUE(Mutate(vector<int64_t>{1, 2}, TMutator::Add, vector<int64_t>{3, 1}, v))) {
+    EXPECT_TRUE(v == (vector<int64_t>{1, 2, 3, 1}));
+  }
+  if (EXPECT_TRUE(Mutate(vector<int64_t>{}, TMutator::Add, vector<int64_t>{3}, v))) {
+    EXPECT_TRUE(v == vector<int64_t>{3});
+  }
+  if (EXPECT_TRUE(Mutate(vector<int64_t>{}, TMutator::Add, vector<int64_t>{}, v))) {
+    EXPECT_TRUE(v.empty());
+  }
+  EXPECT_FALSE(Mutate(vector<int64_t>{}, TMutator::Union, vector<int64_t>{}, v));
+}
+
+FIXTURE(Sets) {
+  set<string> s;
+  if (EXPECT_TRUE(Mutate(set<string>{"b", "d"}, TMutator::Union, set<string>{"a", "b", "c", "e"}, s))) {
+    EXPECT_TRUE(s == (set<string>{"a", "b", "c", "d", "e"}));
+  }
+  if (EXPECT_TRUE(Mutate(set<string>{"b"}, TMutator::Union, set<string>{}, s))) {
+    EXPECT_TRUE(s == set<string>{"b"});
+  }
+  EXPECT_FALSE(Mutate(set<string>{}, TMutator::Add, set<string>{}, s));
+}
+
+FIXTURE(Dicts) {
+  map<int64_t, string> m;
+  if (EXPECT_TRUE(Mutate(
+          map<int64_t, string>{{1, "one"}, {3, "three"}}, TMutator::Add, map<int64_t, string>{{2, "two"}, {3, "THREE"}}, m))) {
+    EXPECT_TRUE(m == (map<int64_t, string>{{1, "one"}, {2, "two"}, {3, "THREE"}}));
+  }
+}
+
+FIXTURE(Mismatch) {
+  TSuprena arena;
+  void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+  TCore out;
+  EXPECT_FALSE(TryMutate(
+      &arena, state_alloc, out,
+      &arena, TCore(int64_t(1), &arena, state_alloc), TMutator::Add, &arena, TCore(1.0, &arena, state_alloc)));
+  EXPECT_FALSE(TryMutate(
+      &arena, state_alloc, out,
+      &arena, TCore(vector<int64_t>{1}, &arena, state_alloc), TMutator::Add,
+      &arena, TCore(vector<string>{"a"}, &arena, state_alloc)));
+  /* Not a record, so nothing to change. */
+  EXPECT_EQ(TryMutateRecord(&arena, state_alloc, out, &arena, TCore(int64_t(1), &arena, state_alloc),
+                            [](const string &, const TCore &, TCore &) { return true; }), 0U);
+}
@@ -28,6 +28,14 @@ TNoteInterner::~TNoteInterner() {
   }
 }
 
+void TNoteInterner::Clear() {
+  assert(this);
+  for (auto note: Notes) {
+    delete const_cast<TCore::TNote *>(note);
+  }
+  Notes.clear();
+}
+
 bool TNoteInterner::IsKnown(const TCore::TNote *note) const {
   assert(this);
   return Notes.find(note) != Notes.end();
@@ -44,6 +44,9 @@ namespace Orly {
       /* Delete the notes when we go. */
       ~TNoteInterner();
 
+      /* Delete all our notes, leaving us empty but keeping the room we've grown. */
+      void Clear();
+
       /* TODO */
       inline const TNotes &GetNotes() const;
 
@@ -44,6 +44,9 @@ namespace Orly {
       /* The number of notes we contain. */
       inline size_t GetSize() const;
 
+      /* Destroys all notes, so we can be used again.  Any core still pointing at us is left dangling. */
+      inline void Clear();
+
       /* TODO */
       inline const TNoteInterner::TNotes &GetNotes() const;
 
@@ -78,6 +81,11 @@ namespace Orly {
       return NoteInterner.GetSize();
     }
 
+    inline void TSuprena::Clear() {
+      assert(this);
+      NoteInterner.Clear();
+    }
+
     inline const TNoteInterner::TNotes &TSuprena::GetNotes() const {
       assert(this);
       return NoteInterner.GetNotes();
@@ -69,3 +69,15 @@ FIXTURE(Uniqueness) {
     }
   } while (next_permutation(idxs.begin(), idxs.end()));
 }
+
+FIXTURE(Clear) {
+  TSuprena arena;
+  arena.Propose(TCore::TNote::New("A is for Alice, who fell down the stairs.", false));
+  arena.Propose(TCore::TNote::New("B is for Basil, assaulted by bears.", false));
+  EXPECT_EQ(arena.GetSize(), 2U);
+  arena.Clear();
+  EXPECT_EQ(arena.GetSize(), 0U);
+  /* The arena is as good as new afterward. */
+  arena.Propose(TCore::TNote::New("A is for Alice, who fell down the stairs.", false));
+  EXPECT_EQ(arena.GetSize(), 1U);
+}
@@ -121,6 +121,11 @@ shared_ptr<Rpc::TFuture<TMethodResult>> TClient::Try(const TUuid &pov_id, const
   return Write<TMethodResult>(ServerRpc::Try, pov_id, fq_name, closure);
 }
 
+shared_ptr<Rpc::TFuture<vector<TMethodResult>>> TClient::TryMany(const vector<TMethodRequest> &requests) {
+  assert(this);
+  return Write<vector<TMethodResult>>(ServerRpc::TryMany, requests);
+}
+
 shared_ptr<Rpc::TFuture<void>> TClient::BeginImport() {
   assert(this);
   return Write<void>(ServerRpc::BeginImport);
@@ -181,6 +186,40 @@ void TClient::DispatchMain() {
   }
 }
 
+void TClient::OnNotify(const ClientRpc::TNotifications &notifications) {
+  assert(this);
+  assert(&notifications);
+  for (const auto &notification: notifications) {
+    const auto &pov_id = get<1>(notification);
+    const auto &tracking_id = get<2>(notification);
+    switch (get<0>(notification)) {
+      case ClientRpc::PovFailed: {
+        OnPovFailed(pov_id);
+        break;
+      }
+      case ClientRpc::UpdateAccepted: {
+        OnUpdateAccepted(pov_id, tracking_id);
+        break;
+      }
+      case ClientRpc::UpdateReplicated: {
+        OnUpdateReplicated(pov_id, tracking_id);
+        break;
+      }
+      case ClientRpc::UpdateDurable: {
+        OnUpdateDurable(pov_id, tracking_id);
+        break;
+      }
+      case ClientRpc::UpdateSemiDurable: {
+        OnUpdateSemiDurable(pov_id, tracking_id);
+        break;
+      }
+      default: {
+        syslog(LOG_ERR, "orly client; unknown notification kind %d", get<0>(notification));
+      }
+    }
+  }
+}
+
 void TClient::IoMain() {
   assert(this);
   try {
@@ -330,6 +369,7 @@ TClient::TProtocol::TProtocol() {
   Register<TClient, void, TUuid, TUuid>(ClientRpc::UpdateReplicated,  &TClient::OnUpdateReplicated);
   Register<TClient, void, TUuid, TUuid>(ClientRpc::UpdateDurable,     &TClient::OnUpdateDurable);
   Register<TClient, void, TUuid, TUuid>(ClientRpc::UpdateSemiDurable, &TClient::OnUpdateSemiDurable);
+  Register<TClient, void, ClientRpc::TNotifications>(ClientRpc::Notify, &TClient::OnNotify);
 }
 
 const TClient::TProtocol TClient::TProtocol::Protocol;
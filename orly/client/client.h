@@ -22,6 +22,7 @@
 #include <chrono>
 #include <memory>
 #include <thread>
+#include <vector>
 
 #include <base/class_traits.h>
 #include <base/event_semaphore.h>
@@ -32,7 +33,9 @@
 #include <rpc/rpc.h>
 #include <socket/address.h>
 #include <orly/closure.h>
+#include <orly/method_request.h>
 #include <orly/method_result.h>
+#include <orly/protocol.h>
 
 namespace Orly {
 
@@ -87,6 +90,10 @@ namespace Orly {
       /* TODO */
       std::shared_ptr<Rpc::TFuture<TMethodResult>> Try(const Base::TUuid &pov_id, const std::vector<std::string> &fq_name, const TClosure &closure);
 
+      /* Try several methods in one round trip.  The results come back in the same order as the requests.  See
+         <orly/protocol.h>. */
+      std::shared_ptr<Rpc::TFuture<std::vector<TMethodResult>>> TryMany(const std::vector<TMethodRequest> &requests);
+
       /* TODO */
       std::shared_ptr<Rpc::TFuture<void>> BeginImport();
 
@@ -152,6 +159,9 @@ namespace Orly {
       /* TODO */
       void DispatchMain();
 
+      /* Hands each notification in the batch to the matching On...() handler above. */
+      void OnNotify(const ClientRpc::TNotifications &notifications);
+
       /* Handles background I/O with the server. */
       void IoMain();
 
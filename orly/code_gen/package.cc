@@ -357,7 +357,8 @@ void TPackage::WriteCc(TCppPrinter &out, const TRelPath &rel_path) const {
         << "/* ret */ "; //NOTE: GetOstream at the start of a line will cause indent to not be printed.
       Type::GenCode(out.GetOstream(), it->GetReturnType());
       out << ',' << Eol
-          << "RF_" << it->GetName() << Eol;
+          << "RF_" << it->GetName() << ',' << Eol
+          << "/* has effects */ " << (dynamic_cast<const TExportFunc &>(*it).HasEffects() ? "true" : "false") << Eol;
     }
     out << "};" << Eol;
   }
@@ -18,9 +18,52 @@
 
 #include <orly/code_gen/symbol_func.h>
 
+#include <unordered_set>
+
+#include <orly/expr/effect.h>
+#include <orly/expr/function_app.h>
+#include <orly/expr/walker.h>
+#include <orly/symbol/built_in_function.h>
+
 using namespace Orly;
 using namespace Orly::CodeGen;
 
+/* True iff. the given function's body, or that of any function it calls, contains an effect.  Functions we've already
+   visited count as effect-free, which is what breaks recursion; if one of them has an effect, we'll find it there. */
+static bool HasEffects(const Symbol::TFunction *func, std::unordered_set<const Symbol::TFunction *> &visited) {
+  assert(func);
+  if (!visited.insert(func).second) {
+    return false;
+  }
+  bool res = false;
+  Expr::ForEachExpr(func->GetExpr(), [&res, &visited](const Expr::TExpr::TPtr &expr) {
+    if (res || expr->TryAs<Expr::TEffect>()) {
+      res = true;
+      return true;
+    }
+    const Expr::TFunctionApp *func_app = expr->TryAs<Expr::TFunctionApp>();
+    if (func_app) {
+      class TVisitor
+          : public Symbol::TAnyFunction::TVisitor {
+        NO_COPY(TVisitor);
+        public:
+        TVisitor(bool &res, std::unordered_set<const Symbol::TFunction *> &visited)
+            : Res(res), Visited(visited) {}
+        virtual void operator()(const Symbol::TFunction *that) const {
+          Res = HasEffects(that, Visited);
+        }
+        virtual void operator()(const Symbol::TBuiltInFunction *) const {}
+        private:
+        bool &Res;
+        std::unordered_set<const Symbol::TFunction *> &Visited;
+      };  // TVisitor
+      func_app->GetFunction()->Accept(TVisitor(res, visited));
+    }
+    return res;
+  }, true);
+  return res;
+}
+
 //TODO: Should really return a TSymbolFuncPtr...
 TFunction::TPtr TSymbolFunc::Find(const Symbol::TFunction *symbol) {
   auto res = Functions.find(symbol);
@@ -47,6 +90,12 @@ Type::TType TSymbolFunc::GetType() const {
   return Symbol->GetType();
 }
 
+bool TSymbolFunc::HasEffects() const {
+  assert(this);
+  std::unordered_set<const Symbol::TFunction *> visited;
+  return ::HasEffects(Symbol.get(), visited);
+}
+
 TSymbolFunc::TSymbolFunc(const L0::TPackage *package, const Symbol::TFunction::TPtr &symbol, const TIdScope::TPtr &id_scope)
       : TFunction(package, id_scope), Symbol(symbol) {
   PostCtor(symbol->GetParams(), symbol->GetExpr(), true);
@@ -35,6 +35,10 @@ namespace Orly {
       Type::TType GetReturnType() const;
       Type::TType GetType() const;
 
+      /* True iff. calling the function might produce database effects, either itself or through a function it calls.
+         This errs on the side of true: an effect anywhere in the body counts, taken or not. */
+      bool HasEffects() const;
+
       protected:
       TSymbolFunc(const L0::TPackage *package, const Symbol::TFunction::TPtr &symbol, const TIdScope::TPtr &id_scope);
 
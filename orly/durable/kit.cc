@@ -28,48 +28,56 @@ using namespace Orly::Durable;
 void TManager::Clean() {
   assert(this);
   TSem sem;
-  /* extra */ {
-    lock_guard<mutex> lock(Mutex);
-    auto now = TDeadline::clock::now();
-    while (!ClosedObjs.empty()) {
-      auto iter = ClosedObjs.begin();
+  auto now = TDeadline::clock::now();
+  for (auto &shard: Shards) {
+    lock_guard<mutex> lock(shard.Mutex);
+    while (!shard.ClosedObjs.empty()) {
+      auto iter = shard.ClosedObjs.begin();
       if (iter->first.first > now) {
         break;
       }
       TObj *cached_obj = iter->second;
-      ClosedObjs.erase(iter);
+      shard.ClosedObjs.erase(iter);
       DestroyObj(cached_obj);
     }
+  }
+  /* extra */ {
+    lock_guard<mutex> storage_lock(StorageMutex);
     CleanDisk(now, &sem);
   }
   sem.Pop();
 }
 
 TManager::TManager(size_t max_cache_size)
-    : MaxCacheSize(max_cache_size) {}
+    : MaxCacheSizePerShard((max_cache_size + ShardCount - 1) / ShardCount) {}
 
 TManager::~TManager() {
   assert(this);
-  for (const auto &item: OpenableObjs) {
-    /* If this assertion fails, it means there is at least one ptr still alive someplace. */
-    assert(item.second->PtrCount == 0);
-    delete item.second;
+  for (auto &shard: Shards) {
+    for (const auto &item: shard.OpenableObjs) {
+      /* If this assertion fails, it means there is at least one ptr still alive someplace. */
+      assert(item.second->PtrCount == 0);
+      delete item.second;
+    }
   }
 }
 
 void TManager::Clear() {
-  for (const auto &item: OpenableObjs) {
-    /* If this assertion fails, it means there is at least one ptr still alive someplace. */
-    assert(item.second->PtrCount == 0);
-    delete item.second;
+  for (auto &shard: Shards) {
+    for (const auto &item: shard.OpenableObjs) {
+      /* If this assertion fails, it means there is at least one ptr still alive someplace. */
+      assert(item.second->PtrCount == 0);
+      delete item.second;
+    }
+    shard.OpenableObjs.clear();
+    shard.ClosedObjs.clear();
   }
-  OpenableObjs.clear();
 }
 
 void TManager::DestroyObj(TObj *obj) noexcept {
   assert(this);
   assert(obj);
-  size_t erased_from_openable = OpenableObjs.erase(obj->GetId());
+  size_t erased_from_openable = GetShard(obj->GetId()).OpenableObjs.erase(obj->GetId());
   assert(erased_from_openable == 1);
   delete obj;
 }
@@ -78,21 +86,22 @@ bool TManager::TryCacheObj(TObj *obj) noexcept {
   assert(this);
   assert(obj);
   bool success = false;
-  if (MaxCacheSize) {
+  if (MaxCacheSizePerShard) {
     try {
+      TShard &shard = GetShard(obj->GetId());
       /* The object is entering the cache.  It should have no sem right now, but it will need one later. */
       assert(!(obj->Sem));
       obj->Sem = new TSem;
       /* Discard objects from the cache until there's room for the new object.
          Start with the object with the soonest deadline and work forward. */
-      while (ClosedObjs.size() >= MaxCacheSize) {
-        auto iter = ClosedObjs.begin();
+      while (shard.ClosedObjs.size() >= MaxCacheSizePerShard) {
+        auto iter = shard.ClosedObjs.begin();
         TObj *cached_obj = iter->second;
-        ClosedObjs.erase(iter);
+        shard.ClosedObjs.erase(iter);
         DestroyObj(cached_obj);
       }
       /* Insert this object into the cache in order of its deadline. */
-      ClosedObjs.insert(make_pair(make_pair(*(obj->GetDeadline()), obj->GetId()), obj));
+      shard.ClosedObjs.insert(make_pair(make_pair(*(obj->GetDeadline()), obj->GetId()), obj));
       success = true;
     } catch (const exception &ex) {
       obj->Log(LOG_INFO, "caching", ex);
@@ -162,21 +171,27 @@ bool TObj::ForEachDependentPtr(const function<bool (TAnyPtr &)> &) noexcept {
 
 void TObj::OnPtrAcquire() noexcept {
   assert(this);
-  lock_guard<mutex> lock(Manager->Mutex);
-  PtrCount += 1;
   assert(PtrCount > 0);
+  PtrCount.fetch_add(1, memory_order_relaxed);
 }
 
 void TObj::OnPtrRelease() noexcept {
   assert(this);
   assert(PtrCount);
+  /* So long as we're not the last pointer, we can just count down. */
+  for (size_t count = PtrCount.load(memory_order_relaxed); count > 1;) {
+    if (PtrCount.compare_exchange_weak(count, count - 1, memory_order_release, memory_order_relaxed)) {
+      return;
+    }
+  }
   bool async = false;
   TSem *sem = nullptr;
   unordered_set<TObj *> dependent_objs;
   /* extra */ {
-    lock_guard<mutex> lock(Manager->Mutex);
-    --PtrCount;
-    if (!PtrCount) {
+    /* We might be the last pointer, so we need the lock.  Since we hold a pointer, no one can close us out from under
+       us in the meantime, but someone may open us again, so we have to look at the count again once we have the lock. */
+    lock_guard<mutex> lock(Manager->GetShard(Id).Mutex);
+    if (PtrCount.fetch_sub(1, memory_order_acq_rel) == 1) {
       /* We're transitioning from open to closed.  We should not yet have a deadline but we should have a sem available. */
       assert(!Deadline);
       assert(Sem);
@@ -195,6 +210,7 @@ void TObj::OnPtrRelease() noexcept {
             strm.Flush();
             recorder->CopyOut(blob);
           }
+          lock_guard<mutex> storage_lock(Manager->StorageMutex);
           Manager->Save(Id, *Deadline, Ttl, blob, sem);
           OnDisk = true;
           async = true;
@@ -226,6 +242,7 @@ void TObj::OnPtrRelease() noexcept {
         /* We have a zero time-to-live, so delete the object from disk (if necessary) and evict it. */
         if (OnDisk) {
           try {
+            lock_guard<mutex> storage_lock(Manager->StorageMutex);
             Manager->Delete(Id, sem);
             async = true;
           } catch (const exception &ex) {
@@ -261,6 +278,5 @@ void TObj::OnPtrAdoptNew() noexcept {
 
 void TObj::OnPtrAdoptOld() noexcept {
   assert(this);
-  PtrCount += 1;
-  assert(PtrCount > 0);
+  PtrCount.fetch_add(1, memory_order_relaxed);
 }
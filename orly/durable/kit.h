@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <exception>
@@ -25,6 +26,7 @@
 #include <map>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <utility>
 
 #include <base/class_traits.h>
@@ -188,12 +190,17 @@ namespace Orly {
 
     };  // TPtr<TSomeObj>
 
-    /* The base class for managers of durable objects. */
+    /* The base class for managers of durable objects.
+       The table of objects is split into shards by id, each with its own lock, so opening and closing different objects
+       doesn't contend.  Copying or dropping a pointer to an object which stays open takes no lock at all. */
     class TManager
         : public Indy::Fiber::TRunnable {
       NO_COPY(TManager);
       public:
 
+      /* The number of shards into which we split the table of objects. */
+      static const size_t ShardCount = 64UL;
+
       /* Evict and destroy all objects whose deadlines have passed.
          This will affect the cache as well as the disk. */
       void Clean();
@@ -233,7 +240,8 @@ namespace Orly {
 
       protected:
 
-      /* The cache size is the maximum number of closed objects we will keep in memory. */
+      /* The cache size is the maximum number of closed objects we will keep in memory.
+         Each shard keeps its share of them, rounded up. */
       TManager(size_t max_cache_size);
 
       /* Destroy all our objects on the way out. */
@@ -241,61 +249,86 @@ namespace Orly {
 
       /* Override to search the disk for an object with the given id.
          If found, return true; else, return false.
-         Assume that the mutex has already been obtained. */
+         Assume that the storage mutex has already been obtained. */
       virtual bool CanLoad(const TId &id) = 0;
 
       /* Override to erase from disk all objects which have a deadline <= the given time.
-         Assume that the mutex has already been obtained.
+         Assume that the storage mutex has already been obtained.
          When the task is complete, push the semaphore.  Do not delete the semaphore. */
       virtual void CleanDisk(const TDeadline &now, TSem *sem) = 0;
 
       /* Override to erase the given object from disk.
          If the object does not exist, there is a logic error in the program or a disk failure.
-         Assume that the mutex has already been obtained.
+         Assume that the storage mutex has already been obtained.
          When the task is complete, push the semaphore.  Do not delete the semaphore. */
       virtual void Delete(const TId &id, TSem *sem) = 0;
 
       /* Override to save the given object to disk.
-         Assume that the mutex has already been obtained.
+         Assume that the storage mutex has already been obtained.
          When the task is complete, push the semaphore.  Do not delete the semaphore. */
       virtual void Save(const TId &id, const TDeadline &deadline, const TTtl &ttl, const std::string &blob, TSem *sem) = 0;
 
       /* Override to search the disk for an object with the given id.
          If found, return the object's blob (via out-parameter) and return true; else, ignore the out-parameter and return false.
-         Assume that the mutex has already been obtained. */
+         Assume that the storage mutex has already been obtained. */
       virtual bool TryLoad(const TId &id, std::string &blob) = 0;
 
       private:
 
+      /* The objects whose ids hash to one shard. */
+      class TShard {
+        NO_COPY(TShard);
+        public:
+
+        /* Empty. */
+        TShard() {}
+
+        /* Covers OpenableObjs, ClosedObjs, and the opening and closing of the objects in them.
+           A pointer count may go up or down without this lock, so long as it doesn't go to or from zero. */
+        std::mutex Mutex;
+
+        /* All the objects currently open as well as those which are closed but cached.
+           These are objects which can be found by the Open() function.
+           If a closed object (that is, one with a PtrCount of zero) is in this container, it will also be in ClosedObjs. */
+        std::unordered_map<TId, TObj *> OpenableObjs;
+
+        /* All the objects currently closed but still cached.
+           They are in order by their deadlines, soonest deadlines first.
+           The size of this container will never exceed MaxCacheSizePerShard.
+           All of the objects in this container have a PtrCount of zero and also appear in OpenableObjs. */
+        std::map<std::pair<TDeadline, TId>, TObj *> ClosedObjs;
+
+      };  // TShard
+
+      /* The shard in which we keep the object with the given id. */
+      TShard &GetShard(const TId &id) {
+        assert(this);
+        size_t hash = id.GetHash();
+        return Shards[(hash ^ (hash >> 32)) % ShardCount];
+      }
+
       /* Evict the given object from the set of openable objects, then destroy the object.
          NOTE 1: The object pointer passed to this function WILL BE BAD by the time this function returns.
-         NOTE 2: This function assumes that the mutex has already been obtained. */
+         NOTE 2: This function assumes that the object's shard's mutex has already been obtained. */
       void DestroyObj(TObj *obj) noexcept;
 
       /* If we're caching, insert the given object into the set of closed objects.
          Discard enough old objects to make room.
          Return true iff. the object is successfully cached.
-         This function assumes that the mutex has already been obtained. */
+         This function assumes that the object's shard's mutex has already been obtained. */
       bool TryCacheObj(TObj *obj) noexcept;
 
-      /* The maximum number of objects to keep in ClosedObjs. */
-      size_t MaxCacheSize;
+      /* The maximum number of objects to keep in each shard's ClosedObjs. */
+      size_t MaxCacheSizePerShard;
 
-      /* Covers OpenableObj, ClosedObjs, and all instances of TObj::PtrCount. */
-      std::mutex Mutex;
+      /* Covers calls to the storage functions (CanLoad(), Save(), etc.), which were written to expect one caller at a
+         time.  When we need both, we take a shard's mutex first and this one second. */
+      std::mutex StorageMutex;
 
-      /* All the objects currently open as well as those which are closed but cached.
-         These are objects which can be found by the Open() function.
-         If a closed object (that is, one with a PtrCount of zero) is in this container, it will also be in ClosedObjs. */
-      std::unordered_map<TId, TObj *> OpenableObjs;
+      /* See TShard. */
+      TShard Shards[ShardCount];
 
-      /* All the objects currently closed but still cached.
-         They are in order by their deadlines, soonest deadlines first.
-         The size of this container will never exceed MaxCacheSize.
-         All of the objects in this container have a PtrCount of zero and also appear in OpenableObjs. */
-      std::map<std::pair<TDeadline, TId>, TObj *> ClosedObjs;
-
-      /* For do-stuff-to-obj functions and the mutex. */
+      /* For do-stuff-to-obj functions and the mutexes. */
       friend class TObj;
 
       /* for saving replicated durables. */
@@ -382,24 +415,24 @@ namespace Orly {
       private:
 
       /* Increment the count of pointers currently sharing this durable object.
-         This operation is syncrhonized between threads. */
+         The caller already holds a pointer, so the object is open and will stay that way; we don't need a lock. */
       void OnPtrAcquire() noexcept;
 
       /* Decrement the count of pointers currently sharing this durable object.
          If this causes the count to reach zero, close the durable object.
          If the close requires an asynchronous disk operation, wait for it to complete.
-         This operation is syncrhonized between threads; however, the lock will be released before waiting for the async operation, if any.
+         Only the last pointer takes the shard's lock, and it releases the lock before waiting for the async operation, if any.
          NOTE: By the time this function returns, 'this' may be a bad pointer. */
       void OnPtrRelease() noexcept;
 
       /* Transition the pointer count from zero to one.
          This is done when the object is adopted by its first pointer.
-         NOTE: This function assumes that the manager's mutex has already been obtained. */
+         NOTE: This function assumes that the shard's mutex has already been obtained. */
       void OnPtrAdoptNew() noexcept;
 
       /* Increment the count of pointers currently sharing this durable object.
          This is done when the object is adopted by a pointer which is not the object's first.
-         NOTE: This function assumes that the manager's mutex has already been obtained. */
+         NOTE: This function assumes that the shard's mutex has already been obtained. */
       void OnPtrAdoptOld() noexcept;
 
       /* See accessor. */
@@ -410,8 +443,9 @@ namespace Orly {
 
       /* The number of pointers currently sharing this durable object.
          If this count is greater than zero, it means the durable object is open.
-         If this count is zero, it means the durable object is closed but being held in cache. */
-      size_t PtrCount;
+         If this count is zero, it means the durable object is closed but being held in cache.
+         It only goes to or from zero under the shard's lock. */
+      std::atomic<size_t> PtrCount;
 
       /* See accessor. */
       bool OnDisk;
@@ -568,17 +602,23 @@ namespace Orly {
     template <typename TSomeObj, typename... TArgs>
     TPtr<TSomeObj> TManager::New(const TId &id, const TTtl &ttl, TArgs &&... args) {
       assert(this);
-      /* Lock the manager and create the requested slot among the openable objects.
+      /* Lock the shard and create the requested slot among the openable objects.
          If the slot already exists, throw. */
-      std::lock_guard<std::mutex> lock(Mutex);
-      auto iter = OpenableObjs.insert(std::pair<TId, TObj *>(id, nullptr)).first;
+      TShard &shard = GetShard(id);
+      std::lock_guard<std::mutex> lock(shard.Mutex);
+      auto iter = shard.OpenableObjs.insert(std::pair<TId, TObj *>(id, nullptr)).first;
       TObj *&openable_obj = iter->second;
       if (openable_obj) {
         THROW_ERROR(TAlreadyExists) << "in cache" << Base::EndOfPart << "id = " << id;
       }
       try {
         /* If the disk store already has an object with the given id, throw. */
-        if (CanLoad(id)) {
+        bool can_load;
+        /* extra */ {
+          std::lock_guard<std::mutex> storage_lock(StorageMutex);
+          can_load = CanLoad(id);
+        }
+        if (can_load) {
           THROW_ERROR(TAlreadyExists) << "on disk" << Base::EndOfPart << "id = " << id;
         }
         /* Construct the new object and keep it in the openable set. */
@@ -596,6 +636,7 @@ namespace Orly {
               recorder->CopyOut(blob);
             }
             TSem sem;
+            std::lock_guard<std::mutex> storage_lock(StorageMutex);
             Save(id, deadline, ttl, blob, &sem);
           }
         }
@@ -605,7 +646,7 @@ namespace Orly {
       } catch (...) {
         /* We already had the object on disk or the object's constructor failed.
            Either way, we need to dispose of the slot we made before continuing to handle the error. */
-        OpenableObjs.erase(iter);
+        shard.OpenableObjs.erase(iter);
         throw;
       }
     }
@@ -613,9 +654,10 @@ namespace Orly {
     template <typename TSomeObj>
     TPtr<TSomeObj> TManager::Open(const TId &id) {
       assert(this);
-      /* Lock the manager and find/create the requested slot among the openable objects. */
-      std::lock_guard<std::mutex> lock(Mutex);
-      auto iter = OpenableObjs.insert(std::pair<TId, TObj *>(id, nullptr)).first;
+      /* Lock the shard and find/create the requested slot among the openable objects. */
+      TShard &shard = GetShard(id);
+      std::lock_guard<std::mutex> lock(shard.Mutex);
+      auto iter = shard.OpenableObjs.insert(std::pair<TId, TObj *>(id, nullptr)).first;
       TObj *&openable_obj = iter->second;
       if (openable_obj) {
         /* We found an object with the given id. */
@@ -623,7 +665,7 @@ namespace Orly {
         const auto &deadline = openable_obj->GetDeadline();
         if (deadline) {
           /* The object is being re-opened from a closed state, so remove it from the set of closed objects. */
-          size_t erased_from_closed = ClosedObjs.erase(std::make_pair(*deadline, id));
+          size_t erased_from_closed = shard.ClosedObjs.erase(std::make_pair(*deadline, id));
           assert(erased_from_closed == 1);
           openable_obj->Deadline.Reset();
         }
@@ -632,7 +674,12 @@ namespace Orly {
       try {
         /* Load the object from disk and keep it in the openable set. */
         std::string blob;
-        if (!TryLoad(id, blob)) {
+        bool loaded;
+        /* extra */ {
+          std::lock_guard<std::mutex> storage_lock(StorageMutex);
+          loaded = TryLoad(id, blob);
+        }
+        if (!loaded) {
           THROW_ERROR(TDoesntExist) << "id = " << id;
         }
         Io::TBinaryInputOnlyStream strm(std::make_shared<Io::TPlayer>(std::make_shared<Io::TRecorder>(blob)));
@@ -642,7 +689,7 @@ namespace Orly {
       } catch (...) {
         /* We could not find the object on disk or the object's constructor failed.
            Either way, we need to dispose of the slot we made before continuing to handle the error. */
-        OpenableObjs.erase(iter);
+        shard.OpenableObjs.erase(iter);
         throw;
       }
     }
@@ -0,0 +1,212 @@
+/* <orly/durable/kit.test.manual.cc>
+
+   Opens per second through a durable manager when many fibers hammer it at once.
+
+   Each fixture runs a pool of fibers over a few runners.  Every fiber opens a pov-like object, holds it across a
+   yield (as a request would while it works), and drops it, over and over.  In one fixture all the fibers share a
+   single object; in the other each fiber has its own.  A third copies a pointer to an object which stays open, which
+   is what passing a pov around costs.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/durable/kit.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <orly/durable/test_manager.h>
+#include <orly/indy/fiber/fiber.h>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace chrono;
+using namespace Base;
+using namespace Io;
+using namespace Orly::Durable;
+using namespace Orly::Indy::Fiber;
+
+typedef TThreadLocalGlobalPoolManager<TFrame, size_t, TRunner *> TFrameManager;
+
+static const size_t NumWorkers = 4UL;
+static const size_t NumFibers = 256UL;
+static const size_t NumOpensPerFiber = 20000UL;
+static const size_t StackSize = 64UL * 1024UL;
+
+/* Stands in for a pov: it has a ttl, so it lingers in the cache after it closes. */
+class TPovLike final
+    : public TObj {
+  public:
+
+  TPovLike(TManager *manager, const TId &id, const TTtl &ttl)
+      : TObj(manager, id, ttl) {}
+
+  TPovLike(TManager *manager, const TId &id, TBinaryInputStream &strm)
+      : TObj(manager, id, strm) {}
+
+  virtual const char *GetKind() const noexcept {
+    return "pov-like";
+  }
+
+  private:
+
+  virtual ~TPovLike() {}
+
+};  // TPovLike
+
+/* How the fibers pick what they open. */
+enum TShape {
+
+  /* Every fiber opens the same object, which some fiber nearly always has open. */
+  Same,
+
+  /* Every fiber opens its own object, so each open starts from the cache. */
+  Different,
+
+  /* Every fiber copies a pointer to the same object, which we hold open throughout. */
+  Copy
+
+};  // TShape
+
+class TBench;
+
+/* One fiber's worth of opening. */
+class TOpener
+    : public TRunnable {
+  NO_COPY(TOpener);
+  public:
+
+  TOpener() {}
+
+  void Submit(TBench *bench, const TId &id);
+
+  void Run();
+
+  private:
+
+  TBench *Bench;
+
+  TId Id;
+
+};  // TOpener
+
+/* Runs one shape of workload on a fresh manager and pool and reports on it. */
+class TBench {
+  NO_COPY(TBench);
+  public:
+
+  TBench(const char *name, TShape shape)
+      : Shape(shape),
+        Manager(NumFibers * 2),
+        RunnerCons(NumWorkers),
+        FrameManager(NumFibers * 2, StackSize, nullptr),
+        FramePool(new TFrameManager::TThreadLocalPool(&FrameManager)),
+        Pool(RunnerCons, NumWorkers),
+        Openers(NumFibers),
+        NumInflight(0UL) {
+    vector<TId> ids;
+    for (size_t i = 0; i < (shape == Different ? NumFibers : 1UL); ++i) {
+      ids.push_back(Manager.New<TPovLike>(TId::Twister, TTtl(999))->GetId());
+    }
+    if (shape == Copy) {
+      Held = Manager.Open<TPovLike>(ids[0]);
+    }
+    const auto start = steady_clock::now();
+    for (size_t i = 0; i < NumFibers; ++i) {
+      ++NumInflight;
+      Openers[i].Submit(this, ids[i % ids.size()]);
+    }
+    while (NumInflight) {
+      this_thread::sleep_for(milliseconds(1));
+    }
+    const double secs = duration_cast<duration<double>>(steady_clock::now() - start).count();
+    printf("%-10s %12.0f opens/s\n", name, NumFibers * NumOpensPerFiber / secs);
+    Held.Reset();
+  }
+
+  /* Called by an opener when it finishes. */
+  void OnDone() {
+    --NumInflight;
+  }
+
+  /* Open the given object, or copy the held pointer to it. */
+  TPtr<TPovLike> Open(const TId &id) {
+    return (Shape == Copy) ? Held : Manager.Open<TPovLike>(id);
+  }
+
+  /* The pool of frames all the openers use. */
+  TFrameManager::TThreadLocalPool *GetFramePool() const {
+    return FramePool.get();
+  }
+
+  /* Runs the openers. */
+  TRunnerPool &GetPool() {
+    return Pool;
+  }
+
+  private:
+
+  const TShape Shape;
+
+  TTestManager Manager;
+
+  /* Held open for the duration of a Copy run. */
+  TPtr<TPovLike> Held;
+
+  TRunner::TRunnerCons RunnerCons;
+
+  TFrameManager FrameManager;
+
+  unique_ptr<TFrameManager::TThreadLocalPool> FramePool;
+
+  /* Declared after the frames, so its runners have stopped (and freed their last frames) before those go away. */
+  TRunnerPool Pool;
+
+  vector<TOpener> Openers;
+
+  atomic<size_t> NumInflight;
+
+};  // TBench
+
+void TOpener::Submit(TBench *bench, const TId &id) {
+  Bench = bench;
+  Id = id;
+  bench->GetPool().Schedule(bench->GetFramePool()->Alloc(), this, static_cast<TRunnable::TFunc>(&TOpener::Run));
+}
+
+void TOpener::Run() {
+  for (size_t i = 0; i < NumOpensPerFiber; ++i) {
+    auto pov = Bench->Open(Id);
+    Yield();
+  }
+  FreeMyFrame(Bench->GetFramePool());
+  Bench->OnDone();
+}
+
+FIXTURE(SamePov) {
+  TBench("same", Same);
+}
+
+FIXTURE(DifferentPovs) {
+  TBench("different", Different);
+}
+
+FIXTURE(CopyPtr) {
+  TBench("copy", Copy);
+}
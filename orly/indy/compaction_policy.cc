@@ -0,0 +1,118 @@
+/* <orly/indy/compaction_policy.cc>
+
+   Implements <orly/indy/compaction_policy.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/compaction_policy.h>
+
+#include <limits>
+#include <stdexcept>
+
+#include <orly/indy/disk/util/hash_util.h>
+
+using namespace std;
+using namespace Orly;
+using namespace Orly::Indy;
+
+unique_ptr<TCompactionPolicy> TCompactionPolicy::New(const string &name, size_t files_per_level) {
+  if (name == "tiered") {
+    return unique_ptr<TCompactionPolicy>(new TTieredCompactionPolicy());
+  }
+  if (name == "leveled") {
+    if (!files_per_level) {
+      throw invalid_argument("a leveled compaction policy needs at least one file per level");
+    }
+    return unique_ptr<TCompactionPolicy>(new TLeveledCompactionPolicy(files_per_level));
+  }
+  throw invalid_argument("unknown compaction policy \"" + name + "\"");
+}
+
+TCompactionPolicy::~TCompactionPolicy() {}
+
+bool TTieredCompactionPolicy::TryChoose(const vector<TLayer> &layers, size_t &out_begin, size_t &out_end) const {
+  assert(this);
+  assert(&layers);
+  for (size_t i = 0; i + 1 < layers.size(); ++i) {
+    const TLayer &older = layers[i], &newer = layers[i + 1];
+    if (older.IsMergeable && newer.IsMergeable
+        && Disk::Util::SuggestGeneration(older.Size) <= Disk::Util::SuggestGeneration(newer.Size)) {
+      out_begin = i;
+      out_end = i + 2;
+      return true;
+    }
+  }
+  return false;
+}
+
+constexpr size_t TLeveledCompactionPolicy::DefaultFanOut;
+
+constexpr size_t TLeveledCompactionPolicy::DefaultBaseSize;
+
+TLeveledCompactionPolicy::TLeveledCompactionPolicy(size_t files_per_level, size_t fan_out, size_t base_size)
+    : FilesPerLevel(files_per_level), FanOut(fan_out), BaseSize(base_size) {
+  assert(files_per_level);
+  assert(fan_out > 1);
+  assert(base_size);
+}
+
+size_t TLeveledCompactionPolicy::GetLevel(size_t size) const {
+  assert(this);
+  size_t level = 0;
+  for (size_t limit = BaseSize; size >= limit; limit *= FanOut) {
+    ++level;
+    if (limit > numeric_limits<size_t>::max() / FanOut) {
+      break;
+    }
+  }
+  return level;
+}
+
+bool TLeveledCompactionPolicy::TryChoose(const vector<TLayer> &layers, size_t &out_begin, size_t &out_end) const {
+  assert(this);
+  assert(&layers);
+  /* An older layer on a lower level than its newer neighbor is out of order, so merge the two before anything else. */
+  for (size_t i = 0; i + 1 < layers.size(); ++i) {
+    const TLayer &older = layers[i], &newer = layers[i + 1];
+    if (older.IsMergeable && newer.IsMergeable && GetLevel(older.Size) < GetLevel(newer.Size)) {
+      out_begin = i;
+      out_end = i + 2;
+      return true;
+    }
+  }
+  /* Look for the newest level with too many layers in it.  Merge them, along with the newest layer of the level above,
+     if that's their older neighbor. */
+  for (size_t end = layers.size(); end;) {
+    if (!layers[end - 1].IsMergeable) {
+      --end;
+      continue;
+    }
+    const size_t level = GetLevel(layers[end - 1].Size);
+    size_t begin = end - 1;
+    while (begin && layers[begin - 1].IsMergeable && GetLevel(layers[begin - 1].Size) == level) {
+      --begin;
+    }
+    if (end - begin > FilesPerLevel) {
+      if (begin && layers[begin - 1].IsMergeable && GetLevel(layers[begin - 1].Size) == level + 1) {
+        --begin;
+      }
+      out_begin = begin;
+      out_end = end;
+      return true;
+    }
+    end = begin;
+  }
+  return false;
+}
@@ -0,0 +1,133 @@
+/* <orly/indy/compaction_policy.h>
+
+   Policies which choose the disk layers of a repo to merge.
+
+   A repo's layers are ordered oldest first, and only adjacent layers may be merged, as the result takes their place
+   in the order.  A policy looks at the sizes of the layers and picks a run of them to merge next, or none.
+
+   The tiered policy merges a layer with its newer neighbor whenever the neighbor is in the same or a higher size
+   generation.  Merges are cheap, but the number of layers, and so the number of places a point read must look, is
+   only bounded by the number of generations times however many layers pile up in each.
+
+   The leveled policy sorts the layers into levels whose sizes grow by a fan-out, and lets each level hold at most a
+   given number of layers.  When a level holds too many, they are merged together with the newest layer of the level
+   above, so reads are bounded by the number of levels times the layers per level, at the cost of rewriting the larger
+   layers more often.  Our layers each cover the whole key space, so unlike the leveled schemes of other stores, a level
+   is not partitioned by key range.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <cassert>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <base/class_traits.h>
+
+namespace Orly {
+
+  namespace Indy {
+
+    /* Chooses the disk layers of a repo to merge. */
+    class TCompactionPolicy {
+      NO_COPY(TCompactionPolicy);
+      public:
+
+      /* What a policy knows about a layer. */
+      class TLayer {
+        public:
+
+        /* Do-little. */
+        TLayer(size_t size, bool is_mergeable) : Size(size), IsMergeable(is_mergeable) {}
+
+        /* The number of keys in the layer. */
+        size_t Size;
+
+        /* True iff. the layer is on disk and not already being merged. */
+        bool IsMergeable;
+
+      };  // TLayer
+
+      /* Construct the policy with the given name, which is either "tiered" or "leveled".  The leveled policy keeps at
+         most files_per_level layers in each level; the tiered policy ignores this. */
+      static std::unique_ptr<TCompactionPolicy> New(const std::string &name, size_t files_per_level);
+
+      /* Do-little. */
+      virtual ~TCompactionPolicy();
+
+      /* Given a repo's layers, oldest first, choose a run of two or more adjacent mergeable layers to merge into one.
+         If there is a run worth merging, set [out_begin, out_end) to its positions and return true; otherwise, leave
+         them alone and return false. */
+      virtual bool TryChoose(const std::vector<TLayer> &layers, size_t &out_begin, size_t &out_end) const = 0;
+
+      protected:
+
+      /* Do-little. */
+      TCompactionPolicy() {}
+
+    };  // TCompactionPolicy
+
+    /* Merges a layer with its newer neighbor when the neighbor's size generation is at least as high. */
+    class TTieredCompactionPolicy final
+        : public TCompactionPolicy {
+      NO_COPY(TTieredCompactionPolicy);
+      public:
+
+      /* Do-little. */
+      TTieredCompactionPolicy() {}
+
+      /* See TCompactionPolicy. */
+      virtual bool TryChoose(const std::vector<TLayer> &layers, size_t &out_begin, size_t &out_end) const override;
+
+    };  // TTieredCompactionPolicy
+
+    /* Keeps the layers in levels of bounded population.  Layers smaller than base_size keys are in level 0, and each
+       level above holds layers fan_out times larger than the one below. */
+    class TLeveledCompactionPolicy final
+        : public TCompactionPolicy {
+      NO_COPY(TLeveledCompactionPolicy);
+      public:
+
+      /* The defaults for the constructor. */
+      static constexpr size_t DefaultFanOut = 10UL;
+      static constexpr size_t DefaultBaseSize = 4096UL;
+
+      /* Keep at most files_per_level layers in each level. */
+      TLeveledCompactionPolicy(size_t files_per_level, size_t fan_out = DefaultFanOut, size_t base_size = DefaultBaseSize);
+
+      /* The level of a layer of the given size. */
+      size_t GetLevel(size_t size) const;
+
+      /* See TCompactionPolicy. */
+      virtual bool TryChoose(const std::vector<TLayer> &layers, size_t &out_begin, size_t &out_end) const override;
+
+      private:
+
+      /* See constructor. */
+      const size_t FilesPerLevel;
+
+      /* See constructor. */
+      const size_t FanOut;
+
+      /* See constructor. */
+      const size_t BaseSize;
+
+    };  // TLeveledCompactionPolicy
+
+  }  // Indy
+
+}  // Orly
@@ -0,0 +1,84 @@
+/* <orly/indy/compaction_policy.test.cc>
+
+   Unit test for <orly/indy/compaction_policy.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/compaction_policy.h>
+
+#include <stdexcept>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Orly::Indy;
+
+typedef TCompactionPolicy::TLayer TLayer;
+
+FIXTURE(New) {
+  EXPECT_TRUE(dynamic_cast<TTieredCompactionPolicy *>(TCompactionPolicy::New("tiered", 0).get()));
+  EXPECT_TRUE(dynamic_cast<TLeveledCompactionPolicy *>(TCompactionPolicy::New("leveled", 4).get()));
+  EXPECT_THROW(invalid_argument, [] { TCompactionPolicy::New("leveled", 0); });
+  EXPECT_THROW(invalid_argument, [] { TCompactionPolicy::New("universal", 4); });
+}
+
+FIXTURE(Tiered) {
+  TTieredCompactionPolicy policy;
+  size_t begin = 0, end = 0;
+  /* Older layers in higher generations are left alone. */
+  EXPECT_FALSE(policy.TryChoose({ TLayer(1000000, true), TLayer(10000, true), TLayer(100, true) }, begin, end));
+  /* A newer layer in the same generation is merged with its older neighbor. */
+  if (EXPECT_TRUE(policy.TryChoose({ TLayer(1000000, true), TLayer(100, true), TLayer(200, true) }, begin, end))) {
+    EXPECT_EQ(begin, 1UL);
+    EXPECT_EQ(end, 3UL);
+  }
+  /* But not if either is taken, or isn't on disk. */
+  EXPECT_FALSE(policy.TryChoose({ TLayer(1000000, true), TLayer(100, false), TLayer(200, true) }, begin, end));
+  EXPECT_FALSE(policy.TryChoose({ TLayer(1000000, true), TLayer(100, true), TLayer(200, false) }, begin, end));
+}
+
+FIXTURE(Levels) {
+  TLeveledCompactionPolicy policy(2, 10, 100);
+  EXPECT_EQ(policy.GetLevel(0), 0UL);
+  EXPECT_EQ(policy.GetLevel(99), 0UL);
+  EXPECT_EQ(policy.GetLevel(100), 1UL);
+  EXPECT_EQ(policy.GetLevel(999), 1UL);
+  EXPECT_EQ(policy.GetLevel(1000), 2UL);
+  EXPECT_EQ(policy.GetLevel(static_cast<size_t>(-1)), 18UL);
+}
+
+FIXTURE(Leveled) {
+  TLeveledCompactionPolicy policy(2, 10, 100);
+  size_t begin = 0, end = 0;
+  /* Up to two layers per level is fine. */
+  EXPECT_FALSE(policy.TryChoose({ TLayer(5000, true), TLayer(500, true), TLayer(400, true), TLayer(50, true), TLayer(40, true) }, begin, end));
+  /* A third layer in level 0 is merged with the others, and with the newest layer in level 1. */
+  if (EXPECT_TRUE(policy.TryChoose({ TLayer(5000, true), TLayer(500, true), TLayer(50, true), TLayer(40, true), TLayer(30, true) }, begin, end))) {
+    EXPECT_EQ(begin, 1UL);
+    EXPECT_EQ(end, 5UL);
+  }
+  /* If the level above is busy, the level is merged on its own. */
+  if (EXPECT_TRUE(policy.TryChoose({ TLayer(5000, true), TLayer(500, false), TLayer(50, true), TLayer(40, true), TLayer(30, true) }, begin, end))) {
+    EXPECT_EQ(begin, 2UL);
+    EXPECT_EQ(end, 5UL);
+  }
+  /* A newer layer on a higher level than its older neighbor is merged with it first. */
+  if (EXPECT_TRUE(policy.TryChoose({ TLayer(5000, true), TLayer(50, true), TLayer(500, true), TLayer(40, true), TLayer(30, true), TLayer(20, true) }, begin, end))) {
+    EXPECT_EQ(begin, 1UL);
+    EXPECT_EQ(end, 3UL);
+  }
+  /* Layers which aren't mergeable break up a level. */
+  EXPECT_FALSE(policy.TryChoose({ TLayer(50, true), TLayer(40, true), TLayer(30, false), TLayer(20, true) }, begin, end));
+}
@@ -0,0 +1,171 @@
+/* <orly/indy/compaction_policy.test.manual.cc>
+
+   Simulates the compaction policies of <orly/indy/compaction_policy.h> over a memory-backed disk.
+
+   Each fixture flushes batches of random updates to a repo-like sequence of data files and, after each flush, merges
+   whatever its policy chooses until the policy is satisfied, just as a safe repo's disk merges would.  The files and
+   merges are real; only the repo is missing.  At the end, it reports:
+
+     read amp:  the number of layers a point read must look in, on average and at worst, sampled after each flush;
+     write amp: the bytes written by flushes and merges, over the bytes written by flushes alone; and
+     space amp: the bytes of the layers left at the end, over the bytes of a single file of the live keys alone.
+
+   Merged-away files aren't freed, so the simulated disk needs room for everything written.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/compaction_policy.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+#include <base/scheduler.h>
+#include <orly/indy/disk/data_file.h>
+#include <orly/indy/disk/disk_test.h>
+#include <orly/indy/disk/merge_data_file.h>
+#include <orly/indy/disk/sim/mem_engine.h>
+#include <orly/indy/fiber/fiber_test_runner.h>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace chrono;
+using namespace Base;
+using namespace Orly;
+using namespace Orly::Atom;
+using namespace Orly::Indy;
+using namespace Orly::Indy::Disk;
+using namespace Orly::Indy::Disk::Util;
+using namespace Orly::Indy::Fiber;
+
+static const size_t BlockSize = Disk::Util::PhysicalBlockSize;
+
+Orly::Indy::Util::TPool L0::TManager::TRepo::TMapping::Pool(sizeof(TRepo::TMapping), "Repo Mapping");
+Orly::Indy::Util::TPool L0::TManager::TRepo::TMapping::TEntry::Pool(sizeof(TRepo::TMapping::TEntry), "Repo Mapping Entry");
+Orly::Indy::Util::TPool L0::TManager::TRepo::TDataLayer::Pool(sizeof(TMemoryLayer), "Data Layer");
+
+Orly::Indy::Util::TPool TUpdate::Pool(sizeof(TUpdate), "Update", 100000UL);
+Orly::Indy::Util::TPool TUpdate::TEntry::Pool(sizeof(TUpdate::TEntry), "Entry", 100000UL);
+Disk::TBufBlock::TPool Disk::TBufBlock::Pool(BlockSize, 2000UL);
+
+static const size_t NumFlushes = 100UL;
+static const size_t KeysPerFlush = 500UL;
+static const int64_t KeySpace = 20000L;
+
+/* A data file standing in for a disk layer. */
+class TSimLayer {
+  public:
+
+  TSimLayer(size_t gen_id, size_t num_keys, size_t num_bytes) : GenId(gen_id), NumKeys(num_keys), NumBytes(num_bytes) {}
+
+  size_t GenId;
+
+  size_t NumKeys;
+
+  size_t NumBytes;
+
+};  // TSimLayer
+
+/* Find the size, in bytes, of the given data file. */
+static size_t GetNumBytes(Sim::TMemEngine &mem_engine, const TUuid &file_id, size_t gen_id) {
+  size_t starting_block, starting_block_offset, file_length, num_keys;
+  if (!mem_engine.GetEngine()->FindFile(file_id, gen_id, starting_block, starting_block_offset, file_length, num_keys)) {
+    throw logic_error("missing data file");
+  }
+  return file_length;
+}
+
+static void Simulate(const char *name, const TCompactionPolicy &policy) {
+  TFiberTestRunner runner([name, &policy](std::mutex &mut, std::condition_variable &cond, bool &fin, Fiber::TRunner::TRunnerCons &) {
+    TScheduler scheduler(TScheduler::TPolicy(4, 10, milliseconds(10)));
+    Sim::TMemEngine mem_engine(&scheduler,
+                               1024 /* disk space: 1GB */,
+                               256 /* slow disk space: 256MB */,
+                               16384 /* page cache slots: 64MB */,
+                               1 /* num page lru */,
+                               1024 /* block cache slots: 64MB */,
+                               1 /* num block lru */);
+    const TUuid file_id(TUuid::Best), index_id(TUuid::Twister);
+    TSequenceNumber seq_num = 0UL;
+    size_t next_gen_id = 0UL, flushed_bytes = 0UL, merged_bytes = 0UL, total_layers = 0UL, max_layers = 0UL;
+    vector<TSimLayer> layers;
+    map<int64_t, TSequenceNumber> live;
+    for (size_t flush = 0; flush < NumFlushes; ++flush) {
+      /* flush a batch of updates */ {
+        TMockMem mem_layer;
+        for (size_t i = 0; i < KeysPerFlush; ++i) {
+          const int64_t key = rand() % KeySpace;
+          live[key] = ++seq_num;
+          Insert(mem_layer, seq_num, index_id, static_cast<int64_t>(seq_num), key, string("customer"));
+        }
+        TDataFile data_file(mem_engine.GetEngine(), TVolume::TDesc::Fast, &mem_layer, file_id, ++next_gen_id, 20UL, 0U, Medium);
+        layers.emplace_back(next_gen_id, data_file.GetNumKeys(), GetNumBytes(mem_engine, file_id, next_gen_id));
+        flushed_bytes += layers.back().NumBytes;
+      }
+      /* merge until the policy is happy */
+      for (;;) {
+        vector<TCompactionPolicy::TLayer> policy_layers;
+        for (const auto &layer: layers) {
+          policy_layers.emplace_back(layer.NumKeys, true);
+        }
+        size_t begin, end;
+        if (!policy.TryChoose(policy_layers, begin, end)) {
+          break;
+        }
+        vector<size_t> gen_vec;
+        for (size_t i = begin; i < end; ++i) {
+          gen_vec.push_back(layers[i].GenId);
+        }
+        TMergeDataFile merge_file(mem_engine.GetEngine(), TVolume::TDesc::Fast, file_id, gen_vec, file_id, ++next_gen_id, 0U, Low, 16384, 20UL, false, false);
+        TSimLayer merged(next_gen_id, merge_file.GetNumKeys(), GetNumBytes(mem_engine, file_id, next_gen_id));
+        merged_bytes += merged.NumBytes;
+        layers.erase(layers.begin() + begin + 1, layers.begin() + end);
+        layers[begin] = merged;
+      }
+      total_layers += layers.size();
+      max_layers = max(max_layers, layers.size());
+    }
+    size_t live_bytes = 0UL;
+    for (const auto &layer: layers) {
+      live_bytes += layer.NumBytes;
+    }
+    /* the smallest the data could be: just the latest update to each key */ {
+      TMockMem mem_layer;
+      for (const auto &item: live) {
+        Insert(mem_layer, item.second, index_id, static_cast<int64_t>(item.second), item.first, string("customer"));
+      }
+      TDataFile data_file(mem_engine.GetEngine(), TVolume::TDesc::Fast, &mem_layer, file_id, ++next_gen_id, 20UL, 0U, Medium);
+    }
+    const size_t compact_bytes = GetNumBytes(mem_engine, file_id, next_gen_id);
+    printf(
+        "%-8s read amp %5.2f avg, %2zu max; write amp %5.2f; space amp %5.2f\n", name,
+        static_cast<double>(total_layers) / NumFlushes, max_layers,
+        static_cast<double>(flushed_bytes + merged_bytes) / flushed_bytes, static_cast<double>(live_bytes) / compact_bytes);
+    std::lock_guard<std::mutex> lock(mut);
+    fin = true;
+    cond.notify_one();
+  });
+}
+
+FIXTURE(Tiered) {
+  Simulate("tiered", TTieredCompactionPolicy());
+}
+
+FIXTURE(Leveled) {
+  Simulate("leveled", TLeveledCompactionPolicy(4, 10, 1000));
+}
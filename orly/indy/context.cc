@@ -44,7 +44,7 @@ static void CheckDestroyKeyCursor() {
 #endif
 
 TContext::TContext(const Indy::L0::TManager::TPtr<TRepo> &private_repo, Atom::TCore::TExtensibleArena *arena)
-    : TContextBase(arena), KeyCursorCollection(this), WalkerCount(0UL) {
+    : TContextBase(arena), KeyCursorCollection(this), WalkerCount(0UL), ReadLog(nullptr) {
   Indy::L0::TManager::TPtr<L0::TManager::TRepo> cur_repo = private_repo;
   RepoTree.push_back(make_pair(private_repo, make_unique<TRepo::TView>(private_repo)));
   for (;cur_repo->GetParentRepo(); cur_repo = *cur_repo->GetParentRepo()) {
@@ -56,6 +56,9 @@ TContext::TContext(const Indy::L0::TManager::TPtr<TRepo> &private_repo, Atom::TC
 TContext::~TContext() {}
 
 Indy::TKey TContext::operator[](const Indy::TIndexKey &index_key) {
+  if (ReadLog) {
+    ReadLog->KeyHashes.insert(index_key.GetHash());
+  }
   /* check to see if any of our current key cursors are on this key.
      We're doing this as a quick fix to the fact that we've lost which cursor (if any) this key
      originated from in the code gen. (loss of information). */
@@ -71,9 +74,9 @@ Indy::TKey TContext::operator[](const Indy::TIndexKey &index_key) {
      key (as opposed to one generated by the "keys" expression), or we've manipulated / collected keys
      to the point where the cursor has advanced past what we're trying to read. */
   ++WalkerCount;
-  TPresentWalker walker(this, RepoTree, index_key);
-  if (walker) {
-    const Indy::TPresentWalker::TItem &item = *walker;
+  unique_ptr<Indy::TPresentWalker> walker;
+  Indy::TPresentWalker::TItem item;
+  if (FindPresent(index_key, walker, item) && !item.Op.IsTombstone()) {
     return Indy::TKey(Atom::TCore(GetArena(), alloca(Sabot::State::GetMaxStateSize()), item.OpArena, item.Op), GetArena());
   }
   /* We return an empty var here because in the case of an optional type being returned, the result is "empty" not a throw.
@@ -82,13 +85,31 @@ Indy::TKey TContext::operator[](const Indy::TIndexKey &index_key) {
 }
 
 bool TContext::Exists(const Indy::TIndexKey &key) {
+  if (ReadLog) {
+    ReadLog->KeyHashes.insert(key.GetHash());
+  }
   ++WalkerCount;
-  TPresentWalker walker(this, RepoTree, key);
-  return static_cast<bool>(walker);
+  unique_ptr<Indy::TPresentWalker> walker;
+  Indy::TPresentWalker::TItem item;
+  return FindPresent(key, walker, item) && !item.Op.IsTombstone();
+}
+
+bool TContext::FindPresent(const Indy::TIndexKey &key, unique_ptr<Indy::TPresentWalker> &walker, Indy::TPresentWalker::TItem &item) {
+  assert(this);
+  PresentWalkConsTimer.Start();
+  bool found = false;
+  for (const auto &iter : RepoTree) {
+    if (iter.first->FindPresent(iter.second, key, walker, item)) {
+      found = true;
+      break;
+    }
+  }
+  PresentWalkConsTimer.Stop();
+  return found;
 }
 
 TContext::TPresentWalker::TPresentWalker(TContext *ctx, const TRepoTree &repo_tree, const TIndexKey &key)
-    : MinHeap(repo_tree.size()),
+    : LoserTree(repo_tree.size()),
       Valid(false) {
   assert(Fiber::TFrame::LocalFramePool);
   size_t pos = 0;
@@ -102,17 +123,17 @@ TContext::TPresentWalker::TPresentWalker(TContext *ctx, const TRepoTree &repo_tr
   for (auto &walker_ptr : WalkerVec) {
     Indy::TPresentWalker &walker = *walker_ptr;
     if (walker) {
-      MinHeap.Insert(*walker, pos);
+      LoserTree.Insert(*walker, pos);
     }
     ++pos;
   }
-  Valid = static_cast<bool>(MinHeap);
+  Valid = static_cast<bool>(LoserTree);
   Refresh();
   ctx->PresentWalkConsTimer.Stop();
 }
 
 TContext::TPresentWalker::TPresentWalker(TContext *ctx, const TRepoTree &repo_tree, const TIndexKey &from, const TIndexKey &to)
-    : MinHeap(repo_tree.size()),
+    : LoserTree(repo_tree.size()),
       Valid(false) {
   ctx->PresentWalkConsTimer.Start();
   size_t pos = 0;
@@ -120,11 +141,11 @@ TContext::TPresentWalker::TPresentWalker(TContext *ctx, const TRepoTree &repo_tr
     WalkerVec.emplace_back(iter.first->NewPresentWalker(iter.second, from, to, false));
     Indy::TPresentWalker &walker = *WalkerVec.back();
     if (walker) {
-      MinHeap.Insert(*walker, pos);
+      LoserTree.Insert(*walker, pos);
     }
     ++pos;
   }
-  Valid = static_cast<bool>(MinHeap);
+  Valid = static_cast<bool>(LoserTree);
   Refresh();
   ctx->PresentWalkConsTimer.Stop();
 }
@@ -133,29 +154,41 @@ TContext::TPresentWalker::~TPresentWalker() {}
 
 void TContext::TPresentWalker::Refresh() {
   assert(this);
-  bool done = false;
-  size_t pos;
+  /* Each repo numbers its own updates, so the tree's ordering by sequence number can't tell us which of several repos'
+     ops on a key is current.  Instead, as in FindPresent(), a repo's op shadows its parent's.  The tree hands us all the
+     ops on a key one after another, so we take them all and keep the one from the child-most repo, which is the one
+     earliest in our walker vector.  Then we stop if it's live, or move on to the next key if it's a tombstone. */
+  size_t pos, item_pos = 0;
+  bool has_item = false;
   while (Valid) {
-    const Indy::TPresentWalker::TItem &cur_item = MinHeap.Pop(pos);
+    const Indy::TPresentWalker::TItem &cur_item = LoserTree.Pop(pos);
     Indy::TPresentWalker &walker = *WalkerVec[pos];
     assert((*walker).KeyArena == cur_item.KeyArena);
     assert((*walker).OpArena == cur_item.OpArena);
     assert((*walker).SequenceNumber == cur_item.SequenceNumber);
     if (Item.KeyArena == nullptr || (Indy::TKey::TupleNeEq(Item.Key, Item.KeyArena, cur_item.Key, cur_item.KeyArena))) {
       Item = cur_item;
-      if (!Item.Op.IsTombstone()) {
-        done = true;
-      }
+      item_pos = pos;
+      has_item = true;
+    } else if (has_item && pos < item_pos) {
+      Item = cur_item;
+      item_pos = pos;
     }
     ++walker;
     if (walker) {
-      MinHeap.Insert(*walker, pos);
+      LoserTree.Insert(*walker, pos);
     }
-    if (!done) {
-      Valid = static_cast<bool>(MinHeap);
-    } else {
+    if (LoserTree) {
+      size_t next_pos;
+      const Indy::TPresentWalker::TItem &next_item = LoserTree.Peek(next_pos);
+      if (!Indy::TKey::TupleNeEq(Item.Key, Item.KeyArena, next_item.Key, next_item.KeyArena)) {
+        continue;
+      }
+    }
+    if (has_item && !Item.Op.IsTombstone()) {
       break;
     }
+    Valid = static_cast<bool>(LoserTree);
   }
 }
 
@@ -167,6 +200,9 @@ TContext::TKeyCursor::TKeyCursor(TContext *context, const Indy::TIndexKey &patte
       Csr(context, context->RepoTree, Key),
       ContextMembership(this) {
   ++(context->WalkerCount);
+  if (context->ReadLog) {
+    context->ReadLog->IndexIds.insert(pattern.GetIndexId());
+  }
 }
 
 TContext::TKeyCursor::TKeyCursor(TContext *context, const Indy::TIndexKey &from, const Indy::TIndexKey &to)
@@ -178,6 +214,9 @@ TContext::TKeyCursor::TKeyCursor(TContext *context, const Indy::TIndexKey &from,
       Csr(context, context->RepoTree, Key, To),
       ContextMembership(this) {
   ++(context->WalkerCount);
+  if (context->ReadLog) {
+    context->ReadLog->IndexIds.insert(from.GetIndexId());
+  }
 }
 
 TContext::TKeyCursor::~TKeyCursor() {
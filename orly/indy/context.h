@@ -90,7 +90,7 @@ namespace Orly {
         std::vector<std::shared_ptr<Indy::TPresentWalker>> WalkerVec;
 
         /* TODO */
-        Util::TMinHeap<Indy::TPresentWalker::TItem, size_t> MinHeap;
+        Util::TLoserTree<Indy::TPresentWalker::TItem, size_t, std::less<Indy::TPresentWalker::TItem>, Indy::TPresentWalker::TItem::TPrefixer> LoserTree;
 
         /* TODO */
         bool Valid;
@@ -163,6 +163,31 @@ namespace Orly {
 
       };  // TKeyCursor
 
+      /* What a context has read: the keys it looked up directly and the indexes it walked.  We keep hashes rather than
+         keys so the log can outlive the arenas the keys live in; a collision can only make a conflict check more
+         cautious. */
+      class TReadLog {
+        NO_COPY(TReadLog);
+        public:
+
+        /* TODO */
+        TReadLog() {}
+
+        /* Forget everything. */
+        void Clear() {
+          assert(this);
+          KeyHashes.clear();
+          IndexIds.clear();
+        }
+
+        /* The hashes of the index keys we looked up. */
+        std::unordered_set<size_t> KeyHashes;
+
+        /* The ids of the indexes we walked with a key cursor.  We don't try to narrow these down to a range. */
+        std::unordered_set<Base::TUuid> IndexIds;
+
+      };  // TReadLog
+
       /* TODO */
       TContext(const Indy::L0::TManager::TPtr<TRepo> &private_repo, Atom::TCore::TExtensibleArena *arena);
 
@@ -187,11 +212,23 @@ namespace Orly {
         return PresentWalkConsTimer;
       }
 
+      /* Record everything we read from now on in the given log, or stop recording if it's null.  The log must outlive
+         its use here. */
+      void SetReadLog(TReadLog *read_log) {
+        assert(this);
+        ReadLog = read_log;
+      }
+
       /* TODO */
       TKeyCursorCollection::TImpl KeyCursorCollection;
 
       private:
 
+      /* Find the most recent op on the given key, tombstones included, and return true, or return false if no repo
+         has anything on it.  We ask our own repo first and then its ancestors, and stop at the first which has an
+         answer; a repo's op on a key shadows any its parent has.  The item stays good for as long as the walker does. */
+      bool FindPresent(const Indy::TIndexKey &key, std::unique_ptr<Indy::TPresentWalker> &walker, Indy::TPresentWalker::TItem &item);
+
       /* TODO */
       TRepoTree RepoTree;
 
@@ -201,6 +238,9 @@ namespace Orly {
       /* TODO */
       Base::TTimer PresentWalkConsTimer;
 
+      /* See SetReadLog().  May be null. */
+      TReadLog *ReadLog;
+
       /* TODO */
       friend class TIndyContext;
 
@@ -279,7 +319,7 @@ namespace Orly {
     inline TContext::TPresentWalker &TContext::TPresentWalker::operator++() {
       assert(this);
       assert(Valid);
-      Valid = static_cast<bool>(MinHeap);
+      Valid = static_cast<bool>(LoserTree);
       Refresh();
       return *this;
     }
@@ -21,6 +21,7 @@
 #include <orly/indy/disk/in_file.h>
 #include <orly/indy/disk/indy_util_reporter.h>
 #include <orly/indy/disk/read_file.h>
+#include <orly/indy/disk/util/bloom_filter.h>
 #include <orly/indy/disk/util/hash_util.h>
 
 using namespace std;
@@ -167,6 +168,9 @@ class TIndexFile
         NumHistKeys(0UL),
         EndOfHistoryStream(0UL),
         FileSize(0UL),
+        ByteOffsetOfBloomFilter(0UL),
+        NumBloomFilterWords(0UL),
+        NumBloomFilterProbes(0UL),
         TempFileConsolThresh(temp_file_consol_thresh),
         ExampleKey(example_key),
         #ifndef NDEBUG
@@ -203,6 +207,9 @@ class TIndexFile
       meta_stream << NumHistKeys;  // # History Keys
       meta_stream << ByteOffsetOfKeyIndex;  // Current Key Offset
       meta_stream << NumHashTables;  // # of hash indexes (n)
+      meta_stream << ByteOffsetOfBloomFilter;  // Bloom filter offset
+      meta_stream << NumBloomFilterWords;  // # bloom filter words
+      meta_stream << NumBloomFilterProbes;  // # bloom filter probes
 
       #if 0
       stringstream ss;
@@ -215,6 +222,7 @@ class TIndexFile
       ss << "\tNumHistKeys = " << NumHistKeys << std::endl;
       ss << "\tByteOffsetOfKeyIndex = " << ByteOffsetOfKeyIndex << std::endl;
       ss << "\tNumHashTables = " << NumHashTables << std::endl;
+      ss << "\tNumBloomFilterWords = " << NumBloomFilterWords << std::endl;
       std::cout << ss.str();
       #endif
 
@@ -307,6 +315,10 @@ class TIndexFile
   TDataFile::TBlockVec *BlockVec;
   size_t FileSize;
 
+  size_t ByteOffsetOfBloomFilter;
+  size_t NumBloomFilterWords;
+  size_t NumBloomFilterProbes;
+
   size_t TempFileConsolThresh;
 
   TDataFile::TRemapIndex ArenaRemapIndex;
@@ -332,6 +344,9 @@ class TIndexFile
      # History Keys
      Current Key Offset
      # of hash indexes (n)
+     Bloom filter offset
+     # bloom filter words
+     # bloom filter probes
 
      (n) (size_t) -> (size_t) hash index offset -> num hash fields pairings
   */
@@ -401,7 +416,7 @@ void TIndexFile::PrepKeyRange(TDataFile::TUpdateCollector *update_collector, TDa
   for (size_t i = 0; i < num_tuple_fields; ++i) {
     HashCollectorVec.emplace_back(new THashCollector(HERE, Source::DataFileHashIndex, TempFileConsolThresh, StorageSpeed, Engine, true));
   }
-  const size_t bytes_of_metadata = (TData::NumMetaFields * sizeof(size_t)) + (NumHashTables * sizeof(size_t) * 2UL) + (ArenaTypeBoundaryOffsetVec.size() * sizeof(size_t));
+  const size_t bytes_of_metadata = (NumMetaFields * sizeof(size_t)) + (NumHashTables * sizeof(size_t) * 2UL) + (ArenaTypeBoundaryOffsetVec.size() * sizeof(size_t));
   if (bytes_of_metadata >= Disk::Util::LogicalBlockSize) {
     throw std::runtime_error("Index metadata >= 1 block");
   }
@@ -584,6 +599,7 @@ void TIndexFile::FlushHashes() {
   size_t total_bytes_required = 0UL;
   unordered_map<size_t, shared_ptr<const TBufBlock>> collision_map {};
   size_t hash_index_byte_offset = BlockVec->Size() * Disk::Util::LogicalBlockSize;
+  size_t num_bloom_entries = 0UL;
   for (const auto &collection : HashCollectorVec) {
     /* collision at beginning of this hash index */
     auto ret = collision_map.insert(make_pair((hash_index_byte_offset + total_bytes_required) / Disk::Util::LogicalBlockSize, nullptr));
@@ -593,6 +609,7 @@ void TIndexFile::FlushHashes() {
     size_t num_hash_fields = Disk::Util::SuggestHashSize(collection->GetSize());
     NumHashFieldsByOffset.emplace_back(hash_index_byte_offset + total_bytes_required, num_hash_fields);
     total_bytes_required += num_hash_fields * TDataFile::HashEntrySize;
+    num_bloom_entries += collection->GetSize();
     /* collision at end of this hash index (if the block doesn't get filled completely) */
     if ((hash_index_byte_offset + total_bytes_required) % Disk::Util::LogicalBlockSize != 0) {
       ret = collision_map.insert(make_pair((hash_index_byte_offset + total_bytes_required) / Disk::Util::LogicalBlockSize, nullptr));
@@ -602,17 +619,33 @@ void TIndexFile::FlushHashes() {
     }
   }
   assert(NumHashFieldsByOffset.size() == NumHashTables);
+  /* the bloom filter follows the last hash index */
+  Disk::Util::TBloomFilter bloom_filter(num_bloom_entries);
+  ByteOffsetOfBloomFilter = hash_index_byte_offset + total_bytes_required;
+  NumBloomFilterWords = bloom_filter.GetNumWords();
+  NumBloomFilterProbes = bloom_filter.GetNumProbes();
+  total_bytes_required += bloom_filter.GetNumBytes();
+  /* collision at end of the bloom filter */
+  if ((hash_index_byte_offset + total_bytes_required) % Disk::Util::LogicalBlockSize != 0) {
+    auto ret = collision_map.insert(make_pair((hash_index_byte_offset + total_bytes_required) / Disk::Util::LogicalBlockSize, nullptr));
+    if (ret.second) { // fresh insert
+      ret.first->second = std::shared_ptr<const TBufBlock>(new TBufBlock());
+    }
+  }
   size_t max_blocks_required = ceil(static_cast<double>(total_bytes_required) / Disk::Util::LogicalBlockSize);
 
   Engine->AppendReserveBlocks(StorageSpeed, max_blocks_required, *BlockVec);
   TCompletionTrigger completion_trigger;
+  size_t num_prefix_fields = 0UL;
   for (const auto &collection : HashCollectorVec) {
+    ++num_prefix_fields;
     size_t num_hash_fields = Disk::Util::SuggestHashSize(collection->GetSize());
     /* make a new index with the hashes modded by the hash field size */
     THashCollector modded_hash_collector(HERE, Source::DataFileHashIndex, TempFileConsolThresh, StorageSpeed, Engine, true);
     for (THashCollector::TCursor orig_csr(collection.get(), 32UL); orig_csr; ++orig_csr) {
       const THashObj &obj = *orig_csr;
       modded_hash_collector.Emplace(obj.Core, obj.Hash % num_hash_fields, obj.Offset);
+      bloom_filter.Add(num_prefix_fields, obj.Hash);
     }
     THashCollector::TCursor hash_csr(&modded_hash_collector, 32UL);
     /* do the first pass over the hash map */ {
@@ -732,6 +765,24 @@ void TIndexFile::FlushHashes() {
     }
     hash_index_byte_offset += num_hash_fields * TDataFile::HashEntrySize;
   }
+  /* write the bloom filter */ {
+    assert(hash_index_byte_offset == ByteOffsetOfBloomFilter);
+    TDataFile::TDataOutStream stream(HERE,
+                                     Source::DataFileHashIndex,
+                                     Engine->GetVolMan(),
+                                     ByteOffsetOfBloomFilter,
+                                     *BlockVec,
+                                     collision_map,
+                                     completion_trigger,
+                                     Priority,
+                                     true
+                                     #ifndef NDEBUG
+                                     ,WrittenBlockSet
+                                     #endif
+                                     );
+    stream.Write(bloom_filter.GetData(), bloom_filter.GetNumBytes());
+    FileSize = stream.GetOffset();
+  }
   /* flush collision blocks */ {
     for (auto iter : collision_map) {
       assert(iter.first < BlockVec->Size());
@@ -1042,6 +1093,7 @@ TDataFile::TDataFile(Util::TEngine *engine,
     size_t num_meta_blocks = 0UL;
     /* compute / write out the meta-data */ {
       /*
+        format magic and version
         # of blocks
         # of meta-blocks (n)
         # of #block / block_id pairings (number of sequential blocks starting at) (m)
@@ -1093,6 +1145,7 @@ TDataFile::TDataFile(Util::TEngine *engine,
                             ,WrittenBlockSet
                             #endif
                             );
+      stream << (TData::FormatMagic | TData::FormatVersion);  // format magic and version
       stream << BlockVec.Size();  // # of blocks
       stream << num_meta_blocks;  // # of meta-blocks
       stream << num_sequential_block_pairings;  // # of #block / block_id pairings
@@ -169,6 +169,7 @@ namespace Orly {
         /* ptr to key */
         static const size_t UpdateKeyPtrSize = sizeof(size_t);
         /*
+        format magic and version
         # of blocks
         # of meta-blocks (n)
         # of #block / block_id pairings (number of sequential blocks starting at) (m)
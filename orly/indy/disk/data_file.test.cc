@@ -154,6 +154,16 @@ FIXTURE(Deep) {
       EXPECT_TRUE(int_str_decint_decstr_idx_file.FindInHash(TKey(make_tuple(1L, string("Orly"), TDesc<int64_t>(1L), TDesc<string>("short")), &arena, state_alloc), out_offset, in_stream, &int_str_decint_decstr_idx_arena));
       EXPECT_TRUE(int_str_decint_decstr_idx_file.FindInHash(TKey(make_tuple(1L, string("Orly"), TDesc<int64_t>(1L), TDesc<string>("This string should be too long to fit in a core")), &arena, state_alloc), out_offset, in_stream, &int_str_decint_decstr_idx_arena));
       EXPECT_TRUE(int_str_int_str_idx_file.FindInHash(TKey(make_tuple(1L, string("Orly"), 1L, string("short")), &arena, state_alloc), out_offset, in_stream, &int_str_int_str_idx_arena));
+      /* the bloom filter turns away keys which aren't in the file, but not prefixes which are */ {
+        const size_t prev_reject_count = Disk::Util::TBloomFilter::RejectCount;
+        size_t num_found = 0UL;
+        for (int64_t i = 100L; i < 200L; ++i) {
+          num_found += int_str_int_str_idx_file.FindInHash(TKey(make_tuple(i, string("Orly"), 1L, string("short")), &arena, state_alloc), out_offset, in_stream, &int_str_int_str_idx_arena) ? 1UL : 0UL;
+        }
+        EXPECT_EQ(num_found, 0UL);
+        EXPECT_GE(Disk::Util::TBloomFilter::RejectCount - prev_reject_count, 90UL);
+        EXPECT_TRUE(int_str_int_str_idx_file.FindInHash(TKey(make_tuple(1L, string("Orly"), Native::TFree<int64_t>(), Native::TFree<string>()), &arena, state_alloc), out_offset, in_stream, &int_str_int_str_idx_arena));
+      }
       /* check the <[int64_t, string, desc<int64_t>, desc<string>]> index */ {
         //TReader::TIndexFile idx_file(&reader, int_str_decint_decstr_idx, RealTime);
         std::vector<std::pair<TKey, TKey>> expected_vec;
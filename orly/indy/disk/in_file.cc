@@ -18,9 +18,26 @@
 
 #include <orly/indy/disk/in_file.h>
 
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
 using namespace Orly::Atom;
 using namespace Orly::Indy::Disk;
 
 static_assert(sizeof(TCore) == 24, "NullCore must be set to right number of zero'd out bytes");
 const uint8_t TData::NullCore[sizeof(TCore)] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-const TCore TData::TombstoneCore = TData::GetTombstoneCore();
\ No newline at end of file
+const TCore TData::TombstoneCore = TData::GetTombstoneCore();
+
+void TData::CheckFormat(size_t magic_and_version) {
+  static const size_t MagicMask = 0xFFFFFFFF00000000UL;
+  if ((magic_and_version & MagicMask) != FormatMagic) {
+    throw runtime_error("data file predates format versioning; it must be rewritten before this version can read it");
+  }
+  size_t version = magic_and_version & ~MagicMask;
+  if (version != FormatVersion) {
+    ostringstream strm;
+    strm << "data file is format version " << version << "; expected version " << FormatVersion;
+    throw runtime_error(strm.str());
+  }
+}
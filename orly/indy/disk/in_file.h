@@ -52,24 +52,37 @@ namespace Orly {
         /* TODO */
         static const size_t UpdateKeyPtrSize = sizeof(size_t);
 
+        /* The first meta field of every data file is this, or'd with the version of the format the file was written in.
+           A file written before we versioned the format starts with its block count instead, which is far too small to
+           have anything in its upper half, so we can tell it apart. */
+        static const size_t FormatMagic = 0x4F524C5900000000UL;  // "ORLY"
+
+        /* The version of the format we write, and the only one we read.  Version 1 was the unversioned format.
+           Version 2 added the bloom filter fields to the index meta-data. */
+        static const size_t FormatVersion = 2UL;
+
+        /* Throw if the given first meta field isn't FormatMagic or'd with FormatVersion. */
+        static void CheckFormat(size_t magic_and_version);
+
         /* TODO */
-        static const size_t NumMetaFields = 10U;
+        static const size_t NumMetaFields = 11U;
         /*
-           1.  # of blocks
-           2.  # of meta-blocks (n)
-           3.  # of #block / block_id pairings (number of sequential blocks starting at) (m)
-           4.  # updates
-           5.  # index segments (p)
-           6.  # of arena notes
-           7.  # of arena bytes
-           8.  # of arena type boundaries
-           9.  offset of main arena
-           10.  offset of update index
+           1.  format magic and version
+           2.  # of blocks
+           3.  # of meta-blocks (n)
+           4.  # of #block / block_id pairings (number of sequential blocks starting at) (m)
+           5.  # updates
+           6.  # index segments (p)
+           7.  # of arena notes
+           8.  # of arena bytes
+           9.  # of arena type boundaries
+           10.  offset of main arena
+           11.  offset of update index
 
         */
 
         /* TODO */
-        static const size_t NumIndexMetaFields = 8U;
+        static const size_t NumIndexMetaFields = 11U;
         /*
            Offset of Arena
            # arena notes
@@ -79,6 +92,9 @@ namespace Orly {
            # History Keys
            Current Key Offset
            # of hash indexes (n)
+           Bloom filter offset
+           # bloom filter words
+           # bloom filter probes
 
            (n) (size_t) -> (size_t) hash index offset -> num hash fields pairings
         */
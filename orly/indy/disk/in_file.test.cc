@@ -109,4 +109,22 @@ FIXTURE(Stream) {
     fin = true;
     cond.notify_one();
   });
-}
\ No newline at end of file
+}
+/* Return true iff. CheckFormat() throws on the given first meta field. */
+static bool IsRejected(size_t magic_and_version) {
+  try {
+    TData::CheckFormat(magic_and_version);
+  } catch (const std::runtime_error &) {
+    return true;
+  }
+  return false;
+}
+
+FIXTURE(CheckFormat) {
+  EXPECT_FALSE(IsRejected(TData::FormatMagic | TData::FormatVersion));
+  /* An unversioned file starts with its block count. */
+  EXPECT_TRUE(IsRejected(0UL));
+  EXPECT_TRUE(IsRejected(12345UL));
+  EXPECT_TRUE(IsRejected(TData::FormatMagic | (TData::FormatVersion - 1UL)));
+  EXPECT_TRUE(IsRejected(TData::FormatMagic | (TData::FormatVersion + 1UL)));
+}
@@ -18,9 +18,12 @@
 
 #include <orly/indy/disk/merge_data_file.h>
 
+#include <exception>
+
+#include <orly/indy/disk/util/bloom_filter.h>
 #include <orly/indy/disk/util/hash_util.h>
 #include <orly/indy/util/block_vec.h>
-#include <orly/indy/util/min_heap.h>
+#include <orly/indy/util/loser_tree.h>
 
 using namespace std;
 using namespace Base;
@@ -52,13 +55,15 @@ class TMergeDataFileImpl {
                      TSequenceNumber /*release_up_to*/,
                      DiskPriority priority,
                      size_t max_block_cache_read_slots_allowed,
-                     size_t temp_file_consol_thresh)
+                     size_t temp_file_consol_thresh,
+                     const std::vector<Fiber::TRunner *> &runner_vec)
       : Engine(engine),
         StorageSpeed(storage_speed),
         UpdateIndexStorageSpeed(TVolume::TDesc::TStorageSpeed::Slow),
         SorterStorageSpeed(TVolume::TDesc::TStorageSpeed::Slow),
         Priority(priority),
         MaxBlockCacheReadSlotsAllowed(max_block_cache_read_slots_allowed),
+        RunnerVec(runner_vec),
         MainArenaByteOffset(0UL),
         NumUpdates(0UL),
         NumKeys(0UL),
@@ -284,15 +289,14 @@ class TMergeDataFileImpl {
           std::vector<std::unique_ptr<typename TReader::TIndexFile::TKeyCursor>> cur_key_cursor_vec;
           std::vector<std::unique_ptr<typename TReader::TIndexFile::THistoryKeyCursor>> hist_key_cursor_vec;
           std::vector<size_t> history_key_cur_idx_vec(source_file_vec.size(), 0UL);
-          Orly::Indy::Util::TMinHeap<TSortedKey, size_t> min_heap(source_file_vec.size() * 2);
+          Orly::Indy::Util::TLoserTree<TSortedKey, size_t, std::less<TSortedKey>, typename TSortedKey::TPrefixer> loser_tree(source_file_vec.size() * 2);
           std::vector<TSortedKey> sorted_key_vec(source_file_vec.size() * 2);
 
-          std::vector<std::unique_ptr<TMergeDataFileImpl::TRemapAccessSorter>> key_access_sorter_vec;
-          std::vector<std::unique_ptr<TMergeDataFileImpl::TRemapResolvedSorter>> key_resolved_sorter_vec;
-          std::vector<std::unique_ptr<typename TMergeDataFileImpl::TRemapResolvedSorter::TCursor>> key_resolved_sorter_cursor_vec;
-          std::vector<std::unique_ptr<TMergeDataFileImpl::TRemapAccessSorter>> val_access_sorter_vec;
-          std::vector<std::unique_ptr<TMergeDataFileImpl::TRemapResolvedSorter>> val_resolved_sorter_vec;
-          std::vector<std::unique_ptr<typename TMergeDataFileImpl::TRemapResolvedSorter::TCursor>> val_resolved_sorter_cursor_vec;
+          const size_t num_sources = source_file_vec.size();
+          std::vector<std::unique_ptr<TMergeDataFileImpl::TRemapResolvedSorter>> key_resolved_sorter_vec(num_sources * 2);
+          std::vector<std::unique_ptr<typename TMergeDataFileImpl::TRemapResolvedSorter::TCursor>> key_resolved_sorter_cursor_vec(num_sources * 2);
+          std::vector<std::unique_ptr<TMergeDataFileImpl::TRemapResolvedSorter>> val_resolved_sorter_vec(num_sources * 2);
+          std::vector<std::unique_ptr<typename TMergeDataFileImpl::TRemapResolvedSorter::TCursor>> val_resolved_sorter_cursor_vec(num_sources * 2);
           std::vector<size_t> read_file_vec_pos_by_source_pos;
           for (const auto &source_file : source_file_vec) {
             for (size_t i = 0; i < ReadFileVec.size(); ++i) {
@@ -303,111 +307,30 @@ class TMergeDataFileImpl {
             }
           }
           size_t pos = 0;
-          /* build the key access pattern */ {
-            size_t max_block_cache_read_slot_per_sub_cursor = MaxBlockCacheReadSlotsAllowed / (source_file_vec.size() * 4UL);
-            for (const auto &source_file : source_file_vec) {
-              /* current keys */ {
-                key_access_sorter_vec.push_back(make_unique<TMergeDataFileImpl::TRemapAccessSorter>(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true));
-                key_resolved_sorter_vec.push_back(make_unique<TMergeDataFileImpl::TRemapResolvedSorter>(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true));
-                val_access_sorter_vec.push_back(make_unique<TMergeDataFileImpl::TRemapAccessSorter>(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true));
-                val_resolved_sorter_vec.push_back(make_unique<TMergeDataFileImpl::TRemapResolvedSorter>(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true));
-                TMergeDataFileImpl::TRemapAccessSorter &key_access_sorter = *key_access_sorter_vec.back();
-                TMergeDataFileImpl::TRemapResolvedSorter &key_resolved_sorter = *key_resolved_sorter_vec.back();
-                TMergeDataFileImpl::TRemapSorter &key_remap_sorter = *idx_file.ArenaRemapSorterVec[pos / 2];
-                TMergeDataFileImpl::TRemapAccessSorter &val_access_sorter = *val_access_sorter_vec.back();
-                TMergeDataFileImpl::TRemapResolvedSorter &val_resolved_sorter = *val_resolved_sorter_vec.back();
-                TMergeDataFileImpl::TRemapSorter &val_remap_sorter = *main_remap_sorter_vec[read_file_vec_pos_by_source_pos[pos / 2]];
-                size_t idx = 0UL;
-                if (CanTail) {
-                  for (typename TReader::TIndexFile::TKeyCursor key_cursor(source_file.get()); key_cursor; ++key_cursor) {
-                    const typename TReader::TIndexFile::TKeyItem &item = *key_cursor;
-                    if (!CanTailTombstones || !item.Value.IsTombstone() || item.NumHistKeys > 0) {
-                      const Atom::TCore::TOffset *key_off = item.Key.TryGetOffset();
-                      if (key_off) {
-                        key_access_sorter.Emplace(++idx, *key_off);
-                      }
-                      const Atom::TCore::TOffset *val_off = item.Value.TryGetOffset();
-                      if (val_off) {
-                        val_access_sorter.Emplace(++idx, *val_off);
-                      }
-                    }
-                  }
-                } else {
-                  for (typename TReader::TIndexFile::TKeyCursor key_cursor(source_file.get()); key_cursor; ++key_cursor) {
-                    const typename TReader::TIndexFile::TKeyItem &item = *key_cursor;
-                    const Atom::TCore::TOffset *key_off = item.Key.TryGetOffset();
-                    if (key_off) {
-                      key_access_sorter.Emplace(++idx, *key_off);
-                    }
-                    const Atom::TCore::TOffset *val_off = item.Value.TryGetOffset();
-                    if (val_off) {
-                      val_access_sorter.Emplace(++idx, *val_off);
-                    }
-                  }
-                }
-                TMergeDataFileImpl::ResolveRemap(MaxBlockCacheReadSlotsAllowed, key_access_sorter, key_remap_sorter, key_resolved_sorter);
-                TMergeDataFileImpl::ResolveRemap(MaxBlockCacheReadSlotsAllowed, val_access_sorter, val_remap_sorter, val_resolved_sorter);
-                key_access_sorter_vec.back().reset(); /* reset the access sorter so we release the resources. */
-                val_access_sorter_vec.back().reset(); /* reset the access sorter so we release the resources. */
-                key_resolved_sorter_cursor_vec.push_back(std::make_unique<typename TMergeDataFileImpl::TRemapResolvedSorter::TCursor>(&key_resolved_sorter, max_block_cache_read_slot_per_sub_cursor));
-                val_resolved_sorter_cursor_vec.push_back(std::make_unique<typename TMergeDataFileImpl::TRemapResolvedSorter::TCursor>(&val_resolved_sorter, max_block_cache_read_slot_per_sub_cursor));
-              } /* finish access pattern for current keys */
-
-              ++pos;
-
-              /* history keys */ {
-                key_access_sorter_vec.push_back(make_unique<TMergeDataFileImpl::TRemapAccessSorter>(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true));
-                key_resolved_sorter_vec.push_back(make_unique<TMergeDataFileImpl::TRemapResolvedSorter>(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true));
-                val_access_sorter_vec.push_back(make_unique<TMergeDataFileImpl::TRemapAccessSorter>(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true));
-                val_resolved_sorter_vec.push_back(make_unique<TMergeDataFileImpl::TRemapResolvedSorter>(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true));
-                TMergeDataFileImpl::TRemapAccessSorter &key_access_sorter = *key_access_sorter_vec.back();
-                TMergeDataFileImpl::TRemapResolvedSorter &key_resolved_sorter = *key_resolved_sorter_vec.back();
-                TMergeDataFileImpl::TRemapSorter &key_remap_sorter = *idx_file.ArenaRemapSorterVec[pos / 2];
-                TMergeDataFileImpl::TRemapAccessSorter &val_access_sorter = *val_access_sorter_vec.back();
-                TMergeDataFileImpl::TRemapResolvedSorter &val_resolved_sorter = *val_resolved_sorter_vec.back();
-                TMergeDataFileImpl::TRemapSorter &val_remap_sorter = *main_remap_sorter_vec[read_file_vec_pos_by_source_pos[pos / 2]];
-                size_t idx = 0UL;
-                if (CanTail) {
-                  std::vector<bool> &hist_filter_vec = idx_file.HistoryKeeperFilterVec[pos / 2];
-                  assert(hist_filter_vec.size() == source_file->GetNumHistKeys());
-                  size_t cur_hist_offset = 0UL;
-                  for (typename TReader::TIndexFile::THistoryKeyCursor history_cursor(source_file.get()); history_cursor; ++history_cursor, ++cur_hist_offset) {
-                    assert(cur_hist_offset < hist_filter_vec.size());
-                    if (hist_filter_vec[cur_hist_offset]) {
-                      const typename TReader::TIndexFile::THistoryKeyItem &item = *history_cursor;
-                      const Atom::TCore::TOffset *key_off = item.Key.TryGetOffset();
-                      if (key_off) {
-                        key_access_sorter.Emplace(++idx, *key_off);
-                      }
-                      const Atom::TCore::TOffset *val_off = item.Value.TryGetOffset();
-                      if (val_off) {
-                        val_access_sorter.Emplace(++idx, *val_off);
-                      }
-                    }
-                  }
+          /* build the key access pattern.  The current and history halves of each source are independent of each
+             other and of the other sources', so we scan them in parallel.  Then each source's key patterns and its value
+             patterns are resolved in parallel.  (A source's two halves share a remap sorter, which isn't safe to read
+             from two runners at once, so they're resolved one after the other, in the same job.)  That's two jobs per
+             source in each phase, so a merge of few sources can't keep more runners than that busy. */ {
+            const size_t num_slots = num_sources * 2;
+            const size_t max_block_cache_read_slot_per_sub_cursor = MaxBlockCacheReadSlotsAllowed / (num_sources * 4UL);
+            std::vector<std::unique_ptr<TMergeDataFileImpl::TRemapAccessSorter>> key_access_sorter_vec(num_slots);
+            std::vector<std::unique_ptr<TMergeDataFileImpl::TRemapAccessSorter>> val_access_sorter_vec(num_slots);
+            RunJobs(num_slots, [&](size_t slot, size_t /*max_block_cache_read_slots_allowed*/) {
+              ScanSourceHalf(idx_file, slot, key_access_sorter_vec, val_access_sorter_vec);
+            });
+            RunJobs(num_sources * 2, [&](size_t job, size_t max_block_cache_read_slots_allowed) {
+              const size_t source_pos = job / 2;
+              for (size_t slot = source_pos * 2; slot < source_pos * 2 + 2; ++slot) {
+                if (job % 2 == 0) {
+                  ResolveSlot(slot, *idx_file.ArenaRemapSorterVec[source_pos], max_block_cache_read_slots_allowed, max_block_cache_read_slot_per_sub_cursor,
+                              key_access_sorter_vec, key_resolved_sorter_vec, key_resolved_sorter_cursor_vec);
                 } else {
-                  for (typename TReader::TIndexFile::THistoryKeyCursor history_cursor(source_file.get()); history_cursor; ++history_cursor) {
-                    const typename TReader::TIndexFile::THistoryKeyItem &item = *history_cursor;
-                    const Atom::TCore::TOffset *key_off = item.Key.TryGetOffset();
-                    if (key_off) {
-                      key_access_sorter.Emplace(++idx, *key_off);
-                    }
-                    const Atom::TCore::TOffset *val_off = item.Value.TryGetOffset();
-                    if (val_off) {
-                      val_access_sorter.Emplace(++idx, *val_off);
-                    }
-                  }
+                  ResolveSlot(slot, *main_remap_sorter_vec[read_file_vec_pos_by_source_pos[source_pos]], max_block_cache_read_slots_allowed, max_block_cache_read_slot_per_sub_cursor,
+                              val_access_sorter_vec, val_resolved_sorter_vec, val_resolved_sorter_cursor_vec);
                 }
-                TMergeDataFileImpl::ResolveRemap(MaxBlockCacheReadSlotsAllowed, key_access_sorter, key_remap_sorter, key_resolved_sorter);
-                TMergeDataFileImpl::ResolveRemap(MaxBlockCacheReadSlotsAllowed, val_access_sorter, val_remap_sorter, val_resolved_sorter);
-                key_access_sorter_vec.back().reset(); /* reset the access sorter so we release the resources. */
-                val_access_sorter_vec.back().reset(); /* reset the access sorter so we release the resources. */
-                key_resolved_sorter_cursor_vec.push_back(std::make_unique<typename TMergeDataFileImpl::TRemapResolvedSorter::TCursor>(&key_resolved_sorter, max_block_cache_read_slot_per_sub_cursor));
-                val_resolved_sorter_cursor_vec.push_back(std::make_unique<typename TMergeDataFileImpl::TRemapResolvedSorter::TCursor>(&val_resolved_sorter, max_block_cache_read_slot_per_sub_cursor));
-              } /* finish access pattern for history keys */
-
-              ++pos;
-            }
+              }
+            });
           }
           std::swap(idx_file.ResolvedKeySorterCursorVec, key_resolved_sorter_cursor_vec);
           std::swap(idx_file.ResolvedValSorterCursorVec, val_resolved_sorter_cursor_vec);
@@ -427,7 +350,7 @@ class TMergeDataFileImpl {
                   k.Core = item.Key;
                   k.Arena = disk_arena_vec[pos / 2].get();
                   k.SeqNum = item.SeqNum;
-                  min_heap.Insert(k, pos);
+                  loser_tree.Insert(k, pos);
                   break;
                 }
               }
@@ -438,7 +361,7 @@ class TMergeDataFileImpl {
                 k.Core = item.Key;
                 k.Arena = disk_arena_vec[pos / 2].get();
                 k.SeqNum = item.SeqNum;
-                min_heap.Insert(k, pos);
+                loser_tree.Insert(k, pos);
               }
             }
             ++pos;
@@ -454,7 +377,7 @@ class TMergeDataFileImpl {
                   k.Core = item.Key;
                   k.Arena = disk_arena_vec[pos / 2].get();
                   k.SeqNum = item.SeqNum;
-                  min_heap.Insert(k, pos);
+                  loser_tree.Insert(k, pos);
                   ++cur_hist_offset;
                   break;
                 }
@@ -466,16 +389,16 @@ class TMergeDataFileImpl {
                 k.Core = item.Key;
                 k.Arena = disk_arena_vec[pos / 2].get();
                 k.SeqNum = item.SeqNum;
-                min_heap.Insert(k, pos);
+                loser_tree.Insert(k, pos);
               }
             }
             ++pos;
           }
           idx_file.PrepKeyRange(max_key_count, &UpdateCollector);
           Base::TOpt<TKey> last_written;
-          while (min_heap) {
+          while (loser_tree) {
             size_t pos;
-            const TSortedKey &k = min_heap.Pop(pos);
+            const TSortedKey &k = loser_tree.Pop(pos);
             if (pos % 2 == 0) { /* came from a current source */
               typename TReader::TIndexFile::TKeyCursor &cur_csr = *cur_key_cursor_vec[pos / 2];
               assert(cur_csr);
@@ -506,7 +429,7 @@ class TMergeDataFileImpl {
                     k.Core = item.Key;
                     /* the arena should already be correct k.Arena = ... */
                     k.SeqNum = item.SeqNum;
-                    min_heap.Insert(k, pos);
+                    loser_tree.Insert(k, pos);
                     break;
                   }
                 }
@@ -517,7 +440,7 @@ class TMergeDataFileImpl {
                   k.Core = item.Key;
                   /* the arena should already be correct k.Arena = ... */
                   k.SeqNum = item.SeqNum;
-                  min_heap.Insert(k, pos);
+                  loser_tree.Insert(k, pos);
                 }
               }
             } else { /* came from a history source */
@@ -541,7 +464,7 @@ class TMergeDataFileImpl {
                     k.Core = item.Key;
                     /* the arena should already be correct k.Arena = ... */
                     k.SeqNum = item.SeqNum;
-                    min_heap.Insert(k, pos);
+                    loser_tree.Insert(k, pos);
                     ++cur_hist_offset;
                     break;
                   }
@@ -553,11 +476,11 @@ class TMergeDataFileImpl {
                   k.Core = item.Key;
                   /* the arena should already be correct k.Arena = ... */
                   k.SeqNum = item.SeqNum;
-                  min_heap.Insert(k, pos);
+                  loser_tree.Insert(k, pos);
                 }
               }
             }
-          } /* end of min-heap */
+          } /* end of loser tree */
           idx_file.FlushHistory();
           /* now that we've finished writing the current + history keys, we can remove the unused blocks. */
           const size_t end_of_stream = idx_file.EndOfHistoryStream;
@@ -682,6 +605,7 @@ class TMergeDataFileImpl {
       size_t num_meta_blocks = 0UL;
       /* compute / write out the meta-data */ {
         /*
+          format magic and version
           # of blocks
           # of meta-blocks (n)
           # of #block / block_id pairings (number of sequential blocks starting at) (m)
@@ -734,6 +658,7 @@ class TMergeDataFileImpl {
                                               ,WrittenBlockSet
                                               #endif
                                               );
+        stream << (TData::FormatMagic | TData::FormatVersion);  // format magic and version
         stream << BlockVec.Size();  // # of blocks
         stream << num_meta_blocks;  // # of meta-blocks
         stream << num_sequential_block_pairings;  // # of #block / block_id pairings
@@ -1412,13 +1337,13 @@ class TMergeDataFileImpl {
         }
         std::vector<TTypeNote> type_note_vec;
         type_note_vec.reserve(num_total_types);
-        Orly::Indy::Util::TMinHeap<TTypeNote, size_t> min_heap(num_total_types);
+        Orly::Indy::Util::TLoserTree<TTypeNote, size_t> loser_tree(num_total_types);
         for (size_t i = 0; i < disk_arena_vec.size(); ++i) {
           TDataDiskArena<true> *const arena = disk_arena_vec[i].get();
           const std::vector<size_t> &type_boundary_offset_vec = type_boundary_offset_vec_by_file[i];
           for (const size_t off : type_boundary_offset_vec) {
             type_note_vec.emplace_back(arena, off);
-            min_heap.Insert(type_note_vec.back(), i);
+            loser_tree.Insert(type_note_vec.back(), i);
           }
         }
 
@@ -1513,9 +1438,9 @@ class TMergeDataFileImpl {
           }
         };
 
-        while (min_heap) {
+        while (loser_tree) {
           size_t file;
-          const typename TMergeDataFileImpl<CanTail, CanTailTombstones>::TTypeNote &type_note = min_heap.Pop(file);
+          const typename TMergeDataFileImpl<CanTail, CanTailTombstones>::TTypeNote &type_note = loser_tree.Pop(file);
 
           if (!prev_type || type_note != *prev_type) {
             if (prev_type) { /* we have collected all the ranges of this type, time to merge */
@@ -1603,7 +1528,7 @@ class TMergeDataFileImpl {
         note_cursor_vec.emplace_back(new typename TDataDiskArena<ScanAheadAllowed>::TCursor(disk_arena, from_offset, to_offset));
       }
       std::vector<TL0MergeNote> merge_note_vec(note_cursor_vec.size());
-      Orly::Indy::Util::TMinHeap<TL0MergeNote, size_t> min_heap(note_cursor_vec.size());
+      Orly::Indy::Util::TLoserTree<TL0MergeNote, size_t> loser_tree(note_cursor_vec.size());
       size_t pos = 0UL;
       for (const auto &csr_ptr : note_cursor_vec) {
         typename TDataDiskArena<ScanAheadAllowed>::TCursor &csr = *csr_ptr;
@@ -1616,19 +1541,19 @@ class TMergeDataFileImpl {
           const auto &keeper_filter = sorted_keeper_map_vec[file].find(from_offset)->second;
           keeper_filter_csr_vec.emplace_back(new typename TArenaKeeperSorter::TCursor(keeper_filter.get(), max_block_cache_read_slots_allowed));
         }
-        /* add the first elements we're interested in to the min-heap */
+        /* add the first elements we're interested in to the loser tree */
         if (CanTail) {
           typename TMergeDataFileImpl<CanTail, CanTailTombstones>::TArenaKeeperSorter::TCursor &filter_csr = *keeper_filter_csr_vec[pos];
           for (; csr && filter_csr && csr.GetOffset() < *filter_csr; ++csr) {}
           if (csr && filter_csr) {
             merge_note_vec[pos] = TL0MergeNote(csr.GetArena(), csr.GetOffset(), *csr);
-            min_heap.Insert(merge_note_vec[pos], pos);
+            loser_tree.Insert(merge_note_vec[pos], pos);
             AdvanceFilterCursor(filter_csr);
           }
         } else {
           if (csr) {
             merge_note_vec[pos] = TL0MergeNote(csr.GetArena(), csr.GetOffset(), *csr);
-            min_heap.Insert(merge_note_vec[pos], pos);
+            loser_tree.Insert(merge_note_vec[pos], pos);
           }
         }
         ++pos;
@@ -1642,8 +1567,8 @@ class TMergeDataFileImpl {
         throw std::bad_alloc();
       }
       try {
-        while (min_heap) {
-          const TL0MergeNote &merge_note = min_heap.Pop(pos);
+        while (loser_tree) {
+          const TL0MergeNote &merge_note = loser_tree.Pop(pos);
           typename TDataDiskArena<ScanAheadAllowed>::TCursor &csr = *note_cursor_vec[pos];
           const size_t file = file_id_by_pos_vec[pos];
           typename TMergeDataFileImpl<CanTail, CanTailTombstones>::TRemapSorter &remap_sorter = *(remap_sorter_vec[file]);
@@ -1685,13 +1610,13 @@ class TMergeDataFileImpl {
             if (csr && filter_csr) {
               assert(csr.GetOffset() == *filter_csr);
               merge_note_vec[pos] = TL0MergeNote(csr.GetArena(), csr.GetOffset(), *csr);
-              min_heap.Insert(merge_note_vec[pos], pos);
+              loser_tree.Insert(merge_note_vec[pos], pos);
               AdvanceFilterCursor(filter_csr);
             }
           } else {
             if (csr) {
               merge_note_vec[pos] = TL0MergeNote(csr.GetArena(), csr.GetOffset(), *csr);
-              min_heap.Insert(merge_note_vec[pos], pos);
+              loser_tree.Insert(merge_note_vec[pos], pos);
             }
           }
         }
@@ -1801,7 +1726,7 @@ class TMergeDataFileImpl {
       }
       std::vector<TMergeNote> merge_note_vec(note_cursor_vec.size());
       Atom::TCore::TNote::TOrderedArenaCompare note_comp(my_arena);
-      Orly::Indy::Util::TMinHeap<Atom::TCore::TNote, size_t, Atom::TCore::TNote::TOrderedArenaCompare> min_heap(note_cursor_vec.size(), note_comp);
+      Orly::Indy::Util::TLoserTree<Atom::TCore::TNote, size_t, Atom::TCore::TNote::TOrderedArenaCompare> loser_tree(note_cursor_vec.size(), note_comp);
       std::vector<std::pair<Atom::TCore::TNote *, size_t>> temp_note_vec(note_cursor_vec.size(), std::make_pair(nullptr, 0UL));
       //std::cout << "=== Create MinHeap ===" << std::endl;
       try {
@@ -1829,7 +1754,7 @@ class TMergeDataFileImpl {
               temp_note_vec[pos].first = t_note;
               temp_note_vec[pos].second = cur_max_note_size;
               merge_note_vec[pos] = TMergeNote(my_arena, csr.GetOffset(), t_note);
-              min_heap.Insert(*merge_note_vec[pos].GetNote(), pos);
+              loser_tree.Insert(*merge_note_vec[pos].GetNote(), pos);
               AdvanceFilterCursor(filter_csr);
             }
           } else {
@@ -1848,7 +1773,7 @@ class TMergeDataFileImpl {
               temp_note_vec[pos].first = t_note;
               temp_note_vec[pos].second = cur_max_note_size;
               merge_note_vec[pos] = TMergeNote(my_arena, csr.GetOffset(), t_note);
-              min_heap.Insert(*merge_note_vec[pos].GetNote(), pos);
+              loser_tree.Insert(*merge_note_vec[pos].GetNote(), pos);
             }
           }
 
@@ -1863,8 +1788,8 @@ class TMergeDataFileImpl {
         try {
           Base::TOpt<TMergeNote> prev_note;
           Atom::TCore::TOffset prev_disk_offset = cur_disk_offset;
-          while (min_heap) {
-            min_heap.Pop(pos);
+          while (loser_tree) {
+            loser_tree.Pop(pos);
             const typename TMergeDataFileImpl<CanTail, CanTailTombstones>::TMergeNote &merge_note = merge_note_vec[pos];
             typename TDataDiskArena<DiskArenaVecScanAheadAllowed>::TCursor &csr = *note_cursor_vec[pos];
             const size_t file = file_id_by_pos_vec[pos];
@@ -1914,7 +1839,7 @@ class TMergeDataFileImpl {
                 my_pos = pos;
                 mem_note.first->Remap(note_remapper);
                 merge_note_vec[pos] = TMergeNote(my_arena, csr.GetOffset(), mem_note.first);
-                min_heap.Insert(*merge_note_vec[pos].GetNote(), pos);
+                loser_tree.Insert(*merge_note_vec[pos].GetNote(), pos);
                 AdvanceFilterCursor(filter_csr);
               }
             } else {
@@ -1934,7 +1859,7 @@ class TMergeDataFileImpl {
                 my_pos = pos;
                 mem_note.first->Remap(note_remapper);
                 merge_note_vec[pos] = TMergeNote(my_arena, csr.GetOffset(), mem_note.first);
-                min_heap.Insert(*merge_note_vec[pos].GetNote(), pos);
+                loser_tree.Insert(*merge_note_vec[pos].GetNote(), pos);
               }
             }
           }
@@ -2002,6 +1927,21 @@ class TMergeDataFileImpl {
       return Atom::IsLt(comp) || (Atom::IsEq(comp) && SeqNum >= that.SeqNum);
     }
 
+    /* Lets a loser tree of sorted keys order them by the first elements of their keys, where those differ. */
+    class TPrefixer {
+      NO_CONSTRUCTION(TPrefixer);
+      public:
+
+      /* See Util::TKeyPrefix. */
+      using TPrefix = Orly::Indy::Util::TKeyPrefix;
+
+      /* See Util::TKeyPrefix. */
+      static bool TryGet(const TSortedKey &key, TPrefix &out) {
+        return Orly::Indy::Util::TKeyPrefix::TryGet(key.Core, key.Arena, out);
+      }
+
+    };  // TPrefixer
+
     /* TODO */
     Atom::TCore Core;
     Atom::TCore::TArena *Arena;
@@ -2120,6 +2060,9 @@ class TMergeDataFileImpl {
           ByteOffsetOfCurHistory(0UL),
           ByteOffsetOfIndexMeta(0UL),
           ByteOffsetOfKeyIndex(0UL),
+          ByteOffsetOfBloomFilter(0UL),
+          NumBloomFilterWords(0UL),
+          NumBloomFilterProbes(0UL),
           FirstKey(true),
           GenId(gen_id),
           #ifndef NDEBUG
@@ -2159,7 +2102,9 @@ class TMergeDataFileImpl {
         meta_stream << NumHistKeys;  // # History Keys
         meta_stream << ByteOffsetOfKeyIndex;  // Current Key Offset
         meta_stream << NumHashTables;  // # of hash indexes (n)
-
+        meta_stream << ByteOffsetOfBloomFilter;  // Bloom filter offset
+        meta_stream << NumBloomFilterWords;  // # bloom filter words
+        meta_stream << NumBloomFilterProbes;  // # bloom filter probes
 
         for (const auto &hash_table : NumHashFieldsByOffset) {
           meta_stream << hash_table.first << hash_table.second;
@@ -2333,6 +2278,7 @@ class TMergeDataFileImpl {
       size_t total_bytes_required = 0UL;
       std::unordered_map<size_t, std::shared_ptr<const TBufBlock>> collision_map {};
       size_t hash_index_byte_offset = BlockVec->Size() * LogicalBlockSize;
+      size_t num_bloom_entries = 0UL;
       for (const auto &collection : HashCollectorVec) {
         /* collision at beginning of this hash index */
         auto ret = collision_map.insert(std::make_pair((hash_index_byte_offset + total_bytes_required) / LogicalBlockSize, nullptr));
@@ -2342,6 +2288,7 @@ class TMergeDataFileImpl {
         size_t num_hash_fields = Disk::Util::SuggestHashSize(collection->GetSize());
         NumHashFieldsByOffset.emplace_back(hash_index_byte_offset + total_bytes_required, num_hash_fields);
         total_bytes_required += num_hash_fields * TDataFile::HashEntrySize;
+        num_bloom_entries += collection->GetSize();
         /* collision at end of this hash index (if the block doesn't get filled completely) */
         if ((hash_index_byte_offset + total_bytes_required) % LogicalBlockSize != 0) {
           ret = collision_map.insert(std::make_pair((hash_index_byte_offset + total_bytes_required) / LogicalBlockSize, nullptr));
@@ -2351,6 +2298,19 @@ class TMergeDataFileImpl {
         }
       }
       assert(NumHashFieldsByOffset.size() == NumHashTables);
+      /* the bloom filter follows the last hash index */
+      Disk::Util::TBloomFilter bloom_filter(num_bloom_entries);
+      ByteOffsetOfBloomFilter = hash_index_byte_offset + total_bytes_required;
+      NumBloomFilterWords = bloom_filter.GetNumWords();
+      NumBloomFilterProbes = bloom_filter.GetNumProbes();
+      total_bytes_required += bloom_filter.GetNumBytes();
+      /* collision at end of the bloom filter */
+      if ((hash_index_byte_offset + total_bytes_required) % LogicalBlockSize != 0) {
+        auto ret = collision_map.insert(std::make_pair((hash_index_byte_offset + total_bytes_required) / LogicalBlockSize, nullptr));
+        if (ret.second) { // fresh insert
+          ret.first->second = std::shared_ptr<const TBufBlock>(new TBufBlock());
+        }
+      }
       size_t max_blocks_required = ceil(static_cast<double>(total_bytes_required) / LogicalBlockSize);
       const size_t total_num_blocks_required = BlockVec->Size() + max_blocks_required;
       Engine->AppendReserveBlocks(StorageSpeed, max_blocks_required, *BlockVec);
@@ -2362,13 +2322,16 @@ class TMergeDataFileImpl {
       }
       #endif
       TCompletionTrigger completion_trigger;
+      size_t num_prefix_fields = 0UL;
       for (const auto &collection : HashCollectorVec) {
+        ++num_prefix_fields;
         size_t num_hash_fields = Disk::Util::SuggestHashSize(collection->GetSize());
         /* make a new index with the hashes modded by the hash field size */
         THashCollector modded_hash_collector(HERE, Source::DataFileHashIndex, TempFileConsolThresh, SorterStorageSpeed, Engine, true);
         for (typename THashCollector::TCursor orig_csr(collection.get(), MaxBlockCacheReadSlotsAllowed); orig_csr; ++orig_csr) {
           const THashObj &obj = *orig_csr;
           modded_hash_collector.Emplace(obj.Core, obj.Hash % num_hash_fields, obj.Offset);
+          bloom_filter.Add(num_prefix_fields, obj.Hash);
         }
         typename THashCollector::TCursor hash_csr(&modded_hash_collector, MaxBlockCacheReadSlotsAllowed);
         /* do the first pass over the hash map */ {
@@ -2482,6 +2445,24 @@ class TMergeDataFileImpl {
         }
         hash_index_byte_offset += num_hash_fields * TDataFile::HashEntrySize;
       }
+      /* write the bloom filter */ {
+        assert(hash_index_byte_offset == ByteOffsetOfBloomFilter);
+        TDataOutStream stream(HERE,
+                              Source::MergeDataFileHashIndex,
+                              Engine->GetVolMan(),
+                              ByteOffsetOfBloomFilter,
+                              *BlockVec,
+                              collision_map,
+                              completion_trigger,
+                              Priority,
+                              true /* do_cache */
+                              #ifndef NDEBUG
+                              ,WrittenBlockSet
+                              #endif
+                              );
+        stream.Write(bloom_filter.GetData(), bloom_filter.GetNumBytes());
+        FileSize = stream.GetOffset();
+      }
       /* flush collision blocks */ {
         for (auto iter : collision_map) {
           assert(iter.first < BlockVec->Size());
@@ -2588,6 +2569,10 @@ class TMergeDataFileImpl {
 
     size_t NumHashTables;
 
+    size_t ByteOffsetOfBloomFilter;
+    size_t NumBloomFilterWords;
+    size_t NumBloomFilterProbes;
+
     bool FirstKey;
     size_t CurKeyOffset;
     std::unique_ptr<TDataOutStream> KeyStream;
@@ -2658,6 +2643,204 @@ class TMergeDataFileImpl {
 
   };
 
+  /* Runs one of the jobs passed to RunJobs() on a runner of its own. */
+  class TJob
+      : public Fiber::TRunnable {
+    NO_COPY(TJob);
+    public:
+
+    /* Do-little. */
+    TJob() {}
+
+    /* Launch the job on the given runner.  The sync must already be waiting for us; we complete it when we finish. */
+    void Start(Fiber::TRunner *runner, const std::function<void (size_t, size_t)> *cb, size_t job, size_t max_block_cache_read_slots_allowed, Fiber::TSafeSync *sync) {
+      assert(this);
+      assert(runner);
+      assert(cb);
+      assert(sync);
+      Cb = cb;
+      Job = job;
+      MaxBlockCacheReadSlotsAllowed = max_block_cache_read_slots_allowed;
+      Sync = sync;
+      Fiber::TFrame *frame = Fiber::TFrame::LocalFramePool->Alloc();
+      try {
+        frame->Latch(runner, this, static_cast<Fiber::TRunnable::TFunc>(&TJob::Run));
+      } catch (...) {
+        Fiber::TFrame::LocalFramePool->Free(frame);
+        throw;
+      }
+    }
+
+    /* The error the job threw, if any. */
+    const std::exception_ptr &GetError() const {
+      assert(this);
+      return Error;
+    }
+
+    private:
+
+    /* Runs on the runner's fiber.  We free our frame before completing the sync, as the sync's waiter may destroy us
+       as soon as it's complete. */
+    void Run() {
+      assert(this);
+      try {
+        (*Cb)(Job, MaxBlockCacheReadSlotsAllowed);
+      } catch (...) {
+        Error = std::current_exception();
+      }
+      Fiber::TSafeSync *sync = Sync;
+      Fiber::FreeMyFrame(Fiber::TFrame::LocalFramePool);
+      sync->Complete();
+    }
+
+    /* The job to run, and its arguments. */
+    const std::function<void (size_t, size_t)> *Cb;
+    size_t Job;
+    size_t MaxBlockCacheReadSlotsAllowed;
+
+    /* Completed when we finish. */
+    Fiber::TSafeSync *Sync;
+
+    /* See accessor. */
+    std::exception_ptr Error;
+
+  };  // TJob
+
+  /* Call the callback once for each of the given number of jobs, passing it the job's index and the block cache read
+     slots it may use.  If we have runners, the jobs run concurrently, dealt round-robin over the runners, and split our
+     slots between them; otherwise they run one after another, right here, and each gets all our slots.  Either way, we
+     return once they've all finished, rethrowing the first error any of them threw. */
+  void RunJobs(size_t num_jobs, const std::function<void (size_t, size_t)> &cb) {
+    assert(this);
+    if (RunnerVec.empty() || num_jobs < 2) {
+      for (size_t job = 0; job < num_jobs; ++job) {
+        cb(job, MaxBlockCacheReadSlotsAllowed);
+      }
+      return;
+    }
+    std::unique_ptr<TJob[]> jobs(new TJob[num_jobs]);
+    Fiber::TSafeSync sync;
+    try {
+      for (size_t job = 0; job < num_jobs; ++job) {
+        sync.WaitForMore(1);
+        try {
+          jobs[job].Start(RunnerVec[job % RunnerVec.size()], &cb, job, MaxBlockCacheReadSlotsAllowed / num_jobs, &sync);
+        } catch (...) {
+          sync.Complete();
+          throw;
+        }
+      }
+    } catch (...) {
+      sync.Sync();
+      throw;
+    }
+    sync.Sync();
+    for (size_t job = 0; job < num_jobs; ++job) {
+      if (jobs[job].GetError()) {
+        std::rethrow_exception(jobs[job].GetError());
+      }
+    }
+  }
+
+  /* Build the access patterns for one half of a source file of the given index file: its current keys if the slot is
+     even, its history keys if it's odd.  The source is the one at position slot / 2.  We fill in only our own slot of
+     the output vectors, so all the halves of an index can be scanned concurrently. */
+  void ScanSourceHalf(TMergeIndexFile &idx_file,
+                      size_t slot,
+                      std::vector<std::unique_ptr<TRemapAccessSorter>> &key_access_sorter_vec,
+                      std::vector<std::unique_ptr<TRemapAccessSorter>> &val_access_sorter_vec) {
+    assert(this);
+    assert(&idx_file);
+    const size_t source_pos = slot / 2;
+    const std::unique_ptr<typename TReader::TIndexFile> &source_file = idx_file.SourceFileVec[source_pos];
+    key_access_sorter_vec[slot] = make_unique<TRemapAccessSorter>(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true);
+    val_access_sorter_vec[slot] = make_unique<TRemapAccessSorter>(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true);
+    TRemapAccessSorter &key_access_sorter = *key_access_sorter_vec[slot];
+    TRemapAccessSorter &val_access_sorter = *val_access_sorter_vec[slot];
+    size_t idx = 0UL;
+    if (slot % 2 == 0) {
+      /* current keys */
+      if (CanTail) {
+        for (typename TReader::TIndexFile::TKeyCursor key_cursor(source_file.get()); key_cursor; ++key_cursor) {
+          const typename TReader::TIndexFile::TKeyItem &item = *key_cursor;
+          if (!CanTailTombstones || !item.Value.IsTombstone() || item.NumHistKeys > 0) {
+            const Atom::TCore::TOffset *key_off = item.Key.TryGetOffset();
+            if (key_off) {
+              key_access_sorter.Emplace(++idx, *key_off);
+            }
+            const Atom::TCore::TOffset *val_off = item.Value.TryGetOffset();
+            if (val_off) {
+              val_access_sorter.Emplace(++idx, *val_off);
+            }
+          }
+        }
+      } else {
+        for (typename TReader::TIndexFile::TKeyCursor key_cursor(source_file.get()); key_cursor; ++key_cursor) {
+          const typename TReader::TIndexFile::TKeyItem &item = *key_cursor;
+          const Atom::TCore::TOffset *key_off = item.Key.TryGetOffset();
+          if (key_off) {
+            key_access_sorter.Emplace(++idx, *key_off);
+          }
+          const Atom::TCore::TOffset *val_off = item.Value.TryGetOffset();
+          if (val_off) {
+            val_access_sorter.Emplace(++idx, *val_off);
+          }
+        }
+      }
+    } else {
+      /* history keys */
+      if (CanTail) {
+        std::vector<bool> &hist_filter_vec = idx_file.HistoryKeeperFilterVec[source_pos];
+        assert(hist_filter_vec.size() == source_file->GetNumHistKeys());
+        size_t cur_hist_offset = 0UL;
+        for (typename TReader::TIndexFile::THistoryKeyCursor history_cursor(source_file.get()); history_cursor; ++history_cursor, ++cur_hist_offset) {
+          assert(cur_hist_offset < hist_filter_vec.size());
+          if (hist_filter_vec[cur_hist_offset]) {
+            const typename TReader::TIndexFile::THistoryKeyItem &item = *history_cursor;
+            const Atom::TCore::TOffset *key_off = item.Key.TryGetOffset();
+            if (key_off) {
+              key_access_sorter.Emplace(++idx, *key_off);
+            }
+            const Atom::TCore::TOffset *val_off = item.Value.TryGetOffset();
+            if (val_off) {
+              val_access_sorter.Emplace(++idx, *val_off);
+            }
+          }
+        }
+      } else {
+        for (typename TReader::TIndexFile::THistoryKeyCursor history_cursor(source_file.get()); history_cursor; ++history_cursor) {
+          const typename TReader::TIndexFile::THistoryKeyItem &item = *history_cursor;
+          const Atom::TCore::TOffset *key_off = item.Key.TryGetOffset();
+          if (key_off) {
+            key_access_sorter.Emplace(++idx, *key_off);
+          }
+          const Atom::TCore::TOffset *val_off = item.Value.TryGetOffset();
+          if (val_off) {
+            val_access_sorter.Emplace(++idx, *val_off);
+          }
+        }
+      }
+    }
+  }
+
+  /* Resolve one access pattern built by ScanSourceHalf() against its remapping, release the access pattern, and open a
+     cursor over the result.  The access sorter, resolved sorter and cursor are all in the given slot of their vectors.
+     A slot's key and value patterns are resolved against different remappings, so they can be resolved concurrently. */
+  void ResolveSlot(size_t slot,
+                   TRemapSorter &remap_sorter,
+                   size_t max_block_cache_read_slots_allowed,
+                   size_t max_block_cache_read_slot_per_sub_cursor,
+                   std::vector<std::unique_ptr<TRemapAccessSorter>> &access_sorter_vec,
+                   std::vector<std::unique_ptr<TRemapResolvedSorter>> &resolved_sorter_vec,
+                   std::vector<std::unique_ptr<typename TRemapResolvedSorter::TCursor>> &resolved_sorter_cursor_vec) {
+    assert(this);
+    resolved_sorter_vec[slot] = make_unique<TRemapResolvedSorter>(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true);
+    TRemapResolvedSorter &resolved_sorter = *resolved_sorter_vec[slot];
+    ResolveRemap(max_block_cache_read_slots_allowed, *access_sorter_vec[slot], remap_sorter, resolved_sorter);
+    access_sorter_vec[slot].reset();
+    resolved_sorter_cursor_vec[slot] = std::make_unique<typename TRemapResolvedSorter::TCursor>(&resolved_sorter, max_block_cache_read_slot_per_sub_cursor);
+  }
+
   /* TODO */
   TEngine *Engine;
 
@@ -2672,6 +2855,9 @@ class TMergeDataFileImpl {
   /* TODO */
   size_t MaxBlockCacheReadSlotsAllowed;
 
+  /* The runners over which we spread the work that can be done in parallel.  If empty, we do it all ourselves. */
+  std::vector<Fiber::TRunner *> RunnerVec;
+
   /* TODO */
   TBlockVec BlockVec;
 
@@ -2726,21 +2912,22 @@ TMergeDataFile::TMergeDataFile(Util::TEngine *engine,
                                size_t max_block_cache_read_slots_allowed,
                                size_t temp_file_consol_thresh,
                                bool can_tail,
-                               bool can_tail_tombstone) {
+                               bool can_tail_tombstone,
+                               const std::vector<Fiber::TRunner *> &runner_vec) {
   if (can_tail) {
     if (can_tail_tombstone) {
-      TMergeDataFileImpl<true, true> merge_file(engine, storage_speed, file_uuid, gen_vec, file_uid, gen_id, release_up_to, priority, max_block_cache_read_slots_allowed, temp_file_consol_thresh);
+      TMergeDataFileImpl<true, true> merge_file(engine, storage_speed, file_uuid, gen_vec, file_uid, gen_id, release_up_to, priority, max_block_cache_read_slots_allowed, temp_file_consol_thresh, runner_vec);
       NumKeys = merge_file.GetNumKeys();
       LowestSeq = merge_file.GetLowestSequence();
       HighestSeq = merge_file.GetHighestSequence();
     } else {
-      TMergeDataFileImpl<true, false> merge_file(engine, storage_speed, file_uuid, gen_vec, file_uid, gen_id, release_up_to, priority, max_block_cache_read_slots_allowed, temp_file_consol_thresh);
+      TMergeDataFileImpl<true, false> merge_file(engine, storage_speed, file_uuid, gen_vec, file_uid, gen_id, release_up_to, priority, max_block_cache_read_slots_allowed, temp_file_consol_thresh, runner_vec);
       NumKeys = merge_file.GetNumKeys();
       LowestSeq = merge_file.GetLowestSequence();
       HighestSeq = merge_file.GetHighestSequence();
     }
   } else {
-    TMergeDataFileImpl<false, false> merge_file(engine, storage_speed, file_uuid, gen_vec, file_uid, gen_id, release_up_to, priority, max_block_cache_read_slots_allowed, temp_file_consol_thresh);
+    TMergeDataFileImpl<false, false> merge_file(engine, storage_speed, file_uuid, gen_vec, file_uid, gen_id, release_up_to, priority, max_block_cache_read_slots_allowed, temp_file_consol_thresh, runner_vec);
     NumKeys = merge_file.GetNumKeys();
     LowestSeq = merge_file.GetLowestSequence();
     HighestSeq = merge_file.GetHighestSequence();
@@ -18,12 +18,15 @@
 
 #pragma once
 
+#include <vector>
+
 #include <base/class_traits.h>
 #include <orly/atom/kit2.h>
 #include <orly/indy/disk/data_file.h>
 #include <orly/indy/disk/out_stream.h>
 #include <orly/indy/disk/read_file.h>
 #include <orly/indy/disk/util/index_manager.h>
+#include <orly/indy/fiber/fiber.h>
 #include <orly/indy/memory_layer.h>
 #include <orly/sabot/all.h>
 
@@ -42,7 +45,8 @@ namespace Orly {
         NO_COPY(TMergeDataFile);
         public:
 
-        /* TODO */
+        /* The work of the merge which can be done in parallel is spread over the given runners, if any, each of which
+           must have a local frame pool.  If there are any, we must ourselves be running on a fiber. */
         TMergeDataFile(Util::TEngine *engine,
                        Disk::Util::TVolume::TDesc::TStorageSpeed storage_speed,
                        const Base::TUuid &file_uuid,
@@ -54,7 +58,8 @@ namespace Orly {
                        size_t max_block_cache_read_slots_allowed,
                        size_t temp_file_consol_thresh,
                        bool can_tail,
-                       bool can_tail_tombstone);
+                       bool can_tail_tombstone,
+                       const std::vector<Fiber::TRunner *> &runner_vec = std::vector<Fiber::TRunner *>());
 
         /* TODO */
         inline size_t GetNumKeys() const {
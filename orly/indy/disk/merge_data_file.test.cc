@@ -18,6 +18,10 @@
 
 #include <orly/indy/disk/merge_data_file.h>
 
+#include <memory>
+#include <thread>
+#include <vector>
+
 #include <valgrind/callgrind.h>
 
 #include <base/scheduler.h>
@@ -473,6 +477,69 @@ FIXTURE(Deep) {
   });
 }
 
+FIXTURE(SpreadOverRunners) {
+  static const size_t NumRunners = 3UL;
+  TFiberTestRunner runner([](std::mutex &mut, std::condition_variable &cond, bool &fin, Fiber::TRunner::TRunnerCons &runner_cons) {
+    void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+    /* Real runners, each on a thread of its own, sharing our frame pool. */
+    vector<unique_ptr<TRunner>> runner_vec;
+    vector<TRunner *> runner_ptr_vec;
+    vector<thread> thread_vec;
+    for (size_t i = 0; i < NumRunners; ++i) {
+      runner_vec.emplace_back(new TRunner(runner_cons));
+      runner_ptr_vec.push_back(runner_vec.back().get());
+      thread_vec.emplace_back(LaunchSlowFiberSched, runner_vec.back().get(), TFrame::LocalFramePool->GetPoolManager());
+    }
+    TScheduler scheduler(TScheduler::TPolicy(4, 10, milliseconds(10)));
+    /* engine */ {
+      Sim::TMemEngine mem_engine(&scheduler,
+                                 256 /* disk space: 256MB */,
+                                 256 /* slow disk space: 256MB */,
+                                 16384 /* page cache slots: 64MB */,
+                                 1 /* num page lru */,
+                                 1024 /* block cache slots: 64MB */,
+                                 1 /* num block lru */);
+      Base::TUuid file_id(TUuid::Best);
+      Base::TUuid int_idx(TUuid::Twister);
+      TSequenceNumber seq_num = 0U;
+      /* four files of interleaved keys, so every source contributes throughout the merge */
+      for (size_t gen_id = 1; gen_id <= 4; ++gen_id) {
+        TSuprena arena;
+        TMockMem mem_layer;
+        for (int64_t i = gen_id; i <= 400; i += 4) {
+          Insert(mem_layer, ++seq_num, int_idx, i * 10, i);
+        }
+        TDataFile data_file(mem_engine.GetEngine(), TVolume::TDesc::Fast, &mem_layer, file_id, gen_id, 20UL, 0U, Medium);
+      }
+      /* merge them, spreading the work over the runners */ {
+        TMergeDataFile merge_file(mem_engine.GetEngine(), TVolume::TDesc::Fast, file_id, vector<size_t>{1, 2, 3, 4}, file_id, 5UL, 0U, Low, 16384, 20UL, false, false, runner_ptr_vec);
+        EXPECT_EQ(merge_file.GetNumKeys(), 400UL);
+      }
+      /* the keys all came through, in order */ {
+        TSuprena arena;
+        TReader reader(HERE, mem_engine.GetEngine(), file_id, 5UL);
+        TReader::TIndexFile int_idx_file(&reader, int_idx, RealTime);
+        TReader::TArena int_idx_arena(&int_idx_file, mem_engine.GetEngine()->GetCache<TReader::PhysicalCachePageSize>(), RealTime);
+        int64_t expected = 1L;
+        for (TReader::TIndexFile::TKeyCursor csr(&int_idx_file); csr; ++csr, ++expected) {
+          EXPECT_EQ(TKey((*csr).Key, &int_idx_arena), TKey(make_tuple(expected), &arena, state_alloc));
+        }
+        EXPECT_EQ(expected, 401L);
+      }
+      GracefullShutdown();
+    }
+    for (auto &cur_runner: runner_vec) {
+      cur_runner->ShutDown();
+    }
+    for (auto &t: thread_vec) {
+      t.join();
+    }
+    std::lock_guard<std::mutex> lock(mut);
+    fin = true;
+    cond.notify_one();
+  }, NumRunners);
+}
+
 FIXTURE(SomeHistory) {
   TFiberTestRunner runner([](std::mutex &mut, std::condition_variable &cond, bool &fin, Fiber::TRunner::TRunnerCons &) {
     void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
@@ -63,6 +63,7 @@ std::pair<size_t, size_t> TMetaRewriter::RewriteMetaData(Disk::Util::TEngine *en
   assert(engine);
   TMetaRewriteInFile in_file(block_vec);
   TInStream in_stream(HERE, Source::FileSync, Disk::RealTime, &in_file, engine->GetPageCache(), starting_block_offset * Disk::Util::LogicalBlockSize);
+  size_t magic_and_version;
   size_t block_vec_size;
   size_t old_num_meta_blocks;
   size_t old_num_sequential_block_pairings;
@@ -73,6 +74,8 @@ std::pair<size_t, size_t> TMetaRewriter::RewriteMetaData(Disk::Util::TEngine *en
   size_t num_arena_type_boundaries;
   size_t main_arena_byte_offset;
   size_t byte_offset_of_update_entries;
+  in_stream.Read(magic_and_version);  // format magic and version
+  TData::CheckFormat(magic_and_version);
   in_stream.Read(block_vec_size);  // # of blocks
   in_stream.Read(old_num_meta_blocks);  // # of meta-blocks
   in_stream.Read(old_num_sequential_block_pairings);  // # of #block / block_id pairings
@@ -125,6 +128,7 @@ std::pair<size_t, size_t> TMetaRewriter::RewriteMetaData(Disk::Util::TEngine *en
                        ,written_block_set
                        #endif
                        );
+    out << (TData::FormatMagic | TData::FormatVersion);  // format magic and version
     out << block_vec_size - old_num_meta_blocks + num_meta_blocks;  // # of blocks
     out << num_meta_blocks;  // # of meta-blocks
     out << num_sequential_block_pairings;  // # of #block / block_id pairings
@@ -29,6 +29,7 @@
 #include <orly/atom/kit2.h>
 #include <orly/indy/disk/in_file.h>
 #include <orly/indy/disk/indy_util_reporter.h>
+#include <orly/indy/disk/util/bloom_filter.h>
 #include <orly/indy/disk/util/cache.h>
 #include <orly/indy/disk/util/engine.h>
 #include <orly/indy/update.h>
@@ -413,6 +414,7 @@ namespace Orly {
           assert(StartingBlockOffset * BlockSize < FileLength);
           TStream<CachePageSize, BlockSize, PhysicalBlockSize, BufKind, MaxMetaCacheSize> in_stream(CodeLocation, UtilSrc, Priority, this, Cache, StartingBlockOffset * BlockSize);
           /*
+            format magic and version
             # of blocks
             # of meta-blocks (n)
             # of #block / block_id pairings (number of sequential blocks starting at) (m)
@@ -424,6 +426,9 @@ namespace Orly {
             offset of main arena
             offset of update index
           */
+          size_t magic_and_version;
+          in_stream.Read(magic_and_version);
+          TData::CheckFormat(magic_and_version);
           in_stream.Read(NumBlocks);
           in_stream.Read(NumMetaBlocks);
           in_stream.Read(NumSequentialBlockPairings);
@@ -731,6 +736,10 @@ namespace Orly {
             in_stream.Read(NumHistKeys);
             in_stream.Read(ByteOffsetOfKeyIndex);
             in_stream.Read(NumHashTables);
+            size_t num_bloom_filter_words, num_bloom_filter_probes;
+            in_stream.Read(ByteOffsetOfBloomFilter);
+            in_stream.Read(num_bloom_filter_words);
+            in_stream.Read(num_bloom_filter_probes);
             assert(NumArenaBytes > 0UL);
 
             size_t offset, num_hash_fields;
@@ -744,6 +753,12 @@ namespace Orly {
               in_stream.Read(offset);
               ArenaTypeBoundaryByOffset.emplace_back(offset);
             }
+            /* keep the bloom filter in memory for as long as we're open */
+            if (num_bloom_filter_words) {
+              BloomFilter.Reset(num_bloom_filter_words, num_bloom_filter_probes);
+              in_stream.GoTo(ByteOffsetOfBloomFilter);
+              in_stream.Read(BloomFilter.GetData(), BloomFilter.GetNumBytes());
+            }
           }
 
           /* TODO */
@@ -765,6 +780,10 @@ namespace Orly {
               const size_t num_hash_fields = idx.second;
               const size_t hash_to_look_for = key.GetHash();
               const size_t modded_hash = hash_to_look_for % num_hash_fields;
+              if (!BloomFilter.MayContain(num_defined, hash_to_look_for)) {
+                Util::TBloomFilter::RejectCount.fetch_add(1UL, std::memory_order_relaxed);
+                return false;
+              }
 
               void *key_state_alloc = alloca(Sabot::State::GetMaxStateSize() * 2);
               void *other_state_alloc = reinterpret_cast<uint8_t *>(key_state_alloc) + Sabot::State::GetMaxStateSize();
@@ -785,10 +804,10 @@ namespace Orly {
                       return true;
                     }
                   } else if (cur_hash % num_hash_fields > modded_hash) {
-                    return false;
+                    return OnFalsePositive();
                   }
                 } else {
-                  return false;
+                  return OnFalsePositive();
                 }
               }
               in_stream.GoTo(byte_offset_of_hash_table);
@@ -803,10 +822,10 @@ namespace Orly {
                       return true;
                     }
                   } else if (cur_hash % num_hash_fields > modded_hash) {
-                    return false;
+                    return OnFalsePositive();
                   }
                 } else {
-                  return false;
+                  return OnFalsePositive();
                 }
               }
               syslog(LOG_ERR, "TReadFile::TIndexFile::FindInHash() Should not happen, implies hash table is completely full, modded_hash = [%ld], num_hash_fields[%ld]", modded_hash, num_hash_fields);
@@ -921,6 +940,12 @@ namespace Orly {
 
           private:
 
+          /* Our bloom filter let a key through, but it isn't in the hash table. */
+          static bool OnFalsePositive() {
+            Util::TBloomFilter::FalsePositiveCount.fetch_add(1UL, std::memory_order_relaxed);
+            return false;
+          }
+
           /* TODO */
           inline virtual size_t GetByteOffsetOfArena() const override {
             assert(this);
@@ -976,10 +1001,14 @@ namespace Orly {
           size_t NumHistKeys;
           size_t ByteOffsetOfKeyIndex;
           size_t NumHashTables;
+          size_t ByteOffsetOfBloomFilter;
 
           /* TODO */
           std::vector<std::pair<size_t, size_t>> NumHashFieldsByOffset;
 
+          /* Every prefix in our hash tables.  Empty (letting everything through) if the file has no filter. */
+          Util::TBloomFilter BloomFilter;
+
           /* TODO */
           std::vector<size_t> ArenaTypeBoundaryByOffset;
 
@@ -0,0 +1,26 @@
+/* <orly/indy/disk/util/bloom_filter.cc>
+
+   Implements <orly/indy/disk/util/bloom_filter.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/disk/util/bloom_filter.h>
+
+using namespace std;
+using namespace Orly::Indy::Disk::Util;
+
+std::atomic<size_t> TBloomFilter::RejectCount(0UL);
+
+std::atomic<size_t> TBloomFilter::FalsePositiveCount(0UL);
@@ -0,0 +1,189 @@
+/* <orly/indy/disk/util/bloom_filter.h>
+
+   A blocked bloom filter over key hashes, used to skip the on-disk hash tables of a file which cannot hold a key.
+
+   The bits are split into 512-bit blocks (one cache line each).  A hash picks one block and then sets or tests
+   NumProbes bits inside it, so a lookup touches a single line no matter how many probes we make.  A file's filter
+   holds every key prefix which appears in one of its hash tables, tagged with the number of fields in the prefix,
+   so a key with trailing frees can be tested the same way as a fully-defined one.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include <base/class_traits.h>
+
+namespace Orly {
+
+  namespace Indy {
+
+    namespace Disk {
+
+      namespace Util {
+
+        /* A bloom filter over (number of fields, hash) pairs.  Not thread-safe for writing; any number of threads may
+           call MayContain() once the filter is built. */
+        class TBloomFilter {
+          NO_COPY(TBloomFilter);
+          public:
+
+          /* The number of 64-bit words in a block. */
+          static constexpr size_t WordsPerBlock = 8UL;
+
+          /* The number of bits in a block. */
+          static constexpr size_t BitsPerBlock = WordsPerBlock * 64UL;
+
+          /* Bits of filter per entry.  At 10 bits and 6 probes we expect just over 1% false positives. */
+          static constexpr size_t BitsPerEntry = 10UL;
+
+          /* The number of bits we set per entry. */
+          static constexpr size_t DefaultNumProbes = 6UL;
+
+          /* An empty filter.  It has no bits, so it reports that it may contain anything. */
+          TBloomFilter()
+              : NumProbes(0UL) {}
+
+          /* A cleared filter sized for the given number of entries. */
+          explicit TBloomFilter(size_t num_entries)
+              : WordVec(GetNumBlocksFor(num_entries) * WordsPerBlock, 0UL), NumProbes(DefaultNumProbes) {}
+
+          /* Add the prefix with the given number of fields and hash. */
+          void Add(size_t num_fields, size_t hash) {
+            assert(this);
+            if (WordVec.empty()) {
+              return;
+            }
+            size_t first_word;
+            uint64_t h1, h2;
+            Locate(num_fields, hash, first_word, h1, h2);
+            for (size_t i = 0; i < NumProbes; ++i) {
+              const size_t bit = (h1 + i * h2) % BitsPerBlock;
+              WordVec[first_word + bit / 64UL] |= (1UL << (bit % 64UL));
+            }
+          }
+
+          /* False iff. the prefix with the given number of fields and hash was definitely never added. */
+          bool MayContain(size_t num_fields, size_t hash) const {
+            assert(this);
+            if (WordVec.empty()) {
+              return true;
+            }
+            size_t first_word;
+            uint64_t h1, h2;
+            Locate(num_fields, hash, first_word, h1, h2);
+            for (size_t i = 0; i < NumProbes; ++i) {
+              const size_t bit = (h1 + i * h2) % BitsPerBlock;
+              if (!(WordVec[first_word + bit / 64UL] & (1UL << (bit % 64UL)))) {
+                return false;
+              }
+            }
+            return true;
+          }
+
+          /* Clear the filter and give it the given shape.  Use this when loading a filter which was written to disk, then
+             read the words into GetData(). */
+          void Reset(size_t num_words, size_t num_probes) {
+            assert(this);
+            assert(num_words % WordsPerBlock == 0UL);
+            WordVec.assign(num_words, 0UL);
+            NumProbes = num_probes;
+          }
+
+          /* The words of the filter, for writing it to or reading it from disk. */
+          uint64_t *GetData() {
+            assert(this);
+            return WordVec.data();
+          }
+
+          /* See GetData(). */
+          const uint64_t *GetData() const {
+            assert(this);
+            return WordVec.data();
+          }
+
+          /* The number of bytes in the filter. */
+          size_t GetNumBytes() const {
+            assert(this);
+            return WordVec.size() * sizeof(uint64_t);
+          }
+
+          /* The number of probes we make per entry. */
+          size_t GetNumProbes() const {
+            assert(this);
+            return NumProbes;
+          }
+
+          /* The number of 64-bit words in the filter. */
+          size_t GetNumWords() const {
+            assert(this);
+            return WordVec.size();
+          }
+
+          /* The number of lookups a filter has turned away, across all files. */
+          static std::atomic<size_t> RejectCount;
+
+          /* The number of lookups a filter let through which then missed in the hash table, across all files. */
+          static std::atomic<size_t> FalsePositiveCount;
+
+          private:
+
+          /* The number of blocks to use for the given number of entries.  Always at least one. */
+          static size_t GetNumBlocksFor(size_t num_entries) {
+            const size_t num_bits = num_entries * BitsPerEntry;
+            return num_bits / BitsPerBlock + 1UL;
+          }
+
+          /* A strong 64-bit mix (the murmur3 finalizer).  Key hashes of small scalars can be quite regular, so we mix
+             before we use any of the bits. */
+          static uint64_t Mix(uint64_t h) {
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdUL;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53UL;
+            h ^= h >> 33;
+            return h;
+          }
+
+          /* Find the first word of the block for the given entry and the two hashes we'll use to probe within it. */
+          void Locate(size_t num_fields, size_t hash, size_t &first_word, uint64_t &h1, uint64_t &h2) const {
+            assert(this);
+            const uint64_t mixed = Mix(hash + num_fields * 0x9e3779b97f4a7c15UL);
+            const size_t num_blocks = WordVec.size() / WordsPerBlock;
+            first_word = (mixed % num_blocks) * WordsPerBlock;
+            const uint64_t inner = Mix(mixed);
+            h1 = inner;
+            h2 = (inner >> 32) | 1UL;
+          }
+
+          /* The bits. */
+          std::vector<uint64_t> WordVec;
+
+          /* See accessor. */
+          size_t NumProbes;
+
+        };  // TBloomFilter
+
+      }  // Util
+
+    }  // Disk
+
+  }  // Indy
+
+}  // Orly
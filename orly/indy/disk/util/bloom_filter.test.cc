@@ -0,0 +1,77 @@
+/* <orly/indy/disk/util/bloom_filter.test.cc>
+
+   Unit test for <orly/indy/disk/util/bloom_filter.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/disk/util/bloom_filter.h>
+
+#include <cstring>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Orly::Indy::Disk::Util;
+
+FIXTURE(Empty) {
+  TBloomFilter filter;
+  EXPECT_EQ(filter.GetNumBytes(), 0UL);
+  EXPECT_TRUE(filter.MayContain(1UL, 42UL));
+}
+
+FIXTURE(NoFalseNegatives) {
+  const size_t num_entries = 100000UL;
+  TBloomFilter filter(num_entries);
+  for (size_t i = 0; i < num_entries; ++i) {
+    filter.Add(1UL + i % 3UL, i);
+  }
+  size_t num_missing = 0UL;
+  for (size_t i = 0; i < num_entries; ++i) {
+    num_missing += filter.MayContain(1UL + i % 3UL, i) ? 0UL : 1UL;
+  }
+  EXPECT_EQ(num_missing, 0UL);
+}
+
+FIXTURE(FalsePositiveRate) {
+  const size_t num_entries = 100000UL;
+  TBloomFilter filter(num_entries);
+  for (size_t i = 0; i < num_entries; ++i) {
+    filter.Add(1UL, i);
+  }
+  /* hashes we never added, and hashes we added but under a different number of fields */
+  size_t num_absent = 0UL, num_other_fields = 0UL;
+  for (size_t i = 0; i < num_entries; ++i) {
+    num_absent += filter.MayContain(1UL, num_entries + i) ? 1UL : 0UL;
+    num_other_fields += filter.MayContain(2UL, i) ? 1UL : 0UL;
+  }
+  /* we expect about 1.5%; allow some slack */
+  EXPECT_LT(num_absent, num_entries / 33UL);
+  EXPECT_LT(num_other_fields, num_entries / 33UL);
+}
+
+FIXTURE(Reload) {
+  TBloomFilter filter(1000UL);
+  for (size_t i = 0; i < 1000UL; ++i) {
+    filter.Add(2UL, i * 7919UL);
+  }
+  TBloomFilter loaded;
+  loaded.Reset(filter.GetNumWords(), filter.GetNumProbes());
+  memcpy(loaded.GetData(), filter.GetData(), filter.GetNumBytes());
+  bool all_present = true;
+  for (size_t i = 0; i < 1000UL; ++i) {
+    all_present = all_present && loaded.MayContain(2UL, i * 7919UL);
+  }
+  EXPECT_TRUE(all_present);
+}
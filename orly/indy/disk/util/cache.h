@@ -264,6 +264,18 @@ namespace Orly {
             TryRemoveSlotFunc = std::bind(&TCache::TryRemoveSlot, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
           }
 
+          /* The arena our pages live in, for registering with the disk controller. */
+          inline char *GetPageData() const {
+            assert(this);
+            return PageData.get();
+          }
+
+          /* The size of the arena in bytes. */
+          inline size_t GetPageDataSize() const {
+            assert(this);
+            return PageSize * MaxCacheSize;
+          }
+
           /* STATS */
           #ifdef PERF_STATS
           inline size_t GetMaxCacheSize() const {
@@ -25,6 +25,7 @@
 #include <stdexcept>
 
 #include <base/class_traits.h>
+#include <base/crc32c.h>
 #include <base/murmur.h>
 
 namespace Orly {
@@ -58,6 +59,25 @@ namespace Orly {
             }
           }
 
+          /* Write a CRC-32C of all but the last word of the buffer, seeded with the key, into the last word.  This is
+             what the devices use; it is several times faster than the murmur on hardware with SSE4.2. */
+          static void inline WriteCrc(size_t *buf, size_t buf_size, size_t key) {
+            *reinterpret_cast<uint64_t *>(reinterpret_cast<uint8_t *>(buf) + buf_size - sizeof(size_t)) = ComputeCrc(buf, buf_size, key);
+          }
+
+          /* True iff. the last word of the buffer holds the CRC-32C written by WriteCrc() with the same key. */
+          static bool inline TryReadCrc(size_t *buf, size_t buf_size, size_t key) {
+            uint64_t crc = *reinterpret_cast<uint64_t *>(reinterpret_cast<uint8_t *>(buf) + buf_size - sizeof(size_t));
+            return crc == ComputeCrc(buf, buf_size, key);
+          }
+
+          private:
+
+          /* The CRC-32C of the key followed by all but the last word of the buffer. */
+          static uint64_t inline ComputeCrc(const size_t *buf, size_t buf_size, size_t key) {
+            return Base::Crc32c(buf, buf_size - sizeof(size_t), Base::Crc32c(&key, sizeof(key)));
+          }
+
         };  // TCorruptionDetector
 
       }  // Util
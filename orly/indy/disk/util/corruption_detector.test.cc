@@ -161,4 +161,34 @@ FIXTURE(ParallelErrorChecking) {
   const size_t num_iter = num_per_cpu * num_cpu;
   EXPECT_EQ(total_passed, 0UL);
   EXPECT_EQ(total_errored, num_iter);
-}
\ No newline at end of file
+}
+
+FIXTURE(CrcBitErrors) {
+  const size_t num_iter = 5000UL;
+  size_t passed = 0UL;
+  size_t errored = 0UL;
+  size_t *data = nullptr;
+  const size_t data_size = getpagesize();
+  const size_t user_data_per_block = (data_size - sizeof(size_t)) / sizeof(size_t);
+  IfNe0(posix_memalign(reinterpret_cast<void **>(&data), getpagesize(), std::max(static_cast<int>(data_size), getpagesize())));
+  std::mt19937_64 engine;
+  for (size_t iter = 0; iter < num_iter; ++iter) {
+    const size_t offset = iter * 512;
+    for (size_t i = 0; i < user_data_per_block; ++i) {
+      data[i] = engine();
+    }
+    TCorruptionDetector::WriteCrc(data, data_size, offset);
+    if (TCorruptionDetector::TryReadCrc(data, data_size, offset) && !TCorruptionDetector::TryReadCrc(data, data_size, offset + 512)) {
+      ++passed;
+    }
+    IntroduceRandomBitError(data, data_size - sizeof(size_t), engine);
+    IntroduceRandomBitError(data, data_size - sizeof(size_t), engine);
+    IntroduceRandomBitError(data, data_size - sizeof(size_t), engine);
+    if (!TCorruptionDetector::TryReadCrc(data, data_size, offset)) {
+      ++errored;
+    }
+  }
+  EXPECT_EQ(passed, num_iter);
+  EXPECT_EQ(errored, num_iter);
+  free(data);
+}
@@ -27,6 +27,10 @@ using namespace Orly::Indy::Disk::Util;
 using namespace std;
 using namespace ::Util;
 
+constexpr uint64_t TDeviceUtil::MurmurChecksumVersion;
+constexpr uint64_t TDeviceUtil::CrcChecksumVersion;
+constexpr uint64_t TDeviceUtil::CurrentChecksumVersion;
+
 bool TDeviceUtil::ProbeDevice(const char *path, TOrlyDevice &out_device) {
   try {
     Base::TFd fd = open(path, O_RDONLY);
@@ -53,6 +57,7 @@ bool TDeviceUtil::ProbeDevice(const char *path, TOrlyDevice &out_device) {
       out_device.PhysicalBlockSize = buf.get()[PhysicalBlockSizePos];
       out_device.NumLogicalBlockExposed = buf.get()[NumLogicalBlockExposedPos];
       out_device.MinDiscardBlocks = buf.get()[MinDiscardBlocksPos];
+      out_device.ChecksumVersion = buf.get()[ChecksumVersionPos];
     } catch (...) {
       throw;
     }
@@ -81,6 +86,7 @@ void TDeviceUtil::ModifyDevice(const char *path, TOrlyDevice &new_device_info) {
     buf.get()[PhysicalBlockSizePos] = new_device_info.PhysicalBlockSize;
     buf.get()[NumLogicalBlockExposedPos] = new_device_info.NumLogicalBlockExposed;
     buf.get()[MinDiscardBlocksPos] = new_device_info.MinDiscardBlocks;
+    buf.get()[ChecksumVersionPos] = new_device_info.ChecksumVersion;
     buf.get()[NumDataElem] = Base::Murmur(buf.get(), NumDataElem, 0UL);
     IfLt0(pwrite(fd, buf.get(), BlockSize, 0UL));
     fsync(fd);
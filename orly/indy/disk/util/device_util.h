@@ -106,6 +106,15 @@ namespace Orly {
           static constexpr uint64_t PhysicalBlockSizePos = LogicalBlockSizePos + 1UL;
           static constexpr uint64_t NumLogicalBlockExposedPos = PhysicalBlockSizePos + 1UL;
           static constexpr uint64_t MinDiscardBlocksPos = NumLogicalBlockExposedPos + 1UL;
+          static constexpr uint64_t ChecksumVersionPos = MinDiscardBlocksPos + 1UL;
+
+          /* The checksums guarding a device's checked pages and sectors.  A super block written before we recorded this
+             reads back as zero, which is the murmur hash those devices were written with. */
+          static constexpr uint64_t MurmurChecksumVersion = 0UL;
+          static constexpr uint64_t CrcChecksumVersion = 1UL;
+
+          /* The checksum version we write, and the only one we can read. */
+          static constexpr uint64_t CurrentChecksumVersion = CrcChecksumVersion;
 
           struct TOrlyDevice {
             TVolumeId VolumeId;
@@ -121,6 +130,7 @@ namespace Orly {
             uint64_t PhysicalBlockSize;
             uint64_t NumLogicalBlockExposed;
             uint64_t MinDiscardBlocks;
+            uint64_t ChecksumVersion;
           };
 
           /* TODO */
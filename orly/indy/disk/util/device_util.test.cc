@@ -16,8 +16,13 @@
 
 #include <orly/indy/disk/util/device_util.h>
 
+#include <cstring>
+
+#include <base/tmp_file.h>
+
 #include <test/kit.h>
 
+using namespace Base;
 using namespace Orly::Indy::Disk::Util;
 
 FIXTURE(GetPathToDeviceInfo) {
@@ -37,4 +42,24 @@ FIXTURE(GetPathToPartitionInfo) {
   EXPECT_EQ(TDeviceUtil::GetPathToPartitionInfo("sdb6"), "/sys/block/sdb/sdb6/");
   EXPECT_EQ(TDeviceUtil::GetPathToPartitionInfo("sde0"), "/sys/block/sde/sde0/");
   EXPECT_EQ(TDeviceUtil::GetPathToPartitionInfo("sdaz19"), "/sys/block/sdaz/sdaz19/");
-}
\ No newline at end of file
+}
+
+FIXTURE(ChecksumVersion) {
+  TTmpFile tmp_file("/tmp/device_util_test_XXXXXX", true);
+  TDeviceUtil::TOrlyDevice device_info;
+  memset(&device_info, 0, sizeof(device_info));
+  device_info.ReplicationFactor = 1UL;
+  device_info.ChecksumVersion = TDeviceUtil::CurrentChecksumVersion;
+  TDeviceUtil::ModifyDevice(tmp_file.GetName(), device_info);
+  TDeviceUtil::TOrlyDevice probed;
+  if (EXPECT_TRUE(TDeviceUtil::ProbeDevice(tmp_file.GetName(), probed))) {
+    EXPECT_EQ(probed.ReplicationFactor, 1UL);
+    EXPECT_EQ(probed.ChecksumVersion, TDeviceUtil::CurrentChecksumVersion);
+  }
+  /* A super block written before we recorded the checksum version has a zero where it would be. */
+  device_info.ChecksumVersion = 0UL;
+  TDeviceUtil::ModifyDevice(tmp_file.GetName(), device_info);
+  if (EXPECT_TRUE(TDeviceUtil::ProbeDevice(tmp_file.GetName(), probed))) {
+    EXPECT_EQ(probed.ChecksumVersion, TDeviceUtil::MurmurChecksumVersion);
+  }
+}
@@ -48,7 +48,9 @@ namespace Orly {
                       size_t num_block_lru,
                       size_t append_log_mb,
                       bool create = false,
-                      bool no_realtime = false)
+                      bool no_realtime = false,
+                      TDiskController::TIoEngine io_engine = TDiskController::TIoEngine::Aio,
+                      bool io_uring_sq_poll = false)
             : Scheduler(scheduler),
               SystemBlockId(0UL),
               FileAppendLogBlocks((append_log_mb * 1024 * 1024) / Util::PhysicalBlockSize) {
@@ -124,7 +126,7 @@ namespace Orly {
                 }
               }
             };
-            DiskController = std::make_unique<TDiskController>();
+            DiskController = std::make_unique<TDiskController>(io_engine, io_uring_sq_poll);
             DiskUtil = std::make_unique<TDiskUtil>(scheduler, DiskController.get(), instance_name, do_fsync, CacheCb, true);
             VolMan = DiskUtil->GetVolumeManager(instance_name);
             std::vector<std::vector<TPersistentDevice *>> device_vec;
@@ -143,6 +145,8 @@ namespace Orly {
 
             PageCache = std::make_unique<Util::TPageCache>(VolMan, page_cache_size, num_page_lru);
             BlockCache = std::make_unique<Util::TBlockCache>(VolMan, block_cache_size, num_block_lru);
+            DiskController->RegisterBuffer(PageCache->GetPageData(), PageCache->GetPageDataSize());
+            DiskController->RegisterBuffer(BlockCache->GetPageData(), BlockCache->GetPageDataSize());
 
             std::unique_ptr<const TBufBlock> buf_block(new TBufBlock());
             memset(buf_block->GetData(), 0, PhysicalBlockSize);
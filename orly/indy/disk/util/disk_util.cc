@@ -44,6 +44,13 @@ TDiskUtil::TDiskUtil(Base::TScheduler *scheduler,
     bool ret = TDeviceUtil::ProbeDevice(path_to_device.c_str(), device_info);
     AllDeviceSet.emplace(path_to_device);
     if (ret && (!instance_filter || device_info.VolumeId.GetInstanceName() == *instance_filter)) {
+      if (device_info.ChecksumVersion != TDeviceUtil::CurrentChecksumVersion) {
+        syslog(LOG_ERR, "Device [%s] has checksum version [%ld], but we can only read version [%ld]; it must be reformatted",
+               path_to_device.c_str(),
+               device_info.ChecksumVersion,
+               TDeviceUtil::CurrentChecksumVersion);
+        throw std::runtime_error("Device has an unsupported checksum version");
+      }
       OrlyDeviceMap.emplace(path_to_device, device_info);
       auto ret = VolumeById.find(device_info.VolumeId);
       if (ret != VolumeById.end()) {
@@ -322,6 +329,7 @@ void TDiskUtil::CreateVolume(const std::string &instance_name,
   new_device_info.PhysicalBlockSize = physical_block_size;
   new_device_info.NumLogicalBlockExposed = min_logical_blocks;
   new_device_info.MinDiscardBlocks = std::max(8UL, num_blocks_required_for_discard);
+  new_device_info.ChecksumVersion = TDeviceUtil::CurrentChecksumVersion;
   for (size_t i = 0; i < num_devices; ++i, ++device_iter) {
     new_device_info.VolumeDeviceNumber = i;
     new_device_info.LogicalExtentStart = extent_vec[i / replication_factor].Start;
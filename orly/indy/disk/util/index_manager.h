@@ -24,7 +24,7 @@
 #include <inv_con/ordered_list.h>
 #include <orly/indy/disk/util/index_sort_file.h>
 #include <orly/indy/util/merge_sorter.h>
-#include <orly/indy/util/min_heap.h>
+#include <orly/indy/util/loser_tree.h>
 #include <orly/indy/util/sorter.h>
 
 namespace Orly {
@@ -62,11 +62,11 @@ namespace Orly {
                 CsrVec.push_back(std::unique_ptr<typename Indy::Util::TSorter<TVal, MemSize>::TCursor>(new typename TSortFile::TCursor(&*csr, read_ahead_per_csr)));
               }
               CsrVec.push_back(std::unique_ptr<typename Indy::Util::TSorter<TVal, MemSize>::TCursor>(new typename Indy::Util::TSorter<TVal, MemSize>::TMemCursor(&Manager->MemSorter)));
-              MinHeap = std::make_unique<Indy::Util::TMinHeap<TVal, size_t, TComparator>>(CsrVec.size(), manager->Comp);
+              LoserTree = std::make_unique<Indy::Util::TLoserTree<TVal, size_t, TComparator>>(CsrVec.size(), manager->Comp);
               for (size_t i = 0; i < CsrVec.size(); ++i) {
                 typename Indy::Util::TSorter<TVal, MemSize>::TCursor &csr = *CsrVec[i];
                 if (csr) {
-                  MinHeap->Insert(*csr, i);
+                  LoserTree->Insert(*csr, i);
                 }
               }
             }
@@ -79,45 +79,45 @@ namespace Orly {
             /* TODO */
             operator bool() const {
               assert(this);
-              return static_cast<bool>(*MinHeap);
+              return static_cast<bool>(*LoserTree);
             }
 
             /* TODO */
             const TVal &operator*() const {
               assert(this);
               #ifndef NDEBUG
-              if (!static_cast<bool>(*MinHeap)) {
-                throw std::logic_error("empty minheap");
+              if (!static_cast<bool>(*LoserTree)) {
+                throw std::logic_error("empty loser tree");
               }
               #endif
-              assert(static_cast<bool>(*MinHeap));
+              assert(static_cast<bool>(*LoserTree));
               size_t dummy;
-              return MinHeap->Peek(dummy);
+              return LoserTree->Peek(dummy);
             }
 
             /* TODO */
             const TVal *operator->() const {
               assert(this);
               #ifndef NDEBUG
-              if (!static_cast<bool>(*MinHeap)) {
-                throw std::logic_error("empty minheap");
+              if (!static_cast<bool>(*LoserTree)) {
+                throw std::logic_error("empty loser tree");
               }
               #endif
-              assert(static_cast<bool>(*MinHeap));
+              assert(static_cast<bool>(*LoserTree));
               size_t dummy;
-              return &(MinHeap->Peek(dummy));
+              return &(LoserTree->Peek(dummy));
             }
 
             /* TODO */
             TCursor &operator++() {
               assert(this);
               size_t pos = 0U;
-              MinHeap->Pop(pos);
+              LoserTree->Pop(pos);
               assert(pos < CsrVec.size());
               typename Indy::Util::TSorter<TVal, MemSize>::TCursor &csr = *CsrVec[pos];
               ++csr;
               if (csr) {
-                MinHeap->Insert(*csr, pos);
+                LoserTree->Insert(*csr, pos);
               }
               return *this;
             }
@@ -131,7 +131,7 @@ namespace Orly {
             std::vector<std::unique_ptr<typename Indy::Util::TSorter<TVal, MemSize>::TCursor>> CsrVec;
 
             /* TODO */
-            std::unique_ptr<Indy::Util::TMinHeap<TVal, size_t, TComparator>> MinHeap;
+            std::unique_ptr<Indy::Util::TLoserTree<TVal, size_t, TComparator>> LoserTree;
 
           };  // TCursor
 
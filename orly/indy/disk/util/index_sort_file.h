@@ -26,7 +26,7 @@
 #include <orly/indy/disk/util/engine.h>
 #include <orly/indy/disk/util/snappy.h>
 #include <orly/indy/util/block_vec.h>
-#include <orly/indy/util/min_heap.h>
+#include <orly/indy/util/loser_tree.h>
 #include <orly/indy/util/sorter.h>
 
 namespace Orly {
@@ -335,11 +335,11 @@ namespace Orly {
 
 
 
-                Indy::Util::TMinHeap<TVal, size_t, TComparator> min_heap(num_csr_required, comparator);
+                Indy::Util::TLoserTree<TVal, size_t, TComparator> loser_tree(num_csr_required, comparator);
                 for (size_t i = 0; i < csr_vec.size(); ++i) {
                   typename Indy::Util::TSorter<TVal, MemSize>::TCursor &csr = *csr_vec[i];
                   if (csr) {
-                    min_heap.Insert(*csr, i);
+                    loser_tree.Insert(*csr, i);
                   }
                 }
                 std::stringstream ss;
@@ -351,8 +351,8 @@ namespace Orly {
                   const size_t compressed_size = snappy::Compress(&block_source, &block_sink);
                   meta_stream << num_elem << compressed_size;
                 };
-                while (min_heap) {
-                  const TVal &v = min_heap.Pop(pos);
+                while (loser_tree) {
+                  const TVal &v = loser_tree.Pop(pos);
                   assert(pos < num_csr_required);
                   memcpy(buf_block->GetData() + cur_into_block * sizeof(TVal), &v, sizeof(TVal));
                   ++cur_into_block;
@@ -364,7 +364,7 @@ namespace Orly {
                   typename Indy::Util::TSorter<TVal, MemSize>::TCursor &csr = *csr_vec[pos];
                   ++csr;
                   if (csr) {
-                    min_heap.Insert(*csr, pos);
+                    loser_tree.Insert(*csr, pos);
                   }
                 }
                 if (cur_into_block > 0UL) {
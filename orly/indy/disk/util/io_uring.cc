@@ -0,0 +1,208 @@
+/* <orly/indy/disk/util/io_uring.cc>
+
+   Implements <orly/indy/disk/util/io_uring.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/disk/util/io_uring.h>
+
+#include <algorithm>
+#include <cerrno>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <syslog.h>
+#include <unistd.h>
+
+#include <util/error.h>
+
+using namespace std;
+using namespace Orly::Indy::Disk::Util;
+
+constexpr size_t TIoUring::MaxRegisteredBufferSize;
+
+/* glibc doesn't wrap these. */
+static int IoUringSetup(unsigned num_entries, struct io_uring_params *params) {
+  return static_cast<int>(syscall(SYS_io_uring_setup, num_entries, params));
+}
+
+static int IoUringEnter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+  return static_cast<int>(syscall(SYS_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0UL));
+}
+
+static int IoUringRegister(int fd, unsigned opcode, const void *arg, unsigned nr_args) {
+  return static_cast<int>(syscall(SYS_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+/* Map a region of the ring at the given offset. */
+static void *MapRing(int fd, size_t size, off_t offset) {
+  void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+  if (ptr == MAP_FAILED) {
+    ::Util::ThrowSystemError(errno);
+  }
+  return ptr;
+}
+
+/* A field of a mapped ring. */
+template <typename TVal>
+static TVal *GetField(void *ring, unsigned offset) {
+  return reinterpret_cast<TVal *>(reinterpret_cast<char *>(ring) + offset);
+}
+
+TIoUring::TIoUring(size_t num_entries, bool sq_poll)
+    : SqPoll(false),
+      HasBuffers(false),
+      SqRing(nullptr),
+      SqRingSize(0UL),
+      CqRing(nullptr),
+      CqRingSize(0UL),
+      Sqes(nullptr),
+      SqesSize(0UL),
+      SqeTail(0U),
+      SubmittedTail(0U) {
+  struct io_uring_params params;
+  int fd = -1;
+  if (sq_poll) {
+    params = io_uring_params();
+    params.flags = IORING_SETUP_SQPOLL;
+    params.sq_thread_idle = 10U;  // ms before the poller goes to sleep
+    fd = IoUringSetup(static_cast<unsigned>(num_entries), &params);
+    if (fd < 0) {
+      syslog(LOG_WARNING, "io_uring: could not get a submission queue polling thread (errno %d); submitting with system calls", errno);
+    } else {
+      SqPoll = true;
+    }
+  }
+  if (fd < 0) {
+    params = io_uring_params();
+    fd = IoUringSetup(static_cast<unsigned>(num_entries), &params);
+  }
+  RingFd = Base::TFd(fd);
+  try {
+    SqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    const size_t cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+      SqRingSize = max(SqRingSize, cq_ring_size);
+      SqRing = MapRing(RingFd, SqRingSize, IORING_OFF_SQ_RING);
+      CqRing = SqRing;
+    } else {
+      SqRing = MapRing(RingFd, SqRingSize, IORING_OFF_SQ_RING);
+      CqRingSize = cq_ring_size;
+      CqRing = MapRing(RingFd, CqRingSize, IORING_OFF_CQ_RING);
+    }
+    SqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    Sqes = reinterpret_cast<struct io_uring_sqe *>(MapRing(RingFd, SqesSize, IORING_OFF_SQES));
+  } catch (...) {
+    if (CqRingSize) {
+      munmap(CqRing, CqRingSize);
+    }
+    if (SqRing) {
+      munmap(SqRing, SqRingSize);
+    }
+    throw;
+  }
+  SqHead = GetField<atomic<unsigned>>(SqRing, params.sq_off.head);
+  SqTail = GetField<atomic<unsigned>>(SqRing, params.sq_off.tail);
+  SqMask = GetField<const unsigned>(SqRing, params.sq_off.ring_mask);
+  SqFlags = GetField<atomic<unsigned>>(SqRing, params.sq_off.flags);
+  NumSqEntries = params.sq_entries;
+  CqHead = GetField<atomic<unsigned>>(CqRing, params.cq_off.head);
+  CqTail = GetField<atomic<unsigned>>(CqRing, params.cq_off.tail);
+  CqMask = GetField<const unsigned>(CqRing, params.cq_off.ring_mask);
+  Cqes = GetField<const struct io_uring_cqe>(CqRing, params.cq_off.cqes);
+  /* Entry i of the submission ring always names sqe i, so filling in an sqe is all it takes to queue it. */
+  unsigned *array = GetField<unsigned>(SqRing, params.sq_off.array);
+  for (unsigned i = 0; i < NumSqEntries; ++i) {
+    array[i] = i;
+  }
+  SqeTail = SubmittedTail = atomic_load_explicit(SqTail, memory_order_relaxed);
+}
+
+TIoUring::~TIoUring() {
+  assert(this);
+  munmap(Sqes, SqesSize);
+  if (CqRingSize) {
+    munmap(CqRing, CqRingSize);
+  }
+  munmap(SqRing, SqRingSize);
+}
+
+size_t TIoUring::Submit(bool wait) {
+  assert(this);
+  const size_t num_published = SqeTail - SubmittedTail;
+  if (num_published) {
+    atomic_store_explicit(SqTail, SqeTail, memory_order_release);
+    SubmittedTail = SqeTail;
+  }
+  unsigned flags = wait ? IORING_ENTER_GETEVENTS : 0U;
+  unsigned to_submit;
+  if (SqPoll) {
+    /* The poller picks up the new tail on its own, unless it has gone to sleep. */
+    to_submit = num_published;
+    if (num_published && (atomic_load_explicit(SqFlags, memory_order_acquire) & IORING_SQ_NEED_WAKEUP)) {
+      flags |= IORING_ENTER_SQ_WAKEUP;
+    }
+    if (!flags) {
+      return num_published;
+    }
+  } else {
+    /* Anything the kernel didn't take last time is still between its head and our tail. */
+    to_submit = SqeTail - atomic_load_explicit(SqHead, memory_order_acquire);
+    if (!to_submit && !wait) {
+      return 0UL;
+    }
+  }
+  for (;;) {
+    if (IoUringEnter(RingFd, to_submit, wait ? 1U : 0U, flags) >= 0) {
+      break;
+    }
+    switch (errno) {
+      case EINTR: {
+        continue;
+      }
+      case EAGAIN:
+      case EBUSY: {
+        /* The completion ring is backed up; the caller will reap and try again. */
+        return num_published;
+      }
+      default: {
+        ::Util::ThrowSystemError(errno);
+      }
+    }
+  }
+  return num_published;
+}
+
+bool TIoUring::TryRegisterBuffers(const vector<struct iovec> &buffer_vec) {
+  assert(this);
+  UnregisterBuffers();
+  if (buffer_vec.empty()) {
+    return true;
+  }
+  if (IoUringRegister(RingFd, IORING_REGISTER_BUFFERS, buffer_vec.data(), static_cast<unsigned>(buffer_vec.size())) < 0) {
+    syslog(LOG_WARNING, "io_uring: could not register [%ld] buffers (errno %d); using unregistered I/O", buffer_vec.size(), errno);
+    return false;
+  }
+  HasBuffers = true;
+  return true;
+}
+
+void TIoUring::UnregisterBuffers() {
+  assert(this);
+  if (HasBuffers) {
+    ::Util::IfLt0(IoUringRegister(RingFd, IORING_UNREGISTER_BUFFERS, nullptr, 0U));
+    HasBuffers = false;
+  }
+}
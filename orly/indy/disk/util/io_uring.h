@@ -0,0 +1,161 @@
+/* <orly/indy/disk/util/io_uring.h>
+
+   A thin wrapper around a Linux io_uring instance, driven through the raw system calls.
+
+   The disk controller uses one of these per queue runner.  Submission queue entries are filled in place and published
+   in batches with a single io_uring_enter() (or none at all when the kernel is polling the submission queue), and
+   completions are reaped straight out of the shared completion ring without a system call.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+#include <base/class_traits.h>
+#include <base/fd.h>
+
+namespace Orly {
+
+  namespace Indy {
+
+    namespace Disk {
+
+      namespace Util {
+
+        /* An io_uring instance.  Only one thread may use a ring at a time. */
+        class TIoUring {
+          NO_COPY(TIoUring);
+          public:
+
+          /* The largest buffer the kernel will let us register in one piece. */
+          static constexpr size_t MaxRegisteredBufferSize = 1UL << 30;
+
+          /* Set up a ring with room for at least 'num_entries' submissions.  If 'sq_poll' is true, we ask the kernel for a
+             thread to poll the submission queue; if it won't give us one (older kernels require root), we fall back to
+             a plain ring.  Throws if the kernel doesn't support io_uring at all. */
+          TIoUring(size_t num_entries, bool sq_poll);
+
+          /* Unmaps the rings and closes the ring. */
+          ~TIoUring();
+
+          /* The next free submission queue entry, cleared, or null if the submission queue is full.  The entry isn't
+             seen by the kernel until the next call to Submit(). */
+          struct io_uring_sqe *TryGetSqe() {
+            assert(this);
+            if (SqeTail - std::atomic_load_explicit(SqHead, std::memory_order_acquire) >= NumSqEntries) {
+              return nullptr;
+            }
+            struct io_uring_sqe *sqe = &Sqes[SqeTail & *SqMask];
+            ++SqeTail;
+            *sqe = io_uring_sqe();
+            return sqe;
+          }
+
+          /* Publish every entry we've filled in since the last call and, if 'wait' is true, block until at least one
+             completion is ready.  Returns the number of entries handed to the kernel. */
+          size_t Submit(bool wait);
+
+          /* Call cb(user_data, res) for each completion which is ready, then hand the completion slots back to the kernel.
+             Returns the number of completions reaped. */
+          template <typename TCb>
+          size_t ForEachCompletion(const TCb &cb) {
+            assert(this);
+            unsigned head = std::atomic_load_explicit(CqHead, std::memory_order_relaxed);
+            const unsigned tail = std::atomic_load_explicit(CqTail, std::memory_order_acquire);
+            size_t num_reaped = 0UL;
+            for (; head != tail; ++head, ++num_reaped) {
+              const struct io_uring_cqe &cqe = Cqes[head & *CqMask];
+              cb(cqe.user_data, cqe.res);
+            }
+            std::atomic_store_explicit(CqHead, head, std::memory_order_release);
+            return num_reaped;
+          }
+
+          /* Register the given buffers with the kernel, replacing any we registered before, so reads and writes which
+             land entirely within one of them can skip pinning and mapping pages per I/O.  Buffers are indexed in the
+             order given.  Returns false (and leaves no buffers registered) if the kernel refused, usually because of
+             RLIMIT_MEMLOCK. */
+          bool TryRegisterBuffers(const std::vector<struct iovec> &buffer_vec);
+
+          /* The number of submissions the ring can hold. */
+          size_t GetNumEntries() const {
+            assert(this);
+            return NumSqEntries;
+          }
+
+          /* True iff. the kernel is polling our submission queue. */
+          bool IsSqPolling() const {
+            assert(this);
+            return SqPoll;
+          }
+
+          private:
+
+          /* Release any buffers we've registered. */
+          void UnregisterBuffers();
+
+          /* The ring. */
+          Base::TFd RingFd;
+
+          /* See accessor. */
+          bool SqPoll;
+
+          /* True iff. we've registered buffers with the kernel. */
+          bool HasBuffers;
+
+          /* The mapped rings.  When the kernel supports IORING_FEAT_SINGLE_MMAP, the completion ring shares the
+             submission ring's mapping and CqRingSize is zero. */
+          void *SqRing;
+          size_t SqRingSize;
+          void *CqRing;
+          size_t CqRingSize;
+
+          /* The mapped submission queue entries. */
+          struct io_uring_sqe *Sqes;
+          size_t SqesSize;
+
+          /* Fields of the submission ring. */
+          std::atomic<unsigned> *SqHead;
+          std::atomic<unsigned> *SqTail;
+          const unsigned *SqMask;
+          std::atomic<unsigned> *SqFlags;
+          unsigned NumSqEntries;
+
+          /* Fields of the completion ring. */
+          std::atomic<unsigned> *CqHead;
+          std::atomic<unsigned> *CqTail;
+          const unsigned *CqMask;
+          const struct io_uring_cqe *Cqes;
+
+          /* One past the last entry handed out by TryGetSqe(), and the tail as of the last Submit(). */
+          unsigned SqeTail;
+          unsigned SubmittedTail;
+
+        };  // TIoUring
+
+      }  // Util
+
+    }  // Disk
+
+  }  // Indy
+
+}  // Orly
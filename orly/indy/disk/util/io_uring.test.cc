@@ -0,0 +1,127 @@
+/* <orly/indy/disk/util/io_uring.test.cc>
+
+   Unit test for <orly/indy/disk/util/io_uring.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/disk/util/io_uring.h>
+
+#include <cstring>
+#include <vector>
+
+#include <base/tmp_file.h>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Base;
+using namespace Orly::Indy::Disk::Util;
+
+static const size_t BufSize = 4096UL;
+
+/* Queue a read or write of 'buf' at 'offset', tagged with 'tag'.  A non-negative 'buf_index' makes it a fixed-buffer op. */
+static void Prep(TIoUring &ring, uint8_t op, int fd, char *buf, size_t offset, uint64_t tag, int buf_index = -1) {
+  struct io_uring_sqe *sqe = ring.TryGetSqe();
+  if (EXPECT_TRUE(sqe)) {
+    sqe->opcode = op;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buf);
+    sqe->len = BufSize;
+    sqe->off = offset;
+    sqe->user_data = tag;
+    if (buf_index >= 0) {
+      sqe->buf_index = static_cast<uint16_t>(buf_index);
+    }
+  }
+}
+
+/* Wait for 'num' completions, checking that each moved a whole buffer, and return the sum of their tags. */
+static uint64_t Reap(TIoUring &ring, size_t num) {
+  uint64_t tag_sum = 0UL;
+  size_t num_bad = 0UL;
+  while (num) {
+    ring.Submit(true);
+    num -= ring.ForEachCompletion([&tag_sum, &num_bad](uint64_t tag, int res) {
+      tag_sum += tag;
+      if (res != static_cast<int>(BufSize)) {
+        ++num_bad;
+      }
+    });
+  }
+  EXPECT_EQ(num_bad, 0UL);
+  return tag_sum;
+}
+
+static void ReadWrite(bool sq_poll, bool fixed) {
+  TTmpFile tmp_file("/tmp/io_uring_test_XXXXXX", true);
+  TIoUring ring(8UL, sq_poll);
+  const size_t num_buf = 4UL;
+  vector<char> write_vec(num_buf * BufSize), read_vec(num_buf * BufSize, 0);
+  for (size_t i = 0; i < write_vec.size(); ++i) {
+    write_vec[i] = static_cast<char>(i * 7 + i / BufSize);
+  }
+  int write_idx = -1, read_idx = -1;
+  if (fixed) {
+    vector<struct iovec> iov_vec{{ write_vec.data(), write_vec.size() }, { read_vec.data(), read_vec.size() }};
+    if (!ring.TryRegisterBuffers(iov_vec)) {
+      /* not enough locked memory allowed here; nothing more to check */
+      return;
+    }
+    write_idx = 0;
+    read_idx = 1;
+  }
+  for (size_t i = 0; i < num_buf; ++i) {
+    Prep(ring, fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE, tmp_file.GetFd(), &write_vec[i * BufSize], i * BufSize, i + 1, write_idx);
+  }
+  EXPECT_EQ(Reap(ring, num_buf), 10UL);
+  for (size_t i = 0; i < num_buf; ++i) {
+    Prep(ring, fixed ? IORING_OP_READ_FIXED : IORING_OP_READ, tmp_file.GetFd(), &read_vec[i * BufSize], i * BufSize, i + 1, read_idx);
+  }
+  EXPECT_EQ(Reap(ring, num_buf), 10UL);
+  EXPECT_TRUE(memcmp(write_vec.data(), read_vec.data(), write_vec.size()) == 0);
+}
+
+FIXTURE(ReadWrite) {
+  ReadWrite(false, false);
+}
+
+FIXTURE(RegisteredBuffers) {
+  ReadWrite(false, true);
+}
+
+FIXTURE(SqPoll) {
+  /* falls back to a plain ring where we aren't allowed a poller */
+  ReadWrite(true, true);
+}
+
+FIXTURE(Full) {
+  TIoUring ring(4UL, false);
+  const size_t num_entries = ring.GetNumEntries();
+  for (size_t i = 0; i < num_entries; ++i) {
+    struct io_uring_sqe *sqe = ring.TryGetSqe();
+    if (EXPECT_TRUE(sqe)) {
+      sqe->opcode = IORING_OP_NOP;
+      sqe->user_data = i;
+    }
+  }
+  EXPECT_FALSE(ring.TryGetSqe());
+  EXPECT_EQ(ring.Submit(false), num_entries);
+  size_t num_reaped = 0UL;
+  while (num_reaped < num_entries) {
+    ring.Submit(true);
+    num_reaped += ring.ForEachCompletion([](uint64_t, int) {});
+  }
+  EXPECT_TRUE(ring.TryGetSqe());
+}
@@ -30,6 +30,7 @@
 #include <base/timer.h>
 #include <base/zero.h>
 #include <orly/indy/disk/util/corruption_detector.h>
+#include <orly/indy/disk/util/io_uring.h>
 
 using namespace std;
 using namespace Base;
@@ -39,6 +40,13 @@ using namespace ::Util;
 std::unique_ptr<Base::TThreadLocalGlobalPoolManager<TDiskController::TEvent>> TDiskController::TEvent::DiskEventPoolManager;
 __thread Base::TThreadLocalGlobalPoolManager<TDiskController::TEvent>::TThreadLocalPool *TDiskController::TEvent::LocalEventPool = nullptr;
 
+constexpr size_t TDiskController::RealTimeQueueDepth;
+constexpr size_t TDiskController::MediumQueueDepth;
+constexpr size_t TDiskController::LowQueueDepth;
+constexpr size_t TDiskController::MaxAioEvents;
+constexpr size_t TDiskController::MaxInlineVerifySize;
+constexpr size_t TDiskController::DefaultNumVerifiers;
+
 namespace Orly {
 
   namespace Indy {
@@ -129,29 +137,47 @@ namespace Orly {
 
 }
 
-TDiskController::TDiskController()
-    : DeviceCollection(this)
+TDiskController::TDiskController(TIoEngine io_engine, bool sq_poll, size_t num_verifiers)
+    : DeviceCollection(this),
+      IoEngine(io_engine),
+      SqPoll(sq_poll),
+      NumBuffers(0UL),
+      VerifyHead(nullptr),
+      VerifyTail(nullptr),
+      VerifyShutdown(false)
 #ifndef NDEBUG
     ,NextId(0UL)
 #endif
 {
+  for (size_t i = 0; i < num_verifiers; ++i) {
+    VerifierVec.emplace_back(&TDiskController::VerifierMain, this);
+  }
 }
 
 TDiskController::~TDiskController() {
+  /* shut down the verifiers */ {
+    std::lock_guard<std::mutex> lock(VerifyMutex);
+    VerifyShutdown = true;
+  }
+  VerifyCond.notify_all();
+  for (auto &verifier : VerifierVec) {
+    verifier.join();
+  }
 }
 
-void TDiskController::QueueRunner(std::vector<TPersistentDevice *> device_vec, bool no_realtime, size_t core) {
+void TDiskController::RegisterBuffer(void *buf, size_t size) {
   assert(this);
-  const size_t max_aio_num = 64;
-  size_t inflight = 0UL;
-
-  io_context_t ctxp(0);
-  try {
-    IfWeird(io_setup(max_aio_num, &ctxp));
-  } catch (const std::exception &ex) {
-    syslog(LOG_ERR, "Error in io_setup: [%s]", ex.what());
-    throw;
+  assert(buf);
+  std::lock_guard<std::mutex> lock(BufferMutex);
+  /* the kernel takes at most 1GB per registered buffer, so big arenas go in as several */
+  for (size_t pos = 0UL; pos < size; pos += TIoUring::MaxRegisteredBufferSize) {
+    BufferVec.push_back(iovec{ reinterpret_cast<char *>(buf) + pos, std::min(TIoUring::MaxRegisteredBufferSize, size - pos) });
   }
+  NumBuffers = BufferVec.size();
+}
+
+void TDiskController::QueueRunner(std::vector<TPersistentDevice *> device_vec, bool no_realtime, size_t core) {
+  assert(this);
   cpu_set_t mask;
   CPU_ZERO(&mask);
   CPU_SET(core, &mask);
@@ -160,386 +186,643 @@ void TDiskController::QueueRunner(std::vector<TPersistentDevice *> device_vec, b
   if (!no_realtime) {
     booster.MakeKnown(SCHED_FIFO);
   }
-  const size_t rt_not_to_exceed_depth = 32UL;
-  const size_t medium_not_to_exceed_depth = 6UL;
-  const size_t low_not_to_exceed_depth = 2UL;
-  struct iocb *ioq[std::max(rt_not_to_exceed_depth, std::max(medium_not_to_exceed_depth, low_not_to_exceed_depth)) * device_vec.size()];
-  struct io_event *io_ev = 0;
-  io_ev = new struct io_event[max_aio_num];
   try {
-    memset(io_ev, 0, max_aio_num * sizeof(struct io_event));
-    size_t num_laps_without_work = 0UL;
-    const timespec lap_wait{0, 10000UL};
-    const size_t laps_before_sleep = 5UL;
-    for (;;) {
-      ++num_laps_without_work;
-      if (num_laps_without_work > laps_before_sleep) {
-        nanosleep(&lap_wait, NULL);
+    if (IoEngine == TIoEngine::IoUring) {
+      const size_t max_inflight = RealTimeQueueDepth * device_vec.size();
+      std::unique_ptr<TIoUring> ring;
+      try {
+        ring = std::make_unique<TIoUring>(std::max(max_inflight, MaxAioEvents), SqPoll);
+      } catch (const std::exception &ex) {
+        syslog(LOG_WARNING, "Could not set up io_uring [%s]; falling back to aio", ex.what());
       }
-      /* wait for a queue to be ready */
-      for (TPersistentDevice *ready_device : device_vec) {
-        TEvent *cur_tail = __sync_lock_test_and_set(&ready_device->IncomingEventQueue, nullptr);
-        if (cur_tail) {
-          num_laps_without_work = 0UL;
-          /* there were inbound events scheduled against this device. Process these events (which are in reverse order) and put them into their
-             Realtime / Medium / Low priority queues. */
-          TEvent *append_after_rt = ready_device->RealTimePrioEventQueue.TryGetLastMember();
-          TEvent *append_after_m = ready_device->MediumPrioEventQueue.TryGetLastMember();
-          TEvent *append_after_l = ready_device->LowPrioEventQueue.TryGetLastMember();
-          size_t num_dequeue = 0UL;
-          for (TEvent *cur_event = cur_tail; cur_event; cur_event = cur_event->NextEvent, ++num_dequeue) {
-            switch (cur_event->Iocb.aio_reqprio) {
-              case RealTimePriority: {
-                if (append_after_rt) {
-                  cur_event->DeviceMembership.Insert(&append_after_rt->DeviceMembership, InvCon::Fwd);
-                } else {
-                  cur_event->DeviceMembership.Insert(&ready_device->RealTimePrioEventQueue, InvCon::Rev);
-                }
-                break;
-              }
-              case MediumPriority: {
-                if (append_after_m) {
-                  cur_event->DeviceMembership.Insert(&append_after_m->DeviceMembership, InvCon::Fwd);
-                } else {
-                  cur_event->DeviceMembership.Insert(&ready_device->MediumPrioEventQueue, InvCon::Rev);
-                }
-                break;
-              }
-              case LowPriority: {
-                if (append_after_l) {
-                  cur_event->DeviceMembership.Insert(&append_after_l->DeviceMembership, InvCon::Fwd);
-                } else {
-                  cur_event->DeviceMembership.Insert(&ready_device->LowPrioEventQueue, InvCon::Rev);
-                }
-                break;
-              }
+      if (ring) {
+        RunIoUring(*ring, device_vec);
+        return;
+      }
+    }
+    RunAio(device_vec);
+  } catch (const std::exception &ex) {
+    syslog(LOG_ERR, "QueueRunner caught error [%s]", ex.what());
+    throw;
+  } catch (...) {
+    throw;
+  }
+}
+
+void TDiskController::RunAio(const std::vector<TPersistentDevice *> &device_vec) {
+  assert(this);
+  size_t inflight = 0UL;
+
+  io_context_t ctxp(0);
+  try {
+    IfWeird(io_setup(MaxAioEvents, &ctxp));
+  } catch (const std::exception &ex) {
+    syslog(LOG_ERR, "Error in io_setup: [%s]", ex.what());
+    throw;
+  }
+  std::vector<TEvent *> event_vec(RealTimeQueueDepth * device_vec.size());
+  std::vector<TEvent *> completed_vec;
+  completed_vec.reserve(MaxAioEvents);
+  struct iocb *ioq[RealTimeQueueDepth * device_vec.size()];
+  struct io_event *io_ev = 0;
+  io_ev = new struct io_event[MaxAioEvents];
+  memset(io_ev, 0, MaxAioEvents * sizeof(struct io_event));
+  size_t num_laps_without_work = 0UL;
+  const timespec lap_wait{0, 10000UL};
+  const size_t laps_before_sleep = 5UL;
+  for (;;) {
+    ++num_laps_without_work;
+    if (num_laps_without_work > laps_before_sleep) {
+      nanosleep(&lap_wait, NULL);
+    }
+    bool found_work = DrainIncomingEvents(device_vec);
+    const size_t ioq_pos = DequeueEvents(device_vec, event_vec.data(), found_work);
+    if (found_work) {
+      num_laps_without_work = 0UL;
+    }
+
+    if (ioq_pos > 0) {
+      for (size_t i = 0; i < ioq_pos; ++i) {
+        ioq[i] = &event_vec[i]->Iocb;
+      }
+      inflight += ioq_pos;
+      int ret = io_submit(ctxp, ioq_pos, ioq);
+      if (ret < 0) {
+        syslog(LOG_ERR, "Error in io_submit; nr=[%ld]", ioq_pos);
+        for (size_t nr = 0; nr < ioq_pos; ++nr) {
+          switch (ioq[nr]->aio_lio_opcode) {
+            case IO_CMD_PREAD: {
+              syslog(LOG_INFO, "ioq[%ld] IO_CMD_PREAD, offset=[%lld], nbytes=[%ld]", nr, ioq[nr]->u.c.offset, ioq[nr]->u.c.nbytes);
+              break;
+            }
+            case IO_CMD_PWRITE: {
+              syslog(LOG_INFO, "ioq[%ld] IO_CMD_PWRITE, offset=[%lld], nbytes=[%ld]", nr, ioq[nr]->u.c.offset, ioq[nr]->u.c.nbytes);
+              break;
+            }
+            case IO_CMD_FSYNC: {
+              throw;
+              break;
+            }
+            case IO_CMD_FDSYNC: {
+              throw;
+              break;
+            }
+            case IO_CMD_POLL: {
+              throw;
+              break;
+            }
+            case IO_CMD_NOOP: {
+              throw;
+              break;
+            }
+            case IO_CMD_PREADV: {
+              syslog(LOG_INFO, "ioq[%ld] IO_CMD_PREADV, nr=[%d], offset=[%lld], size=[%ld]", nr, ioq[nr]->u.v.nr, ioq[nr]->u.v.offset, ioq[nr]->u.v.vec[0].iov_len);
+              break;
+            }
+            case IO_CMD_PWRITEV: {
+              syslog(LOG_INFO, "ioq[%ld] IO_CMD_PWRITEV, nr=[%d], offset=[%lld], size=[%ld]", nr, ioq[nr]->u.v.nr, ioq[nr]->u.v.offset, ioq[nr]->u.v.vec[0].iov_len);
+              break;
             }
           }
         }
+        ThrowSystemError(-ret);
       }
-      size_t ioq_pos = 0UL;
-      for (TPersistentDevice *ready_device : device_vec) {
-        if (!ready_device->RealTimePrioEventQueue.IsEmpty() || !ready_device->MediumPrioEventQueue.IsEmpty() || !ready_device->LowPrioEventQueue.IsEmpty()) {
-          num_laps_without_work = 0UL;
-          size_t num_removed = 0UL;
-          size_t cur_inflight = ready_device->Inflight.load();
-          for (TEvent *member = ready_device->RealTimePrioEventQueue.TryGetFirstMember(); member && (cur_inflight + num_removed) < rt_not_to_exceed_depth/*num_removed < max_to_submit*/; member = ready_device->RealTimePrioEventQueue.TryGetFirstMember(), ++num_removed) {
-            ioq[ioq_pos] = &(member->Iocb);
-            ++ioq_pos;
-            member->DeviceMembership.Remove();
+      if (ret != static_cast<int>(ioq_pos)) {
+        syslog(LOG_ERR, "io_submit did not sumbit as as many events as requested [%ld] vs. [%d]", ioq_pos, ret);
+        throw;
+      }
+    }
+
+    if (inflight > 0) {
+      int num_popped = io_getevents(ctxp, 1, MaxAioEvents, io_ev, NULL);
+      if (num_popped > 0) {
+        inflight -= num_popped;
+      }
+      try {
+        #ifndef NDEBUG
+        for (int i = 0; i < num_popped; ++i) {
+          RetireRequestId(reinterpret_cast<TEvent *>(io_ev[i].data));
+        }
+        #endif
+        for (int i = 0; i < num_popped; ++i) {
+          TEvent *compl_event = reinterpret_cast<TEvent *>(io_ev[i].data);
+          if (Complete(compl_event, io_ev[i].res, io_ev[i].res2)) {
+            completed_vec.push_back(compl_event);
           }
-          for (TEvent *member = ready_device->MediumPrioEventQueue.TryGetFirstMember(); member && (cur_inflight + num_removed) < medium_not_to_exceed_depth/*num_removed < max_to_submit*/; member = ready_device->MediumPrioEventQueue.TryGetFirstMember(), ++num_removed) {
-            ioq[ioq_pos] = &(member->Iocb);
-            ++ioq_pos;
-            member->DeviceMembership.Remove();
+        }
+        /* now that we're done completing all the events, reset them and give them back to their pool. */
+        for (TEvent *compl_event : completed_vec) {
+          compl_event->Reset(true);
+        }
+        completed_vec.clear();
+      } catch (const std::exception &ex) {
+        syslog(LOG_ERR, "QueueRunner caught error while iterating over completion events");
+        throw;
+      }
+    }
+  }
+}
+
+void TDiskController::RunIoUring(TIoUring &ring, const std::vector<TPersistentDevice *> &device_vec) {
+  assert(this);
+  assert(&ring);
+  const size_t max_inflight = RealTimeQueueDepth * device_vec.size();
+  assert(ring.GetNumEntries() >= max_inflight);
+  size_t inflight = 0UL;
+  std::vector<TEvent *> event_vec(max_inflight);
+  std::vector<TEvent *> completed_vec;
+  completed_vec.reserve(max_inflight);
+  /* the buffers registered with the ring, and how many of the controller's buffers we've looked at */
+  std::vector<struct iovec> registered_vec;
+  size_t num_buffers_seen = 0UL;
+  /* Spin for a few laps when we run dry, then sleep between laps.  After a long quiet spell, sleep longer. */
+  size_t num_laps_without_work = 0UL;
+  const timespec lap_wait{0, 10000UL};
+  const timespec idle_wait{0, 50000UL};
+  const size_t laps_before_sleep = 5UL;
+  const size_t laps_before_idle = 10000UL;
+  for (;;) {
+    /* The kernel won't swap the registered buffers out from under I/O in flight, so only pick up new ones when we're
+       quiet. */
+    if (!inflight && NumBuffers.load(std::memory_order_relaxed) != num_buffers_seen) {
+      std::lock_guard<std::mutex> lock(BufferMutex);
+      num_buffers_seen = BufferVec.size();
+      registered_vec = BufferVec;
+      if (!ring.TryRegisterBuffers(registered_vec)) {
+        registered_vec.clear();
+      }
+    }
+    bool found_work = DrainIncomingEvents(device_vec);
+    const size_t num_dequeued = DequeueEvents(device_vec, event_vec.data(), found_work);
+    for (size_t i = 0; i < num_dequeued; ++i) {
+      struct io_uring_sqe *sqe = ring.TryGetSqe();
+      assert(sqe);
+      PrepSqe(sqe, event_vec[i], registered_vec);
+    }
+    inflight += num_dequeued;
+    /* publish the whole batch at once; a single system call at most, and none if the kernel is polling for us */
+    ring.Submit(false);
+    auto reap = [this, &ring, &completed_vec]() {
+      return ring.ForEachCompletion([this, &completed_vec](uint64_t user_data, int res) {
+        TEvent *compl_event = reinterpret_cast<TEvent *>(user_data);
+        #ifndef NDEBUG
+        RetireRequestId(compl_event);
+        #endif
+        /* io_uring reports errors as a negative errno in place of the byte count */
+        if (Complete(compl_event, static_cast<unsigned long>(static_cast<long>(res)), 0UL)) {
+          completed_vec.push_back(compl_event);
+        }
+      });
+    };
+    size_t num_reaped = reap();
+    if (!num_reaped && inflight && !found_work) {
+      /* nothing new to send and nothing finished yet, so block until something does */
+      ring.Submit(true);
+      num_reaped = reap();
+    }
+    inflight -= num_reaped;
+    /* now that we're done completing all the events, reset them and give them back to their pool. */
+    for (TEvent *compl_event : completed_vec) {
+      compl_event->Reset(true);
+    }
+    completed_vec.clear();
+    if (found_work || num_reaped) {
+      num_laps_without_work = 0UL;
+    } else if (!inflight) {
+      ++num_laps_without_work;
+      if (num_laps_without_work > laps_before_idle) {
+        nanosleep(&idle_wait, NULL);
+      } else if (num_laps_without_work > laps_before_sleep) {
+        nanosleep(&lap_wait, NULL);
+      }
+    }
+  }
+}
+
+void TDiskController::PrepSqe(struct io_uring_sqe *sqe, TEvent *event, const std::vector<struct iovec> &registered_vec) {
+  assert(sqe);
+  assert(event);
+  const struct iocb &io = event->Iocb;
+  sqe->fd = io.aio_fildes;
+  sqe->user_data = reinterpret_cast<uint64_t>(event);
+  switch (io.aio_lio_opcode) {
+    case IO_CMD_PREAD:
+    case IO_CMD_PWRITE: {
+      const bool is_read = io.aio_lio_opcode == IO_CMD_PREAD;
+      sqe->addr = reinterpret_cast<uint64_t>(io.u.c.buf);
+      sqe->len = static_cast<uint32_t>(io.u.c.nbytes);
+      sqe->off = io.u.c.offset;
+      sqe->opcode = is_read ? IORING_OP_READ : IORING_OP_WRITE;
+      const char *start = reinterpret_cast<const char *>(io.u.c.buf);
+      for (size_t i = 0; i < registered_vec.size(); ++i) {
+        const char *base = reinterpret_cast<const char *>(registered_vec[i].iov_base);
+        if (start >= base && start + io.u.c.nbytes <= base + registered_vec[i].iov_len) {
+          sqe->opcode = is_read ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+          sqe->buf_index = static_cast<uint16_t>(i);
+          break;
+        }
+      }
+      break;
+    }
+    case IO_CMD_PREADV: {
+      sqe->opcode = IORING_OP_READV;
+      sqe->addr = reinterpret_cast<uint64_t>(io.u.v.vec);
+      sqe->len = static_cast<uint32_t>(io.u.v.nr);
+      sqe->off = io.u.v.offset;
+      break;
+    }
+    default: {
+      throw std::logic_error("Unsupported event opcode for io_uring.");
+    }
+  }
+}
+
+bool TDiskController::DrainIncomingEvents(const std::vector<TPersistentDevice *> &device_vec) {
+  bool found_work = false;
+  for (TPersistentDevice *ready_device : device_vec) {
+    TEvent *cur_tail = __sync_lock_test_and_set(&ready_device->IncomingEventQueue, nullptr);
+    if (cur_tail) {
+      found_work = true;
+      /* there were inbound events scheduled against this device. Process these events (which are in reverse order) and put them into their
+         Realtime / Medium / Low priority queues. */
+      TEvent *append_after_rt = ready_device->RealTimePrioEventQueue.TryGetLastMember();
+      TEvent *append_after_m = ready_device->MediumPrioEventQueue.TryGetLastMember();
+      TEvent *append_after_l = ready_device->LowPrioEventQueue.TryGetLastMember();
+      for (TEvent *cur_event = cur_tail; cur_event; cur_event = cur_event->NextEvent) {
+        switch (cur_event->Iocb.aio_reqprio) {
+          case RealTimePriority: {
+            if (append_after_rt) {
+              cur_event->DeviceMembership.Insert(&append_after_rt->DeviceMembership, InvCon::Fwd);
+            } else {
+              cur_event->DeviceMembership.Insert(&ready_device->RealTimePrioEventQueue, InvCon::Rev);
+            }
+            break;
           }
-          for (TEvent *member = ready_device->LowPrioEventQueue.TryGetFirstMember(); member && (cur_inflight + num_removed) < low_not_to_exceed_depth/*num_removed < max_to_submit*/; member = ready_device->LowPrioEventQueue.TryGetFirstMember(), ++num_removed) {
-            ioq[ioq_pos] = &(member->Iocb);
-            ++ioq_pos;
-            member->DeviceMembership.Remove();
+          case MediumPriority: {
+            if (append_after_m) {
+              cur_event->DeviceMembership.Insert(&append_after_m->DeviceMembership, InvCon::Fwd);
+            } else {
+              cur_event->DeviceMembership.Insert(&ready_device->MediumPrioEventQueue, InvCon::Rev);
+            }
+            break;
           }
-          if (num_removed) {
-            ready_device->Inflight += num_removed;
-            #ifndef NDEBUG
-            /* register all these events in the outstanding set */ {
-              std::lock_guard<std::mutex> lock(OutstandingIdMutex);
-              for (size_t i = 0; i < num_removed; ++i) {
-                const size_t this_id = ++NextId;
-                reinterpret_cast<TEvent *>(ioq[i]->data)->RequestId = this_id;
-                OutstandingIdSet.insert(this_id);
-              }
+          case LowPriority: {
+            if (append_after_l) {
+              cur_event->DeviceMembership.Insert(&append_after_l->DeviceMembership, InvCon::Fwd);
+            } else {
+              cur_event->DeviceMembership.Insert(&ready_device->LowPrioEventQueue, InvCon::Rev);
             }
-            #endif
+            break;
           }
         }
       }
+    }
+  }
+  return found_work;
+}
 
-      if (ioq_pos > 0) {
-        inflight += ioq_pos;
-        int ret = io_submit(ctxp, ioq_pos, ioq);
-        if (ret < 0) {
-          syslog(LOG_ERR, "Error in io_submit; nr=[%ld]", ioq_pos);
-          for (size_t nr = 0; nr < ioq_pos; ++nr) {
-            switch (ioq[nr]->aio_lio_opcode) {
-              case IO_CMD_PREAD: {
-                syslog(LOG_INFO, "ioq[%ld] IO_CMD_PREAD, offset=[%lld], nbytes=[%ld]", nr, ioq[nr]->u.c.offset, ioq[nr]->u.c.nbytes);
-                break;
-              }
-              case IO_CMD_PWRITE: {
-                syslog(LOG_INFO, "ioq[%ld] IO_CMD_PWRITE, offset=[%lld], nbytes=[%ld]", nr, ioq[nr]->u.c.offset, ioq[nr]->u.c.nbytes);
-                break;
-              }
-              case IO_CMD_FSYNC: {
-                throw;
-                break;
-              }
-              case IO_CMD_FDSYNC: {
-                throw;
-                break;
-              }
-              case IO_CMD_POLL: {
-                throw;
-                break;
-              }
-              case IO_CMD_NOOP: {
-                throw;
-                break;
-              }
-              case IO_CMD_PREADV: {
-                syslog(LOG_INFO, "ioq[%ld] IO_CMD_PREADV, nr=[%d], offset=[%lld], size=[%ld]", nr, ioq[nr]->u.v.nr, ioq[nr]->u.v.offset, ioq[nr]->u.v.vec[0].iov_len);
-                break;
-              }
-              case IO_CMD_PWRITEV: {
-                syslog(LOG_INFO, "ioq[%ld] IO_CMD_PWRITEV, nr=[%d], offset=[%lld], size=[%ld]", nr, ioq[nr]->u.v.nr, ioq[nr]->u.v.offset, ioq[nr]->u.v.vec[0].iov_len);
-                break;
-              }
-            }
+size_t TDiskController::DequeueEvents(const std::vector<TPersistentDevice *> &device_vec, TEvent **event_array, bool &found_work) {
+  assert(this);
+  size_t pos = 0UL;
+  for (TPersistentDevice *ready_device : device_vec) {
+    if (!ready_device->RealTimePrioEventQueue.IsEmpty() || !ready_device->MediumPrioEventQueue.IsEmpty() || !ready_device->LowPrioEventQueue.IsEmpty()) {
+      found_work = true;
+      size_t num_removed = 0UL;
+      size_t cur_inflight = ready_device->Inflight.load();
+      for (TEvent *member = ready_device->RealTimePrioEventQueue.TryGetFirstMember(); member && (cur_inflight + num_removed) < RealTimeQueueDepth; member = ready_device->RealTimePrioEventQueue.TryGetFirstMember(), ++num_removed) {
+        event_array[pos++] = member;
+        member->DeviceMembership.Remove();
+      }
+      for (TEvent *member = ready_device->MediumPrioEventQueue.TryGetFirstMember(); member && (cur_inflight + num_removed) < MediumQueueDepth; member = ready_device->MediumPrioEventQueue.TryGetFirstMember(), ++num_removed) {
+        event_array[pos++] = member;
+        member->DeviceMembership.Remove();
+      }
+      for (TEvent *member = ready_device->LowPrioEventQueue.TryGetFirstMember(); member && (cur_inflight + num_removed) < LowQueueDepth; member = ready_device->LowPrioEventQueue.TryGetFirstMember(), ++num_removed) {
+        event_array[pos++] = member;
+        member->DeviceMembership.Remove();
+      }
+      if (num_removed) {
+        ready_device->Inflight += num_removed;
+        #ifndef NDEBUG
+        /* register all these events in the outstanding set */ {
+          std::lock_guard<std::mutex> lock(OutstandingIdMutex);
+          for (size_t i = pos - num_removed; i < pos; ++i) {
+            const size_t this_id = ++NextId;
+            event_array[i]->RequestId = this_id;
+            OutstandingIdSet.insert(this_id);
           }
-          ThrowSystemError(-ret);
-        }
-        if (ret != static_cast<int>(ioq_pos)) {
-          syslog(LOG_ERR, "io_submit did not sumbit as as many events as requested [%ld] vs. [%d]", ioq_pos, ret);
-          throw;
         }
+        #endif
       }
+    }
+  }
+  return pos;
+}
+
+#ifndef NDEBUG
+void TDiskController::RetireRequestId(TEvent *compl_event) {
+  assert(this);
+  std::lock_guard<std::mutex> lock(OutstandingIdMutex);
+  const size_t request_id = compl_event->RequestId;
+  auto pos = OutstandingIdSet.find(request_id);
+  if (pos == OutstandingIdSet.end()) {
+    syslog(LOG_ERR, "Completing request id [%ld] that was not outstanding.", request_id);
+    throw std::runtime_error("Completing request id that was not outstanding");
+  }
+  OutstandingIdSet.erase(pos);
+}
+#endif
 
-      if (inflight > 0) {
-        int num_popped = io_getevents(ctxp, 1, max_aio_num, io_ev, NULL);
-        if (num_popped > 0) {
-          inflight -= num_popped;
+bool TDiskController::Complete(TEvent *compl_event, unsigned long res, unsigned long res2) {
+  assert(this);
+  assert(compl_event);
+  const struct iocb &io = compl_event->Iocb;
+  --compl_event->Device->Inflight;
+  if (compl_event->Device->DoCorruptionCheck && res2 == 0) {
+    bool is_checked_read = false;
+    switch (compl_event->Kind) {
+      case TEvent::TriggeredRead:
+      case TEvent::CallbackRead: {
+        is_checked_read = res == io.u.c.nbytes && res > MaxInlineVerifySize;
+        break;
+      }
+      case TEvent::TriggeredReadV:
+      case TEvent::CallbackReadV: {
+        size_t expected_size = 0UL;
+        for (int j = 0; j < io.u.v.nr; ++j) {
+          expected_size += io.u.v.vec[j].iov_len;
+        }
+        is_checked_read = res == expected_size && res > MaxInlineVerifySize;
+        break;
+      }
+      case TEvent::TriggeredWrite:
+      case TEvent::CallbackWrite: {
+        break;
+      }
+    }
+    switch (compl_event->BufKind) {
+      case FullSector:
+      case FullPage:
+      case FullBlock: {
+        is_checked_read = false;
+        break;
+      }
+      default: {
+        break;
+      }
+    }
+    if (is_checked_read && !VerifierVec.empty()) {
+      /* hand it to a verifier */ {
+        std::lock_guard<std::mutex> lock(VerifyMutex);
+        compl_event->NextEvent = nullptr;
+        if (VerifyTail) {
+          VerifyTail->NextEvent = compl_event;
+        } else {
+          VerifyHead = compl_event;
         }
-        try {
+        VerifyTail = compl_event;
+      }
+      VerifyCond.notify_one();
+      return false;
+    }
+  }
+  Finish(compl_event, res, res2);
+  return true;
+}
 
-          #ifndef NDEBUG
-          /* check and remove all these events in the outstanding set */ {
-            std::lock_guard<std::mutex> lock(OutstandingIdMutex);
-            for (int i = 0; i < num_popped; ++i) {
-              TEvent *compl_event = reinterpret_cast<TEvent *>(io_ev[i].data);
-              const size_t request_id = compl_event->RequestId;
-              auto pos = OutstandingIdSet.find(request_id);
-              if (pos == OutstandingIdSet.end()) {
-                syslog(LOG_ERR, "Completing request id [%ld] that was not outstanding.", request_id);
-                throw std::runtime_error("Completing request id that was not outstanding");
-              }
-              OutstandingIdSet.erase(pos);
+void TDiskController::VerifierMain() {
+  assert(this);
+  for (;;) {
+    TEvent *compl_event;
+    /* wait for an event */ {
+      std::unique_lock<std::mutex> lock(VerifyMutex);
+      while (!VerifyHead && !VerifyShutdown) {
+        VerifyCond.wait(lock);
+      }
+      if (!VerifyHead) {
+        break;
+      }
+      compl_event = VerifyHead;
+      VerifyHead = compl_event->NextEvent;
+      if (!VerifyHead) {
+        VerifyTail = nullptr;
+      }
+    }
+    compl_event->NextEvent = nullptr;
+    /* Complete() only hands over reads which moved every byte */
+    const struct iocb &io = compl_event->Iocb;
+    unsigned long res = io.u.c.nbytes;
+    if (io.aio_lio_opcode == IO_CMD_PREADV) {
+      res = 0UL;
+      for (int j = 0; j < io.u.v.nr; ++j) {
+        res += io.u.v.vec[j].iov_len;
+      }
+    }
+    try {
+      Finish(compl_event, res, 0UL);
+    } catch (const std::exception &ex) {
+      syslog(LOG_ERR, "Disk verifier caught error [%s]", ex.what());
+      throw;
+    }
+    compl_event->Reset(true);
+  }
+}
+
+void TDiskController::Finish(TEvent *compl_event, unsigned long res, unsigned long res2) {
+  assert(compl_event);
+  const struct iocb &io = compl_event->Iocb;
+  try {
+    switch (compl_event->Kind) {
+      case TEvent::TriggeredRead: {
+        if (likely(res == io.u.c.nbytes && res2 == 0)) {
+          bool passed_corruption_check = compl_event->Device->CheckCorruptCheck(compl_event->BufKind, io.u.c.buf, io.u.c.offset, io.u.c.nbytes);
+          if (likely(passed_corruption_check)) {
+            compl_event->TriggerOp->Callback(Success, "");
+          } else {
+            stringstream ss;
+            ss << compl_event->CodeLocation;
+            syslog(LOG_ERR, "Corrupt data Reading @ [%lld] in device [%s] from [%s]", io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
+            if (compl_event->AbortOnError) {
+              abort();
             }
+            compl_event->TriggerOp->Callback(Error, "Corrupt Data");
           }
-          #endif
-
-          for (int i = 0; i < num_popped; ++i) {
-            TEvent *compl_event = reinterpret_cast<TEvent *>(io_ev[i].data);
-            const struct iocb &io = compl_event->Iocb;
-            --compl_event->Device->Inflight;
-            try {
-              switch (compl_event->Kind) {
-                case TEvent::TriggeredRead: {
-                  if (likely(io_ev[i].res == io.u.c.nbytes && io_ev[i].res2 == 0)) {
-                    bool passed_corruption_check = compl_event->Device->CheckCorruptCheck(compl_event->BufKind, io.u.c.buf, io.u.c.offset, io.u.c.nbytes);
-                    if (likely(passed_corruption_check)) {
-                      compl_event->TriggerOp->Callback(Success, "");
-                    } else {
-                      stringstream ss;
-                      ss << compl_event->CodeLocation;
-                      syslog(LOG_ERR, "Corrupt data Reading @ [%lld] in device [%s] from [%s]", io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
-                      if (compl_event->AbortOnError) {
-                        abort();
-                      }
-                      compl_event->TriggerOp->Callback(Error, "Corrupt Data");
-                    }
-                  } else {
-                    stringstream ss;
-                    ss << compl_event->CodeLocation;
-                    syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Reading @ [%lld] in device [%s] from [%s]", io_ev[i].res, io_ev[i].res2, io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
-                    if (compl_event->AbortOnError) {
-                      abort();
-                    }
-                    compl_event->TriggerOp->Callback(Error, "Disk Error");
-                  }
-                  break;
-                }
-                case TEvent::TriggeredReadV: {
-                  long long offset = io_ev[i].obj->u.v.offset;
-                  int nr = io_ev[i].obj->u.v.nr;
-                  size_t expected_size = 0UL;
-                  for (int j = 0; j < nr; ++j) {
-                    expected_size += io_ev[i].obj->u.v.vec[j].iov_len;
-                  }
-                  if (likely(io_ev[i].res == expected_size && io_ev[i].res2 == 0)) {
-                    assert(io_ev[i].obj->aio_lio_opcode == IO_CMD_PREADV);
-                    assert(static_cast<size_t>(nr) == compl_event->TriggerVOp.IoVCnt);
-                    bool passed_corruption_check = true;
-                    long long processed = 0UL;
-                    for (int n = 0; n < nr; ++n) {
-                      if (unlikely(!compl_event->Device->CheckCorruptCheck(compl_event->BufKind, io_ev[i].obj->u.v.vec[n].iov_base, offset + processed, io_ev[i].obj->u.v.vec[n].iov_len))) {
-                        passed_corruption_check = false;
-                        break;
-                      }
-                      processed += io_ev[i].obj->u.v.vec[n].iov_len;
-                    }
-                    if (likely(passed_corruption_check)) {
-                      compl_event->TriggerVOp.Trigger->Callback(Success, "");
-                    } else {
-                      stringstream ss;
-                      ss << compl_event->CodeLocation;
-                      syslog(LOG_ERR, "Corrupt data Reading @ [%lld] in device [%s] from [%s]", offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
-                      if (compl_event->AbortOnError) {
-                        abort();
-                      }
-                      compl_event->TriggerVOp.Trigger->Callback(Error, "Corrupt Data");
-                    }
-                  } else {
-                    stringstream ss;
-                    ss << compl_event->CodeLocation;
-                    syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Reading @ [%lld] in device [%s] from [%s]", io_ev[i].res, io_ev[i].res2, offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
-                    if (compl_event->AbortOnError) {
-                      abort();
-                    }
-                    compl_event->TriggerVOp.Trigger->Callback(Error, "Disk Error");
-                  }
-                  break;
-                }
-                case TEvent::TriggeredWrite: {
-                  if (likely(io_ev[i].res == io.u.c.nbytes && io_ev[i].res2 == 0)) {
-                    compl_event->TriggerOp->Callback(Success, "");
-                  } else {
-                    stringstream ss;
-                    ss << compl_event->CodeLocation;
-                    syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Writing @ [%lld] in device [%s] from [%s]", io_ev[i].res, io_ev[i].res2, io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
-                    if (compl_event->AbortOnError) {
-                      abort();
-                    }
-                    compl_event->TriggerOp->Callback(Error, "Disk Error");
-                  }
-                  break;
-                }
-                case TEvent::CallbackRead: {
-                  if (likely(io_ev[i].res == io.u.c.nbytes && io_ev[i].res2 == 0)) {
-                    bool passed_corruption_check = compl_event->Device->CheckCorruptCheck(compl_event->BufKind, io.u.c.buf, io.u.c.offset, io.u.c.nbytes);
-                    if (likely(passed_corruption_check)) {
-                      compl_event->CallbackOp(Success, "");
-                    } else {
-                      stringstream ss;
-                      ss << compl_event->CodeLocation;
-                      syslog(LOG_ERR, "Corrupt data Reading @ [%lld] in device [%s] from [%s]", io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
-                      if (compl_event->AbortOnError) {
-                        abort();
-                      }
-                      compl_event->CallbackOp(Error, "Corrupt Data");
-                    }
-                  } else {
-                    stringstream ss;
-                    ss << compl_event->CodeLocation;
-                    syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Reading @ [%lld] in device [%s] from [%s]", io_ev[i].res, io_ev[i].res2, io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
-                    if (compl_event->AbortOnError) {
-                      abort();
-                    }
-                    compl_event->CallbackOp(Error, "Disk Error");
-                  }
-                  break;
-                }
-                case TEvent::CallbackReadV: {
-                  long long offset = io_ev[i].obj->u.v.offset;
-                  int nr = io_ev[i].obj->u.v.nr;
-                  size_t expected_size = 0UL;
-                  for (int j = 0; j < nr; ++j) {
-                    expected_size += io_ev[i].obj->u.v.vec[j].iov_len;
-                  }
-                  if (likely(io_ev[i].res == expected_size && io_ev[i].res2 == 0)) {
-                    assert(io_ev[i].obj->aio_lio_opcode == IO_CMD_PREADV);
-                    assert(static_cast<size_t>(nr) == compl_event->TriggerVOp.IoVCnt);
-                    bool passed_corruption_check = true;
-                    long long processed = 0UL;
-                    for (int n = 0; n < nr; ++n) {
-                      if (unlikely(!compl_event->Device->CheckCorruptCheck(compl_event->BufKind, io_ev[i].obj->u.v.vec[n].iov_base, offset + processed, io_ev[i].obj->u.v.vec[n].iov_len))) {
-                        passed_corruption_check = false;
-                        break;
-                      }
-                      processed += io_ev[i].obj->u.v.vec[n].iov_len;
-                    }
-                    if (likely(passed_corruption_check)) {
-                      compl_event->CallbackVOp.GroupRequest->Callback(Success, "");
-                    } else {
-                      stringstream ss;
-                      ss << compl_event->CodeLocation;
-                      syslog(LOG_ERR, "Corrupt data Reading @ [%lld] in device [%s] from [%s]", offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
-                      if (compl_event->AbortOnError) {
-                        abort();
-                      }
-                      compl_event->CallbackVOp.GroupRequest->Callback(Error, "Corrupt Data");
-                    }
-                  } else {
-                    stringstream ss;
-                    ss << compl_event->CodeLocation;
-                    syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Reading @ [%lld] in device [%s] from [%s]", io_ev[i].res, io_ev[i].res2, offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
-                    if (compl_event->AbortOnError) {
-                      abort();
-                    }
-                    compl_event->CallbackVOp.GroupRequest->Callback(Error, "Disk Error");
-                  }
-                  break;
-                }
-                case TEvent::CallbackWrite: {
-                  if (likely(io_ev[i].res == io.u.c.nbytes && io_ev[i].res2 == 0)) {
-                    compl_event->CallbackOp(Success, "");
-                  } else {
-                    stringstream ss;
-                    ss << compl_event->CodeLocation;
-                    syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Writing @ [%lld] in device [%s] from [%s]", io_ev[i].res, io_ev[i].res2, io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
-                    if (compl_event->AbortOnError) {
-                      abort();
-                    }
-                    compl_event->CallbackOp(Error, "Disk Error");
-                  }
-                  break;
-                }
-              }
-            } catch (const std::exception &ex) {
-              std::cerr << "Caught error while completing io : [" << compl_event->CodeLocation << "] Kind [";
-              switch(compl_event->Kind) {
-                case TEvent::TriggeredRead: {
-                  std::cerr << "TriggeredRead";
-                  break;
-                }
-                case TEvent::TriggeredReadV: {
-                  std::cerr << "TriggeredReadV";
-                  break;
-                }
-                case TEvent::TriggeredWrite: {
-                  std::cerr << "TriggeredWrite";
-                  break;
-                }
-                case TEvent::CallbackRead: {
-                  std::cerr << "CallbackRead";
-                  break;
-                }
-                case TEvent::CallbackReadV: {
-                  std::cerr << "CallbackReadV";
-                  break;
-                }
-                case TEvent::CallbackWrite: {
-                  std::cerr << "CallbackWrite";
-                  break;
-                }
-              }
-              std::cerr << "]" << std::endl;
-              throw;
+        } else {
+          stringstream ss;
+          ss << compl_event->CodeLocation;
+          syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Reading @ [%lld] in device [%s] from [%s]", res, res2, io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
+          if (compl_event->AbortOnError) {
+            abort();
+          }
+          compl_event->TriggerOp->Callback(Error, "Disk Error");
+        }
+        break;
+      }
+      case TEvent::TriggeredReadV: {
+        long long offset = io.u.v.offset;
+        int nr = io.u.v.nr;
+        size_t expected_size = 0UL;
+        for (int j = 0; j < nr; ++j) {
+          expected_size += io.u.v.vec[j].iov_len;
+        }
+        if (likely(res == expected_size && res2 == 0)) {
+          assert(io.aio_lio_opcode == IO_CMD_PREADV);
+          assert(static_cast<size_t>(nr) == compl_event->TriggerVOp.IoVCnt);
+          bool passed_corruption_check = true;
+          long long processed = 0UL;
+          for (int n = 0; n < nr; ++n) {
+            if (unlikely(!compl_event->Device->CheckCorruptCheck(compl_event->BufKind, io.u.v.vec[n].iov_base, offset + processed, io.u.v.vec[n].iov_len))) {
+              passed_corruption_check = false;
+              break;
             }
+            processed += io.u.v.vec[n].iov_len;
           }
-          /* now that we're done completing all the events, reset them and give them back to their pool. */
-          for (int i = 0; i < num_popped; ++i) {
-            TEvent *compl_event = reinterpret_cast<TEvent *>(io_ev[i].data);
-            compl_event->Reset(true);
+          if (likely(passed_corruption_check)) {
+            compl_event->TriggerVOp.Trigger->Callback(Success, "");
+          } else {
+            stringstream ss;
+            ss << compl_event->CodeLocation;
+            syslog(LOG_ERR, "Corrupt data Reading @ [%lld] in device [%s] from [%s]", offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
+            if (compl_event->AbortOnError) {
+              abort();
+            }
+            compl_event->TriggerVOp.Trigger->Callback(Error, "Corrupt Data");
+          }
+        } else {
+          stringstream ss;
+          ss << compl_event->CodeLocation;
+          syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Reading @ [%lld] in device [%s] from [%s]", res, res2, offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
+          if (compl_event->AbortOnError) {
+            abort();
           }
-        } catch (const std::exception &ex) {
-          syslog(LOG_ERR, "QueueRunner caught error while iterating over completion events");
-          throw;
+          compl_event->TriggerVOp.Trigger->Callback(Error, "Disk Error");
         }
+        break;
+      }
+      case TEvent::TriggeredWrite: {
+        if (likely(res == io.u.c.nbytes && res2 == 0)) {
+          compl_event->TriggerOp->Callback(Success, "");
+        } else {
+          stringstream ss;
+          ss << compl_event->CodeLocation;
+          syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Writing @ [%lld] in device [%s] from [%s]", res, res2, io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
+          if (compl_event->AbortOnError) {
+            abort();
+          }
+          compl_event->TriggerOp->Callback(Error, "Disk Error");
+        }
+        break;
+      }
+      case TEvent::CallbackRead: {
+        if (likely(res == io.u.c.nbytes && res2 == 0)) {
+          bool passed_corruption_check = compl_event->Device->CheckCorruptCheck(compl_event->BufKind, io.u.c.buf, io.u.c.offset, io.u.c.nbytes);
+          if (likely(passed_corruption_check)) {
+            compl_event->CallbackOp(Success, "");
+          } else {
+            stringstream ss;
+            ss << compl_event->CodeLocation;
+            syslog(LOG_ERR, "Corrupt data Reading @ [%lld] in device [%s] from [%s]", io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
+            if (compl_event->AbortOnError) {
+              abort();
+            }
+            compl_event->CallbackOp(Error, "Corrupt Data");
+          }
+        } else {
+          stringstream ss;
+          ss << compl_event->CodeLocation;
+          syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Reading @ [%lld] in device [%s] from [%s]", res, res2, io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
+          if (compl_event->AbortOnError) {
+            abort();
+          }
+          compl_event->CallbackOp(Error, "Disk Error");
+        }
+        break;
+      }
+      case TEvent::CallbackReadV: {
+        long long offset = io.u.v.offset;
+        int nr = io.u.v.nr;
+        size_t expected_size = 0UL;
+        for (int j = 0; j < nr; ++j) {
+          expected_size += io.u.v.vec[j].iov_len;
+        }
+        if (likely(res == expected_size && res2 == 0)) {
+          assert(io.aio_lio_opcode == IO_CMD_PREADV);
+          assert(static_cast<size_t>(nr) == compl_event->TriggerVOp.IoVCnt);
+          bool passed_corruption_check = true;
+          long long processed = 0UL;
+          for (int n = 0; n < nr; ++n) {
+            if (unlikely(!compl_event->Device->CheckCorruptCheck(compl_event->BufKind, io.u.v.vec[n].iov_base, offset + processed, io.u.v.vec[n].iov_len))) {
+              passed_corruption_check = false;
+              break;
+            }
+            processed += io.u.v.vec[n].iov_len;
+          }
+          if (likely(passed_corruption_check)) {
+            compl_event->CallbackVOp.GroupRequest->Callback(Success, "");
+          } else {
+            stringstream ss;
+            ss << compl_event->CodeLocation;
+            syslog(LOG_ERR, "Corrupt data Reading @ [%lld] in device [%s] from [%s]", offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
+            if (compl_event->AbortOnError) {
+              abort();
+            }
+            compl_event->CallbackVOp.GroupRequest->Callback(Error, "Corrupt Data");
+          }
+        } else {
+          stringstream ss;
+          ss << compl_event->CodeLocation;
+          syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Reading @ [%lld] in device [%s] from [%s]", res, res2, offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
+          if (compl_event->AbortOnError) {
+            abort();
+          }
+          compl_event->CallbackVOp.GroupRequest->Callback(Error, "Disk Error");
+        }
+        break;
+      }
+      case TEvent::CallbackWrite: {
+        if (likely(res == io.u.c.nbytes && res2 == 0)) {
+          compl_event->CallbackOp(Success, "");
+        } else {
+          stringstream ss;
+          ss << compl_event->CodeLocation;
+          syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Writing @ [%lld] in device [%s] from [%s]", res, res2, io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
+          if (compl_event->AbortOnError) {
+            abort();
+          }
+          compl_event->CallbackOp(Error, "Disk Error");
+        }
+        break;
       }
     }
   } catch (const std::exception &ex) {
-    syslog(LOG_ERR, "QueueRunner caught error [%s]", ex.what());
-    throw;
-  } catch (...) {
+    std::cerr << "Caught error while completing io : [" << compl_event->CodeLocation << "] Kind [";
+    switch(compl_event->Kind) {
+      case TEvent::TriggeredRead: {
+        std::cerr << "TriggeredRead";
+        break;
+      }
+      case TEvent::TriggeredReadV: {
+        std::cerr << "TriggeredReadV";
+        break;
+      }
+      case TEvent::TriggeredWrite: {
+        std::cerr << "TriggeredWrite";
+        break;
+      }
+      case TEvent::CallbackRead: {
+        std::cerr << "CallbackRead";
+        break;
+      }
+      case TEvent::CallbackReadV: {
+        std::cerr << "CallbackReadV";
+        break;
+      }
+      case TEvent::CallbackWrite: {
+        std::cerr << "CallbackWrite";
+        break;
+      }
+    }
+    std::cerr << "]" << std::endl;
     throw;
   }
 }
@@ -2241,9 +2524,9 @@ void TDevice::ApplyCorruptionCheck(TBufKind buf_kind, void *buf, const TOffset o
       assert(nbytes % PhysicalBlockSize == 0);
       for (size_t num_buf = 0; num_buf < nbytes / PhysicalBlockSize; ++num_buf) {
         for (size_t i = 0; i < SectorsPerBlock; ++i) {
-          Util::TCorruptionDetector::WriteMurmur(reinterpret_cast<size_t *>(reinterpret_cast<uint8_t *>(buf) + (num_buf * PhysicalBlockSize) + (i * PhysicalSectorSize)),
-                                                 PhysicalSectorSize,
-                                                 offset + (num_buf * PhysicalBlockSize) + (i * PhysicalSectorSize));
+          Util::TCorruptionDetector::WriteCrc(reinterpret_cast<size_t *>(reinterpret_cast<uint8_t *>(buf) + (num_buf * PhysicalBlockSize) + (i * PhysicalSectorSize)),
+                                              PhysicalSectorSize,
+                                              offset + (num_buf * PhysicalBlockSize) + (i * PhysicalSectorSize));
         }
       }
       break;
@@ -2252,9 +2535,9 @@ void TDevice::ApplyCorruptionCheck(TBufKind buf_kind, void *buf, const TOffset o
       assert(nbytes % PhysicalBlockSize == 0);
       for (size_t num_buf = 0; num_buf < nbytes / PhysicalBlockSize; ++num_buf) {
         for (size_t i = 0; i < PagesPerBlock; ++i) {
-          Util::TCorruptionDetector::WriteMurmur(reinterpret_cast<size_t *>(reinterpret_cast<uint8_t *>(buf) + (num_buf * PhysicalBlockSize) + (i * PhysicalPageSize)),
-                                                 PhysicalPageSize,
-                                                 offset + (num_buf * PhysicalBlockSize) + (i * PhysicalPageSize));
+          Util::TCorruptionDetector::WriteCrc(reinterpret_cast<size_t *>(reinterpret_cast<uint8_t *>(buf) + (num_buf * PhysicalBlockSize) + (i * PhysicalPageSize)),
+                                              PhysicalPageSize,
+                                              offset + (num_buf * PhysicalBlockSize) + (i * PhysicalPageSize));
         }
       }
       break;
@@ -2262,21 +2545,21 @@ void TDevice::ApplyCorruptionCheck(TBufKind buf_kind, void *buf, const TOffset o
     case CheckedSector: {
       assert(nbytes % PhysicalSectorSize == 0);
       for (size_t num_buf = 0; num_buf < nbytes / PhysicalSectorSize; ++num_buf) {
-        Util::TCorruptionDetector::WriteMurmur(reinterpret_cast<size_t *>(reinterpret_cast<uint8_t *>(buf) + (num_buf * PhysicalSectorSize)), PhysicalSectorSize, offset + (num_buf * PhysicalSectorSize));
+        Util::TCorruptionDetector::WriteCrc(reinterpret_cast<size_t *>(reinterpret_cast<uint8_t *>(buf) + (num_buf * PhysicalSectorSize)), PhysicalSectorSize, offset + (num_buf * PhysicalSectorSize));
       }
       break;
     }
     case CheckedPage: {
       assert(nbytes % PhysicalPageSize == 0);
       for (size_t num_buf = 0; num_buf < nbytes / PhysicalPageSize; ++num_buf) {
-        Util::TCorruptionDetector::WriteMurmur(reinterpret_cast<size_t *>(reinterpret_cast<uint8_t *>(buf) + (num_buf * PhysicalPageSize)), PhysicalPageSize, offset + (num_buf * PhysicalPageSize));
+        Util::TCorruptionDetector::WriteCrc(reinterpret_cast<size_t *>(reinterpret_cast<uint8_t *>(buf) + (num_buf * PhysicalPageSize)), PhysicalPageSize, offset + (num_buf * PhysicalPageSize));
       }
       break;
     }
     case CheckedBlock: {
       assert(nbytes % PhysicalBlockSize == 0);
       for (size_t num_buf = 0; num_buf < nbytes / PhysicalBlockSize; ++num_buf) {
-        Util::TCorruptionDetector::WriteMurmur(reinterpret_cast<size_t *>(reinterpret_cast<uint8_t *>(buf) + (num_buf * PhysicalBlockSize)), PhysicalBlockSize, offset + (num_buf * PhysicalBlockSize));
+        Util::TCorruptionDetector::WriteCrc(reinterpret_cast<size_t *>(reinterpret_cast<uint8_t *>(buf) + (num_buf * PhysicalBlockSize)), PhysicalBlockSize, offset + (num_buf * PhysicalBlockSize));
       }
       break;
     }
@@ -2304,9 +2587,9 @@ bool TDevice::CheckCorruptCheck(TBufKind buf_kind, void *buf, const TOffset offs
         assert(nbytes % PhysicalBlockSize == 0);
         for (size_t num_buf = 0; num_buf < nbytes / PhysicalBlockSize; ++num_buf) {
           for (size_t i = 0; i < SectorsPerBlock; ++i) {
-            if (!Util::TCorruptionDetector::TryReadMurmur(reinterpret_cast<size_t *>(reinterpret_cast<uint8_t *>(buf) + (num_buf * PhysicalBlockSize) + (i * PhysicalSectorSize)),
-                                                          PhysicalSectorSize,
-                                                          offset + (num_buf * PhysicalBlockSize) + (i * PhysicalSectorSize))) {
+            if (!Util::TCorruptionDetector::TryReadCrc(reinterpret_cast<size_t *>(reinterpret_cast<uint8_t *>(buf) + (num_buf * PhysicalBlockSize) + (i * PhysicalSectorSize)),
+                                                       PhysicalSectorSize,
+                                                       offset + (num_buf * PhysicalBlockSize) + (i * PhysicalSectorSize))) {
               passed_corruption_check = false;
             }
           }
@@ -2317,9 +2600,9 @@ bool TDevice::CheckCorruptCheck(TBufKind buf_kind, void *buf, const TOffset offs
         assert(nbytes % PhysicalBlockSize == 0);
         for (size_t num_buf = 0; num_buf < nbytes / PhysicalBlockSize; ++num_buf) {
           for (size_t i = 0; i < PagesPerBlock; ++i) {
-            if (!Util::TCorruptionDetector::TryReadMurmur(reinterpret_cast<size_t *>(reinterpret_cast<uint8_t *>(buf) + (num_buf * PhysicalBlockSize) + (i * PhysicalPageSize)),
-                                                          PhysicalPageSize,
-                                                          offset + (num_buf * PhysicalBlockSize) + (i * PhysicalPageSize))) {
+            if (!Util::TCorruptionDetector::TryReadCrc(reinterpret_cast<size_t *>(reinterpret_cast<uint8_t *>(buf) + (num_buf * PhysicalBlockSize) + (i * PhysicalPageSize)),
+                                                       PhysicalPageSize,
+                                                       offset + (num_buf * PhysicalBlockSize) + (i * PhysicalPageSize))) {
               passed_corruption_check = false;
             }
           }
@@ -2329,7 +2612,7 @@ bool TDevice::CheckCorruptCheck(TBufKind buf_kind, void *buf, const TOffset offs
       case CheckedSector: {
         assert(nbytes % PhysicalSectorSize == 0);
         for (size_t num_buf = 0; num_buf < nbytes / PhysicalSectorSize; ++num_buf) {
-          if (!Util::TCorruptionDetector::TryReadMurmur(reinterpret_cast<size_t *>(reinterpret_cast<uint8_t *>(buf) + (num_buf * PhysicalSectorSize)), PhysicalSectorSize, offset + (num_buf * PhysicalSectorSize))) {
+          if (!Util::TCorruptionDetector::TryReadCrc(reinterpret_cast<size_t *>(reinterpret_cast<uint8_t *>(buf) + (num_buf * PhysicalSectorSize)), PhysicalSectorSize, offset + (num_buf * PhysicalSectorSize))) {
             passed_corruption_check = false;
           }
         }
@@ -2338,7 +2621,7 @@ bool TDevice::CheckCorruptCheck(TBufKind buf_kind, void *buf, const TOffset offs
       case CheckedPage: {
         assert(nbytes % PhysicalPageSize == 0);
         for (size_t num_buf = 0; num_buf < nbytes / PhysicalPageSize; ++num_buf) {
-          if (!Util::TCorruptionDetector::TryReadMurmur(reinterpret_cast<size_t *>(reinterpret_cast<uint8_t *>(buf) + (num_buf * PhysicalPageSize)), PhysicalPageSize, offset + (num_buf * PhysicalPageSize))) {
+          if (!Util::TCorruptionDetector::TryReadCrc(reinterpret_cast<size_t *>(reinterpret_cast<uint8_t *>(buf) + (num_buf * PhysicalPageSize)), PhysicalPageSize, offset + (num_buf * PhysicalPageSize))) {
             passed_corruption_check = false;
           }
         }
@@ -2347,7 +2630,7 @@ bool TDevice::CheckCorruptCheck(TBufKind buf_kind, void *buf, const TOffset offs
       case CheckedBlock: {
         assert(nbytes % PhysicalBlockSize == 0);
         for (size_t num_buf = 0; num_buf < nbytes / PhysicalBlockSize; ++num_buf) {
-          if (!Util::TCorruptionDetector::TryReadMurmur(reinterpret_cast<size_t *>(reinterpret_cast<uint8_t *>(buf) + (num_buf * PhysicalBlockSize)), PhysicalBlockSize, offset + (num_buf * PhysicalBlockSize))) {
+          if (!Util::TCorruptionDetector::TryReadCrc(reinterpret_cast<size_t *>(reinterpret_cast<uint8_t *>(buf) + (num_buf * PhysicalBlockSize)), PhysicalBlockSize, offset + (num_buf * PhysicalBlockSize))) {
             passed_corruption_check = false;
           }
         }
@@ -21,6 +21,7 @@
 #include <cassert>
 #include <limits>
 #include <sstream>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -49,6 +50,7 @@
 #include <orly/indy/disk/priority.h>
 #include <orly/indy/disk/result.h>
 #include <orly/indy/disk/util/device_util.h>
+#include <orly/indy/disk/util/io_uring.h>
 #include <util/error.h>
 
 namespace Orly {
@@ -336,6 +338,18 @@ namespace Orly {
           /* TODO */
           typedef InvCon::UnorderedList::TCollection<TDiskController, TPersistentDevice> TDeviceCollection;
 
+          /* The kernel interface our queue runners use to drive their devices. */
+          enum class TIoEngine {
+
+            /* Linux native aio. */
+            Aio,
+
+            /* io_uring, with batched submission, registered cache buffers and, optionally, a kernel thread polling the
+               submission queue.  A runner which can't get a ring falls back to aio. */
+            IoUring
+
+          };  // TIoEngine
+
           /* TODO */
           class TEvent
               : public Base::TThreadLocalGlobalPoolManager<TEvent>::TObjBase {
@@ -517,8 +531,11 @@ namespace Orly {
 
           };  // TEvent
 
+          /* The number of verifier threads a controller starts by default. */
+          static constexpr size_t DefaultNumVerifiers = 2UL;
+
           /* TODO */
-          TDiskController();
+          TDiskController(TIoEngine io_engine = TIoEngine::Aio, bool sq_poll = false, size_t num_verifiers = DefaultNumVerifiers);
 
           /* TODO */
           ~TDiskController();
@@ -532,6 +549,11 @@ namespace Orly {
           /* TODO */
           void QueueRunner(std::vector<TPersistentDevice *> device_vec, bool no_realtime, size_t core);
 
+          /* Tell the io_uring runners about a long-lived region of memory which I/O will land in, such as a cache's page
+             arena.  They register it with their rings the next time they're quiet, after which reads and writes into it
+             skip the per-I/O page pinning.  Aio runners ignore this. */
+          void RegisterBuffer(void *buf, size_t size);
+
           /* TODO */
           void Report(std::stringstream &ss, double elapsed_time) const;
 
@@ -542,9 +564,76 @@ namespace Orly {
           static constexpr int MediumPriority = 2;
           static constexpr int LowPriority = 4;
 
+          /* The most I/Os a device may have in flight while we submit events of each priority. */
+          static constexpr size_t RealTimeQueueDepth = 32UL;
+          static constexpr size_t MediumQueueDepth = 6UL;
+          static constexpr size_t LowQueueDepth = 2UL;
+
+          /* The size of an aio context, and the least number of entries in an io_uring. */
+          static constexpr size_t MaxAioEvents = 64UL;
+
+          /* Checked reads larger than this have their checksums verified by the verifier threads rather than by the
+             queue runner, so one big read can't hold up the completions queued behind it. */
+          static constexpr size_t MaxInlineVerifySize = 16384UL;
+
+          /* The queue runner loop for each engine. */
+          void RunAio(const std::vector<TPersistentDevice *> &device_vec);
+          void RunIoUring(TIoUring &ring, const std::vector<TPersistentDevice *> &device_vec);
+
+          /* Fill in a submission queue entry for the given event, using a registered buffer if the event's buffer lies
+             inside one. */
+          static void PrepSqe(struct io_uring_sqe *sqe, TEvent *event, const std::vector<struct iovec> &registered_vec);
+
+          /* Move the events enqueued against the given devices onto their priority queues.  True iff. there were any. */
+          static bool DrainIncomingEvents(const std::vector<TPersistentDevice *> &device_vec);
+
+          /* Take as many events off the devices' priority queues as their queue depths allow, writing them to
+             event_array, which must have room for RealTimeQueueDepth events per device.  Sets found_work if any queue
+             was non-empty.  Returns the number of events taken. */
+          size_t DequeueEvents(const std::vector<TPersistentDevice *> &device_vec, TEvent **event_array, bool &found_work);
+
+          /* Take an event the kernel has completed.  Returns true if we finished it here, in which case the caller must
+             reset it; false if we handed it to the verifiers, which will finish and reset it themselves. */
+          bool Complete(TEvent *compl_event, unsigned long res, unsigned long res2);
+
+          /* Finish a completed event: check the result, verify the checksums of what we read, and call back. */
+          static void Finish(TEvent *compl_event, unsigned long res, unsigned long res2);
+
+          /* The body of each verifier thread.  Finishes the events handed over by Complete() until we shut down. */
+          void VerifierMain();
+
+          #ifndef NDEBUG
+          /* Remove a completed event from the outstanding set, throwing if it wasn't there. */
+          void RetireRequestId(TEvent *compl_event);
+          #endif
+
           /* TODO */
           mutable TDeviceCollection::TImpl DeviceCollection;
 
+          /* See TIoEngine. */
+          const TIoEngine IoEngine;
+
+          /* If true, io_uring runners ask for a submission queue polling thread. */
+          const bool SqPoll;
+
+          /* The buffers given to RegisterBuffer(), each at most TIoUring::MaxRegisteredBufferSize.  NumBuffers lets the
+             runners notice new ones without taking the lock. */
+          std::mutex BufferMutex;
+          std::vector<struct iovec> BufferVec;
+          std::atomic<size_t> NumBuffers;
+
+          /* Events waiting for a verifier, linked through their NextEvent, oldest first. */
+          std::mutex VerifyMutex;
+          std::condition_variable VerifyCond;
+          TEvent *VerifyHead;
+          TEvent *VerifyTail;
+
+          /* Set when we're being destroyed; the verifiers drain the queue and exit. */
+          bool VerifyShutdown;
+
+          /* The verifier threads. */
+          std::vector<std::thread> VerifierVec;
+
           #ifndef NDEBUG
           /* TODO */
           std::unordered_set<size_t> OutstandingIdSet;
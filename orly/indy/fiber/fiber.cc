@@ -26,6 +26,135 @@ __thread TRunner *TRunner::LocalRunner = nullptr;
 __thread TFrame *TFrame::LocalFrame = nullptr;
 __thread Base::TThreadLocalGlobalPoolManager<TFrame, size_t, TRunner *>::TThreadLocalPool *TFrame::LocalFramePool = nullptr;
 
+constexpr size_t TRunner::StealDequeSize;
+
+#ifdef __x86_64__
+/* The stack at a switch, from the saved stack pointer up:
+
+     r15 r14 r13 r12 rbx rbp [ return address ]
+
+   Everything else the ABI makes the caller save, so the compiler has already taken care of it by the time it calls
+   orly_fiber_switch().  The ABI also has callees preserve the mxcsr and x87 control words, but nothing here changes
+   them, so every fiber runs with the same ones and we skip saving them; that's about a quarter of the cost of a
+   switch.  A fresh stack returns into orly_fiber_entry, with the function in r13 and its argument in r12. */
+asm(R"(
+  .text
+  .globl orly_fiber_switch
+  .type orly_fiber_switch, @function
+  .align 16
+orly_fiber_switch:
+  pushq %rbp
+  pushq %rbx
+  pushq %r12
+  pushq %r13
+  pushq %r14
+  pushq %r15
+  movq %rsp, (%rdi)
+  movq %rsi, %rsp
+  popq %r15
+  popq %r14
+  popq %r13
+  popq %r12
+  popq %rbx
+  popq %rbp
+  ret
+  .size orly_fiber_switch, .-orly_fiber_switch
+
+  .type orly_fiber_entry, @function
+  .align 16
+orly_fiber_entry:
+  .cfi_startproc
+  .cfi_undefined rip
+  movq %r12, %rdi
+  callq *%r13
+  ud2
+  .cfi_endproc
+  .size orly_fiber_entry, .-orly_fiber_entry
+)");
+
+extern "C" void orly_fiber_entry();
+
+void *Orly::Indy::Fiber::make_asm_context(void *stack, size_t stack_size, void (*ufnc)(void *), void *uctx) {
+  assert(stack);
+  /* 9 words: the 7 orly_fiber_switch() pops, plus 2 more so the stack is 16-byte aligned when we land in
+     orly_fiber_entry, just as it would be before a call. */
+  const uintptr_t top = (reinterpret_cast<uintptr_t>(stack) + stack_size) & ~static_cast<uintptr_t>(15);
+  uint64_t *sp = reinterpret_cast<uint64_t *>(top) - 9;
+  assert(reinterpret_cast<uintptr_t>(sp) >= reinterpret_cast<uintptr_t>(stack));
+  sp[0] = 0UL;  // r15
+  sp[1] = 0UL;  // r14
+  sp[2] = reinterpret_cast<uint64_t>(ufnc);  // r13
+  sp[3] = reinterpret_cast<uint64_t>(uctx);  // r12
+  sp[4] = 0UL;  // rbx
+  sp[5] = 0UL;  // rbp
+  sp[6] = reinterpret_cast<uint64_t>(&orly_fiber_entry);
+  sp[7] = 0UL;
+  sp[8] = 0UL;
+  return sp;
+}
+#endif
+
+void TRunner::RunFrame(TFrame *frame) {
+  assert(this);
+  assert(frame);
+  fiber_t *sched_fib = &frame->GetFiber();
+  TFrame::LocalFrame = frame;
+  FreeFrame = nullptr;
+  FreeFramePool = nullptr;
+  //printf("[%p]\tSwitch to Frame\n", this);
+  switch_to_fiber(*sched_fib, MainFiber);
+  //printf("[%p]\tDone Frame\n", this);
+  if (FreeFrame) {
+    assert(FreeFrame == frame);
+    assert(FreeFramePool);
+    FreeFramePool->Free(FreeFrame);
+    FreeFrame = nullptr;
+    FreeFramePool = nullptr;
+  }
+  if (ForeignRunnerToMoveFrameTo) {
+    assert(FrameToMoveToForeignRunner);
+    ScheduleFrameSlow(ForeignRunnerToMoveFrameTo, FrameToMoveToForeignRunner);
+    ForeignRunnerToMoveFrameTo = nullptr;
+    FrameToMoveToForeignRunner = nullptr;
+  }
+  TFrame::LocalFrame = nullptr;
+}
+
+void TRunner::TakeInjectedFrames() {
+  assert(this);
+  assert(Pool);
+  TFrame *next_frame = nullptr;
+  for (TFrame *frame = __sync_lock_test_and_set(&Pool->InjectQueue, nullptr); frame; frame = next_frame) {
+    next_frame = frame->InboundQueueNextFrame;
+    if (!StealDeque.TryPush(frame)) {
+      /* our deque is full, so this one is ours alone */
+      frame->InboundQueueNextFrame = ReadyToRunQueue;
+      ReadyToRunQueue = frame;
+    }
+  }
+}
+
+TFrame *TRunner::TrySteal() {
+  assert(this);
+  assert(Pool);
+  const size_t num_runners = Pool->RunnerVec.size();
+  for (size_t i = 0; i < num_runners; ++i) {
+    const size_t victim_pos = (NextVictim + i) % num_runners;
+    TRunner *victim = Pool->RunnerVec[victim_pos].get();
+    if (victim != this && !victim->StealDeque.IsEmpty()) {
+      TFrame *frame = victim->StealDeque.TrySteal();
+      if (frame) {
+        /* a runner with one frame to spare probably has more, so start with it next time */
+        NextVictim = victim_pos;
+        NumStolen.fetch_add(1UL, std::memory_order_relaxed);
+        return frame;
+      }
+    }
+  }
+  NextVictim = (NextVictim + 1) % num_runners;
+  return nullptr;
+}
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Winvalid-offsetof"
 void TRunner::Run() {
@@ -41,6 +170,9 @@ void TRunner::Run() {
     size_t laps_without_work = 0UL;
     for (; likely(KeepRunning.load());) {
       assert(!ReadyToRunQueue);
+      if (Pool && Pool->InjectQueue) {
+        TakeInjectedFrames();
+      }
       /* check for inbound frames */ {
         if (InboundFrameQueue) {
           assert(rt_queue == nullptr);
@@ -96,7 +228,9 @@ void TRunner::Run() {
                   frame->InboundQueueNextFrame = ReadyToRunQueue;
                   ReadyToRunQueue = frame;
                   //frame->QueueMembership.Insert(&MyFrameQueue, InvCon::Rev);
-                  #ifdef FAST_SWITCH
+                  #if defined(ASM_SWITCH)
+                  _mm_prefetch(reinterpret_cast<const char *>(frame->MyFiber.sp), _MM_HINT_T1);
+                  #elif defined(FAST_SWITCH)
                   _mm_prefetch(frame->MyFiber.jmp, _MM_HINT_T1);
                   #endif
                 }
@@ -106,7 +240,15 @@ void TRunner::Run() {
           }
         }
       }
-      if (ReadyToRunQueue) {
+      if (!ReadyToRunQueue && Pool && StealDeque.IsEmpty()) {
+        /* we have nothing of our own to do, so help out someone who does */
+        TFrame *frame = TrySteal();
+        if (frame) {
+          frame->InboundQueueNextFrame = nullptr;
+          ReadyToRunQueue = frame;
+        }
+      }
+      if (ReadyToRunQueue || !StealDeque.IsEmpty()) {
         laps_without_work = 0UL;
       } else {
         ++laps_without_work;
@@ -120,34 +262,24 @@ void TRunner::Run() {
         for (TFrame *frame = ReadyToRunQueue; ReadyToRunQueue; frame = ReadyToRunQueue) {
           ReadyToRunQueue = frame->InboundQueueNextFrame;
           _mm_prefetch(reinterpret_cast<uint8_t *>(ReadyToRunQueue) + offsetof(TFrame, MyFiber), _MM_HINT_T0);
-          fiber_t *sched_fib = &frame->GetFiber();
-          TFrame::LocalFrame = frame;
-          FreeFrame = nullptr;
-          FreeFramePool = nullptr;
-          //printf("[%p]\tSwitch to Frame\n", this);
-          switch_to_fiber(*sched_fib, MainFiber);
-          //printf("[%p]\tDone Frame\n", this);
-          if (FreeFrame) {
-            assert(FreeFrame == frame);
-            assert(FreeFramePool);
-            FreeFramePool->Free(FreeFrame);
-            FreeFrame = nullptr;
-            FreeFramePool = nullptr;
-          }
-          if (ForeignRunnerToMoveFrameTo) {
-            assert(FrameToMoveToForeignRunner);
-            ScheduleFrameSlow(ForeignRunnerToMoveFrameTo, FrameToMoveToForeignRunner);
-            ForeignRunnerToMoveFrameTo = nullptr;
-            FrameToMoveToForeignRunner = nullptr;
-          }
-          TFrame::LocalFrame = nullptr;
+          RunFrame(frame);
         }
-        if (NewReadyToRunQueue) {
+        /* if another thread has woken a frame (the reactor, say), go take it in before starting another pass over
+           the frames that just yielded; otherwise a frame that yields in a loop starves it */
+        if (NewReadyToRunQueue && !InboundFrameQueue) {
           assert(!ReadyToRunQueue);
           std::swap(ReadyToRunQueue, NewReadyToRunQueue);
           assert(ReadyToRunQueue);
           assert(!NewReadyToRunQueue);
-        } else {
+        }
+        /* start one new frame from our deque per pass, so the frames we've already started don't wait behind all of
+           them, and the rest stay where idle runners can steal them */
+        TFrame *new_frame = StealDeque.TryPop();
+        if (new_frame) {
+          new_frame->InboundQueueNextFrame = ReadyToRunQueue;
+          ReadyToRunQueue = new_frame;
+        }
+        if (!ReadyToRunQueue) {
           break;
         }
       }
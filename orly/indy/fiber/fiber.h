@@ -40,6 +40,7 @@
 #include <base/thread_local_global_pool.h>
 #include <base/zero.h>
 #include <inv_con/unordered_list.h>
+#include <orly/indy/fiber/steal_deque.h>
 #include <util/error.h>
 
 namespace Orly {
@@ -48,9 +49,67 @@ namespace Orly {
 
     namespace Fiber {
 
+      /* Pick how fibers switch stacks, from fastest to most portable:
+
+           ASM_SWITCH   A hand-written x86-64 switch (see fiber.cc) that saves only the callee-saved registers.
+           FAST_SWITCH  _setjmp()/_longjmp(), bootstrapped with swapcontext().  A little more work than ASM_SWITCH per
+                        switch, since glibc mangles the saved pointers.
+           (neither)    swapcontext() on every switch, which costs an rt_sigprocmask() system call each time.
+
+         Build with -DNO_ASM_SWITCH, or with both -DNO_ASM_SWITCH and -DNO_FAST_SWITCH, to step down. */
+      #if defined(__x86_64__) && !defined(NO_ASM_SWITCH)
+      #define ASM_SWITCH
+      #elif !defined(NO_FAST_SWITCH)
       #define FAST_SWITCH
+      #endif
+
+      #ifdef __x86_64__
+      /* Push the callee-saved registers onto the current stack, store the stack pointer in *save_sp, then pop the
+         registers saved on the stack at load_sp and return into whatever was running there. */
+      extern "C" void orly_fiber_switch(void **save_sp, void *load_sp);
+
+      /* Lay out the top of a fresh stack so that the first orly_fiber_switch() to the returned stack pointer calls
+         ufnc(uctx).  ufnc must never return. */
+      void *make_asm_context(void *stack, size_t stack_size, void (*ufnc)(void *), void *uctx);
+      #endif
 
-      #ifdef FAST_SWITCH
+      #ifdef ASM_SWITCH
+      /* TODO */
+      struct fiber_t {
+        void *sp;
+        void *stack;
+        size_t stack_size;
+      };
+
+      /* TODO */
+      inline void create_fiber(fiber_t &fib, void(*ufnc)(void *), void *uctx, size_t stack_size) {
+        fib.stack = malloc(stack_size);
+        if (!fib.stack) {
+          throw std::bad_alloc();
+        }
+        Util::IfLt0(mlock(fib.stack, stack_size));
+        fib.stack_size = stack_size;
+        fib.sp = make_asm_context(fib.stack, stack_size, ufnc, uctx);
+      }
+
+      /* TODO */
+      inline size_t get_stack_size(fiber_t &fib) {
+        return fib.stack_size;
+      }
+
+      /* TODO */
+      inline void free_fiber(fiber_t &fib) {
+        assert(&fib);
+        assert(fib.stack);
+        free(fib.stack);
+      }
+
+      /* TODO */
+      inline void switch_to_fiber(fiber_t &fib, fiber_t &prv) {
+        orly_fiber_switch(&prv.sp, fib.sp);
+      }
+
+      #elif defined(FAST_SWITCH)
       /* TODO */
       struct fiber_t {
         ucontext_t fib;
@@ -144,6 +203,7 @@ namespace Orly {
 
       /* Forward Declaration */
       class TFrame;
+      class TRunnerPool;
 
       /* TODO */
       class alignas(64) TRunner {
@@ -221,7 +281,11 @@ namespace Orly {
               FrameToMoveToForeignRunner(nullptr),
               TotalNumRunners(total_num_runners),
               RunnerId(runner_id),
-              RunnerArray(runner_array) {
+              RunnerArray(runner_array),
+              Pool(nullptr),
+              StealDeque(StealDequeSize),
+              NextVictim(0UL),
+              NumStolen(0UL) {
           assert(runner_id < total_num_runners);
           #ifdef FAST_SWITCH
           Base::Zero(MainFiber.fib);
@@ -265,6 +329,12 @@ namespace Orly {
         /* TODO */
         inline void ScheduleFrame(TFrame *frame);
 
+        /* The number of frames this runner has taken from the other runners in its pool. */
+        inline size_t GetNumStolen() const {
+          assert(this);
+          return NumStolen.load(std::memory_order_relaxed);
+        }
+
         /* TODO */
         fiber_t MainFiber;
 
@@ -284,6 +354,15 @@ namespace Orly {
 
         inline void ScheduleFrameSlow(TRunner *other_runner, TFrame *frame);
 
+        /* Switch to the given frame and clean up after it when it switches back. */
+        void RunFrame(TFrame *frame);
+
+        /* Move the frames waiting in our pool's injection queue into our steal deque. */
+        void TakeInjectedFrames();
+
+        /* Take a frame from the steal deque of another runner in our pool, or return null if they're all empty. */
+        TFrame *TrySteal();
+
         /* TODO */
         //mutable TFrameQueue::TImpl MyFrameQueue;
         TFrame *ReadyToRunQueue;
@@ -310,9 +389,27 @@ namespace Orly {
 
         TRunner **RunnerArray;
 
+        /* The slots in a steal deque. */
+        static constexpr size_t StealDequeSize = 4096UL;
+
+        /* The pool we belong to, if any.  Only runners in a pool steal, and only from each other. */
+        TRunnerPool *Pool;
+
+        /* Frames which have been scheduled through our pool but have not started yet.  We pop from the bottom; idle
+           runners in the pool steal from the top.  A frame which has started running is never put here again, so once
+           a frame lands on a runner it stays there; everything it does after that (yields, waits, locks) relies on it. */
+        TStealDeque<TFrame> StealDeque;
+
+        /* The runner in our pool we'll try to steal from first. */
+        size_t NextVictim;
+
+        /* See GetNumStolen(). */
+        std::atomic<size_t> NumStolen;
+
         /* Access to ComeBackSoon */
         friend class TFrame;
         friend class TFramePool;
+        friend class TRunnerPool;
 
       };  // TRunner
 
@@ -339,12 +436,16 @@ namespace Orly {
         /* TODO */
         TRunnerPool(TRunner::TRunnerCons &runner_cons,
                     size_t num_worker)
-            : WorkerCount(num_worker), AssignPos(0UL) {
+            : WorkerCount(num_worker), InjectQueue(nullptr) {
+          /* all the runners have to exist before any of them starts looking for someone to steal from */
           for (size_t i = 0; i < num_worker; ++i) {
             RunnerVec.emplace_back(new TRunner(runner_cons));
+            RunnerVec.back()->Pool = this;
+          }
+          for (size_t i = 0; i < num_worker; ++i) {
             ThreadVec.emplace_back(new std::thread(std::bind([](TRunner *runner) {
               runner->Run();
-            }, RunnerVec.back().get())));
+            }, RunnerVec[i].get())));
           }
         }
 
@@ -364,20 +465,40 @@ namespace Orly {
           return WorkerCount;
         }
 
-        /* TODO */
+        /* The total number of frames our runners have stolen from each other. */
+        inline size_t GetNumStolen() const {
+          assert(this);
+          size_t num_stolen = 0UL;
+          for (const auto &runner : RunnerVec) {
+            num_stolen += runner->GetNumStolen();
+          }
+          return num_stolen;
+        }
+
+        /* Run the function on whichever of our runners gets to it first.  If we're called from one of our own runners,
+           the frame goes on that runner's steal deque, so it stays local unless another runner is idle; otherwise it
+           goes on the injection queue, where the next runner to come up for air will pick it up. */
         inline void Schedule(TFrame *frame, TRunnable *runnable, const TRunnable::TFunc &func);
 
         private:
 
+        /* Called by TFrame::Latch(). */
+        inline void ScheduleFrame(TFrame *frame);
+
         /* TODO */
         const size_t WorkerCount;
 
-        /* TODO: use better data structure */
+        /* TODO */
         std::vector<std::unique_ptr<TRunner>> RunnerVec;
         std::vector<std::unique_ptr<std::thread>> ThreadVec;
 
-        /* TODO: we can do runner assignment more effectively than iterating through the vector */
-        std::atomic<size_t> AssignPos;
+        /* Frames scheduled from outside the pool, linked through InboundQueueNextFrame.  Pushed with a CAS and taken
+           all at once with an exchange, like a runner's inbound queue. */
+        TFrame *InjectQueue;
+
+        /* Access to ScheduleFrame(), InjectQueue and RunnerVec. */
+        friend class TFrame;
+        friend class TRunner;
 
       };  // TRunnerPool
 
@@ -422,6 +543,16 @@ namespace Orly {
           runner->ScheduleFrame(this);
         }
 
+        /* Latch onto a pool instead of a particular runner.  See TRunnerPool::Schedule(). */
+        inline void Latch(TRunnerPool *pool, TRunnable *runnable, TRunnable::TFunc runnable_func) {
+          CheckFrameUnwound();
+          assert(Runnable == nullptr);
+          assert(RunnableFunc == nullptr);
+          Runnable = runnable;
+          RunnableFunc = runnable_func;
+          pool->ScheduleFrame(this);
+        }
+
         /* TODO */
         inline void Latch(TRunnable *runnable, TRunnable::TFunc runnable_func) {
           //printf("TFrame [%p] Latch runnable [%p]\n", this, runnable);
@@ -556,6 +687,7 @@ namespace Orly {
         /* MyFiber */
         friend class TFramePool;
         friend class TRunner;
+        friend class TRunnerPool;
 
       };  // TFrame
 
@@ -845,9 +977,20 @@ namespace Orly {
         *************/
 
       inline void TRunnerPool::Schedule(TFrame *frame, TRunnable *runnable, const TRunnable::TFunc &func) {
-        size_t prev_assignment_count = std::atomic_fetch_add(&AssignPos, 1UL);
-        TRunner *const chosen_runner = RunnerVec[prev_assignment_count % WorkerCount].get();
-        frame->Latch(chosen_runner, runnable, func);
+        assert(this);
+        frame->Latch(this, runnable, func);
+      }
+
+      inline void TRunnerPool::ScheduleFrame(TFrame *frame) {
+        assert(this);
+        assert(frame);
+        TRunner *const local_runner = TRunner::LocalRunner;
+        if (local_runner && local_runner->Pool == this && local_runner->StealDeque.TryPush(frame)) {
+          return;
+        }
+        do {
+          frame->InboundQueueNextFrame = InjectQueue;
+        } while (!__sync_bool_compare_and_swap(&InjectQueue, frame->InboundQueueNextFrame, frame));
       }
 
       static inline void Yield() {
@@ -1036,17 +1179,25 @@ namespace Orly {
       }
 
       inline void TSingleSem::Push() {
-        Base::TSpinLock::TLock lock(SpinLock);
-        if (FrameWaiting) {
-          assert(!FlagOn);
-          assert(RunnerToReactivateOn);
-          Fiber::TFrame *frame = FrameWaiting;
-          Fiber::TRunner *runner = RunnerToReactivateOn;
-          FrameWaiting = nullptr;
-          RunnerToReactivateOn = nullptr;
+        /* Schedule the waiting frame, if any, only once we've let go of the lock.  It may destroy us as soon as it
+           runs, and it may run on another runner before we could unlock. */
+        Fiber::TFrame *frame = nullptr;
+        Fiber::TRunner *runner = nullptr;
+        /* spinlock scope */ {
+          Base::TSpinLock::TLock lock(SpinLock);
+          if (FrameWaiting) {
+            assert(!FlagOn);
+            assert(RunnerToReactivateOn);
+            frame = FrameWaiting;
+            runner = RunnerToReactivateOn;
+            FrameWaiting = nullptr;
+            RunnerToReactivateOn = nullptr;
+          } else {
+            FlagOn = true;
+          }
+        } // end spinlock scope
+        if (frame) {
           runner->ScheduleFrame(frame);
-        } else {
-          FlagOn = true;
         }
       }
 
@@ -1071,17 +1222,25 @@ namespace Orly {
       }
 
       inline void TSem::Push() {
-        Base::TSpinLock::TLock lock(SpinLock);
-        if (FrameWaiting) {
-          assert(Count == 0UL);
-          assert(RunnerToReactivateOn);
-          Fiber::TFrame *frame = FrameWaiting;
-          Fiber::TRunner *runner = RunnerToReactivateOn;
-          FrameWaiting = nullptr;
-          RunnerToReactivateOn = nullptr;
+        /* Schedule the waiting frame, if any, only once we've let go of the lock.  It may destroy us as soon as it
+           runs, and it may run on another runner before we could unlock. */
+        Fiber::TFrame *frame = nullptr;
+        Fiber::TRunner *runner = nullptr;
+        /* spinlock scope */ {
+          Base::TSpinLock::TLock lock(SpinLock);
+          if (FrameWaiting) {
+            assert(Count == 0UL);
+            assert(RunnerToReactivateOn);
+            frame = FrameWaiting;
+            runner = RunnerToReactivateOn;
+            FrameWaiting = nullptr;
+            RunnerToReactivateOn = nullptr;
+          } else {
+            ++Count;
+          }
+        } // end spinlock scope
+        if (frame) {
           runner->ScheduleFrame(frame);
-        } else {
-          ++Count;
         }
       }
 
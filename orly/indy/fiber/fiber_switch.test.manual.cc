@@ -0,0 +1,121 @@
+/* <orly/indy/fiber/fiber_switch.test.manual.cc>
+
+   Switches per second for each of the ways <orly/indy/fiber/fiber.h> can switch stacks.
+
+   Each fixture bounces between the main stack and a fiber's stack, so every lap is two switches.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/fiber/fiber.h>
+
+#include <chrono>
+#include <cstdio>
+
+#include <setjmp.h>
+#include <stdlib.h>
+#include <ucontext.h>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace chrono;
+using namespace Orly::Indy::Fiber;
+
+static const size_t NumLaps = 5000000UL;
+static const size_t StackSize = 64UL * 1024UL;
+
+/* Time the given number of laps and report. */
+template <typename TLap>
+static void Report(const char *name, const TLap &lap) {
+  const auto start = steady_clock::now();
+  for (size_t i = 0; i < NumLaps; ++i) {
+    lap();
+  }
+  const double secs = duration_cast<duration<double>>(steady_clock::now() - start).count();
+  printf("%-12s %12.0f switches/s, %6.1f ns/switch\n", name, NumLaps * 2 / secs, secs * 1e9 / (NumLaps * 2));
+}
+
+/* swapcontext() both ways. */
+static ucontext_t MainContext, FiberContext;
+
+static void ContextBody() {
+  for (;;) {
+    swapcontext(&FiberContext, &MainContext);
+  }
+}
+
+FIXTURE(SwapContext) {
+  void *stack = malloc(StackSize);
+  getcontext(&FiberContext);
+  FiberContext.uc_stack.ss_sp = stack;
+  FiberContext.uc_stack.ss_size = StackSize;
+  FiberContext.uc_link = nullptr;
+  makecontext(&FiberContext, ContextBody, 0);
+  Report("swapcontext", []() {
+    swapcontext(&MainContext, &FiberContext);
+  });
+  free(stack);
+}
+
+/* _setjmp()/_longjmp() both ways, bootstrapped with swapcontext(), as FAST_SWITCH does it. */
+static jmp_buf MainJmp, FiberJmp;
+
+static void JmpBody() {
+  if (_setjmp(FiberJmp) == 0) {
+    ucontext_t tmp;
+    swapcontext(&tmp, &MainContext);
+  }
+  for (;;) {
+    if (_setjmp(FiberJmp) == 0) {
+      _longjmp(MainJmp, 1);
+    }
+  }
+}
+
+FIXTURE(Jmp) {
+  void *stack = malloc(StackSize);
+  getcontext(&FiberContext);
+  FiberContext.uc_stack.ss_sp = stack;
+  FiberContext.uc_stack.ss_size = StackSize;
+  FiberContext.uc_link = nullptr;
+  makecontext(&FiberContext, JmpBody, 0);
+  swapcontext(&MainContext, &FiberContext);
+  Report("setjmp", []() {
+    if (_setjmp(MainJmp) == 0) {
+      _longjmp(FiberJmp, 1);
+    }
+  });
+  free(stack);
+}
+
+#ifdef __x86_64__
+/* orly_fiber_switch() both ways, as ASM_SWITCH does it. */
+static void *MainSp, *FiberSp;
+
+static void AsmBody(void *) {
+  for (;;) {
+    orly_fiber_switch(&FiberSp, MainSp);
+  }
+}
+
+FIXTURE(Asm) {
+  void *stack = malloc(StackSize);
+  FiberSp = make_asm_context(stack, StackSize, AsmBody, nullptr);
+  Report("asm", []() {
+    orly_fiber_switch(&MainSp, FiberSp);
+  });
+  free(stack);
+}
+#endif
@@ -0,0 +1,134 @@
+/* <orly/indy/fiber/reactor.cc>
+
+   Implements <orly/indy/fiber/reactor.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/fiber/reactor.h>
+
+#include <cerrno>
+#include <memory>
+
+#include <poll.h>
+#include <sys/epoll.h>
+
+#include <base/zero.h>
+#include <util/error.h>
+
+using namespace std;
+using namespace Base;
+using namespace Orly::Indy::Fiber;
+using namespace Util;
+
+/* The most events we'll handle per trip through epoll_wait(). */
+static const int MaxEventCount = 256;
+
+TReactor::TReactor()
+    : Epoll(epoll_create1(EPOLL_CLOEXEC)), WakeCount(0UL) {
+  /* The shutdown semaphore is the only thing in the epoll with a null pointer. */
+  epoll_event event;
+  Zero(event);
+  event.events = EPOLLIN;
+  event.data.ptr = nullptr;
+  IfLt0(epoll_ctl(Epoll, EPOLL_CTL_ADD, ShutdownSem.GetFd(), &event));
+  Thread = thread(&TReactor::Main, this);
+}
+
+TReactor::~TReactor() {
+  assert(this);
+  ShutdownSem.Push();
+  Thread.join();
+}
+
+void TReactor::Wait(int fd, bool for_write) {
+  assert(this);
+  assert(fd >= 0);
+  const int flags = for_write ? EPOLLOUT : EPOLLIN;
+  if (!TFrame::LocalFrame) {
+    /* We're not on a fiber, so there's no one to yield to. */
+    pollfd p;
+    p.fd = fd;
+    p.events = flags;
+    while (poll(&p, 1, -1) < 0) {
+      if (errno != EINTR) {
+        ThrowSystemError(errno);
+      }
+    }
+    return;
+  }
+  assert(TRunner::LocalRunner);
+  /* The waiter lives on our stack, which stays put while we're parked.  The background thread may wake us before we
+     have even yielded, but that's fine; the runner won't pick us up again until we have. */
+  TWaiter waiter { TFrame::LocalFrame, TRunner::LocalRunner, nullptr };
+  Arm(fd, flags, &waiter);
+  Fiber::Wait();
+}
+
+void TReactor::OnReady(int fd, const function<void ()> &cb, bool for_write) {
+  assert(this);
+  assert(fd >= 0);
+  assert(cb);
+  /* The background thread frees the waiter once it has called back. */
+  unique_ptr<TWaiter> waiter(new TWaiter { nullptr, nullptr, cb });
+  Arm(fd, for_write ? EPOLLOUT : EPOLLIN, waiter.get());
+  waiter.release();
+}
+
+void TReactor::Arm(int fd, int flags, TWaiter *waiter) {
+  assert(this);
+  assert(waiter);
+  epoll_event event;
+  Zero(event);
+  event.events = flags | EPOLLONESHOT;
+  event.data.ptr = waiter;
+  if (epoll_ctl(Epoll, EPOLL_CTL_MOD, fd, &event) < 0) {
+    /* First time we've seen this fd (or it was closed and its number reused). */
+    if (errno != ENOENT) {
+      ThrowSystemError(errno);
+    }
+    IfLt0(epoll_ctl(Epoll, EPOLL_CTL_ADD, fd, &event));
+  }
+}
+
+void TReactor::Main() {
+  assert(this);
+  epoll_event events[MaxEventCount];
+  for (;;) {
+    const int count = epoll_wait(Epoll, events, MaxEventCount, -1);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      ThrowSystemError(errno);
+    }
+    for (int i = 0; i < count; ++i) {
+      TWaiter *waiter = static_cast<TWaiter *>(events[i].data.ptr);
+      if (!waiter) {
+        return;
+      }
+      ++WakeCount;
+      /* The fd is one-shot, so it won't fire again until someone re-arms it. */
+      if (!waiter->Frame) {
+        unique_ptr<TWaiter> owned(waiter);
+        owned->Cb();
+        continue;
+      }
+      /* Copy out before scheduling; once the frame runs, the waiter is gone. */
+      TFrame *frame = waiter->Frame;
+      TRunner *runner = waiter->Runner;
+      runner->ScheduleFrame(frame);
+    }
+  }
+}
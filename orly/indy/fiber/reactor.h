@@ -0,0 +1,113 @@
+/* <orly/indy/fiber/reactor.h>
+
+   Parks fibers on file descriptors instead of blocking the runner's thread.
+
+   A frame which wants to read from (or write to) an fd calls TReactor::Wait().  The reactor arms the fd, one-shot, in
+   its epoll and the frame yields, leaving its runner free to run other frames.  A single background thread waits on
+   the epoll and, when the fd becomes ready, schedules the frame back onto the runner it came from.  Tens of thousands
+   of mostly idle connections therefore cost an epoll registration each, not a thread each.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <thread>
+
+#include <base/class_traits.h>
+#include <base/event_semaphore.h>
+#include <base/fd.h>
+#include <orly/indy/fiber/fiber.h>
+
+namespace Orly {
+
+  namespace Indy {
+
+    namespace Fiber {
+
+      /* An epoll-driven waker of frames. */
+      class TReactor {
+        NO_COPY(TReactor);
+        public:
+
+        /* Starts the background thread. */
+        TReactor();
+
+        /* Stops the background thread.  No frame may still be waiting.  Callbacks still waiting are abandoned, neither
+           called nor freed, just as waiting frames would be. */
+        ~TReactor();
+
+        /* The number of times a frame has been woken or a callback called. */
+        size_t GetWakeCount() const {
+          assert(this);
+          return WakeCount;
+        }
+
+        /* Return when the fd is readable (or writable).  Errors and hang-ups count as ready, so the caller finds out
+           about them from its next read or write.
+           From inside a frame, the frame yields until the fd is ready; anywhere else, we just block in poll().
+           Only one frame may wait on a given fd at a time. */
+        void Wait(int fd, bool for_write = false);
+
+        /* Like Wait(), but returns at once, and calls the given function once the fd is ready.  This lets the caller
+           give up its frame while it waits, rather than keep it parked.  The function is called on our background
+           thread, so it should do little more than hand off the real work, and it mustn't throw.
+           Only one frame or function may wait on a given fd at a time. */
+        void OnReady(int fd, const std::function<void ()> &cb, bool for_write = false);
+
+        private:
+
+        /* What we leave in the epoll while a frame or a callback waits. */
+        struct TWaiter {
+
+          /* The frame to wake, or null if we're to call Cb instead. */
+          TFrame *Frame;
+
+          /* The runner to wake it on. */
+          TRunner *Runner;
+
+          /* The function to call.  Only used when Frame is null, in which case the waiter lives on the heap. */
+          std::function<void ()> Cb;
+
+        };  // TWaiter
+
+        /* Arm the fd, one-shot, for the given flags, with the given waiter. */
+        void Arm(int fd, int flags, TWaiter *waiter);
+
+        /* The background thread's loop. */
+        void Main();
+
+        /* The epoll in which we arm fds. */
+        Base::TFd Epoll;
+
+        /* Pushed to tell the background thread to stop. */
+        Base::TEventSemaphore ShutdownSem;
+
+        /* See accessor. */
+        std::atomic<size_t> WakeCount;
+
+        /* Runs Main(). */
+        std::thread Thread;
+
+      };  // TReactor
+
+    }  // Fiber
+
+  }  // Indy
+
+}  // Orly
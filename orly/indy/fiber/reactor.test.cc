@@ -0,0 +1,161 @@
+/* <orly/indy/fiber/reactor.test.cc>
+
+   Unit test for <orly/indy/fiber/reactor.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/fiber/reactor.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <unistd.h>
+
+#include <base/fd.h>
+#include <orly/indy/fiber/fiber_test_runner.h>
+#include <util/io.h>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace chrono;
+using namespace Base;
+using namespace Orly::Indy::Fiber;
+using namespace Util;
+
+/* Yields over and over until told to stop, counting the laps. */
+class TTicker
+    : public TRunnable {
+  NO_COPY(TTicker);
+  public:
+
+  TTicker() : LapCount(0UL), Stop(false), Done(false) {
+    TFrame *frame = TFrame::LocalFramePool->Alloc();
+    try {
+      frame->Latch(TRunner::LocalRunner, this, static_cast<TRunnable::TFunc>(&TTicker::Run));
+    } catch (...) {
+      TFrame::LocalFramePool->Free(frame);
+      throw;
+    }
+  }
+
+  void Run() {
+    while (!Stop) {
+      ++LapCount;
+      Yield();
+    }
+    FreeMyFrame(TFrame::LocalFramePool);
+    Done = true;
+  }
+
+  atomic<size_t> LapCount;
+
+  atomic<bool> Stop, Done;
+
+};  // TTicker
+
+FIXTURE(Typical) {
+  TFiberTestRunner runner([](mutex &mut, condition_variable &cond, bool &fin, TRunner::TRunnerCons &) {
+    TReactor reactor;
+    TFd readable, writeable;
+    TFd::Pipe(readable, writeable);
+    /* While we're parked on the pipe, the ticker should have our runner to itself. */
+    TTicker ticker;
+    thread writer([&writeable]() {
+      this_thread::sleep_for(milliseconds(50));
+      WriteExactly(writeable, "x", 1);
+    });
+    reactor.Wait(readable);
+    const size_t laps_while_parked = ticker.LapCount;
+    char c;
+    EXPECT_EQ(ReadAtMost(readable, &c, 1), 1UL);
+    EXPECT_EQ(c, 'x');
+    EXPECT_TRUE(laps_while_parked > 0UL);
+    EXPECT_EQ(reactor.GetWakeCount(), 1UL);
+    writer.join();
+    /* Already readable, so the re-armed fd fires right away. */
+    WriteExactly(writeable, "y", 1);
+    reactor.Wait(readable);
+    EXPECT_EQ(reactor.GetWakeCount(), 2UL);
+    /* Waiting to write a pipe with room in it shouldn't park us for long either. */
+    reactor.Wait(writeable, true);
+    EXPECT_EQ(reactor.GetWakeCount(), 3UL);
+    ticker.Stop = true;
+    while (!ticker.Done) {
+      Yield();
+    }
+    std::lock_guard<std::mutex> lock(mut);
+    fin = true;
+    cond.notify_one();
+  });
+}
+
+FIXTURE(OffFiber) {
+  /* Off a fiber, we just block. */
+  TReactor reactor;
+  TFd readable, writeable;
+  TFd::Pipe(readable, writeable);
+  WriteExactly(writeable, "x", 1);
+  reactor.Wait(readable);
+  EXPECT_EQ(reactor.GetWakeCount(), 0UL);
+}
+
+FIXTURE(OnReady) {
+  /* No frame needed; the callback comes on the reactor's own thread. */
+  TReactor reactor;
+  TFd readable, writeable;
+  TFd::Pipe(readable, writeable);
+  mutex mut;
+  condition_variable cond;
+  size_t call_count = 0;
+  thread::id caller;
+  auto cb = [&] {
+    lock_guard<mutex> lock(mut);
+    ++call_count;
+    caller = this_thread::get_id();
+    cond.notify_one();
+  };
+  reactor.OnReady(readable, cb);
+  this_thread::sleep_for(milliseconds(50));
+  /* not yet */ {
+    lock_guard<mutex> lock(mut);
+    EXPECT_EQ(call_count, 0UL);
+  }
+  WriteExactly(writeable, "x", 1);
+  /* called */ {
+    unique_lock<mutex> lock(mut);
+    while (call_count < 1) {
+      cond.wait(lock);
+    }
+    EXPECT_TRUE(caller != this_thread::get_id());
+  }
+  /* One-shot, so it takes re-arming to be called again, even though the pipe is still readable. */
+  this_thread::sleep_for(milliseconds(50));
+  /* still once */ {
+    lock_guard<mutex> lock(mut);
+    EXPECT_EQ(call_count, 1UL);
+  }
+  reactor.OnReady(readable, cb);
+  /* called again */ {
+    unique_lock<mutex> lock(mut);
+    while (call_count < 2) {
+      cond.wait(lock);
+    }
+  }
+  EXPECT_EQ(reactor.GetWakeCount(), 2UL);
+}
@@ -0,0 +1,240 @@
+/* <orly/indy/fiber/runner_pool.test.manual.cc>
+
+   Throughput and latency of TRunnerPool under skewed workloads.
+
+   Each fixture pushes a stream of tasks through a pool, keeping a fixed number in flight, and reports tasks per
+   second along with percentiles of the time from Schedule() to completion.  The skewed fixtures are the interesting
+   ones: a few long tasks (think merges, or a slow SyncGetData) mixed into many short ones, or every task coming from a
+   single runner.  Without stealing, the short tasks queued behind a long one wait it out.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/fiber/fiber.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace chrono;
+using namespace Base;
+using namespace Orly::Indy::Fiber;
+
+typedef TThreadLocalGlobalPoolManager<TFrame, size_t, TRunner *> TFrameManager;
+
+static const size_t NumWorkers = 4UL;
+static const size_t NumTasks = 100000UL;
+static const size_t MaxInflight = 256UL;
+static const size_t StackSize = 64UL * 1024UL;
+
+/* Keep the cpu busy for the given time. */
+static void Spin(nanoseconds duration) {
+  const auto until = steady_clock::now() + duration;
+  while (steady_clock::now() < until) {}
+}
+
+/* The shape of a workload. */
+class TWorkload {
+  public:
+
+  /* The cost of a task, and how often (1 in how many) a task costs LongCost instead. */
+  nanoseconds ShortCost, LongCost;
+  size_t LongEvery;
+
+  /* The number of times each task yields along the way. */
+  size_t NumYields;
+
+  /* Submit every task from a frame on one of the pool's runners, rather than from outside the pool. */
+  bool FromInside;
+
+};  // TWorkload
+
+class TBench;
+
+/* One unit of work. */
+class TTask
+    : public TRunnable {
+  NO_COPY(TTask);
+  public:
+
+  TTask() {}
+
+  void Submit(TBench *bench, nanoseconds cost, size_t num_yields);
+
+  void Run();
+
+  nanoseconds GetLatency() const {
+    return Latency;
+  }
+
+  private:
+
+  TBench *Bench;
+
+  nanoseconds Cost;
+
+  size_t NumYields;
+
+  steady_clock::time_point SubmitTime;
+
+  nanoseconds Latency;
+
+};  // TTask
+
+/* Runs one workload on a fresh pool and reports on it. */
+class TBench
+    : public TRunnable {
+  NO_COPY(TBench);
+  public:
+
+  TBench(const char *name, const TWorkload &workload)
+      : Workload(workload),
+        RunnerCons(NumWorkers),
+        FrameManager(MaxInflight * 2, StackSize, nullptr),
+        FramePool(new TFrameManager::TThreadLocalPool(&FrameManager)),
+        Pool(RunnerCons, NumWorkers),
+        TaskVec(NumTasks),
+        NumInflight(0UL),
+        Done(false) {
+    const auto start = steady_clock::now();
+    if (Workload.FromInside) {
+      /* the generator needs a frame too */
+      ++NumInflight;
+      Pool.Schedule(FramePool->Alloc(), this, static_cast<TRunnable::TFunc>(&TBench::Generate));
+      while (!Done) {
+        this_thread::sleep_for(milliseconds(1));
+      }
+    } else {
+      for (size_t i = 0; i < NumTasks; ++i) {
+        while (NumInflight >= MaxInflight) {
+          this_thread::yield();
+        }
+        SubmitTask(i);
+      }
+    }
+    while (NumInflight) {
+      this_thread::yield();
+    }
+    const double secs = duration_cast<duration<double>>(steady_clock::now() - start).count();
+    vector<nanoseconds> latencies;
+    latencies.reserve(NumTasks);
+    for (const auto &task : TaskVec) {
+      latencies.push_back(task.GetLatency());
+    }
+    sort(latencies.begin(), latencies.end());
+    auto usec = [&latencies](double pct) {
+      return duration_cast<duration<double, micro>>(latencies[min(latencies.size() - 1, static_cast<size_t>(latencies.size() * pct))]).count();
+    };
+    printf("%-12s %10.0f tasks/s, latency usec: p50 %9.1f  p99 %9.1f  p99.9 %9.1f  max %9.1f, stolen %ld\n",
+           name, NumTasks / secs, usec(0.5), usec(0.99), usec(0.999), usec(1.0), Pool.GetNumStolen());
+  }
+
+  /* Called by a task when it finishes. */
+  void OnDone() {
+    --NumInflight;
+  }
+
+  /* The pool of frames all the tasks use.  Only the submitting thread allocates from it. */
+  TFrameManager::TThreadLocalPool *GetFramePool() const {
+    return FramePool.get();
+  }
+
+  /* The pool under test. */
+  TRunnerPool &GetPool() {
+    return Pool;
+  }
+
+  private:
+
+  /* Submit the i-th task. */
+  void SubmitTask(size_t i) {
+    ++NumInflight;
+    const bool is_long = Workload.LongEvery && i % Workload.LongEvery == 0;
+    TaskVec[i].Submit(this, is_long ? Workload.LongCost : Workload.ShortCost, Workload.NumYields);
+  }
+
+  /* Submit every task from inside the pool. */
+  void Generate() {
+    for (size_t i = 0; i < NumTasks; ++i) {
+      while (NumInflight >= MaxInflight) {
+        Yield();
+      }
+      SubmitTask(i);
+    }
+    --NumInflight;
+    FreeMyFrame(FramePool.get());
+    Done = true;
+  }
+
+  const TWorkload Workload;
+
+  TRunner::TRunnerCons RunnerCons;
+
+  TFrameManager FrameManager;
+
+  unique_ptr<TFrameManager::TThreadLocalPool> FramePool;
+
+  /* Declared after the frames, so its runners have stopped (and freed their last frames) before those go away. */
+  TRunnerPool Pool;
+
+  vector<TTask> TaskVec;
+
+  atomic<size_t> NumInflight;
+
+  atomic<bool> Done;
+
+};  // TBench
+
+void TTask::Submit(TBench *bench, nanoseconds cost, size_t num_yields) {
+  Bench = bench;
+  Cost = cost;
+  NumYields = num_yields;
+  SubmitTime = steady_clock::now();
+  bench->GetPool().Schedule(bench->GetFramePool()->Alloc(), this, static_cast<TRunnable::TFunc>(&TTask::Run));
+}
+
+void TTask::Run() {
+  const nanoseconds slice = Cost / (NumYields + 1);
+  for (size_t i = 0; i < NumYields; ++i) {
+    Spin(slice);
+    Yield();
+  }
+  Spin(slice);
+  Latency = steady_clock::now() - SubmitTime;
+  FreeMyFrame(Bench->GetFramePool());
+  Bench->OnDone();
+}
+
+FIXTURE(Uniform) {
+  TBench("uniform", TWorkload{microseconds(5), microseconds(5), 0UL, 0UL, false});
+}
+
+FIXTURE(HeavyTail) {
+  TBench("heavy-tail", TWorkload{microseconds(5), milliseconds(1), 100UL, 0UL, false});
+}
+
+FIXTURE(Yielding) {
+  TBench("yielding", TWorkload{microseconds(5), milliseconds(1), 100UL, 4UL, false});
+}
+
+FIXTURE(OneSource) {
+  TBench("one-source", TWorkload{microseconds(5), milliseconds(1), 100UL, 0UL, true});
+}
@@ -0,0 +1,139 @@
+/* <orly/indy/fiber/steal_deque.h>
+
+   A bounded, lock-free work-stealing deque (Chase & Lev, with the memory orderings of Le et al., PPoPP '13).
+
+   One thread owns the deque and pushes and pops at the bottom; any number of other threads may steal from the top.
+   The owner sees its most recent work first, which keeps its cache warm, while thieves take the oldest work, which is
+   the least likely to be hot anywhere.  The deque never grows; when it is full, TryPush() fails and the caller keeps
+   the item some other way.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <base/class_traits.h>
+
+namespace Orly {
+
+  namespace Indy {
+
+    namespace Fiber {
+
+      /* A deque of pointers to TVal. */
+      template <typename TVal>
+      class TStealDeque {
+        NO_COPY(TStealDeque);
+        public:
+
+        /* The capacity must be a power of 2. */
+        explicit TStealDeque(size_t capacity)
+            : Top(0), Bottom(0), Mask(capacity - 1), Buffer(new std::atomic<TVal *>[capacity]) {
+          assert(capacity && !(capacity & Mask));
+          for (size_t i = 0; i < capacity; ++i) {
+            std::atomic_init(&Buffer[i], static_cast<TVal *>(nullptr));
+          }
+        }
+
+        /* TODO */
+        ~TStealDeque() {
+          assert(this);
+          delete[] Buffer;
+        }
+
+        /* Owner only.  Push the item onto the bottom, or return false if the deque is full. */
+        bool TryPush(TVal *val) {
+          assert(this);
+          assert(val);
+          const int64_t b = Bottom.load(std::memory_order_relaxed);
+          const int64_t t = Top.load(std::memory_order_acquire);
+          if (static_cast<size_t>(b - t) > Mask) {
+            return false;
+          }
+          Buffer[b & Mask].store(val, std::memory_order_relaxed);
+          std::atomic_thread_fence(std::memory_order_release);
+          Bottom.store(b + 1, std::memory_order_relaxed);
+          return true;
+        }
+
+        /* Owner only.  Pop the item at the bottom, or return null if the deque is empty (or a thief got the last one). */
+        TVal *TryPop() {
+          assert(this);
+          const int64_t b = Bottom.load(std::memory_order_relaxed) - 1;
+          Bottom.store(b, std::memory_order_relaxed);
+          std::atomic_thread_fence(std::memory_order_seq_cst);
+          int64_t t = Top.load(std::memory_order_relaxed);
+          if (t > b) {
+            Bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+          }
+          TVal *val = Buffer[b & Mask].load(std::memory_order_relaxed);
+          if (t == b) {
+            /* This is the last item, so we race the thieves for it. */
+            if (!Top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+              val = nullptr;
+            }
+            Bottom.store(b + 1, std::memory_order_relaxed);
+          }
+          return val;
+        }
+
+        /* Any thread.  Take the item at the top, or return null if the deque is empty or we lost a race for it. */
+        TVal *TrySteal() {
+          assert(this);
+          int64_t t = Top.load(std::memory_order_acquire);
+          std::atomic_thread_fence(std::memory_order_seq_cst);
+          const int64_t b = Bottom.load(std::memory_order_acquire);
+          if (t >= b) {
+            return nullptr;
+          }
+          TVal *val = Buffer[t & Mask].load(std::memory_order_relaxed);
+          if (!Top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+          }
+          return val;
+        }
+
+        /* A hint only; it may be stale by the time you look at it. */
+        bool IsEmpty() const {
+          assert(this);
+          return Bottom.load(std::memory_order_relaxed) <= Top.load(std::memory_order_relaxed);
+        }
+
+        private:
+
+        /* The next item to steal.  Only ever increases. */
+        alignas(64) std::atomic<int64_t> Top;
+
+        /* One past the last item pushed.  Written only by the owner. */
+        alignas(64) std::atomic<int64_t> Bottom;
+
+        /* Capacity - 1. */
+        alignas(64) const size_t Mask;
+
+        /* The slots, indexed by position & Mask. */
+        std::atomic<TVal *> *Buffer;
+
+      };  // TStealDeque
+
+    }  // Fiber
+
+  }  // Indy
+
+}  // Orly
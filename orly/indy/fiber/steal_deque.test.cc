@@ -0,0 +1,110 @@
+/* <orly/indy/fiber/steal_deque.test.cc>
+
+   Unit test for <orly/indy/fiber/steal_deque.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/fiber/steal_deque.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Orly::Indy::Fiber;
+
+FIXTURE(Typical) {
+  int vals[4];
+  TStealDeque<int> deque(4UL);
+  EXPECT_TRUE(deque.IsEmpty());
+  EXPECT_FALSE(deque.TryPop());
+  EXPECT_FALSE(deque.TrySteal());
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(deque.TryPush(&vals[i]));
+  }
+  EXPECT_FALSE(deque.TryPush(&vals[0]));
+  /* the owner gets the newest, a thief gets the oldest */
+  EXPECT_EQ(deque.TryPop(), &vals[3]);
+  EXPECT_EQ(deque.TrySteal(), &vals[0]);
+  EXPECT_EQ(deque.TrySteal(), &vals[1]);
+  EXPECT_EQ(deque.TryPop(), &vals[2]);
+  EXPECT_TRUE(deque.IsEmpty());
+  EXPECT_FALSE(deque.TryPop());
+  /* wrap around the buffer */
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(deque.TryPush(&vals[i]));
+  }
+  EXPECT_EQ(deque.TrySteal(), &vals[0]);
+  EXPECT_EQ(deque.TryPop(), &vals[3]);
+}
+
+FIXTURE(Concurrent) {
+  /* The owner pushes and pops while the thieves steal.  Every item must come out exactly once. */
+  const size_t num_items = 1000000UL, num_thieves = 3UL;
+  vector<atomic<size_t>> taken(num_items);
+  for (auto &count : taken) {
+    atomic_init(&count, 0UL);
+  }
+  vector<size_t> ids(num_items);
+  for (size_t i = 0; i < num_items; ++i) {
+    ids[i] = i;
+  }
+  TStealDeque<size_t> deque(256UL);
+  atomic<bool> done(false);
+  atomic<size_t> num_stolen(0UL);
+  vector<thread> thieves;
+  for (size_t i = 0; i < num_thieves; ++i) {
+    thieves.emplace_back([&]() {
+      for (;;) {
+        const bool was_done = done.load();
+        size_t *id = deque.TrySteal();
+        if (id) {
+          ++taken[*id];
+          ++num_stolen;
+        } else if (was_done) {
+          break;
+        }
+      }
+    });
+  }
+  for (size_t i = 0; i < num_items; ++i) {
+    while (!deque.TryPush(&ids[i])) {
+      size_t *id = deque.TryPop();
+      if (id) {
+        ++taken[*id];
+      }
+    }
+    if (i % 3 == 0) {
+      size_t *id = deque.TryPop();
+      if (id) {
+        ++taken[*id];
+      }
+    }
+  }
+  done = true;
+  for (auto &thief : thieves) {
+    thief.join();
+  }
+  size_t num_wrong = 0UL;
+  for (auto &count : taken) {
+    if (count != 1UL) {
+      ++num_wrong;
+    }
+  }
+  EXPECT_EQ(num_wrong, 0UL);
+  EXPECT_TRUE(num_stolen > 0UL);
+}
@@ -424,26 +424,34 @@ void TManager::RunReplicateTransaction() {
                       switch (mutation.GetKind()) {
                         case L1::TTransaction::TReplica::TMutation::Pusher: {
                           if (mutation.GetRepoId() == GlobalPovId) {
-                            Base::TUuid session_id;
+                            /* An update promoted on its own carries just its session id, and its id is the one the
+                               session is tracking.  A collapsed update carries the session id of each update in it. */
+                            void *type_alloc = alloca(Sabot::Type::GetMaxTypeSize());
+                            Sabot::Type::TAny::TWrapper meta_type(mutation.GetUpdate().GetMetadata().GetType(mutation.GetUpdate().GetSuprena().get(), type_alloc));
+                            Server::TMetaRecord::TSessionIdByUpdateId session_id_by_update_id;
                             try {
-                              Sabot::ToNative(*Sabot::State::TAny::TWrapper(mutation.GetUpdate().GetMetadata().NewState(mutation.GetUpdate().GetSuprena().get(), state_alloc)), session_id);
+                              if (dynamic_cast<const Sabot::Type::TUuid *>(meta_type.get())) {
+                                Base::TUuid session_id, tracker_id;
+                                Sabot::ToNative(*Sabot::State::TAny::TWrapper(mutation.GetUpdate().GetMetadata().NewState(mutation.GetUpdate().GetSuprena().get(), state_alloc)), session_id);
+                                Sabot::ToNative(*Sabot::State::TAny::TWrapper(mutation.GetUpdate().GetId().NewState(mutation.GetUpdate().GetSuprena().get(), state_alloc)), tracker_id);
+                                session_id_by_update_id.insert(make_pair(tracker_id, session_id));
+                              } else {
+                                Sabot::ToNative(*Sabot::State::TAny::TWrapper(mutation.GetUpdate().GetMetadata().NewState(mutation.GetUpdate().GetSuprena().get(), state_alloc)), session_id_by_update_id);
+                              }
                             } catch (const exception &ex) {
-                              syslog(LOG_ERR, "Exception while trying to access ession ID of update promoted to global: [%s]", ex.what());
+                              syslog(LOG_ERR, "Exception while trying to access session IDs of update promoted to global: [%s]", ex.what());
+                            }
+                            for (const auto &item: session_id_by_update_id) {
+                              UpdateReplicationNotificationCb(item.second, mutation.GetRepoId(), item.first);
                             }
-                            Base::TUuid tracker_id;
-                            Sabot::ToNative(*Sabot::State::TAny::TWrapper(mutation.GetUpdate().GetId().NewState(mutation.GetUpdate().GetSuprena().get(), state_alloc)), tracker_id);
-                            //std::cout << "Calling UpdateReplicationNotificationCb() for global" << std::endl;
-                            UpdateReplicationNotificationCb(session_id, mutation.GetRepoId(), tracker_id);
                           } else {
                             Server::TMetaRecord meta_record;
                             Sabot::ToNative(*Sabot::State::TAny::TWrapper(mutation.GetUpdate().GetMetadata().NewState(mutation.GetUpdate().GetSuprena().get(), state_alloc)), meta_record);
-                            /* TODO : when we start merging updates we need to notify all update tracker ids. */
-                            Base::TUuid tracker_id;
-                            Sabot::ToNative(*Sabot::State::TAny::TWrapper(mutation.GetUpdate().GetId().NewState(mutation.GetUpdate().GetSuprena().get(), state_alloc)), tracker_id);
+                            /* A collapsed update has entries from several updates; each session tracks its own. */
                             for (const auto &item: meta_record.GetEntryByUpdateId()) {
                               const auto &entry = item.second;
                               //std::cout << "Calling UpdateReplicationNotificationCb() for private" << std::endl;
-                              UpdateReplicationNotificationCb(entry.GetSessionId(), mutation.GetRepoId(), tracker_id);
+                              UpdateReplicationNotificationCb(entry.GetSessionId(), mutation.GetRepoId(), item.first);
                             }
                           }
                           break;
@@ -224,6 +224,8 @@ TManager::TManager(Disk::Util::TEngine *engine,
       MergeMemCores(merge_mem_cores),
       MergeDiskCores(merge_disk_cores),
       TetrisManager(nullptr),
+      CompactionPolicy(new TTieredCompactionPolicy()),
+      RowCache(nullptr),
       OnCloseCb(std::bind(&TManager::OnClose, this, std::placeholders::_1)) {}
 
 TManager::~TManager() {
@@ -271,6 +273,18 @@ void TManager::SetTetrisManager(Orly::Server::TTetrisManager *tetris_manager) {
   TetrisManager = tetris_manager;
 }
 
+void TManager::SetMergeDiskRunners(const std::vector<Fiber::TRunner *> &merge_disk_runners) {
+  assert(this);
+  assert(MergeDiskRunners.empty());
+  MergeDiskRunners = merge_disk_runners;
+}
+
+void TManager::SetCompactionPolicy(std::unique_ptr<TCompactionPolicy> &&compaction_policy) {
+  assert(this);
+  assert(compaction_policy);
+  CompactionPolicy = std::move(compaction_policy);
+}
+
 void TManager::CompactOpemMap() {
   assert(this);
   //throw std::logic_error("TODO: Implement CompactOpenMap()");
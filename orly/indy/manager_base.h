@@ -27,6 +27,7 @@
 #include <base/uuid.h>
 #include <inv_con/unordered_list.h>
 #include <inv_con/unordered_multimap.h>
+#include <orly/indy/compaction_policy.h>
 #include <orly/indy/disk/util/engine.h>
 #include <orly/indy/disk/utilization_reporter.h>
 #include <orly/indy/fiber/fiber.h>
@@ -51,6 +52,7 @@ namespace Orly {
     /* Forward Declarations. */
     class TMemoryLayer;
     class TDiskLayer;
+    class TRowCache;
 
     /* Forward Declarations. */
     class TManager;
@@ -736,6 +738,37 @@ namespace Orly {
         /* TODO */
         void SetTetrisManager(Server::TTetrisManager *tetris_manager);
 
+        /* The runners which do disk merges.  A merge spreads what work it can over them. */
+        const std::vector<Fiber::TRunner *> &GetMergeDiskRunners() const {
+          assert(this);
+          return MergeDiskRunners;
+        }
+
+        /* Set the runners returned by GetMergeDiskRunners().  Call this once, before any disk merge starts. */
+        void SetMergeDiskRunners(const std::vector<Fiber::TRunner *> &merge_disk_runners);
+
+        /* Chooses the disk layers which safe repos merge.  Tiered unless set otherwise. */
+        const TCompactionPolicy *GetCompactionPolicy() const {
+          assert(this);
+          return CompactionPolicy.get();
+        }
+
+        /* Set the policy returned by GetCompactionPolicy().  Call this before any disk merge starts. */
+        void SetCompactionPolicy(std::unique_ptr<TCompactionPolicy> &&compaction_policy);
+
+        /* The cache of point reads in root repos, or null if we're not caching. */
+        TRowCache *GetRowCache() const {
+          assert(this);
+          return RowCache;
+        }
+
+        /* Start caching point reads in root repos.  Call this before any repo is opened; we don't own the cache. */
+        void SetRowCache(TRowCache *row_cache) {
+          assert(this);
+          assert(!RowCache);
+          RowCache = row_cache;
+        }
+
         /* TODO */
         void ReportMergeCPUTime(double &out_merge_mem, double &out_merge_disk);
 
@@ -965,6 +998,15 @@ namespace Orly {
         /* TODO */
         Server::TTetrisManager *TetrisManager;
 
+        /* See accessor. */
+        std::vector<Fiber::TRunner *> MergeDiskRunners;
+
+        /* See accessor. */
+        std::unique_ptr<TCompactionPolicy> CompactionPolicy;
+
+        /* See accessor. */
+        TRowCache *RowCache;
+
         /* TODO */
         std::function<void (TRepo *)> OnCloseCb;
 
@@ -20,25 +20,52 @@
 
 using namespace std;
 using namespace Base;
+using namespace Orly;
 using namespace Orly::Indy;
 
+/* True iff. every field of the key is defined.  Such a key can only match entries equal to it. */
+static bool IsFullyBound(const TKey &key) {
+  const Atom::TCore &core = key.GetCore();
+  if (!core.IsTuple()) {
+    return true;
+  }
+  const Atom::TCore::TOffset *const off = core.TryGetOffset();
+  if (!off) {
+    return true;
+  }
+  void *pin_alloc = alloca(sizeof(Atom::TCore::TArena::TFinalPin));
+  Atom::TCore::TArena::TFinalPin::TWrapper pin(key.GetArena()->Pin(*off,
+                                                                   sizeof(Atom::TCore::TNote) + (sizeof(Atom::TCore) * *core.TryGetElemCount()),
+                                                                   pin_alloc));
+  return pin->GetNote()->GetTupleNumNonFree() == *core.TryGetElemCount();
+}
+
+/* A cursor on the first entry of the layer which is not before the given key.  If by_key is false, we skip only the
+   entries of the indices before the key's index.  Free fields order by type before value, so a key with frees does
+   not give us a lower bound within its index; those walks must seek this way. */
+static TMemoryLayer::TEntryCollection::TCursor SeekEntry(const TMemoryLayer *layer, const TIndexKey &key, bool by_key) {
+  return TMemoryLayer::TEntryCollection::TCursor(layer->GetEntryCollection(), [&key, by_key](const TUpdate::TEntry &entry) {
+    Atom::TComparison comp = Atom::CompareOrdered(entry.GetIndexKey().GetIndexId(), key.GetIndexId());
+    return Atom::IsLt(comp) || (by_key && Atom::IsEq(comp) && Atom::IsLt(entry.GetKey().Compare(key.GetKey())));
+  });
+}
+
 TMemoryLayer::TMemoryLayer(L0::TManager *manager)
     : TDataLayer(manager),
       UpdateCollection(this),
-      EntryCollection(this),
       Size(0UL) {}
 
 TMemoryLayer::~TMemoryLayer() {
   assert(this);
+  /* The entries belong to the updates; the skip list frees only its own nodes. */
   UpdateCollection.DeleteEachMember();
-  EntryCollection.DeleteEachMember();
 }
 
 void TMemoryLayer::Insert(TUpdate *update) NO_THROW {
   assert(this);
   for (TUpdate::TEntryCollection::TCursor csr(&update->EntryCollection/*, InvCon::TOrient::Rev*/); csr; ++csr) {
     ++Size;
-    csr->MemoryLayerMembership.ReverseInsert(&EntryCollection);
+    EntryCollection.Insert(&*csr);
   }
   update->MemoryLayerMembership.ReverseInsert(&UpdateCollection);
 }
@@ -47,7 +74,7 @@ void TMemoryLayer::ReverseInsert(TUpdate *update) NO_THROW {
   assert(this);
   for (TUpdate::TEntryCollection::TCursor csr(&update->EntryCollection); csr; ++csr) {
     ++Size;
-    csr->MemoryLayerMembership.ReverseInsert(&EntryCollection);
+    EntryCollection.Insert(&*csr);
   }
   update->MemoryLayerMembership.ReverseInsert(&UpdateCollection);
 }
@@ -73,7 +100,7 @@ TMemoryLayer::TMatchPresentWalker::TMatchPresentWalker(const TMemoryLayer *layer
     : Orly::Indy::TPresentWalker(Match),
       Layer(layer),
       Key(key),
-      Csr(Layer->GetEntryCollection()),
+      Csr(SeekEntry(Layer, Key, IsFullyBound(Key.GetKey()))),
       Valid(true),
       Cached(false),
       PassedMatch(false) {
@@ -163,7 +190,7 @@ TMemoryLayer::TRangePresentWalker::TRangePresentWalker(const TMemoryLayer *layer
       Layer(layer),
       From(from),
       To(to),
-      Csr(Layer->GetEntryCollection()),
+      Csr(SeekEntry(Layer, From, true)),
       Valid(true), Cached(false), PassedMatch(false) {
   assert(From.GetIndexId() == To.GetIndexId());
   Refresh();
@@ -307,5 +334,9 @@ void TMemoryLayer::ImporterAppendEntry(TUpdate::TEntry *entry) {
   assert(this);
   assert(entry);
   ++Size;
-  entry->MemoryLayerMembership.ReverseInsert(&EntryCollection);
+  EntryCollection.Append(entry);
+}
+
+bool TMemoryLayer::IsEntryBefore(const TUpdate::TEntry &lhs, const TUpdate::TEntry &rhs) {
+  return rhs.GetEntryKey() > lhs.GetEntryKey();
 }
\ No newline at end of file
@@ -22,6 +22,7 @@
 #include <inv_con/ordered_list.h>
 #include <orly/indy/manager_base.h>
 #include <orly/indy/update.h>
+#include <orly/indy/util/skip_list.h>
 #include <orly/sabot/all.h>
 
 namespace Orly {
@@ -45,9 +46,20 @@ namespace Orly {
       NO_COPY(TMemoryLayer);
       public:
 
-      /* TODO */
+      /* Orders entries by index id, then key, then descending sequence number. */
+      class TEntryOrder {
+        public:
+
+        /* True iff. lhs sorts strictly before rhs. */
+        inline bool operator()(const TUpdate::TEntry &lhs, const TUpdate::TEntry &rhs) const;
+
+      };  // TEntryOrder
+
+      /* Updates arrive in sequence number order, so appending to an ordered list is O(1).  Entries arrive in
+         arbitrary key order, so they live in a skip list which readers may walk without holding the repo's data
+         lock. */
       typedef InvCon::OrderedList::TCollection<TMemoryLayer, TUpdate, TSequenceNumber> TUpdateCollection;
-      typedef InvCon::OrderedList::TCollection<TMemoryLayer, TUpdate::TEntry, TUpdate::TEntry::TEntryKey> TEntryCollection;
+      typedef Util::TSkipList<TUpdate::TEntry, TEntryOrder> TEntryCollection;
 
       /* TODO */
       TMemoryLayer(L0::TManager *manager);
@@ -242,14 +254,19 @@ namespace Orly {
       /* TODO */
       void ImporterAppendUpdate(TUpdate *update);
 
-      /* TODO */
+      /* Append an entry to the end of the layer's order, without searching for its place.  The importer hands us its
+         entries already sorted by TEntryOrder. */
       void ImporterAppendEntry(TUpdate::TEntry *entry);
 
+      /* True iff. lhs sorts strictly before rhs: by index id, then key, then descending sequence number, so the newest
+         entry for a key comes first.  TEntryOrder defers to this, so the skip list and the importer share one order. */
+      static bool IsEntryBefore(const TUpdate::TEntry &lhs, const TUpdate::TEntry &rhs);
+
       /* TODO */
       mutable TUpdateCollection::TImpl UpdateCollection;
 
       /* TODO */
-      mutable TEntryCollection::TImpl EntryCollection;
+      mutable TEntryCollection EntryCollection;
 
       /* TODO */
       size_t Size;
@@ -260,6 +277,10 @@ namespace Orly {
 
     };  // TMemoryLayer
 
+    inline bool TMemoryLayer::TEntryOrder::operator()(const TUpdate::TEntry &lhs, const TUpdate::TEntry &rhs) const {
+      return TMemoryLayer::IsEntryBefore(lhs, rhs);
+    }
+
     /* TODO */
     inline TMemoryLayer::TEntryCollection *TMemoryLayer::GetEntryCollection() const {
       assert(this);
@@ -152,6 +152,55 @@ FIXTURE(Free) {
   }
 }
 
+FIXTURE(Seek) {
+  TMemoryLayer mem_layer(nullptr);
+  Base::TUuid lhs_idx(Base::TUuid::Twister), rhs_idx(Base::TUuid::Twister);
+  TSuprena arena;
+  TSequenceNumber seq_num = 0UL;
+  void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+  /* insert data; every key in both indices, and the even keys twice */ {
+    for (int64_t i = 0; i < 1000; ++i) {
+      Insert(mem_layer, ++seq_num, lhs_idx, i, i);
+      Insert(mem_layer, ++seq_num, rhs_idx, i, i);
+    }
+    for (int64_t i = 0; i < 1000; i += 2) {
+      Insert(mem_layer, ++seq_num, lhs_idx, -i, i);
+    }
+  }
+  /* point walks land on the newest entry for the key and stop after its last */ {
+    for (int64_t i = 0; i < 1000; i += 37) {
+      TIndexKey search_key(lhs_idx, TKey(make_tuple(i), &arena, state_alloc));
+      auto walker_ptr = mem_layer.NewPresentWalker(search_key);
+      auto &walker = *walker_ptr;
+      size_t count = 0UL;
+      TSequenceNumber prev = 0UL;
+      for (; walker; ++walker) {
+        const TPresentWalker::TItem &item = *walker;
+        EXPECT_EQ(TKey(item.Key, item.KeyArena), TKey(make_tuple(i), &arena, state_alloc));
+        if (count) {
+          EXPECT_LT(item.SequenceNumber, prev);
+        } else {
+          EXPECT_EQ(TKey(item.Op, item.OpArena), TKey((i % 2) ? i : -i, &arena, state_alloc));
+        }
+        prev = item.SequenceNumber;
+        ++count;
+      }
+      EXPECT_EQ(count, ((i % 2) ? 1UL : 2UL));
+    }
+  }
+  /* range walks start at 'from' and stay within the index */ {
+    TIndexKey from(rhs_idx, TKey(make_tuple(500L), &arena, state_alloc)), to(rhs_idx, TKey(make_tuple(509L), &arena, state_alloc));
+    auto walker_ptr = mem_layer.NewPresentWalker(from, to);
+    int64_t expected = 500L;
+    for (auto &walker = *walker_ptr; walker; ++walker) {
+      const TPresentWalker::TItem &item = *walker;
+      EXPECT_EQ(TKey(item.Key, item.KeyArena), TKey(make_tuple(expected), &arena, state_alloc));
+      ++expected;
+    }
+    EXPECT_EQ(expected, 510L);
+  }
+}
+
 #if 0
 FIXTURE(Range) {
   TMemoryLayer layer(nullptr);
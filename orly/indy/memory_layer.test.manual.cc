@@ -0,0 +1,181 @@
+/* <orly/indy/memory_layer.test.manual.cc>
+
+   Insert-rate benchmark for <orly/indy/memory_layer.h>.
+
+   Compares TMemoryLayer::Insert, which keeps its entries in a skip list, against the ordered linked list the memory
+   layer used to keep them in (ReverseInsert from the tail).  Keys arrive in random order, as they do from clients.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/memory_layer.h>
+
+#include <iostream>
+#include <vector>
+
+#include <base/timer.h>
+#include <inv_con/ordered_list.h>
+#include <orly/indy/update.h>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Base;
+using namespace Orly;
+using namespace Orly::Atom;
+using namespace Orly::Indy;
+
+Orly::Indy::Util::TPool L0::TManager::TRepo::TMapping::Pool(sizeof(TRepo::TMapping), "Repo Mapping");
+Orly::Indy::Util::TPool L0::TManager::TRepo::TMapping::TEntry::Pool(sizeof(TRepo::TMapping::TEntry), "Repo Mapping Entry");
+Orly::Indy::Util::TPool L0::TManager::TRepo::TDataLayer::Pool(sizeof(TMemoryLayer), "Data Layer");
+
+Orly::Indy::Util::TPool TUpdate::Pool(sizeof(TUpdate), "Update", 2000004UL);
+Orly::Indy::Util::TPool TUpdate::TEntry::Pool(sizeof(TUpdate::TEntry), "Entry", 2000004UL);
+
+/* The list is quadratic in random keys: seconds at 10k, most of an hour at 100k, days at 1M.  Raise this if you
+   have the time. */
+static const size_t MaxListSize = 10000UL;
+
+/* The old memory layer ordering, expressed over the public entry accessors. */
+class TListKey {
+  public:
+
+  TListKey(const TUpdate::TEntry *entry) : Entry(entry) {}
+
+  bool operator==(const TListKey &that) const {
+    return Entry->GetSequenceNumber() == that.Entry->GetSequenceNumber() && Entry->GetIndexKey() == that.Entry->GetIndexKey();
+  }
+
+  bool operator!=(const TListKey &that) const {
+    return !(*this == that);
+  }
+
+  bool operator<=(const TListKey &that) const {
+    return !(*this > that);
+  }
+
+  bool operator>(const TListKey &that) const {
+    TComparison comp = CompareOrdered(Entry->GetIndexKey().GetIndexId(), that.Entry->GetIndexKey().GetIndexId());
+    if (IsEq(comp)) {
+      comp = Entry->GetKey().Compare(that.Entry->GetKey());
+      return IsGt(comp) || (IsEq(comp) && Entry->GetSequenceNumber() < that.Entry->GetSequenceNumber());
+    }
+    return IsGt(comp);
+  }
+
+  private:
+
+  const TUpdate::TEntry *Entry;
+
+};  // TListKey
+
+class TListLayer;
+
+/* A stand-in for the membership the entries used to carry. */
+class TListEntry {
+  NO_COPY(TListEntry);
+  public:
+
+  typedef InvCon::OrderedList::TMembership<TListEntry, TListLayer, TListKey> TLayerMembership;
+
+  TListEntry(const TUpdate::TEntry *entry) : LayerMembership(this, TListKey(entry)) {}
+
+  TLayerMembership::TImpl LayerMembership;
+
+};  // TListEntry
+
+class TListLayer {
+  NO_COPY(TListLayer);
+  public:
+
+  typedef InvCon::OrderedList::TCollection<TListLayer, TListEntry, TListKey> TEntryCollection;
+
+  TListLayer() : EntryCollection(this) {}
+
+  ~TListLayer() {
+    EntryCollection.DeleteEachMember();
+  }
+
+  void Insert(const TUpdate *update) {
+    for (TUpdate::TEntryCollection::TCursor csr(update->GetEntryCollection()); csr; ++csr) {
+      (new TListEntry(&*csr))->LayerMembership.ReverseInsert(&EntryCollection);
+    }
+  }
+
+  private:
+
+  mutable TEntryCollection::TImpl EntryCollection;
+
+};  // TListLayer
+
+/* Make num_updates single-entry updates with random keys. */
+static void MakeUpdates(size_t num_updates, const TUuid &idx_id, vector<TUpdate *> &out) {
+  void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+  out.reserve(num_updates);
+  for (size_t i = 0; i < num_updates; ++i) {
+    TSuprena arena;
+    auto update = TUpdate::NewUpdate(TUpdate::TOpByKey{
+        { TIndexKey(idx_id, TKey(make_tuple(static_cast<int64_t>(rand()), static_cast<int64_t>(i)), &arena, state_alloc)),
+          TKey(static_cast<int64_t>(i), &arena, state_alloc) }
+        }, TKey(&arena), TKey(TUuid(TUuid::Best), &arena, state_alloc));
+    TUpdate *copy = TUpdate::CopyUpdate(update.get(), state_alloc);
+    copy->SetSequenceNumber(i + 1UL);
+    out.push_back(copy);
+  }
+}
+
+static void RunBench(size_t num_updates) {
+  TUuid idx_id(TUuid::Twister);
+  vector<TUpdate *> update_vec;
+  MakeUpdates(num_updates, idx_id, update_vec);
+  if (num_updates <= MaxListSize) {
+    TTimer timer;
+    /* list scope */ {
+      TListLayer list_layer;
+      timer.Start();
+      for (auto update : update_vec) {
+        list_layer.Insert(update);
+      }
+      timer.Stop();
+    }
+    cout << "list      [" << num_updates << "] inserts took " << timer.Total() << "s ["
+         << (num_updates / timer.Total()) << " / s]" << endl;
+  } else {
+    cout << "list      [" << num_updates << "] skipped" << endl;
+  }
+  TTimer timer;
+  /* skip list scope; the memory layer owns the updates */ {
+    TMemoryLayer mem_layer(nullptr);
+    timer.Start();
+    for (auto update : update_vec) {
+      mem_layer.Insert(update);
+    }
+    timer.Stop();
+    EXPECT_EQ(mem_layer.GetSize(), num_updates);
+  }
+  cout << "skip list [" << num_updates << "] inserts took " << timer.Total() << "s ["
+       << (num_updates / timer.Total()) << " / s]" << endl;
+}
+
+FIXTURE(InsertRate10k) {
+  RunBench(10000UL);
+}
+
+FIXTURE(InsertRate100k) {
+  RunBench(100000UL);
+}
+
+FIXTURE(InsertRate1M) {
+  RunBench(1000000UL);
+}
@@ -26,6 +26,7 @@
 #include <orly/atom/kit2.h>
 #include <orly/indy/fiber/fiber.h>
 #include <orly/indy/sequence_number.h>
+#include <orly/indy/util/loser_tree.h>
 
 namespace Orly {
 
@@ -58,6 +59,21 @@ namespace Orly {
           return Atom::IsLt(comp) || (Atom::IsEq(comp) && SequenceNumber >= that.SequenceNumber);
         }
 
+        /* Lets a Util::TLoserTree of items order them by the first elements of their keys, where those differ. */
+        class TPrefixer {
+          NO_CONSTRUCTION(TPrefixer);
+          public:
+
+          /* See Util::TKeyPrefix. */
+          using TPrefix = Util::TKeyPrefix;
+
+          /* See Util::TKeyPrefix. */
+          static bool TryGet(const TItem &item, TPrefix &out) {
+            return Util::TKeyPrefix::TryGet(item.Key, item.KeyArena, out);
+          }
+
+        };  // TPrefixer
+
         /* The sequence number of the update which contained the key-op pair. */
         TSequenceNumber SequenceNumber;
 
@@ -23,6 +23,7 @@
 
 #include <base/debug_log.h>
 #include <orly/indy/disk/util/hash_util.h>
+#include <orly/indy/row_cache.h>
 
 using namespace std;
 using namespace Base;
@@ -97,6 +98,7 @@ void TRepo::AddImportLayer(TMemoryLayer *mem_layer, Base::TEventSemaphore &sem,
       throw;
     }
   }
+  ClearRowCache();
   if (ParentRepo && !InTetris) {
     Manager->GetTetrisManager()->Join((*ParentRepo)->GetId(), GetId());
     InTetris = true;
@@ -133,6 +135,7 @@ void TRepo::AddFileToRepo(size_t gen_id, TSequenceNumber saved_low_seq, TSequenc
       throw;
     }
   }
+  ClearRowCache();
   if (total_layers >= 3) {
     EnqueueMergeDisk();
   }
@@ -172,6 +175,79 @@ unique_ptr<Indy::TPresentWalker> TRepo::NewPresentWalker(const std::unique_ptr<T
   return make_unique<TPresentWalker>(view, key, ignore_tombstone);
 }
 
+bool TRepo::FindPresent(const std::unique_ptr<TView> &view,
+                        const TIndexKey &key,
+                        unique_ptr<Indy::TPresentWalker> &walker,
+                        Indy::TPresentWalker::TItem &item) {
+  assert(this);
+  assert(view);
+  assert(&walker);
+  assert(&item);
+  if (!view->GetLower() || !view->GetUpper()) {
+    return false;
+  }
+  const TSequenceNumber lower = *view->GetLower(), upper = *view->GetUpper();
+  bool found = false;
+  /* Only root repos cache.  Private povs are short-lived and mostly written, not read. */
+  TRowCache *row_cache = ParentRepo ? nullptr : Manager->GetRowCache();
+  uint64_t gen = 0UL;
+  if (row_cache && row_cache->Find(GetId(), key, lower, upper, walker, item, found, gen)) {
+    return found;
+  }
+  /* Probe a layer, keeping its walker if it has something newer than what we've got. */
+  auto probe = [&](const TDataLayer *layer) {
+    auto layer_walker = layer->NewPresentWalker(key);
+    /* A layer gives us its ops on the key newest first, so the first one within our view is the one we want. */
+    for (; *layer_walker && (**layer_walker).SequenceNumber > upper; ++*layer_walker);
+    if (*layer_walker && (**layer_walker).SequenceNumber >= lower && (!found || (**layer_walker).SequenceNumber > item.SequenceNumber)) {
+      found = true;
+      item = **layer_walker;
+      walker = move(layer_walker);
+    }
+  };
+  assert(view->GetCurMem());
+  probe(view->GetCurMem());
+  /* The mapping orders the disk layers by their lowest sequence numbers, so walking it backward goes newest first.
+     A disk layer's range never changes, so we can check it before we bother opening the layer.  (Not so the memory
+     layer, which takes new updates as we go, so we just always probe it.) */
+  for (TMapping::TEntryCollection::TCursor mapping_csr(view->GetMapping()->GetEntryCollection(), InvCon::Rev); mapping_csr; ++mapping_csr) {
+    const TDataLayer *layer = mapping_csr->GetLayer();
+    if (layer->GetLowestSeq() <= upper && layer->GetHighestSeq() >= lower &&
+        (!found || layer->GetHighestSeq() > item.SequenceNumber)) {
+      probe(layer);
+    }
+  }
+  /* What we found is only worth caching if our view is still the latest.  Anything which lands after this check will
+     invalidate the key, either before we fill, failing the fill, or after, dropping the row. */
+  if (row_cache && IsViewCurrent(view)) {
+    row_cache->Fill(GetId(), key, lower, gen, found ? &item : nullptr);
+  }
+  return found;
+}
+
+bool TRepo::IsViewCurrent(const std::unique_ptr<TView> &view) {
+  assert(this);
+  assert(view);
+  /* acquire Data lock */ {
+    std::lock_guard<std::mutex> lock(DataLock);
+    if (view->GetNextId() != NextUpdate || view->GetCurMem() != CurMemoryLayer) {
+      return false;
+    }
+  }  // release Data lock
+  /* acquire Mapping lock */ {
+    std::lock_guard<std::mutex> lock(MappingLock);
+    return view->GetMapping() == MappingCollection.TryGetLastMember();
+  }  // release Mapping lock
+}
+
+void TRepo::ClearRowCache() {
+  assert(this);
+  TRowCache *row_cache = ParentRepo ? nullptr : Manager->GetRowCache();
+  if (row_cache) {
+    row_cache->Clear(GetId());
+  }
+}
+
 unique_ptr<Indy::TUpdateWalker> TRepo::NewUpdateWalker(const std::unique_ptr<TView> &view,
                                                        TSequenceNumber from,
                                                        const Base::TOpt<TSequenceNumber> &to) {
@@ -242,7 +318,8 @@ TRepo::TRepo(L0::TManager *manager,
       ParentRepo(parent_repo),
       NextUpdate(1U),
       ReleasedUpTo(0U),
-      InTetris(false) {
+      InTetris(false),
+      TetrisWakeArmed(true) {
   try {
     /* acquire Mapping lock */ {
       std::lock_guard<std::mutex> lock(MappingLock);
@@ -269,7 +346,8 @@ TRepo::TRepo(L0::TManager *manager,
       HighestSeqNum(highest),
       NextUpdate(next_update),
       ReleasedUpTo(lowest ? *lowest : 0UL),
-      InTetris(false) {
+      InTetris(false),
+      TetrisWakeArmed(true) {
   try {
     /* acquire Mapping lock */ {
       std::lock_guard<std::mutex> lock(MappingLock);
@@ -295,7 +373,7 @@ TRepo::~TRepo() {
 Base::TOpt<TSequenceNumber> TRepo::AppendUpdate(TUpdate *update, TSequenceNumber &next_update) NO_THROW {
   assert(this);
   Base::TOpt<TSequenceNumber> new_seq;
-  bool add_to_tetris = false;
+  bool add_to_tetris = false, wake_tetris = false;
   /* acquire Data lock */ {
     std::lock_guard<std::mutex> lock(DataLock);
     HighestSeqNum = NextUpdate;
@@ -313,6 +391,11 @@ Base::TOpt<TSequenceNumber> TRepo::AppendUpdate(TUpdate *update, TSequenceNumber
     assert(CurMemoryLayer);
     bool was_empty = CurMemoryLayer->IsEmpty();
     CurMemoryLayer->Insert(update);
+    if (!ParentRepo && Manager->GetRowCache()) {
+      for (TUpdate::TEntryCollection::TCursor entry_csr(update->GetEntryCollection()); entry_csr; ++entry_csr) {
+        Manager->GetRowCache()->Invalidate(GetId(), entry_csr->GetIndexKey());
+      }
+    }
     if (was_empty) {
       EnqueueMergeMem();
     }
@@ -321,8 +404,18 @@ Base::TOpt<TSequenceNumber> TRepo::AppendUpdate(TUpdate *update, TSequenceNumber
       assert(!InTetris);
       Manager->GetTetrisManager()->Join((*ParentRepo)->GetId(), GetId());
       InTetris = true;
+    } else {
+      wake_tetris = InTetris;
     }
   }  // release Data lock
+  if (wake_tetris) {
+    /* We were already joined to our parent's player, which may be asleep waiting for something to promote.  If it
+       hasn't looked at its children since the last update which woke it, it will see this one too. */
+    L0::TManager::TPtr<TRepo> parent_repo = *ParentRepo;
+    if (parent_repo->TakeTetrisWake()) {
+      Manager->GetTetrisManager()->Wake(parent_repo->GetId());
+    }
+  }
   return new_seq;
 }
 
@@ -698,7 +791,7 @@ TRepo::TPresentWalker::TPresentWalker(const unique_ptr<TView> &view,
       View(view),
       Lower(View->GetLower() ? *View->GetLower() : 0UL),
       Upper(View->GetUpper() ? *View->GetUpper() : 0UL),
-      MinHeap(View->GetNumEntries() + 1UL),
+      LoserTree(View->GetNumEntries() + 1UL),
       Valid(false),
       IgnoreTombstone(ignore_tombstone) {
   if (View->GetLower() && View->GetUpper()) {
@@ -707,16 +800,16 @@ TRepo::TPresentWalker::TPresentWalker(const unique_ptr<TView> &view,
       WalkerVec.emplace_back(mapping_csr->GetLayer()->NewPresentWalker(From, To));
       Indy::TPresentWalker &walker = *WalkerVec.back();
       if (walker) {
-        MinHeap.Insert(*walker, pos);
+        LoserTree.Insert(*walker, pos);
       }
     }
     assert(View->GetCurMem());
     WalkerVec.emplace_back(View->GetCurMem()->NewPresentWalker(From, To));
     Indy::TPresentWalker &mem_walker = *WalkerVec.back();
     if (mem_walker) {
-      MinHeap.Insert(*mem_walker, pos);
+      LoserTree.Insert(*mem_walker, pos);
     }
-    Valid = static_cast<bool>(MinHeap);
+    Valid = static_cast<bool>(LoserTree);
     Init();
   }
 }
@@ -729,7 +822,7 @@ TRepo::TPresentWalker::TPresentWalker(const unique_ptr<TView> &view,
       View(view),
       Lower(View->GetLower() ? *View->GetLower() : 0UL),
       Upper(View->GetUpper() ? *View->GetUpper() : 0UL),
-      MinHeap(View->GetNumEntries() + 1UL),
+      LoserTree(View->GetNumEntries() + 1UL),
       Valid(false),
       IgnoreTombstone(ignore_tombstone) {
   if (View->GetLower() && View->GetUpper()) {
@@ -744,7 +837,7 @@ TRepo::TPresentWalker::TPresentWalker(const unique_ptr<TView> &view,
     for (auto &walker_ptr : WalkerVec) {
       Indy::TPresentWalker &walker = *walker_ptr;
       if (walker) {
-        MinHeap.Insert(*walker, pos);
+        LoserTree.Insert(*walker, pos);
       }
       ++pos;
     }
@@ -752,9 +845,9 @@ TRepo::TPresentWalker::TPresentWalker(const unique_ptr<TView> &view,
     WalkerVec.emplace_back(View->GetCurMem()->NewPresentWalker(From));
     Indy::TPresentWalker &mem_walker = *WalkerVec.back();
     if (mem_walker) {
-      MinHeap.Insert(*mem_walker, pos);
+      LoserTree.Insert(*mem_walker, pos);
     }
-    Valid = static_cast<bool>(MinHeap);
+    Valid = static_cast<bool>(LoserTree);
     Init();
   }
 }
@@ -1128,35 +1221,30 @@ void TSafeRepo::StepMergeDisk(size_t block_slots_available) {
         size_t num_keys = 0U;
         TSequenceNumber lowest_seq = numeric_limits<uint64_t>::max(), highest_seq = 0UL;
         try {
-          //std::map<size_t, std::vector<TDiskLayer *>> gen_to_gen_id_map;
           /* acquire Merge lock */ {
             std::lock_guard<std::mutex> lock(MergeLock);
+            /* let the compaction policy choose a run of adjacent disk layers, none of them already being merged */
+            std::vector<TDataLayer *> layer_vec;
+            std::vector<TCompactionPolicy::TLayer> policy_layer_vec;
             for (TMapping::TEntryCollection::TCursor csr(mapping->GetEntryCollection()); csr; ++csr) {
-              TDataLayer *lhs_layer = csr->GetLayer();
-              TDataLayer *rhs_layer = csr->TryGetNextMember() ? csr->TryGetNextMember()->GetLayer() : nullptr;
-              /* if i'm a disk layer, so is my neighbor on the right, neither of us are marked as taken, and i'm in the same or lower gen set than my neigbor */
-              if ((lhs_layer && rhs_layer)  // i have a neighbor
-                  && (lhs_layer->GetKind() == TDataLayer::TKind::Disk)  // I'm a disk layer
-                  && (rhs_layer->GetKind() == TDataLayer::TKind::Disk)  // my neighbor is a disk layer
-                  && (!lhs_layer->GetMarkedTaken())  // I'm not marked taken
-                  && (!rhs_layer->GetMarkedTaken())  // my neighbor is not marked taken
-                  && (Disk::Util::SuggestGeneration(lhs_layer->GetSize()) <= Disk::Util::SuggestGeneration(rhs_layer->GetSize()))  // in in the same or lower gen set than my neighbor
-                  ) {
-                lowest_seq = std::min(lowest_seq, lhs_layer->GetLowestSeq());
-                highest_seq = std::max(highest_seq, lhs_layer->GetHighestSeq());
-                num_keys += lhs_layer->GetSize();
-                gen_layer_vec.push_back(reinterpret_cast<TDiskLayer *>(lhs_layer));
-                gen_id_vec.push_back(reinterpret_cast<TDiskLayer *>(lhs_layer)->GetGenId());
-                lhs_layer->MarkTaken();
-                lowest_seq = std::min(lowest_seq, rhs_layer->GetLowestSeq());
-                highest_seq = std::max(highest_seq, rhs_layer->GetHighestSeq());
-                num_keys += rhs_layer->GetSize();
-                gen_layer_vec.push_back(reinterpret_cast<TDiskLayer *>(rhs_layer));
-                gen_id_vec.push_back(reinterpret_cast<TDiskLayer *>(rhs_layer)->GetGenId());
-                rhs_layer->MarkTaken();
-                EnqueueMergeDisk();
-                break;
+              TDataLayer *layer = csr->GetLayer();
+              layer_vec.push_back(layer);
+              policy_layer_vec.emplace_back(layer->GetSize(), layer->GetKind() == TDataLayer::TKind::Disk && !layer->GetMarkedTaken());
+            }
+            size_t begin, end;
+            if (Manager->GetCompactionPolicy()->TryChoose(policy_layer_vec, begin, end)) {
+              assert(begin < end && end <= layer_vec.size());
+              for (size_t i = begin; i < end; ++i) {
+                TDataLayer *layer = layer_vec[i];
+                assert(policy_layer_vec[i].IsMergeable);
+                lowest_seq = std::min(lowest_seq, layer->GetLowestSeq());
+                highest_seq = std::max(highest_seq, layer->GetHighestSeq());
+                num_keys += layer->GetSize();
+                gen_layer_vec.push_back(reinterpret_cast<TDiskLayer *>(layer));
+                gen_id_vec.push_back(reinterpret_cast<TDiskLayer *>(layer)->GetGenId());
+                layer->MarkTaken();
               }
+              EnqueueMergeDisk();
             }
           }  // release Merge lock
           if (gen_id_vec.size() > 0) {
@@ -1328,7 +1416,7 @@ size_t TSafeRepo::MergeFiles(const std::vector<size_t> &gen_id_vec,
   size_t gen_id = GetNextGenId();
   bool my_can_tail = can_tail && !static_cast<bool>(GetParentRepo()) && IsTailingAllowed();
   bool my_can_tail_tombstone = my_can_tail && can_tail_tombstone && (gen_id_vec.size() == 1);
-  TMergeDataFile merge_data_file(Manager->GetEngine(), storage_speed, GetId(), gen_id_vec, GetId(), gen_id, release_up_to, Low, max_block_cache_read_slots_allowed, temp_file_consol_thresh, my_can_tail, my_can_tail_tombstone);
+  TMergeDataFile merge_data_file(Manager->GetEngine(), storage_speed, GetId(), gen_id_vec, GetId(), gen_id, release_up_to, Low, max_block_cache_read_slots_allowed, temp_file_consol_thresh, my_can_tail, my_can_tail_tombstone, Manager->GetMergeDiskRunners());
   out_num_keys = merge_data_file.GetNumKeys();
   out_saved_low_seq = merge_data_file.GetLowestSequence();
   out_saved_high_seq = merge_data_file.GetHighestSequence();
@@ -32,7 +32,7 @@
 #include <orly/indy/update.h>
 #include <orly/indy/update_walker.h>
 #include <orly/indy/util/merge_sorter.h>
-#include <orly/indy/util/min_heap.h>
+#include <orly/indy/util/loser_tree.h>
 
 namespace Orly {
 
@@ -140,6 +140,15 @@ namespace Orly {
       /* TODO */
       virtual inline const TParentRepo &GetParentRepo() const;
 
+      /* The tetris player for this repo, as a parent, calls this before it checks whether any of its children has
+         anything to promote.  The next child update after that will wake the player. */
+      inline void ArmTetrisWake();
+
+      /* A child repo calls this on its parent after appending an update.  Returns true iff the parent's tetris player
+         has armed itself since the last time this returned true, in which case the caller must wake the player.
+         This spares the tetris manager's lock on all but the first update after each round. */
+      inline bool TakeTetrisWake();
+
       /* TODO */
       void AddImportLayer(TMemoryLayer *mem_layer, Base::TEventSemaphore &sem, Disk::Util::TVolume::TDesc::TStorageSpeed storage_speed);
 
@@ -171,6 +180,17 @@ namespace Orly {
                                                                      const TIndexKey &key,
                                                                      bool ignore_tombstone = false);
 
+      /* Find the most recent op on the given key which is visible in the view, tombstones included, and return true, or
+         return false if this repo has nothing on the key.  The item stays good for as long as the walker does.
+         Rather than merge a walker per layer, as a present walker does, we probe the memory layer and then the disk
+         layers, newest first, and skip any layer which couldn't hold anything newer than what we've already found.  A
+         hit usually costs one probe.  A root repo first asks the manager's row cache, if it has one, and fills it on a
+         miss. */
+      bool FindPresent(const std::unique_ptr<TView> &view,
+                       const TIndexKey &key,
+                       std::unique_ptr<Indy::TPresentWalker> &walker,
+                       Indy::TPresentWalker::TItem &item);
+
       /* TODO */
       virtual std::unique_ptr<Indy::TUpdateWalker> NewUpdateWalker(const std::unique_ptr<TView> &view,
                                                                    TSequenceNumber from,
@@ -354,7 +374,7 @@ namespace Orly {
         std::vector<TRunnablePrep> PrepVec;
 
         /* TODO */
-        Util::TMinHeap<TItem, size_t> MinHeap;
+        Util::TLoserTree<TItem, size_t, std::less<TItem>, TItem::TPrefixer> LoserTree;
 
         /* TODO */
         bool Valid;
@@ -421,6 +441,12 @@ namespace Orly {
 
       };  // TUpdateWalker
 
+      /* True iff. nothing has changed in this repo since the given view was taken. */
+      bool IsViewCurrent(const std::unique_ptr<TView> &view);
+
+      /* If we're a root repo and the manager is caching point reads, forget the ones we've cached. */
+      void ClearRowCache();
+
       /* TODO */
       TParentRepo ParentRepo;
 
@@ -451,6 +477,9 @@ namespace Orly {
       /* TODO */
       bool InTetris;
 
+      /* See ArmTetrisWake() and TakeTetrisWake(). */
+      std::atomic<bool> TetrisWakeArmed;
+
       /* TODO */
       friend class L1::TTransaction;
 
@@ -668,6 +697,16 @@ namespace Orly {
       return ParentRepo;
     }
 
+    inline void TRepo::ArmTetrisWake() {
+      assert(this);
+      TetrisWakeArmed = true;
+    }
+
+    inline bool TRepo::TakeTetrisWake() {
+      assert(this);
+      return TetrisWakeArmed.exchange(false);
+    }
+
     inline TRepo::TPresentWalker::operator bool() const {
       assert(this);
       return Valid;
@@ -682,7 +721,7 @@ namespace Orly {
     inline TRepo::TPresentWalker &TRepo::TPresentWalker::operator++() {
       assert(this);
       assert(Valid);
-      Valid = static_cast<bool>(MinHeap);
+      Valid = static_cast<bool>(LoserTree);
       Refresh();
       return *this;
     }
@@ -692,7 +731,7 @@ namespace Orly {
       bool done = false;
       while (Valid) {
         size_t pos;
-        const Indy::TPresentWalker::TItem &cur_item = MinHeap.Pop(pos);
+        const Indy::TPresentWalker::TItem &cur_item = LoserTree.Pop(pos);
         Indy::TPresentWalker &walker = *WalkerVec[pos];
         assert(cur_item.Key.IsTuple());
         assert((*walker).KeyArena == cur_item.KeyArena);
@@ -705,12 +744,12 @@ namespace Orly {
         }
         ++walker;
         if (walker) {
-          MinHeap.Insert(*walker, pos);
+          LoserTree.Insert(*walker, pos);
         }
         if (done) {
           break;
         } else {
-          Valid = static_cast<bool>(MinHeap);
+          Valid = static_cast<bool>(LoserTree);
         }
       }
     }
@@ -720,7 +759,7 @@ namespace Orly {
       bool done = false;
       while (Valid) {
         size_t pos;
-        const Indy::TPresentWalker::TItem &cur_item = MinHeap.Pop(pos);
+        const Indy::TPresentWalker::TItem &cur_item = LoserTree.Pop(pos);
         Indy::TPresentWalker &walker = *WalkerVec[pos];
         assert(cur_item.Key.IsTuple());
         assert((*walker).KeyArena == cur_item.KeyArena);
@@ -733,12 +772,12 @@ namespace Orly {
         }
         ++walker;
         if (walker) {
-          MinHeap.Insert(*walker, pos);
+          LoserTree.Insert(*walker, pos);
         }
         if (done) {
           break;
         } else {
-          Valid = static_cast<bool>(MinHeap);
+          Valid = static_cast<bool>(LoserTree);
         }
       }
     }
@@ -0,0 +1,182 @@
+/* <orly/indy/row_cache.cc>
+
+   Implements <orly/indy/row_cache.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/row_cache.h>
+
+#include <algorithm>
+
+using namespace std;
+using namespace Base;
+using namespace Orly;
+using namespace Orly::Indy;
+
+std::atomic<size_t> TRowCache::HitCount(0UL);
+
+std::atomic<size_t> TRowCache::MissCount(0UL);
+
+std::atomic<size_t> TRowCache::InvalidationCount(0UL);
+
+TRowCache::TRowCache(size_t max_row_count)
+    : MaxRowCountPerShard(max(max_row_count / ShardCount, 1UL)) {}
+
+size_t TRowCache::GetRowCount() const {
+  assert(this);
+  size_t count = 0UL;
+  for (const auto &shard : Shards) {
+    lock_guard<mutex> lock(shard.Mutex);
+    count += shard.Rows.size();
+  }
+  return count;
+}
+
+bool TRowCache::Find(const TUuid &repo_id,
+                     const TIndexKey &key,
+                     TSequenceNumber lower,
+                     TSequenceNumber upper,
+                     unique_ptr<TPresentWalker> &walker,
+                     TPresentWalker::TItem &item,
+                     bool &found,
+                     uint64_t &gen) {
+  assert(this);
+  assert(&walker);
+  assert(&item);
+  assert(&found);
+  assert(&gen);
+  const size_t hash = GetHash(repo_id, key);
+  TShard &shard = GetShard(hash);
+  shared_ptr<TRow> row;
+  /* acquire shard lock */ {
+    lock_guard<mutex> lock(shard.Mutex);
+    gen = shard.Generation;
+    auto iter = shard.Seek(hash, repo_id, key);
+    if (iter != shard.Rows.end()) {
+      /* The row holds the newest op on the key, so it answers for any view which can see that op.  A view which can't
+         is either older than the op or reaches back before the updates the row was filled from, and either way it may
+         see something else. */
+      const TRow &candidate = **iter;
+      if (candidate.Found ? (candidate.Item.SequenceNumber >= lower && candidate.Item.SequenceNumber <= upper)
+                          : lower >= candidate.Lower) {
+        row = *iter;
+        shard.Rows.splice(shard.Rows.begin(), shard.Rows, iter);
+      }
+    }
+  }  // release shard lock
+  if (!row) {
+    ++MissCount;
+    return false;
+  }
+  ++HitCount;
+  found = row->Found;
+  if (found) {
+    item = row->Item;
+    walker = make_unique<TWalker>(row);
+  }
+  return true;
+}
+
+void TRowCache::Fill(const TUuid &repo_id,
+                     const TIndexKey &key,
+                     TSequenceNumber lower,
+                     uint64_t gen,
+                     const TPresentWalker::TItem *item) {
+  assert(this);
+  const size_t hash = GetHash(repo_id, key);
+  TShard &shard = GetShard(hash);
+  /* Do the copying before we take the lock. */
+  auto row = make_shared<TRow>(repo_id, key, lower, item);
+  lock_guard<mutex> lock(shard.Mutex);
+  if (shard.Generation != gen) {
+    return;
+  }
+  auto iter = shard.Seek(hash, repo_id, key);
+  if (iter != shard.Rows.end()) {
+    /* Someone else filled it first, from a view no older than ours, since the generation hasn't moved. */
+    return;
+  }
+  shard.Rows.push_front(row);
+  shard.RowsByHash.insert(make_pair(hash, shard.Rows.begin()));
+  if (shard.Rows.size() > MaxRowCountPerShard) {
+    const TRow &victim = *shard.Rows.back();
+    shard.Erase(GetHash(victim.RepoId, victim.Key), prev(shard.Rows.end()));
+  }
+}
+
+void TRowCache::Invalidate(const TUuid &repo_id, const TIndexKey &key) {
+  assert(this);
+  const size_t hash = GetHash(repo_id, key);
+  TShard &shard = GetShard(hash);
+  lock_guard<mutex> lock(shard.Mutex);
+  ++shard.Generation;
+  auto iter = shard.Seek(hash, repo_id, key);
+  if (iter != shard.Rows.end()) {
+    shard.Erase(hash, iter);
+    ++InvalidationCount;
+  }
+}
+
+void TRowCache::Clear(const TUuid &repo_id) {
+  assert(this);
+  for (auto &shard : Shards) {
+    lock_guard<mutex> lock(shard.Mutex);
+    ++shard.Generation;
+    for (auto iter = shard.Rows.begin(); iter != shard.Rows.end();) {
+      const TRow &row = **iter;
+      auto next = std::next(iter);
+      if (row.RepoId == repo_id) {
+        shard.Erase(GetHash(row.RepoId, row.Key), iter);
+      }
+      iter = next;
+    }
+  }
+}
+
+TRowCache::TRow::TRow(const TUuid &repo_id, const TIndexKey &key, TSequenceNumber lower, const TPresentWalker::TItem *item)
+    : RepoId(repo_id), Lower(lower), Found(item != nullptr) {
+  void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+  Key = TIndexKey(key.GetIndexId(), TKey(&Arena, state_alloc, key.GetKey()));
+  if (item) {
+    Item.SequenceNumber = item->SequenceNumber;
+    Item.Key = Key.GetKey().GetCore();
+    Item.KeyArena = &Arena;
+    Item.Op = Atom::TCore(&Arena, state_alloc, item->OpArena, item->Op);
+    Item.OpArena = &Arena;
+  }
+}
+
+TRowCache::TRowList::iterator TRowCache::TShard::Seek(size_t hash, const TUuid &repo_id, const TIndexKey &key) {
+  assert(this);
+  auto range = RowsByHash.equal_range(hash);
+  for (auto iter = range.first; iter != range.second; ++iter) {
+    if ((*iter->second)->IsFor(repo_id, key)) {
+      return iter->second;
+    }
+  }
+  return Rows.end();
+}
+
+void TRowCache::TShard::Erase(size_t hash, TRowList::iterator row_iter) {
+  assert(this);
+  auto range = RowsByHash.equal_range(hash);
+  for (auto iter = range.first; iter != range.second; ++iter) {
+    if (iter->second == row_iter) {
+      RowsByHash.erase(iter);
+      break;
+    }
+  }
+  Rows.erase(row_iter);
+}
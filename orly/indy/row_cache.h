@@ -0,0 +1,230 @@
+/* <orly/indy/row_cache.h>
+
+   A cache of resolved point reads, so a hot key in the global pov can be answered without opening a walker.
+
+   A row is keyed by (repo id, index key) and holds the key's most recent op as of when it was filled, tombstones
+   included, or a note that the repo had nothing on the key at all.  The rows are spread over shards, each with its
+   own lock and its own least-recently-used list, and the cache as a whole holds at most a fixed number of rows.
+
+   A repo invalidates a key as soon as an update touching it lands in the repo's memory layer.  That covers tetris
+   promotions, too, since those land in the parent repo the same way any other update does.  Invalidating a key also
+   bumps its shard's generation, and a repo which missed may only fill the row if the generation hasn't moved since it
+   missed.  That keeps a reader which raced with a writer from caching what it found before the write landed.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <base/class_traits.h>
+#include <base/uuid.h>
+#include <orly/atom/suprena.h>
+#include <orly/indy/key.h>
+#include <orly/indy/present_walker.h>
+#include <orly/indy/sequence_number.h>
+
+namespace Orly {
+
+  namespace Indy {
+
+    /* A sharded, size-bounded cache of resolved point reads. */
+    class TRowCache {
+      NO_COPY(TRowCache);
+      public:
+
+      /* The number of shards we spread the rows over. */
+      static const size_t ShardCount = 16UL;
+
+      /* Hold at most the given number of rows. */
+      explicit TRowCache(size_t max_row_count);
+
+      /* The number of rows we're holding right now. */
+      size_t GetRowCount() const;
+
+      /* Look up the row for the given key, as seen by a view bounded by the given sequence numbers.
+         On a hit, return true and set found to whether the repo has an op on the key.  If it has, the item describes
+         the op and stays good for as long as the walker does.
+         On a miss, return false and set gen to the generation the caller must pass to Fill(). */
+      bool Find(const Base::TUuid &repo_id,
+                const TIndexKey &key,
+                TSequenceNumber lower,
+                TSequenceNumber upper,
+                std::unique_ptr<TPresentWalker> &walker,
+                TPresentWalker::TItem &item,
+                bool &found,
+                uint64_t &gen);
+
+      /* Cache what a repo found on the given key after Find() missed; the item is null if it found nothing.  We drop
+         the row on the floor if the key's shard has been invalidated since the miss.  The lower bound is that of the
+         view the repo found the item in; we won't answer for views which reach back further than that. */
+      void Fill(const Base::TUuid &repo_id,
+                const TIndexKey &key,
+                TSequenceNumber lower,
+                uint64_t gen,
+                const TPresentWalker::TItem *item);
+
+      /* Forget the row for the given key, if we have one, and fail any fill in flight in its shard. */
+      void Invalidate(const Base::TUuid &repo_id, const TIndexKey &key);
+
+      /* Forget every row in the given repo and fail every fill in flight.  Used when a repo's contents change other than
+         by updates, as when we import into it. */
+      void Clear(const Base::TUuid &repo_id);
+
+      /* The number of lookups we've answered, across all caches. */
+      static std::atomic<size_t> HitCount;
+
+      /* The number of lookups we couldn't answer, across all caches. */
+      static std::atomic<size_t> MissCount;
+
+      /* The number of rows we've dropped because their keys were written to, across all caches. */
+      static std::atomic<size_t> InvalidationCount;
+
+      private:
+
+      /* A cached answer. */
+      class TRow {
+        NO_COPY(TRow);
+        public:
+
+        /* Copy the key and op into our own arena. */
+        TRow(const Base::TUuid &repo_id, const TIndexKey &key, TSequenceNumber lower, const TPresentWalker::TItem *item);
+
+        /* True iff. we are the row for the given key. */
+        bool IsFor(const Base::TUuid &repo_id, const TIndexKey &key) const {
+          assert(this);
+          return RepoId == repo_id && Key == key;
+        }
+
+        /* Holds our copies of the key and the op. */
+        Atom::TSuprena Arena;
+
+        /* The repo we came from. */
+        Base::TUuid RepoId;
+
+        /* Our copy of the key. */
+        TIndexKey Key;
+
+        /* The lower bound of the view we were filled from. */
+        TSequenceNumber Lower;
+
+        /* True iff. the repo had an op on the key. */
+        bool Found;
+
+        /* Our copy of the op, if we found one; otherwise, a default item. */
+        TPresentWalker::TItem Item;
+
+      };  // TRow
+
+      /* Least recently used rows go at the back. */
+      using TRowList = std::list<std::shared_ptr<TRow>>;
+
+      /* A lock, the rows it guards, and a generation counter. */
+      class TShard {
+        NO_COPY(TShard);
+        public:
+
+        /* Empty. */
+        TShard() : Generation(0UL) {}
+
+        /* Find the row for the given key, or return the end of the list. */
+        TRowList::iterator Seek(size_t hash, const Base::TUuid &repo_id, const TIndexKey &key);
+
+        /* Remove the row at the given position. */
+        void Erase(size_t hash, TRowList::iterator iter);
+
+        /* Covers all the members below. */
+        mutable std::mutex Mutex;
+
+        /* Most recently used first. */
+        TRowList Rows;
+
+        /* Positions in the list, by key hash. */
+        std::unordered_multimap<size_t, TRowList::iterator> RowsByHash;
+
+        /* Bumped each time we drop rows because of a write. */
+        uint64_t Generation;
+
+      };  // TShard
+
+      /* Hands out the single row found by a hit, and keeps it alive while the caller looks at it. */
+      class TWalker
+          : public TPresentWalker {
+        NO_COPY(TWalker);
+        public:
+
+        /* Walk the given row. */
+        explicit TWalker(const std::shared_ptr<TRow> &row)
+            : TPresentWalker(Match), Row(row), Valid(true) {}
+
+        /* True iff. we have an item. */
+        virtual operator bool() const override {
+          assert(this);
+          return Valid;
+        }
+
+        /* The current item. */
+        virtual const TItem &operator*() const override {
+          assert(this);
+          assert(Valid);
+          return Row->Item;
+        }
+
+        /* Walk to the next item, if any. */
+        virtual TWalker &operator++() override {
+          assert(this);
+          Valid = false;
+          return *this;
+        }
+
+        private:
+
+        /* The row we walk. */
+        std::shared_ptr<TRow> Row;
+
+        /* See accessor. */
+        bool Valid;
+
+      };  // TWalker
+
+      /* The hash under which we keep the row for the given key. */
+      static size_t GetHash(const Base::TUuid &repo_id, const TIndexKey &key) {
+        return repo_id.GetHash() ^ key.GetHash();
+      }
+
+      /* The shard which holds rows with the given hash. */
+      TShard &GetShard(size_t hash) {
+        assert(this);
+        return Shards[(hash ^ (hash >> 32)) % ShardCount];
+      }
+
+      /* The most rows any one shard may hold. */
+      size_t MaxRowCountPerShard;
+
+      /* See ShardCount. */
+      TShard Shards[ShardCount];
+
+    };  // TRowCache
+
+  }  // Indy
+
+}  // Orly
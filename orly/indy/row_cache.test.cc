@@ -0,0 +1,135 @@
+/* <orly/indy/row_cache.test.cc>
+
+   Unit test for <orly/indy/row_cache.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/row_cache.h>
+
+#include <tuple>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Base;
+using namespace Orly;
+using namespace Orly::Atom;
+using namespace Orly::Indy;
+
+static const TUuid RepoId(TUuid::Best), IdxId(TUuid::Best);
+
+/* An item describing the given op at the given sequence number. */
+static TPresentWalker::TItem MakeItem(TSuprena &arena, void *state_alloc, const TIndexKey &key, int64_t val, TSequenceNumber seq) {
+  TPresentWalker::TItem item;
+  item.SequenceNumber = seq;
+  item.Key = key.GetKey().GetCore();
+  item.KeyArena = key.GetKey().GetArena();
+  item.Op = TKey(val, &arena, state_alloc).GetCore();
+  item.OpArena = &arena;
+  return item;
+}
+
+FIXTURE(Typical) {
+  TSuprena arena;
+  void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+  TRowCache cache(100UL);
+  const TIndexKey key(IdxId, TKey(make_tuple(101L), &arena, state_alloc));
+  unique_ptr<TPresentWalker> walker;
+  TPresentWalker::TItem item;
+  bool found = false;
+  uint64_t gen = 0UL;
+  EXPECT_FALSE(cache.Find(RepoId, key, 1UL, 10UL, walker, item, found, gen));
+  /* The cache copies the op, so our arena's copy can go. */ {
+    TSuprena op_arena;
+    const auto op_item = MakeItem(op_arena, state_alloc, key, 202L, 7UL);
+    cache.Fill(RepoId, key, 1UL, gen, &op_item);
+  }
+  EXPECT_EQ(cache.GetRowCount(), 1UL);
+  /* A view which can see the op hits. */
+  if (EXPECT_TRUE(cache.Find(RepoId, key, 1UL, 12UL, walker, item, found, gen)) && EXPECT_TRUE(found)) {
+    EXPECT_EQ(item.SequenceNumber, 7UL);
+    EXPECT_EQ(TKey(item.Op, item.OpArena), TKey(202L, &arena, state_alloc));
+    EXPECT_EQ(TKey(item.Key, item.KeyArena), key.GetKey());
+    EXPECT_TRUE(walker && *walker);
+  }
+  /* A view from before the op misses. */
+  EXPECT_FALSE(cache.Find(RepoId, key, 1UL, 6UL, walker, item, found, gen));
+  /* So does another repo. */
+  EXPECT_FALSE(cache.Find(TUuid(TUuid::Best), key, 1UL, 12UL, walker, item, found, gen));
+  /* A write drops the row. */
+  cache.Invalidate(RepoId, key);
+  EXPECT_FALSE(cache.Find(RepoId, key, 1UL, 12UL, walker, item, found, gen));
+  EXPECT_EQ(cache.GetRowCount(), 0UL);
+}
+
+FIXTURE(Absent) {
+  TSuprena arena;
+  void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+  TRowCache cache(100UL);
+  const TIndexKey key(IdxId, TKey(make_tuple(101L), &arena, state_alloc));
+  unique_ptr<TPresentWalker> walker;
+  TPresentWalker::TItem item;
+  bool found = true;
+  uint64_t gen = 0UL;
+  EXPECT_FALSE(cache.Find(RepoId, key, 5UL, 10UL, walker, item, found, gen));
+  cache.Fill(RepoId, key, 5UL, gen, nullptr);
+  EXPECT_TRUE(cache.Find(RepoId, key, 5UL, 20UL, walker, item, found, gen));
+  EXPECT_FALSE(found);
+  /* A view which reaches back further might see something we didn't. */
+  EXPECT_FALSE(cache.Find(RepoId, key, 3UL, 20UL, walker, item, found, gen));
+}
+
+FIXTURE(RacingWrite) {
+  TSuprena arena;
+  void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+  TRowCache cache(100UL);
+  const TIndexKey key(IdxId, TKey(make_tuple(101L), &arena, state_alloc));
+  unique_ptr<TPresentWalker> walker;
+  TPresentWalker::TItem item;
+  bool found = false;
+  uint64_t gen = 0UL;
+  EXPECT_FALSE(cache.Find(RepoId, key, 1UL, 10UL, walker, item, found, gen));
+  /* A write lands between our miss and our fill, so what we found may be stale. */
+  cache.Invalidate(RepoId, key);
+  const auto op_item = MakeItem(arena, state_alloc, key, 202L, 7UL);
+  cache.Fill(RepoId, key, 1UL, gen, &op_item);
+  EXPECT_EQ(cache.GetRowCount(), 0UL);
+  /* Clearing the repo fails fills, too. */
+  EXPECT_FALSE(cache.Find(RepoId, key, 1UL, 10UL, walker, item, found, gen));
+  cache.Clear(RepoId);
+  cache.Fill(RepoId, key, 1UL, gen, &op_item);
+  EXPECT_EQ(cache.GetRowCount(), 0UL);
+}
+
+FIXTURE(Bounded) {
+  TSuprena arena;
+  void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+  TRowCache cache(TRowCache::ShardCount * 2UL);
+  unique_ptr<TPresentWalker> walker;
+  TPresentWalker::TItem item;
+  bool found = false;
+  uint64_t gen = 0UL;
+  for (int64_t i = 0; i < 1000; ++i) {
+    const TIndexKey key(IdxId, TKey(make_tuple(i), &arena, state_alloc));
+    if (!cache.Find(RepoId, key, 1UL, 10UL, walker, item, found, gen)) {
+      cache.Fill(RepoId, key, 1UL, gen, nullptr);
+    }
+  }
+  EXPECT_LE(cache.GetRowCount(), TRowCache::ShardCount * 2UL);
+  /* The most recent key is still there. */
+  EXPECT_TRUE(cache.Find(RepoId, TIndexKey(IdxId, TKey(make_tuple(999L), &arena, state_alloc)), 1UL, 10UL, walker, item, found, gen));
+  cache.Clear(RepoId);
+  EXPECT_EQ(cache.GetRowCount(), 0UL);
+}
@@ -104,7 +104,7 @@ TUpdate::TEntry::TEntryKey::TEntryKey(const TEntry *entry)
 TUpdate::TEntry::TEntry(TUpdate *update, const TIndexKey &index_key, const TKey &op, void *state_alloc)
     : IndexKey(index_key.GetIndexId(), TKey(&update->Suprena, state_alloc, index_key.GetKey())),
       UpdateMembership(this, IndexKey.GetKey(), InvCon::TOrient::Rev, &update->EntryCollection),
-      MemoryLayerMembership(this, TEntryKey(this)),
+      EntryKey(this),
       Op(&update->Suprena, Sabot::State::TAny::TWrapper(op.GetCore().NewState(op.GetArena(), state_alloc))) {
   void *type_alloc = alloca(Sabot::Type::GetMaxTypeSize());
   #ifndef NDEBUG
@@ -162,7 +162,6 @@ namespace Orly {
 
         /* TODO */
         typedef InvCon::OrderedList::TMembership<TEntry, TUpdate, TKey> TUpdateMembership;
-        typedef InvCon::OrderedList::TMembership<TEntry, TMemoryLayer, TEntryKey> TMemoryLayerMembership;
 
         /* TODO */
         TEntry(TUpdate *update, const TIndexKey &key, const TKey &op, void *state_alloc);
@@ -176,8 +175,8 @@ namespace Orly {
         /* TODO */
         TUpdateMembership::TImpl UpdateMembership;
 
-        /* TODO */
-        TMemoryLayerMembership::TImpl MemoryLayerMembership;
+        /* Our position in a memory layer: (index id, key, descending sequence number). */
+        TEntryKey EntryKey;
 
         /* TODO */
         Atom::TCore Op;
@@ -426,7 +425,7 @@ namespace Orly {
 
     inline const TUpdate::TEntry::TEntryKey &TUpdate::TEntry::GetEntryKey() const {
       assert(this);
-      return MemoryLayerMembership.GetKey();
+      return EntryKey;
     }
 
     /* TODO */
@@ -0,0 +1,335 @@
+/* <orly/indy/util/loser_tree.h>
+
+   A tournament (loser) tree for k-way merges, with the same interface as TMinHeap.
+
+   Each internal node of the tree remembers the loser of the match played there, and the root remembers the overall
+   winner.  When the winner is popped and its source inserts its next value, that value replays only the matches on
+   the path from its leaf to the root: one comparison per level, where a heap's sift-down costs two.  The replay is
+   put off until the tree is next looked at, so a Pop followed by an Insert of the same source costs a single replay,
+   and a Pop of an exhausted source costs one which compares nothing but the survivors on its path.
+
+   Comparisons in a merge of keys are expensive, so the tree can also cache a cheap prefix of each source's current
+   value, chosen by a prefixer.  Matches between two values whose prefixes differ are decided by the prefixes alone;
+   only ties go to the comparator.  TKeyPrefix is the usual prefix: the first element of a tuple key.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <cassert>
+#include <functional>
+#include <vector>
+
+#include <base/class_traits.h>
+#include <orly/atom/kit2.h>
+#include <orly/indy/key.h>
+
+namespace Orly {
+
+  namespace Indy {
+
+    namespace Util {
+
+      /* A prefixer for values which have no cheap prefix.  Every match goes to the comparator.
+
+         A prefixer defines the type of prefix it caches, which must be default-constructible and have a member
+         Compare(that) returning Lt or Gt when the prefixes alone decide the order of their values, or Eq when they
+         don't; and a static TryGet(val, prefix), which returns false when a value has no prefix.  A prefix's order must
+         agree with the comparator's: whenever the prefix of one value is Lt that of another, the comparator must put
+         the first value before the second. */
+      template <typename TVal>
+      class TNoPrefix {
+        NO_CONSTRUCTION(TNoPrefix);
+        public:
+
+        /* Never decides anything. */
+        class TPrefix {
+          public:
+
+          /* Always Eq. */
+          Atom::TComparison Compare(const TPrefix &) const {
+            return Atom::TComparison::Eq;
+          }
+
+        };  // TPrefix
+
+        /* Always false. */
+        static bool TryGet(const TVal &, TPrefix &) {
+          return false;
+        }
+
+      };  // TNoPrefix
+
+      /* The first element of a tuple key, which orders tuple keys whenever it differs between them. */
+      class TKeyPrefix {
+        public:
+
+        /* Do-little. */
+        TKeyPrefix() : Arena(nullptr) {}
+
+        /* Lt or Gt if our first elements differ, otherwise Eq, as the tuples themselves may still differ. */
+        Atom::TComparison Compare(const TKeyPrefix &that) const {
+          assert(this);
+          assert(&that);
+          assert(Arena);
+          assert(that.Arena);
+          Atom::TComparison comp;
+          return First.TryQuickOrderComparison(Arena, that.First, that.Arena, comp) ? comp : Atom::TComparison::Eq;
+        }
+
+        /* If the key is a non-empty tuple in an arena, cache its first element and return true. */
+        static bool TryGet(const Atom::TCore &key, Atom::TCore::TArena *arena, TKeyPrefix &out) {
+          assert(&key);
+          assert(&out);
+          if (!arena || !key.IsTuple()) {
+            return false;
+          }
+          const uint32_t elem_count = *key.TryGetElemCount();
+          if (!elem_count) {
+            return false;
+          }
+          void *pin_alloc = alloca(sizeof(Atom::TCore::TArena::TFinalPin));
+          Atom::TCore::TArena::TFinalPin::TWrapper pin(
+              arena->Pin(*key.TryGetOffset(), sizeof(Atom::TCore::TNote) + (sizeof(Atom::TCore) * elem_count), pin_alloc));
+          const Atom::TCore *start, *limit;
+          pin->GetNote()->Get(start, limit);
+          if (start == limit) {
+            return false;
+          }
+          out.First = *start;
+          out.Arena = arena;
+          return true;
+        }
+
+        private:
+
+        /* The first element of the key. */
+        Atom::TCore First;
+
+        /* The arena to look the element up in. */
+        Atom::TCore::TArena *Arena;
+
+      };  // TKeyPrefix
+
+      /* A prefixer for keys. */
+      class TKeyPrefixer {
+        NO_CONSTRUCTION(TKeyPrefixer);
+        public:
+
+        /* See TKeyPrefix. */
+        using TPrefix = TKeyPrefix;
+
+        /* See TKeyPrefix. */
+        static bool TryGet(const TKey &key, TPrefix &out) {
+          return TKeyPrefix::TryGet(key.GetCore(), key.GetArena(), out);
+        }
+
+      };  // TKeyPrefixer
+
+      /* A tournament tree over up to max_elem sources.  The values inserted are held by reference, so each must stay
+         put, and unchanged, until it is popped. */
+      template <typename TVal, typename TRef, class TComparator = std::less<TVal>, class TPrefixer = TNoPrefix<TVal>>
+      class TLoserTree {
+        NO_COPY(TLoserTree);
+        public:
+
+        /* An empty tree. */
+        TLoserTree(size_t max_elem, const TComparator &comp = TComparator())
+            : MaxElem(max_elem), NumElem(0UL), Leaves(max_elem), Nodes(max_elem), Pending(NoLeaf), IsDirty(false),
+              Comp(comp) {
+          FreeLeaves.reserve(MaxElem);
+          for (size_t i = MaxElem; i; --i) {
+            FreeLeaves.push_back(i - 1);
+          }
+        }
+
+        /* True iff. we have a value. */
+        inline operator bool() const {
+          assert(this);
+          return NumElem > 0;
+        }
+
+        /* Insert a value, referred to by ref.  If a value has just been popped, the new one takes its place. */
+        inline void Insert(const TVal &val, TRef ref) {
+          assert(this);
+          assert(&val);
+          assert(NumElem < MaxElem);
+          size_t leaf;
+          if (Pending != NoLeaf) {
+            leaf = Pending;
+            Pending = NoLeaf;
+          } else {
+            assert(!FreeLeaves.empty());
+            leaf = FreeLeaves.back();
+            FreeLeaves.pop_back();
+            IsDirty = true;
+          }
+          TLeaf &that = Leaves[leaf];
+          that.Val = &val;
+          that.Ref = ref;
+          that.HasPrefix = TPrefixer::TryGet(val, that.Prefix);
+          ++NumElem;
+          if (!IsDirty) {
+            Replay(leaf);
+          }
+        }
+
+        /* The least value, and its ref. */
+        inline const TVal &Peek(TRef &ref) const {
+          assert(this);
+          assert(NumElem > 0);
+          Settle();
+          const TLeaf &winner = Leaves[Nodes[0]];
+          ref = winner.Ref;
+          return *winner.Val;
+        }
+
+        /* Remove the least value and return it, and its ref. */
+        inline const TVal &Pop(TRef &ref) {
+          assert(this);
+          assert(NumElem > 0);
+          Settle();
+          Pending = Nodes[0];
+          TLeaf &winner = Leaves[Pending];
+          ref = winner.Ref;
+          const TVal *val = winner.Val;
+          winner.Val = nullptr;
+          --NumElem;
+          return *val;
+        }
+
+        private:
+
+        /* A source's slot in the tree. */
+        class TLeaf {
+          public:
+
+          /* Empty. */
+          TLeaf() : Val(nullptr), HasPrefix(false) {}
+
+          /* The source's current value, or null if it has none. */
+          const TVal *Val;
+
+          /* What the source's value is referred to by. */
+          TRef Ref;
+
+          /* Valid iff. HasPrefix. */
+          typename TPrefixer::TPrefix Prefix;
+
+          /* True iff. the value has a prefix. */
+          bool HasPrefix;
+
+        };  // TLeaf
+
+        /* Marks the lack of a leaf. */
+        static constexpr size_t NoLeaf = static_cast<size_t>(-1);
+
+        /* True iff. the value at the lhs leaf belongs before the value at the rhs one.  Empty leaves lose to everyone. */
+        inline bool Beats(size_t lhs, size_t rhs) const {
+          const TLeaf &lhs_leaf = Leaves[lhs], &rhs_leaf = Leaves[rhs];
+          if (!lhs_leaf.Val || !rhs_leaf.Val) {
+            return lhs_leaf.Val != nullptr;
+          }
+          if (lhs_leaf.HasPrefix && rhs_leaf.HasPrefix) {
+            Atom::TComparison comp = lhs_leaf.Prefix.Compare(rhs_leaf.Prefix);
+            if (Atom::IsLt(comp)) {
+              return true;
+            }
+            if (Atom::IsGt(comp)) {
+              return false;
+            }
+          }
+          return Comp(*lhs_leaf.Val, *rhs_leaf.Val);
+        }
+
+        /* Bring the tree up to date with whatever has been popped or inserted since it was last looked at. */
+        inline void Settle() const {
+          if (IsDirty) {
+            if (Pending != NoLeaf) {
+              FreeLeaves.push_back(Pending);
+              Pending = NoLeaf;
+            }
+            Nodes[0] = (MaxElem > 1) ? Build(1) : 0;
+            IsDirty = false;
+          } else if (Pending != NoLeaf) {
+            /* The popped source had nothing to insert, so its leaf is empty now. */
+            size_t leaf = Pending;
+            Pending = NoLeaf;
+            FreeLeaves.push_back(leaf);
+            Replay(leaf);
+          }
+        }
+
+        /* Play the matches below the given node afresh and return the leaf which wins them.  Node n has children 2n and
+           2n + 1, and leaf i sits at node MaxElem + i. */
+        size_t Build(size_t node) const {
+          if (node >= MaxElem) {
+            return node - MaxElem;
+          }
+          size_t lhs = Build(node * 2), rhs = Build(node * 2 + 1);
+          if (Beats(rhs, lhs)) {
+            std::swap(lhs, rhs);
+          }
+          Nodes[node] = rhs;
+          return lhs;
+        }
+
+        /* Replay the matches on the path from the given leaf to the root. */
+        inline void Replay(size_t leaf) const {
+          size_t winner = leaf;
+          for (size_t node = (MaxElem + leaf) / 2; node; node /= 2) {
+            if (Beats(Nodes[node], winner)) {
+              std::swap(Nodes[node], winner);
+            }
+          }
+          Nodes[0] = winner;
+        }
+
+        /* The number of leaves, fixed at construction; at most this many values may be in the tree at once. */
+        const size_t MaxElem;
+
+        /* The number of values in the tree now.  A popped value stops counting as soon as it's popped, even though its
+           leaf stays reserved for the next insert. */
+        size_t NumElem;
+
+        /* The sources' current values. */
+        std::vector<TLeaf> Leaves;
+
+        /* The loser of the match at each internal node, and the overall winner in the unused slot 0. */
+        mutable std::vector<size_t> Nodes;
+
+        /* The leaves with no source in them. */
+        mutable std::vector<size_t> FreeLeaves;
+
+        /* The leaf most recently popped, if its replay is still to come. */
+        mutable size_t Pending;
+
+        /* True if values have been inserted outside of the tree's matches, so they must all be played again. */
+        mutable bool IsDirty;
+
+        /* Comparator */
+        TComparator Comp;
+
+      };  // TLoserTree
+
+      /* See declaration. */
+      template <typename TVal, typename TRef, class TComparator, class TPrefixer>
+      constexpr size_t TLoserTree<TVal, TRef, TComparator, TPrefixer>::NoLeaf;
+
+    }  // Util
+
+  }  // Indy
+
+}  // Orly
@@ -0,0 +1,146 @@
+/* <orly/indy/util/loser_tree.test.cc>
+
+   Unit test for <orly/indy/util/loser_tree.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/util/loser_tree.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <orly/atom/suprena.h>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Orly;
+using namespace Orly::Atom;
+using namespace Orly::Indy;
+using namespace Orly::Indy::Util;
+
+/* Merge the sorted runs through a tree and return the merged values, checking each came from the run we were told. */
+template <typename TVal, typename TTree>
+static vector<TVal> Merge(const vector<vector<TVal>> &runs, TTree &tree) {
+  vector<size_t> pos_vec(runs.size(), 0UL);
+  for (size_t i = 0; i < runs.size(); ++i) {
+    if (!runs[i].empty()) {
+      tree.Insert(runs[i][0], i);
+    }
+  }
+  vector<TVal> out;
+  while (tree) {
+    size_t peeked, popped;
+    const TVal &peek = tree.Peek(peeked);
+    const TVal &val = tree.Pop(popped);
+    EXPECT_EQ(&peek, &val);
+    EXPECT_EQ(peeked, popped);
+    EXPECT_EQ(&val, &runs[popped][pos_vec[popped]]);
+    out.push_back(val);
+    if (++pos_vec[popped] < runs[popped].size()) {
+      tree.Insert(runs[popped][pos_vec[popped]], popped);
+    }
+  }
+  return out;
+}
+
+/* Make num_runs sorted runs of random lengths, some of them empty, and return all their values, sorted. */
+static vector<int> MakeRuns(size_t num_runs, vector<vector<int>> &runs) {
+  vector<int> all;
+  runs.resize(num_runs);
+  for (auto &run: runs) {
+    run.resize(rand() % 50);
+    for (auto &val: run) {
+      val = rand() % 100;
+    }
+    sort(run.begin(), run.end());
+    all.insert(all.end(), run.begin(), run.end());
+  }
+  sort(all.begin(), all.end());
+  return all;
+}
+
+FIXTURE(Typical) {
+  for (size_t num_runs: {1UL, 2UL, 3UL, 7UL, 16UL, 33UL}) {
+    vector<vector<int>> runs;
+    vector<int> expected = MakeRuns(num_runs, runs);
+    TLoserTree<int, size_t> tree(num_runs);
+    EXPECT_TRUE(Merge(runs, tree) == expected);
+    EXPECT_FALSE(tree);
+  }
+}
+
+FIXTURE(Reverse) {
+  vector<vector<int>> runs;
+  vector<int> expected = MakeRuns(9UL, runs);
+  TLoserTree<int, size_t, greater<int>> tree(runs.size());
+  for (auto &run: runs) {
+    reverse(run.begin(), run.end());
+  }
+  reverse(expected.begin(), expected.end());
+  EXPECT_TRUE(Merge(runs, tree) == expected);
+}
+
+FIXTURE(Refill) {
+  /* Sources come and go: fill the tree, drain part of it without refilling, then add more. */
+  vector<int> vals = {50, 10, 40, 20, 30};
+  TLoserTree<int, size_t> tree(vals.size());
+  for (size_t i = 0; i < 3; ++i) {
+    tree.Insert(vals[i], i);
+  }
+  size_t ref;
+  EXPECT_EQ(tree.Pop(ref), 10);
+  EXPECT_EQ(ref, 1UL);
+  EXPECT_EQ(tree.Pop(ref), 40);
+  EXPECT_EQ(ref, 2UL);
+  tree.Insert(vals[3], 3);
+  tree.Insert(vals[4], 4);
+  EXPECT_EQ(tree.Pop(ref), 20);
+  EXPECT_EQ(ref, 3UL);
+  EXPECT_EQ(tree.Pop(ref), 30);
+  EXPECT_EQ(ref, 4UL);
+  EXPECT_EQ(tree.Peek(ref), 50);
+  EXPECT_EQ(ref, 0UL);
+  EXPECT_EQ(tree.Pop(ref), 50);
+  EXPECT_FALSE(tree);
+}
+
+FIXTURE(KeyPrefix) {
+  /* Keys whose first elements often tie, so some matches go to the prefixes and some to the comparator. */
+  TSuprena arena;
+  void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+  const size_t num_runs = 13UL;
+  vector<vector<TKey>> runs(num_runs);
+  vector<TKey> expected;
+  for (auto &run: runs) {
+    vector<tuple<int64_t, string, int64_t>> tuples(rand() % 40);
+    for (auto &tup: tuples) {
+      tup = make_tuple(rand() % 10, to_string(rand() % 10), rand() % 100);
+    }
+    sort(tuples.begin(), tuples.end());
+    for (const auto &tup: tuples) {
+      run.emplace_back(tup, &arena, state_alloc);
+      expected.push_back(run.back());
+    }
+  }
+  sort(expected.begin(), expected.end());
+  TLoserTree<TKey, size_t, less<TKey>, TKeyPrefixer> prefix_tree(num_runs);
+  TLoserTree<TKey, size_t> plain_tree(num_runs);
+  EXPECT_TRUE(Merge(runs, prefix_tree) == expected);
+  EXPECT_TRUE(Merge(runs, plain_tree) == expected);
+}
@@ -0,0 +1,144 @@
+/* <orly/indy/util/loser_tree.test.manual.cc>
+
+   K-way merge benchmark for <orly/indy/util/loser_tree.h>.
+
+   Merges sorted runs of keys shaped like the ones a repo stores, <[int, str, int]>, through TMinHeap, through
+   TLoserTree, and through TLoserTree caching the first element of each key.  Each source advances as soon as it is
+   popped, as the present walkers and the merges do.  Reports the time and the number of full key comparisons per key
+   merged, with 4, 16 and 64 sources.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/util/loser_tree.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <base/timer.h>
+#include <orly/atom/suprena.h>
+#include <orly/indy/util/min_heap.h>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Base;
+using namespace Orly;
+using namespace Orly::Atom;
+using namespace Orly::Indy;
+using namespace Orly::Indy::Util;
+
+static const size_t NumKeys = 1000000UL;
+
+/* Orders keys, counting as it goes. */
+class TCountingLess {
+  public:
+
+  TCountingLess(size_t *count) : Count(count) {}
+
+  bool operator()(const TKey &lhs, const TKey &rhs) const {
+    ++*Count;
+    return lhs < rhs;
+  }
+
+  private:
+
+  size_t *Count;
+
+};  // TCountingLess
+
+/* Spread NumKeys keys over num_runs sorted runs.  The leading ints repeat often enough that many matches are between
+   keys which differ only later on. */
+static void MakeRuns(TSuprena *arena, size_t num_runs, vector<vector<TKey>> &runs) {
+  void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+  runs.clear();
+  runs.resize(num_runs);
+  for (auto &run: runs) {
+    vector<tuple<int64_t, string, int64_t>> tuples(NumKeys / num_runs);
+    for (auto &tup: tuples) {
+      tup = make_tuple(rand() % (NumKeys / 16), "customer-" + to_string(rand() % 1000), rand());
+    }
+    sort(tuples.begin(), tuples.end());
+    run.reserve(tuples.size());
+    for (const auto &tup: tuples) {
+      run.emplace_back(tup, arena, state_alloc);
+    }
+  }
+}
+
+/* Merge the runs through the given tree and report on it. */
+template <typename TTree>
+static void Merge(const char *name, const vector<vector<TKey>> &runs, TTree &tree, const size_t &count) {
+  vector<size_t> pos_vec(runs.size(), 0UL);
+  TTimer timer;
+  timer.Start();
+  for (size_t i = 0; i < runs.size(); ++i) {
+    tree.Insert(runs[i][0], i);
+  }
+  size_t num_merged = 0UL;
+  const TKey *prev = nullptr;
+  bool is_sorted = true;
+  while (tree) {
+    size_t src;
+    const TKey &key = tree.Pop(src);
+    is_sorted = is_sorted && (!prev || *prev <= key);
+    prev = &key;
+    ++num_merged;
+    if (++pos_vec[src] < runs[src].size()) {
+      tree.Insert(runs[src][pos_vec[src]], src);
+    }
+  }
+  timer.Stop();
+  EXPECT_TRUE(is_sorted);
+  printf(
+      "%-12s %2zu sources: %7.1f ns/key; %5.2f comparisons/key\n", name, runs.size(), timer.Total() * 1e9 / num_merged,
+      static_cast<double>(count) / num_merged);
+}
+
+static void RunBench(size_t num_runs) {
+  TSuprena arena;
+  vector<vector<TKey>> runs;
+  MakeRuns(&arena, num_runs, runs);
+  size_t count = 0UL;
+  /* min heap */ {
+    TMinHeap<TKey, size_t, TCountingLess> tree(num_runs, TCountingLess(&count));
+    Merge("min heap", runs, tree, count);
+  }
+  count = 0UL;
+  /* loser tree */ {
+    TLoserTree<TKey, size_t, TCountingLess> tree(num_runs, TCountingLess(&count));
+    Merge("loser tree", runs, tree, count);
+  }
+  count = 0UL;
+  /* loser tree with prefixes */ {
+    TLoserTree<TKey, size_t, TCountingLess, TKeyPrefixer> tree(num_runs, TCountingLess(&count));
+    Merge("+ prefixes", runs, tree, count);
+  }
+}
+
+FIXTURE(Sources4) {
+  RunBench(4UL);
+}
+
+FIXTURE(Sources16) {
+  RunBench(16UL);
+}
+
+FIXTURE(Sources64) {
+  RunBench(64UL);
+}
@@ -0,0 +1,326 @@
+/* <orly/indy/util/skip_list.h>
+
+   An ordered, non-owning collection of pointers kept in a skip list.
+
+   Inserts and seeks cost O(log n), and appends to the end cost O(1).  There may be only one writer at a time (the
+   caller must serialize calls to Insert() and Append()), but any number of cursors may walk the list while the writer
+   is inserting.  A node is fully linked before it is published at the bottom level, and the next pointers are published
+   with release semantics, so a reader either sees a node completely or not at all.  Nodes are never unlinked; they are
+   all freed when the list is destroyed.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include <base/class_traits.h>
+
+namespace Orly {
+
+  namespace Indy {
+
+    namespace Util {
+
+      /* A skip list of pointers to TVal, ordered by TLess, which must be a strict weak ordering over 'const TVal &'.
+         Equivalent values are kept in insertion order. */
+      template <typename TVal, typename TLess>
+      class TSkipList {
+        NO_COPY(TSkipList);
+        private:
+
+        /* Forward Declarations. */
+        class TNode;
+
+        public:
+
+        /* The tallest tower we will build.  With a branching factor of 4 this comfortably covers 16M members. */
+        static constexpr size_t MaxHeight = 12UL;
+
+        /* Walks the list in order.  Cursors are cheap to copy. */
+        class TCursor {
+          public:
+
+          /* Start at the first member of the list, if any. */
+          TCursor(const TSkipList *list)
+              : Node(list->Head->GetNext(0)) {}
+
+          /* Start at the first member for which is_before returns false.  The predicate must be monotone over the
+             ordering of the list: true for some prefix of the members and false for the rest. */
+          template <typename TIsBefore>
+          TCursor(const TSkipList *list, const TIsBefore &is_before)
+              : Node(list->FindFirstNotBefore(is_before)) {}
+
+          /* True iff. we have a member. */
+          operator bool() const {
+            assert(this);
+            return Node != nullptr;
+          }
+
+          /* The current member. */
+          TVal &operator*() const {
+            assert(this);
+            assert(Node);
+            return *Node->Val;
+          }
+
+          /* The current member. */
+          TVal *operator->() const {
+            assert(this);
+            assert(Node);
+            return Node->Val;
+          }
+
+          /* Walk to the next member, if any. */
+          TCursor &operator++() {
+            assert(this);
+            assert(Node);
+            Node = Node->GetNext(0);
+            return *this;
+          }
+
+          private:
+
+          /* The node we're on, or null if we've walked off the end. */
+          const TNode *Node;
+
+        };  // TCursor
+
+        /* An empty list. */
+        TSkipList(const TLess &less = TLess())
+            : Less(less), Head(TNode::New(nullptr, MaxHeight)), Height(1UL), Size(0UL), RandState(0x9E3779B97F4A7C15UL) {
+          for (size_t level = 0; level < MaxHeight; ++level) {
+            Last[level] = Head;
+          }
+        }
+
+        /* Frees the nodes, but not the members. */
+        ~TSkipList() {
+          assert(this);
+          for (TNode *node = Head; node;) {
+            TNode *next = node->GetNext(0);
+            TNode::Delete(node);
+            node = next;
+          }
+        }
+
+        /* Insert the given member at its position in the order.  Callers must not call this concurrently. */
+        void Insert(TVal *val) {
+          assert(this);
+          assert(val);
+          TNode *prev[MaxHeight];
+          size_t height = Height.load(std::memory_order_relaxed);
+          TNode *node = Head;
+          for (size_t level = height; level-- > 0;) {
+            for (TNode *next = node->GetNext(level); next && !Less(*val, *next->Val); next = node->GetNext(level)) {
+              node = next;
+            }
+            prev[level] = node;
+          }
+          size_t new_height = RandomHeight();
+          if (new_height > height) {
+            for (size_t level = height; level < new_height; ++level) {
+              prev[level] = Head;
+            }
+            /* Readers which see the new height before the new links will just find null at the top of the head. */
+            Height.store(new_height, std::memory_order_relaxed);
+          }
+          TNode *new_node = TNode::New(val, new_height);
+          for (size_t level = 0; level < new_height; ++level) {
+            new_node->SetNextRelaxed(level, prev[level]->GetNextRelaxed(level));
+            prev[level]->SetNext(level, new_node);
+            if (!new_node->GetNextRelaxed(level)) {
+              Last[level] = new_node;
+            }
+          }
+          Size.store(Size.load(std::memory_order_relaxed) + 1UL, std::memory_order_relaxed);
+        }
+
+        /* Append the given member to the end of the list, without searching for its position.  It must not be
+           ordered before the current last member.  Callers must not call this concurrently, nor with Insert(). */
+        void Append(TVal *val) {
+          assert(this);
+          assert(val);
+          assert(Last[0] == Head || !Less(*val, *Last[0]->Val));
+          size_t new_height = RandomHeight();
+          if (new_height > Height.load(std::memory_order_relaxed)) {
+            Height.store(new_height, std::memory_order_relaxed);
+          }
+          TNode *new_node = TNode::New(val, new_height);
+          for (size_t level = 0; level < new_height; ++level) {
+            Last[level]->SetNext(level, new_node);
+            Last[level] = new_node;
+          }
+          Size.store(Size.load(std::memory_order_relaxed) + 1UL, std::memory_order_relaxed);
+        }
+
+        /* The number of members in the list. */
+        size_t GetSize() const {
+          assert(this);
+          return Size.load(std::memory_order_relaxed);
+        }
+
+        /* True iff. the list has no members. */
+        bool IsEmpty() const {
+          assert(this);
+          return Head->GetNext(0) == nullptr;
+        }
+
+        /* The first member in the list, or null if it is empty. */
+        TVal *TryGetFirstMember() const {
+          assert(this);
+          TNode *node = Head->GetNext(0);
+          return node ? node->Val : nullptr;
+        }
+
+        private:
+
+        /* A member plus its tower of next pointers.  The tower is allocated inline, so the size of a node depends on
+           its height. */
+        class TNode {
+          NO_COPY(TNode);
+          public:
+
+          /* Allocate a node with room for 'height' next pointers, all null. */
+          static TNode *New(TVal *val, size_t height) {
+            assert(height > 0 && height <= MaxHeight);
+            void *mem = malloc(sizeof(TNode) + sizeof(std::atomic<TNode *>) * (height - 1UL));
+            if (!mem) {
+              throw std::bad_alloc();
+            }
+            return new (mem) TNode(val, height);
+          }
+
+          /* Free a node allocated by New(). */
+          static void Delete(TNode *node) {
+            assert(node);
+            for (size_t level = 1; level < node->Height; ++level) {
+              node->Next[level].~atomic();
+            }
+            node->~TNode();
+            free(node);
+          }
+
+          /* The next node at the given level, as seen by a reader. */
+          TNode *GetNext(size_t level) const {
+            assert(this);
+            assert(level < Height);
+            return Next[level].load(std::memory_order_acquire);
+          }
+
+          /* The next node at the given level, as seen by the writer. */
+          TNode *GetNextRelaxed(size_t level) const {
+            assert(this);
+            assert(level < Height);
+            return Next[level].load(std::memory_order_relaxed);
+          }
+
+          /* Publish the next node at the given level. */
+          void SetNext(size_t level, TNode *node) {
+            assert(this);
+            assert(level < Height);
+            Next[level].store(node, std::memory_order_release);
+          }
+
+          /* Set the next node at the given level before this node has been published. */
+          void SetNextRelaxed(size_t level, TNode *node) {
+            assert(this);
+            assert(level < Height);
+            Next[level].store(node, std::memory_order_relaxed);
+          }
+
+          /* The member; null only for the head. */
+          TVal *const Val;
+
+          private:
+
+          /* Use New(). */
+          TNode(TVal *val, size_t height)
+              : Val(val), Height(height) {
+            Next[0].store(nullptr, std::memory_order_relaxed);
+            for (size_t level = 1; level < Height; ++level) {
+              new (&Next[level]) std::atomic<TNode *>(nullptr);
+            }
+          }
+
+          /* Use Delete(). */
+          ~TNode() {}
+
+          /* The number of next pointers in our tower. */
+          const size_t Height;
+
+          /* The tower of next pointers.  Over-allocated by New(). */
+          std::atomic<TNode *> Next[1];
+
+        };  // TNode
+
+        /* The first node for which is_before returns false, or null if there isn't one. */
+        template <typename TIsBefore>
+        const TNode *FindFirstNotBefore(const TIsBefore &is_before) const {
+          assert(this);
+          const TNode *node = Head;
+          for (size_t level = Height.load(std::memory_order_relaxed); level-- > 0;) {
+            for (const TNode *next = node->GetNext(level); next && is_before(*next->Val); next = node->GetNext(level)) {
+              node = next;
+            }
+          }
+          return node->GetNext(0);
+        }
+
+        /* Pick a height for a new node: 1 with probability 3/4, 2 with probability 3/16, and so on. */
+        size_t RandomHeight() {
+          assert(this);
+          size_t height = 1UL;
+          for (;;) {
+            RandState ^= RandState << 13;
+            RandState ^= RandState >> 7;
+            RandState ^= RandState << 17;
+            if (height >= MaxHeight || (RandState & 3UL) != 0UL) {
+              break;
+            }
+            ++height;
+          }
+          return height;
+        }
+
+        /* Our ordering. */
+        TLess Less;
+
+        /* The head node; holds no member and is always MaxHeight tall. */
+        TNode *const Head;
+
+        /* The height of the tallest tower in the list. */
+        std::atomic<size_t> Height;
+
+        /* See accessor. */
+        std::atomic<size_t> Size;
+
+        /* The last node at each level, or the head if the level is empty; only touched by the writer. */
+        TNode *Last[MaxHeight];
+
+        /* State for RandomHeight(); only touched by the writer. */
+        uint64_t RandState;
+
+      };  // TSkipList
+
+    }  // Util
+
+  }  // Indy
+
+}  // Orly
@@ -0,0 +1,181 @@
+/* <orly/indy/util/skip_list.test.cc>
+
+   Unit test for <orly/indy/util/skip_list.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/util/skip_list.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Orly::Indy::Util;
+
+class TObj {
+  public:
+
+  TObj(int64_t key, size_t id) : Key(key), Id(id) {}
+
+  int64_t Key;
+  size_t Id;
+
+};
+
+class TObjLess {
+  public:
+
+  bool operator()(const TObj &lhs, const TObj &rhs) const {
+    return lhs.Key < rhs.Key;
+  }
+
+};
+
+typedef TSkipList<TObj, TObjLess> TObjList;
+
+FIXTURE(Empty) {
+  TObjList list;
+  EXPECT_TRUE(list.IsEmpty());
+  EXPECT_EQ(list.GetSize(), 0UL);
+  EXPECT_FALSE(TObjList::TCursor(&list));
+  EXPECT_FALSE(TObjList::TCursor(&list, [](const TObj &obj) { return obj.Key < 7L; }));
+}
+
+FIXTURE(Ordered) {
+  const size_t num_obj = 10000UL;
+  vector<unique_ptr<TObj>> obj_vec;
+  TObjList list;
+  for (size_t i = 0; i < num_obj; ++i) {
+    obj_vec.emplace_back(new TObj(rand() % 1000, i));
+    list.Insert(obj_vec.back().get());
+  }
+  EXPECT_EQ(list.GetSize(), num_obj);
+  size_t count = 0UL;
+  const TObj *prev = nullptr;
+  bool in_order = true;
+  for (TObjList::TCursor csr(&list); csr; ++csr) {
+    if (prev) {
+      /* equal keys must come out in insertion order */
+      in_order = in_order && (prev->Key < csr->Key || (prev->Key == csr->Key && prev->Id < csr->Id));
+    }
+    prev = &*csr;
+    ++count;
+  }
+  EXPECT_EQ(count, num_obj);
+  EXPECT_TRUE(in_order);
+}
+
+FIXTURE(Seek) {
+  vector<unique_ptr<TObj>> obj_vec;
+  TObjList list;
+  for (int64_t i = 0; i < 1000; i += 2) {
+    obj_vec.emplace_back(new TObj(i, obj_vec.size()));
+    list.Insert(obj_vec.back().get());
+  }
+  /* exact hits */ {
+    TObjList::TCursor csr(&list, [](const TObj &obj) { return obj.Key < 500L; });
+    if (EXPECT_TRUE(csr)) {
+      EXPECT_EQ(csr->Key, 500L);
+      ++csr;
+      if (EXPECT_TRUE(csr)) {
+        EXPECT_EQ(csr->Key, 502L);
+      }
+    }
+  }
+  /* misses land on the next member */ {
+    TObjList::TCursor csr(&list, [](const TObj &obj) { return obj.Key < 501L; });
+    if (EXPECT_TRUE(csr)) {
+      EXPECT_EQ(csr->Key, 502L);
+    }
+  }
+  /* before the front */ {
+    TObjList::TCursor csr(&list, [](const TObj &obj) { return obj.Key < -1L; });
+    if (EXPECT_TRUE(csr)) {
+      EXPECT_EQ(csr->Key, 0L);
+    }
+  }
+  /* past the back */ {
+    TObjList::TCursor csr(&list, [](const TObj &obj) { return obj.Key < 999L; });
+    EXPECT_FALSE(csr);
+  }
+}
+
+FIXTURE(Append) {
+  vector<unique_ptr<TObj>> obj_vec;
+  TObjList list;
+  for (int64_t i = 0; i < 1000; i += 2) {
+    obj_vec.emplace_back(new TObj(i, obj_vec.size()));
+    list.Append(obj_vec.back().get());
+  }
+  /* inserts still find their places, including at the end */
+  obj_vec.emplace_back(new TObj(501, obj_vec.size()));
+  list.Insert(obj_vec.back().get());
+  obj_vec.emplace_back(new TObj(1000, obj_vec.size()));
+  list.Insert(obj_vec.back().get());
+  /* and appends follow them */
+  obj_vec.emplace_back(new TObj(1002, obj_vec.size()));
+  list.Append(obj_vec.back().get());
+  EXPECT_EQ(list.GetSize(), 503UL);
+  size_t count = 0UL;
+  const TObj *prev = nullptr;
+  bool in_order = true;
+  for (TObjList::TCursor csr(&list); csr; ++csr) {
+    in_order = in_order && (!prev || prev->Key < csr->Key);
+    prev = &*csr;
+    ++count;
+  }
+  EXPECT_EQ(count, 503UL);
+  EXPECT_TRUE(in_order);
+  TObjList::TCursor csr(&list, [](const TObj &obj) { return obj.Key < 501L; });
+  if (EXPECT_TRUE(csr)) {
+    EXPECT_EQ(csr->Key, 501L);
+  }
+}
+
+FIXTURE(ConcurrentReaders) {
+  const size_t num_obj = 100000UL;
+  vector<unique_ptr<TObj>> obj_vec;
+  for (size_t i = 0; i < num_obj; ++i) {
+    obj_vec.emplace_back(new TObj(rand(), i));
+  }
+  TObjList list;
+  atomic<bool> done(false);
+  atomic<size_t> num_bad(0UL);
+  auto reader = [&list, &done, &num_bad]() {
+    while (!done) {
+      int64_t prev = -1L;
+      for (TObjList::TCursor csr(&list); csr; ++csr) {
+        if (csr->Key < prev) {
+          ++num_bad;
+        }
+        prev = csr->Key;
+      }
+    }
+  };
+  thread t1(reader);
+  thread t2(reader);
+  for (auto &obj : obj_vec) {
+    list.Insert(obj.get());
+  }
+  done = true;
+  t1.join();
+  t2.join();
+  EXPECT_EQ(num_bad.load(), 0UL);
+  EXPECT_EQ(list.GetSize(), num_obj);
+}
@@ -51,6 +51,7 @@ void TMethodResult::Reset() {
   Arena.reset();
   Value = TCore();
   Tracker.Reset();
+  Error = false;
 }
 
 void TMethodResult::Write(TBinaryOutputStream &strm) const {
@@ -37,7 +37,8 @@ namespace Orly {
     using TArena = Atom::TCore::TArena;
 
     /* Default-constructs a void value and unknown tracker. */
-    TMethodResult() {}
+    TMethodResult()
+        : Error(false) {}
 
     /* Shares the given arena and shallow-copies the core.  Sets the tracker. */
     TMethodResult(
@@ -19,6 +19,7 @@
 #include <orly/method_result.h>
 
 #include <tuple>
+#include <vector>
 
 #include <io/binary_input_only_stream.h>
 #include <io/binary_output_only_stream.h>
@@ -59,3 +60,27 @@ FIXTURE(Typical) {
   RoundTrip(string("Mofo the Psychic Gorilla will now perform delightful feats of mental fancy."));
   RoundTrip(make_tuple(101, true, 98.6, set<int>({ 101, 102, 103 })), TTracker({ TUuid::Best, seconds(300) }));
 }
+
+FIXTURE(Batch) {
+  void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+  auto recorder = make_shared<TRecorder>();
+  /* write */ {
+    TSuprena arena;
+    vector<TMethodResult> results;
+    results.emplace_back(&arena, TCore(101, &arena, state_alloc), TOpt<TTracker>());
+    results.emplace_back(&arena, TCore(string("no such pov"), &arena, state_alloc), TOpt<TTracker>(), true);
+    TBinaryOutputOnlyStream strm(recorder);
+    strm << results;
+  }
+  TBinaryInputOnlyStream strm(make_shared<TPlayer>(recorder));
+  vector<TMethodResult> results;
+  strm >> results;
+  TSuprena arena;
+  if (EXPECT_EQ(results.size(), 2U)) {
+    EXPECT_FALSE(results[0].IsError());
+    EXPECT_EQ(Indy::TKey(results[0].GetValue(), results[0].GetArena().get()), Indy::TKey(101, &arena, state_alloc));
+    EXPECT_TRUE(results[1].IsError());
+    EXPECT_EQ(
+        Indy::TKey(results[1].GetValue(), results[1].GetArena().get()), Indy::TKey(string("no such pov"), &arena, state_alloc));
+  }
+}
@@ -81,7 +81,6 @@ TOut &Orly::Mynde::operator<<(TOut &out, const TResponseHeader &that) {
   tmp.Cas = SwapEnds(tmp.Cas);
 
   out.WriteShallow(tmp);
-  out.Flush();
 
   return out;
 }
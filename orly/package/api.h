@@ -90,6 +90,10 @@ namespace Orly {
          caller, and may indicate things such as Orly program assertion failures, multiple mutations of the same part of
          a key, etc. */
       Atom::TCore (*Runner)(TContext &, const TArgMap &);
+
+      /* False iff. the compiler proved the function can't produce database effects, so the server may run it without
+         setting up a transaction. Functions built without this analysis (tests, with blocks) keep the safe default. */
+      bool HasEffects = true;
     }; // TFuncInfo
 
     //NOTE: There are commonalities betwen test case and test, but inheritance messes with just using an initializer list in code gen.
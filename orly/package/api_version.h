@@ -19,4 +19,4 @@
 #pragma once
 
 //NOTE: Could we use a constexpr here?
-#define ORLY_API_VERSION 1
\ No newline at end of file
+#define ORLY_API_VERSION 2
\ No newline at end of file
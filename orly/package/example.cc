@@ -16,7 +16,7 @@
 /* Link file. */
 
 uint64_t GetApiVersion() {
-  return 1;
+  return 2;
 }
 
 static TLinkInfo LinkInfo {
@@ -153,6 +153,12 @@ const Orly::Type::TType &TFuncHolder::GetReturnType() const {
   return Func->ReturnType;
 }
 
+bool TFuncHolder::HasEffects() const {
+  assert(this);
+
+  return Func->HasEffects;
+}
+
 Orly::Atom::TCore TFuncHolder::Call(TContext &ctx, const TArgMap &args) const {
   assert(this);
   assert(&ctx);
@@ -102,6 +102,9 @@ namespace Orly {
       const TParamMap &GetParameters() const;
       const Type::TType &GetReturnType() const;
 
+      /* See TFuncInfo::HasEffects. */
+      bool HasEffects() const;
+
       Atom::TCore Call(TContext &ctx, const TArgMap &args) const;
 
       private:
@@ -29,6 +29,8 @@
 #include <chrono>
 #include <cstdint>
 #include <stdexcept>
+#include <tuple>
+#include <vector>
 
 #include <netinet/in.h>
 
@@ -359,7 +361,14 @@ namespace Orly {
 
     /* TailGlobalPov() -> void
          Tail the global pov. */
-      TailGlobalPov = 1018;
+      TailGlobalPov = 1018,
+
+      /* TryMany(std::vector<TMethodRequest> requests) -> std::vector<TMethodResult>;
+         Try to execute several methods at once, as if by calling Try() for each, and return their results in the same
+         order as the requests.  The server runs the methods concurrently, so there's no telling the order in which
+         their effects land.  A method which fails doesn't fail the batch; its result is an error instead, with the
+         error message as its value.  The requests' tracking ids and times-to-live are ignored. */
+      TryMany = 1019;
 
   }  // Orly::ServerRpc
 
@@ -394,7 +403,17 @@ namespace Orly {
          Notifies the session that one of its updates has been written to durable storage on the master and that there is no slave.  This
          notification is sent every pov, including the private pov in which the update begins, but only when the server has no slave;
          if there is a slave, the server sends UpdateDurable() instead. */
-      UpdateSemiDurable = 2005;
+      UpdateSemiDurable = 2005,
+
+      /* Notify(TNotifications notifications) -> void;
+         Delivers a batch of the notifications above, in the order the session raised them.  Returning acknowledges every
+         notification in the batch, as well as every one sent before it.  The server keeps a limited number of
+         notifications unacknowledged at a time, and it batches whatever piles up while it waits. */
+      Notify = 2006;
+
+    /* The argument to Notify().  Each element is the id of the entry the notification stands for (PovFailed through
+       UpdateSemiDurable), a pov id, and a tracking id.  PovFailed notifications have no tracking id, so theirs is zero. */
+    using TNotifications = std::vector<std::tuple<Rpc::TEntryId, Base::TUuid, Base::TUuid>>;
 
   }  // Orly::ClientRpc
 
@@ -41,3 +41,12 @@ const TMetaRecord::TEntry &TMetaRecord::GetEntry(const TUuid &id) const {
   assert(iter != EntryByUpdateId.end());
   return iter->second;
 }
+
+TMetaRecord::TSessionIdByUpdateId TMetaRecord::GetSessionIdByUpdateId() const {
+  assert(this);
+  TSessionIdByUpdateId session_id_by_update_id;
+  for (const auto &item: EntryByUpdateId) {
+    session_id_by_update_id.insert(make_pair(item.first, item.second.GetSessionId()));
+  }
+  return session_id_by_update_id;
+}
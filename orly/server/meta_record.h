@@ -130,6 +130,10 @@ namespace Orly {
       /* TODO */
       using TEntryByUpdateId = std::map<Base::TUuid, TEntry>;
 
+      /* The global pov doesn't keep whole meta records, only the ids of the sessions to notify.  An update promoted on its
+         own carries just its session id; a collapsed one carries this, the originating session of each update in it. */
+      using TSessionIdByUpdateId = std::map<Base::TUuid, Base::TUuid>;
+
       /* TODO */
       TMetaRecord() {}
 
@@ -138,6 +142,10 @@ namespace Orly {
         EntryByUpdateId.insert(std::make_pair(update_id, std::forward<TEntry>(entry)));
       }
 
+      /* The metadata of several updates collapsed into one. */
+      explicit TMetaRecord(TEntryByUpdateId &&entry_by_update_id)
+          : EntryByUpdateId(std::move(entry_by_update_id)) {}
+
       /* TODO */
       const TEntry &GetEntry(const Base::TUuid &id) const;
 
@@ -147,6 +155,9 @@ namespace Orly {
         return EntryByUpdateId;
       }
 
+      /* The session id of each of our entries, as the global pov keeps them. */
+      TSessionIdByUpdateId GetSessionIdByUpdateId() const;
+
       private:
 
       /* TODO */
@@ -18,6 +18,7 @@
 
 #include <orly/server/repo_tetris_manager.h>
 
+#include <algorithm>
 #include <vector>
 
 #include <orly/mynde/protocol.h> // For Mynde::PackageName
@@ -39,7 +40,8 @@ TRepoTetrisManager::TRepoTetrisManager(
     Indy::TManager *repo_manager,
     Package::TManager *package_manager,
     Durable::TManager *durable_manager,
-    bool log_assertion_failures)
+    bool log_assertion_failures,
+    size_t max_batch_size)
     : TTetrisManager(scheduler, runner_cons, frame_pool_manager, runner_setup_cb, is_master),
       PushCount(0UL),
       PopCount(0UL),
@@ -48,10 +50,12 @@ TRepoTetrisManager::TRepoTetrisManager(
       RepoManager(repo_manager),
       PackageManager(package_manager),
       DurableManager(durable_manager),
-      LogAssertionFailures(log_assertion_failures) {
+      LogAssertionFailures(log_assertion_failures),
+      MaxBatchSize(max_batch_size) {
   assert(repo_manager);
   assert(package_manager);
   assert(durable_manager);
+  assert(max_batch_size);
 }
 
 TRepoTetrisManager::~TRepoTetrisManager() {
@@ -74,30 +78,102 @@ TRepoTetrisManager::TPlayer::~TPlayer() {
   }
 }
 
+void TRepoTetrisManager::TPlayer::TRound::Add(const shared_ptr<TUpdate> &update, const TMetaRecord &meta_record) {
+  assert(this);
+  assert(update);
+  assert(&meta_record);
+  Updates.push_back(update);
+  for (const auto &item: meta_record.GetEntryByUpdateId()) {
+    EntryByUpdateId.insert(item);
+  }
+  for (TUpdate::TEntryCollection::TCursor csr(update->GetEntryCollection()); csr; ++csr) {
+    const TIndexKey &index_key = csr->GetIndexKey();
+    KeyHashes.insert(index_key.GetHash());
+    IndexIds.insert(index_key.GetIndexId());
+  }
+}
+
+shared_ptr<TUpdate> TRepoTetrisManager::TPlayer::TRound::NewUpdate(bool to_global) {
+  assert(this);
+  assert(!Updates.empty());
+  Atom::TSuprena arena;
+  void *state_alloc_1 = alloca(Sabot::State::GetMaxStateSize());
+  void *state_alloc_2 = alloca(Sabot::State::GetMaxStateSize());
+  TKey metadata;
+  if (!to_global) {
+    if (Updates.size() == 1) {
+      return Updates.front();
+    }
+    metadata = TKey(TMetaRecord(TMetaRecord::TEntryByUpdateId(EntryByUpdateId)), &arena, state_alloc_1);
+  } else if (EntryByUpdateId.size() == 1) {
+    metadata = TKey(EntryByUpdateId.begin()->second.GetSessionId(), &arena, state_alloc_1);
+  } else {
+    metadata = TKey(TMetaRecord(TMetaRecord::TEntryByUpdateId(EntryByUpdateId)).GetSessionIdByUpdateId(), &arena, state_alloc_1);
+  }
+  if (Updates.size() == 1) {
+    Updates.front()->SetMetadata(metadata);
+    return Updates.front();
+  }
+  /* Overlaps() keeps any two updates in a round from writing the same key, so the order we merge them in doesn't
+     matter. */
+  TUpdate::TOpByKey op_by_key;
+  for (const auto &update: Updates) {
+    for (TUpdate::TEntryCollection::TCursor csr(update->GetEntryCollection()); csr; ++csr) {
+      op_by_key.insert(make_pair(csr->GetIndexKey(), TKey(csr->GetOp(), &update->GetSuprena())));
+    }
+  }
+  return TUpdate::NewUpdate(op_by_key, metadata, TKey(TUuid(TUuid::Twister), &arena, state_alloc_2));
+}
+
+bool TRepoTetrisManager::TPlayer::TRound::Overlaps(const TContext::TReadLog &read_log, const TUpdate &update) const {
+  assert(this);
+  assert(&read_log);
+  assert(&update);
+  if (KeyHashes.empty()) {
+    return false;
+  }
+  for (const auto &index_id: read_log.IndexIds) {
+    if (IndexIds.count(index_id)) {
+      return true;
+    }
+  }
+  for (size_t key_hash: read_log.KeyHashes) {
+    if (KeyHashes.count(key_hash)) {
+      return true;
+    }
+  }
+  for (TUpdate::TEntryCollection::TCursor csr(update.GetEntryCollection()); csr; ++csr) {
+    if (KeyHashes.count(csr->GetIndexKey().GetHash())) {
+      return true;
+    }
+  }
+  return false;
+}
+
 TRepoTetrisManager::TPlayer::TChild::TChild(TPlayer *player, const TUuid &child_pov_id)
     : Player(player), Age(0), FailureCount(0) {
   Repo = player->RepoTetrisManager->RepoManager->ForceGetRepo(child_pov_id);
 }
 
 bool TRepoTetrisManager::TPlayer::TChild::Play(
-    const unique_ptr<Indy::L1::TTransaction, function<void (Indy::L1::TTransaction *)>> &transaction, Indy::TContext &context) {
+    const unique_ptr<Indy::L1::TTransaction, function<void (Indy::L1::TTransaction *)>> &transaction, Indy::TContext &context,
+    const Indy::TContext::TReadLog &read_log, TRound &round) {
   assert(this);
   assert(transaction);
-  bool success = TestAssertions(context);
+  assert(&round);
+  /* Our assertions are deterministic, so if they failed last time and nothing they could read has changed since, don't
+     bother testing them again. */
+  vector<TSequenceNumber> tree_seq_numbers;
+  GetTreeSequenceNumbers(tree_seq_numbers);
+  bool is_stale = FailureCount && tree_seq_numbers == FailedAt;
+  bool success = !is_stale && TestAssertions(context);
+  if (success && round.Overlaps(read_log, *PeekedUpdate)) {
+    /* Our assertions held, but against a state which doesn't include this round's earlier promotions.  Sit this round
+       out without counting it as a failure; we'll be older, and so earlier in line, next time. */
+    return false;
+  }
   if (success) {
-    /* swap the metadata with just the session ids if we're pushing to global */
-    if (Player->Repo->GetId() == TSession::GlobalPovId) {
-      void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
-      if (FuncHolderByUpdateId.size() == 1) {
-        /* we're storing just a single session id. */
-        PeekedUpdate->SetMetadata(Indy::TKey(MetaRecord.GetEntry(FuncHolderByUpdateId.begin()->first).GetSessionId(), &PeekedUpdate->GetSuprena(), state_alloc));
-      } else {
-        throw std::runtime_error("We don't currently support collapsed updates.");
-      }
-    }
-    transaction->Push(Player->Repo, PeekedUpdate);
     transaction->Pop(Repo);
-    ++(Player->RepoTetrisManager->PushCount);
     ++(Player->RepoTetrisManager->PopCount);
     for (const auto &item: FuncHolderByUpdateId) {
       const auto &entry = MetaRecord.GetEntry(item.first);
@@ -114,10 +190,12 @@ bool TRepoTetrisManager::TPlayer::TChild::Play(
         session->InsertNotification(Notification::TUpdateProgress::New(Player->Repo->GetId(), item.first, Notification::TUpdateProgress::Accepted));
       }
     }
+    round.Add(PeekedUpdate, MetaRecord);
     Flush();
   } else {
     ++FailureCount;
-    if (FailureCount >= 10) {
+    FailedAt = move(tree_seq_numbers);
+    if (is_stale || FailureCount >= 10) {
       transaction->Fail(Repo);
       for (const auto &item: FuncHolderByUpdateId) {
         const auto &entry = MetaRecord.GetEntry(item.first);
@@ -142,6 +220,23 @@ bool TRepoTetrisManager::TPlayer::TChild::Play(
   return success;
 }
 
+void TRepoTetrisManager::TPlayer::TChild::GetTreeSequenceNumbers(vector<TSequenceNumber> &seq_numbers) const {
+  assert(this);
+  assert(&seq_numbers);
+  seq_numbers.clear();
+  Indy::L0::TManager::TPtr<Indy::L0::TManager::TRepo> cur_repo = Player->Repo;
+  seq_numbers.push_back(Player->Repo->GetNextSequenceNumber());
+  for (; cur_repo->GetParentRepo(); cur_repo = *cur_repo->GetParentRepo()) {
+    Indy::L0::TManager::TPtr<Indy::TRepo> parent = *cur_repo->GetParentRepo();
+    seq_numbers.push_back(parent->GetNextSequenceNumber());
+  }
+}
+
+bool TRepoTetrisManager::TPlayer::TChild::IsReady() const {
+  assert(this);
+  return PeekedUpdate || (Repo->GetStatus() == Orly::Indy::Normal && Repo->GetSequenceNumberStart());
+}
+
 bool TRepoTetrisManager::TPlayer::TChild::Refresh(const unique_ptr<Indy::L1::TTransaction, function<void (Indy::L1::TTransaction *)>> &transaction) {
   assert(this);
   assert(transaction);
@@ -293,10 +388,21 @@ void TRepoTetrisManager::TPlayer::OnUnpause() {
   assert(this);
 }
 
-void TRepoTetrisManager::TPlayer::Play() {
+bool TRepoTetrisManager::TPlayer::Play() {
   assert(this);
+  /* If none of our children has anything for us, skip the round without so much as beginning a transaction.  Arm our
+     repo first, so that any update which arrives after we look will wake us. */
+  Repo->ArmTetrisWake();
+  /* extra */ {
+    lock_guard<mutex> lock(Mutex);
+    if (none_of(ChildByPovId.begin(), ChildByPovId.end(), [](const pair<const TUuid, TChild *> &item) { return item.second->IsReady(); })) {
+      return false;
+    }
+  }
   Base::TCPUTimer snapshot_timer, sort_timer, play_timer, commit_timer;
   Atom::TSuprena my_arena;
+  size_t num_promoted = 0UL;
+  bool is_ready;
   try {
     /* Begin a transaction and make a vector of all our children who are ready to participate in it. */
     unique_ptr<Indy::L1::TTransaction, function<void (Indy::L1::TTransaction *)>> transaction = RepoTetrisManager->RepoManager->NewTransaction();
@@ -313,18 +419,30 @@ void TRepoTetrisManager::TPlayer::Play() {
       }
     }
     snapshot_timer.Stop();
+    is_ready = !children.empty();
     /* Sort by decreasing promote-ness. */
     sort_timer.Start();
     sort(children.begin(), children.end(), TChild::SortsBefore);
     sort_timer.Stop();
-    /* Give each child a chance to play.  At most one will be permitted to promote (for now), but any number might fail
-       due to age. */
+    /* Give each child a chance to play.  Every child whose assertions hold is promoted, up to the batch limit, so long as
+       it didn't read or write anything an earlier child in this round wrote; any number might fail due to age. */
     play_timer.Start();
     Indy::TContext context(Repo, &my_arena);
+    Indy::TContext::TReadLog read_log;
+    TRound round;
+    context.SetReadLog(&read_log);
     for (TChild *child: children) {
-      if (child->Play(transaction, context)) {
+      if (round.GetSize() >= RepoTetrisManager->MaxBatchSize) {
         break;
       }
+      read_log.Clear();
+      child->Play(transaction, context, read_log, round);
+    }
+    context.SetReadLog(nullptr);
+    num_promoted = round.GetSize();
+    if (num_promoted) {
+      transaction->Push(Repo, round.NewUpdate(Repo->GetId() == TSession::GlobalPovId));
+      ++(RepoTetrisManager->PushCount);
     }
     play_timer.Stop();
     /* Commit. */
@@ -343,6 +461,8 @@ void TRepoTetrisManager::TPlayer::Play() {
   RepoTetrisManager->TetrisSortCPUTime.Push(sort_timer.Total());
   RepoTetrisManager->TetrisPlayCPUTime.Push(play_timer.Total());
   RepoTetrisManager->TetrisCommitCPUTime.Push(commit_timer.Total());
+  RepoTetrisManager->TetrisPromotedPerRound.Push(num_promoted);
+  return is_ready;
 }
 
 TTetrisManager::TPlayer *TRepoTetrisManager::NewPlayer(const TUuid &parent_pov_id, const TUuid &child_pov_id, bool is_paused, bool is_master) {
@@ -22,6 +22,8 @@
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include <base/class_traits.h>
 #include <orly/indy/context.h>
@@ -50,7 +52,8 @@ namespace Orly {
           Indy::TManager *repo_manager,
           Package::TManager *package_manager,
           Durable::TManager *durable_manager,
-          bool log_assertion_failures);
+          bool log_assertion_failures,
+          size_t max_batch_size);
 
       /* TODO */
       virtual ~TRepoTetrisManager();
@@ -66,6 +69,7 @@ namespace Orly {
       Base::TSigmaCalc TetrisSortCPUTime;
       Base::TSigmaCalc TetrisPlayCPUTime;
       Base::TSigmaCalc TetrisCommitCPUTime;
+      Base::TSigmaCalc TetrisPromotedPerRound;
       std::mutex TetrisTimerLock;
 
       private:
@@ -83,6 +87,50 @@ namespace Orly {
 
         private:
 
+        /* The children promoted so far in a round.  A transaction can push only once to the parent, so their updates
+           are collapsed into one.  A child whose reads touch anything they wrote must wait for the next round, when it
+           will see those writes. */
+        class TRound {
+          NO_COPY(TRound);
+          public:
+
+          /* TODO */
+          TRound() {}
+
+          /* Add a promoted child's update, along with the metadata it carried from its own pov. */
+          void Add(const std::shared_ptr<Indy::TUpdate> &update, const TMetaRecord &meta_record);
+
+          /* The number of updates added. */
+          size_t GetSize() const {
+            assert(this);
+            return Updates.size();
+          }
+
+          /* The update to push to the parent: the only one added, or a new one collapsing all of them, carrying the
+             union of their metadata.  If the parent is the global pov, the metadata is cut down to session ids (see
+             TMetaRecord::TSessionIdByUpdateId).  There must be at least one. */
+          std::shared_ptr<Indy::TUpdate> NewUpdate(bool to_global);
+
+          /* True iff the given update would conflict with the ones added, either because it read something they wrote
+             or because it writes something they wrote. */
+          bool Overlaps(const Indy::TContext::TReadLog &read_log, const Indy::TUpdate &update) const;
+
+          private:
+
+          /* The updates added, in the order they were promoted. */
+          std::vector<std::shared_ptr<Indy::TUpdate>> Updates;
+
+          /* The metadata entries of the updates added. */
+          TMetaRecord::TEntryByUpdateId EntryByUpdateId;
+
+          /* The hashes of the index keys written. */
+          std::unordered_set<size_t> KeyHashes;
+
+          /* The ids of the indexes written. */
+          std::unordered_set<Base::TUuid> IndexIds;
+
+        };  // TRepoTetrisManager::TPlayer::TRound
+
         /* TODO */
         class TChild {
           NO_COPY(TChild);
@@ -91,9 +139,17 @@ namespace Orly {
           /* TODO */
           TChild(TPlayer *player, const Base::TUuid &child_pov_id);
 
-          /* TODO */
+          /* Test our assertions against the context and, if they hold and don't conflict with the children already
+             promoted this round, pop our update and add it to the round.  Return true iff we promoted.  The context must
+             be recording into the read log, which should be empty when we're called.
+             Our assertions are deterministic, so if they already failed against the parent as it now stands, we don't
+             test them again; we fail our update instead. */
           bool Play(
-              const std::unique_ptr<Indy::L1::TTransaction, std::function<void (Indy::L1::TTransaction *)>> &transaction, Indy::TContext &context);
+              const std::unique_ptr<Indy::L1::TTransaction, std::function<void (Indy::L1::TTransaction *)>> &transaction, Indy::TContext &context,
+              const Indy::TContext::TReadLog &read_log, TRound &round);
+
+          /* True iff we might have an update to offer, so it's worth beginning a round for us. */
+          bool IsReady() const;
 
           /* TODO */
           bool Refresh(const std::unique_ptr<Indy::L1::TTransaction, std::function<void (Indy::L1::TTransaction *)>> &transaction);
@@ -106,6 +162,10 @@ namespace Orly {
           /* TODO */
           void Flush();
 
+          /* Fill the vector with the next sequence number of every repo in our parent's tree, from our parent up to
+             the root.  Our assertions can read any of them. */
+          void GetTreeSequenceNumbers(std::vector<Indy::TSequenceNumber> &seq_numbers) const;
+
           /* TODO */
           bool TestAssertions(Indy::TContext &context) const;
 
@@ -118,6 +178,10 @@ namespace Orly {
           /* The number of times we have tested our assertions and failed. */
           size_t FailureCount;
 
+          /* The tree's sequence numbers, as filled in by GetTreeSequenceNumbers(), as of the last time our assertions
+             failed.  Meaningful only while FailureCount is non-zero. */
+          std::vector<Indy::TSequenceNumber> FailedAt;
+
           /* The repo which backs up this child pov. */
           Indy::L0::TManager::TPtr<Indy::TRepo> Repo;
 
@@ -144,8 +208,9 @@ namespace Orly {
         /* See TRepoTetrisManager::TPlayer. */
         virtual void OnUnpause() override;
 
-        /* See TRepoTetrisManager::TPlayer. */
-        virtual void Play() override;
+        /* See TRepoTetrisManager::TPlayer.  Return true iff any child had an update to offer, whether or not it was
+           promoted. */
+        virtual bool Play() override;
 
         /* Our manager.  Never null. */
         TRepoTetrisManager *RepoTetrisManager;
@@ -178,6 +243,9 @@ namespace Orly {
       /* TODO */
       bool LogAssertionFailures;
 
+      /* The most children a player will promote in a single round. */
+      const size_t MaxBatchSize;
+
     };  // TRepoTetrisManager
 
   }  // Server
@@ -18,18 +18,21 @@
 
 #include <orly/server/server.h>
 
-#include <poll.h>
+#include <deque>
+
 #include <sys/syscall.h>
 
 #include <base/booster.h>
+#include <base/epoll.h>
 #include <base/glob.h>
 #include <base/not_implemented.h>
 #include <gz/input_producer.h>
 #include <io/binary_input_only_stream.h>
 #include <io/binary_io_stream.h>
 #include <io/device.h>
-#include <orly/atom/core_vector.h>
+#include <orly/atom/core_vector_reader.h>
 #include <orly/indy/disk/durable_manager.h>
+#include <orly/indy/disk/util/bloom_filter.h>
 #include <orly/mynde/binary_protocol.h>
 #include <orly/mynde/protocol.h>
 #include <orly/mynde/value.h>
@@ -280,6 +283,14 @@ TServer::TCmd::TMeta::TMeta(const char *desc)
       &TCmd::NoRealtime, "no_realtime", Optional, "no_realtime\0",
       "Do not use realtime thread priorities (realtime priorities require root privileges)."
   );
+  Param(
+      &TCmd::UseIoUring, "use_io_uring", Optional, "use_io_uring\0",
+      "Drive the disks with io_uring instead of aio.  Falls back to aio if the kernel won't give us a ring."
+  );
+  Param(
+      &TCmd::IoUringSqPoll, "io_uring_sq_poll", Optional, "io_uring_sq_poll\0",
+      "With use_io_uring, have the kernel poll the submission queues so submitting I/O takes no system calls."
+  );
   Param(
       &TCmd::DoFsync, "do_fsync", Optional, "do_fsync\0",
       "Turn on / off use of fsync on disk writes that change server state."
@@ -288,6 +299,42 @@ TServer::TCmd::TMeta::TMeta(const char *desc)
       &TCmd::LogAssertionFailures, "log_assertion_failures", Optional, "laf\0",
       "Log tetris assertion failures to LOG_INFO."
   );
+  Param(
+      &TCmd::TetrisMaxBatchSize, "tetris_max_batch_size", Optional, "tetris_max_batch_size\0",
+      "The most non-conflicting children tetris will promote into a parent in a single round."
+  );
+  Param(
+      &TCmd::NotificationWindow, "notification_window", Optional, "notification_window\0",
+      "The most notifications we'll push to a client before it acks any of them."
+  );
+  Param(
+      &TCmd::RowCacheSize, "row_cache_size", Optional, "row_cache_size\0",
+      "The most point reads to cache for the global pov.  Zero turns the cache off."
+  );
+  Param(
+      &TCmd::RpcMaxWriteDelay, "rpc_max_write_delay", Optional, "rpc_max_write_delay\0",
+      "The longest, in microseconds, a connection may hold a reply unsent while it coalesces replies.  Zero turns "
+      "coalescing off."
+  );
+  Param(
+      &TCmd::CompactionPolicy, "compaction_policy", Optional, "compaction_policy\0",
+      "How safe repos choose the disk layers to merge.  Either tiered, which merges layers of like size, or leveled, "
+      "which bounds the number of layers a read must look in, at the cost of more writing."
+  );
+  Param(
+      &TCmd::CompactionFilesPerLevel, "compaction_files_per_level", Optional, "compaction_files_per_level\0",
+      "The most disk layers the leveled compaction policy keeps in each level."
+  );
+  Param(
+      &TCmd::ImportRunSize, "import_run_size", Optional, "import_run_size\0",
+      "The most key/value pairs each of the importer's load threads holds in memory before it sorts them and writes "
+      "them out as a data file."
+  );
+  Param(
+      &TCmd::ImportSpoolDir, "import_spool_dir", Optional, "import_spool_dir\0",
+      "The directory in which the importer spools the notes of the files it reads.  It should be on disk, not tmpfs, "
+      "which is why it defaults to /var/tmp."
+  );
 
   /******** Object Pools ********/
 
@@ -407,8 +454,18 @@ TServer::TCmd::TCmd()
       AllowTailing(true),
       AllowFileSync(true),
       NoRealtime(false),
+      UseIoUring(false),
+      IoUringSqPoll(false),
       DoFsync(true),
       LogAssertionFailures(true),
+      TetrisMaxBatchSize(256UL),
+      NotificationWindow(1024UL),
+      RowCacheSize(100000UL),
+      RpcMaxWriteDelay(0UL),
+      CompactionPolicy("tiered"),
+      CompactionFilesPerLevel(4UL),
+      ImportRunSize(1000000UL),
+      ImportSpoolDir("/var/tmp"),
       DurableMappingPoolSize(1000UL),
       DurableMappingEntryPoolSize(10000UL),
       DurableLayerPoolSize(2000UL),
@@ -883,7 +940,9 @@ void TServer::Init() {
           8 /* num block lru */,
           Cmd.FileServiceAppendLogMB,
           Cmd.Create,
-          Cmd.NoRealtime);
+          Cmd.NoRealtime,
+          Cmd.UseIoUring ? Disk::Util::TDiskController::TIoEngine::IoUring : Disk::Util::TDiskController::TIoEngine::Aio,
+          Cmd.IoUringSqPoll);
       engine_ptr = DiskEngine->GetEngine();
     }
     assert(engine_ptr);
@@ -937,6 +996,10 @@ void TServer::Init() {
                                                     Cmd.MemMergeCoreVec,
                                                     Cmd.DiskMergeCoreVec,
                                                     Cmd.Create);
+    if (Cmd.RowCacheSize) {
+      RowCache = make_unique<Indy::TRowCache>(Cmd.RowCacheSize);
+      RepoManager->SetRowCache(RowCache.get());
+    }
     auto global_ttl = TTtl::max();
     GlobalRepo = RepoManager->GetRepo(TSession::GlobalPovId,
                                       global_ttl,
@@ -1036,7 +1099,7 @@ void TServer::Init() {
       Disk::TLocalWalkerCache::Cache = new Disk::TLocalWalkerCache();
     };
 
-    TetrisManager = new TRepoTetrisManager(Scheduler, RunnerCons, FramePoolManager.get(), tetris_runner_setup_cb, (RepoState == Orly::Indy::TManager::Solo), RepoManager.get(), &PackageManager, DurableManager.get(), Cmd.LogAssertionFailures);
+    TetrisManager = new TRepoTetrisManager(Scheduler, RunnerCons, FramePoolManager.get(), tetris_runner_setup_cb, (RepoState == Orly::Indy::TManager::Solo), RepoManager.get(), &PackageManager, DurableManager.get(), Cmd.LogAssertionFailures, Cmd.TetrisMaxBatchSize);
     RepoManager->SetTetrisManager(TetrisManager);
     /* schedule everything the repo manager needs */ {
       /* Read() from master / slave */ {
@@ -1098,10 +1161,17 @@ void TServer::Init() {
         MergeMemFrameVec.emplace_back(frame);
         //Scheduler->Schedule(bind(&Orly::Indy::L0::TManager::RunMergeMem, RepoManager.get()));
       }
-      /* Merge multiple disk files of a specific size category, in the same safe repo. */
+      /* Merge multiple disk files of a specific size category, in the same safe repo.  Each merge spreads its per-source
+         work (two jobs per source file at a time) over all the merge runners, so they must all exist before any merge
+         starts. */
+      std::vector<Fiber::TRunner *> merge_disk_runners;
       for (size_t i = 0; i < Cmd.NumDiskMergeThreads; ++i) {
         MergeDiskRunnerVec.emplace_back(new Fiber::TRunner(RunnerCons));
-        Fiber::TRunner *cur_runner = MergeDiskRunnerVec.back().get();
+        merge_disk_runners.push_back(MergeDiskRunnerVec.back().get());
+      }
+      RepoManager->SetMergeDiskRunners(merge_disk_runners);
+      RepoManager->SetCompactionPolicy(Indy::TCompactionPolicy::New(Cmd.CompactionPolicy, Cmd.CompactionFilesPerLevel));
+      for (Fiber::TRunner *cur_runner: merge_disk_runners) {
         Scheduler->Schedule(std::bind(Fiber::LaunchSlowFiberSched, cur_runner, FramePoolManager.get()));
         Fiber::TFrame *frame = Fiber::TFrame::LocalFramePool->Alloc();
         try {
@@ -1320,83 +1390,172 @@ void TServer::TSessionPin::UnpausePov(const Base::TUuid &pov_id) const {
   Conn->RunWs(Indy::Fiber::TJumpRunnable(bind(&TConnection::UnpausePov, Conn.get(), cref(pov_id))));
 }
 
-void TServer::TConnection::Run(TFd &fd) {
-  /* We use this visitor to push notifications. */
+/* Once a client has this much of our output backed up, we stop reading its requests until it catches up. */
+static const size_t MaxClientBacklogSize = 1024UL * 1024UL;
+
+void TServer::TConnection::Start(TFd &fd) {
+  assert(this);
+  assert(&fd);
+  /* Install the socket as our RPC device.  When it runs dry mid-message, it parks us in the reactor rather than
+     blocking.  Writes never block: whatever the socket won't take waits in the device's backlog, and we flush it when
+     the socket has room.  So a client who stops reading holds up no one but itself, and once its backlog is big
+     enough, we stop reading its requests, too, until it catches up. */
+  Device = make_shared<TDevice>(move(fd));
+  const int client_fd = Device->GetFd();
+  Epoll.Add(client_fd);
+  Device->SetWaitForInput([this](int fd) { Server->ClientReactor.Wait(fd); });
+  Device->SetOnBacklog([this, client_fd](size_t backlog_size) {
+    int flags = EPOLLIN;
+    if (backlog_size) {
+      flags = (backlog_size < MaxClientBacklogSize) ? (EPOLLIN | EPOLLOUT) : EPOLLOUT;
+    }
+    Epoll.Modify(client_fd, flags);
+  });
+  BinaryIoStream = make_shared<TBinaryIoStream>(Device);
+  SetMaxWriteDelay(microseconds(Server->Cmd.RpcMaxWriteDelay));
+  Serve();
+}
+
+void TServer::TConnection::Serve() {
+  /* We use this visitor to add notifications to the batch we're about to push. */
   class visitor_t : public Notification::Single::TComputer<void> {
     public:
-    visitor_t(TConnection *connection, shared_ptr<TFuture<void>> &ack) : Connection(connection), Ack(ack) {}
+    visitor_t(ClientRpc::TNotifications &notifications) : Notifications(notifications) {}
     virtual void operator()(const Notification::TPovFailure &that) const override {
-      Ack = Connection->Write<void>(ClientRpc::PovFailed, that.GetPovId());
+      Notifications.emplace_back(ClientRpc::PovFailed, that.GetPovId(), TUuid());
     }
     virtual void operator()(const Notification::TSystemShutdown &/*that*/) const override {
       throw runtime_error("Not Implemented: TSystemShutdown notification.");
     }
     virtual void operator()(const Notification::TUpdateProgress &that) const override {
+      TEntryId entry_id = 0;
       switch (that.GetResponse()) {
         case Notification::TUpdateProgress::Accepted: {
-          Ack = Connection->Write<void>(ClientRpc::UpdateAccepted, that.GetPovId(), that.GetUpdateId());
+          entry_id = ClientRpc::UpdateAccepted;
           break;
         }
         case Notification::TUpdateProgress::Replicated: {
-          Ack = Connection->Write<void>(ClientRpc::UpdateReplicated, that.GetPovId(), that.GetUpdateId());
+          entry_id = ClientRpc::UpdateReplicated;
           break;
         }
         case Notification::TUpdateProgress::SemiDurable: {
-          Ack = Connection->Write<void>(ClientRpc::UpdateDurable, that.GetPovId(), that.GetUpdateId());
+          entry_id = ClientRpc::UpdateSemiDurable;
           break;
         }
         case Notification::TUpdateProgress::Durable: {
-          Ack = Connection->Write<void>(ClientRpc::UpdateSemiDurable, that.GetPovId(), that.GetUpdateId());
+          entry_id = ClientRpc::UpdateDurable;
           break;
         }
       }
+      Notifications.emplace_back(entry_id, that.GetPovId(), that.GetUpdateId());
     }
     private:
-    TConnection *Connection;
-    shared_ptr<TFuture<void>> &Ack;
+    ClientRpc::TNotifications &Notifications;
   };
   assert(this);
-  assert(&fd);
-  /* Install the socket as our RPC device. */
-  auto device = make_shared<TDevice>(move(fd));
-  BinaryIoStream = make_shared<TBinaryIoStream>(device);
-  /* In our serving loop, we'll wake up for two things:
-       (1) the client sending us a message or
-       (2) the session having a notification to send OR the client ack'ing the last notification we sent.
-     We'll use a pair of poll objects to handle this.  The first is always connected to the client.  The
-     second is either connected to the session's notification queue or to the future representing the client's
-     ack. */
-  pollfd polls[2];
-  for (size_t i = 0; i < 2; ++i) {
-    polls[i].events = POLLIN;
-  }
-  polls[0].fd = device->GetFd();
-  shared_ptr<TFuture<void>> ack;
-  uint32_t seq_number;
-  /* Loop until the client hangs up or times out. */
+  /* We wake up for four things:
+       (1) the client sending us a message,
+       (2) the client's socket having room for our backlog, if we have one,
+       (3) the client ack'ing the oldest batch we haven't heard back on, or
+       (4) the session having a new notification to send, if our window has room for it.
+     We keep them all in our epoll.  The first two are the client's socket, the third is the future representing the
+     client's ack, and the fourth is the session's new-notification counter.  When none is ready, we arm the epoll's fd
+     in the server's reactor and return, giving up our frame, so an idle connection costs neither runner time nor a
+     frame.
+     We push notifications in batches, keeping up to NotificationWindow of them unacked at a time, in as many batches as
+     it takes.  Whatever the session raises while the window is full goes out once an ack makes room, so a busy session
+     costs a round trip per batch rather than per notification. */
+  const int client_fd = Device->GetFd();
+  const size_t window = max<size_t>(Server->Cmd.NotificationWindow, 1UL);
+  vector<pair<uint32_t, const Notification::TNotification *>> pending;
+  ClientRpc::TNotifications notifications;
+  /* Loop until there's nothing to do or until the client hangs up or times out. */
   try {
     for (;;) {
-      /* Wait for something to happen. */
-      polls[1].fd = ack ? ack->GetEventFd() : GetSession()->GetNotificationSem().GetFd();
-      int result = poll(polls, 2, /*Server->Cmd.IdleConnectionTimeout*/ -1);
-      if (result < 0) {
-        ThrowSystemError(errno);
+      /* Push whatever's pending, as far as our window allows.  Pop the session's counter before we look, so anything
+         that arrives after we've looked wakes us again. */
+      if (UnackedCount < window) {
+        auto &new_notification_counter = GetSession()->GetNewNotificationCounter();
+        if (new_notification_counter.GetFd().IsReadable()) {
+          new_notification_counter.Pop();
+        }
+        pending.clear();
+        if (GetSession()->GetNotificationsAfter(LastSentSeqNumber, window - UnackedCount, pending)) {
+          notifications.clear();
+          for (const auto &item: pending) {
+            item.second->Accept(visitor_t(notifications));
+          }
+          LastSentSeqNumber = pending.back().first;
+          Unacked.push_back(TUnacked{ Write<void>(ClientRpc::Notify, notifications), LastSentSeqNumber, pending.size() });
+          UnackedCount += pending.size();
+        }
       }
-      if (!result) {
-        /* We timed out. */
-        break;
+      /* Watch for the ack of our oldest batch, if we have one, and, while our window has room, for new notifications,
+         so that batches keep going out while earlier ones are still in flight. */
+      const int ack_fd = Unacked.empty() ? -1 : static_cast<int>(Unacked.front().Ack->GetEventFd());
+      if (ack_fd != AckFd) {
+        if (AckFd >= 0) {
+          Epoll.Remove(AckFd);
+        }
+        AckFd = ack_fd;
+        if (AckFd >= 0) {
+          Epoll.Add(AckFd);
+        }
       }
-      if (polls[1].revents) {
-        if (ack) {
-          /* The client ack'd our last push. */
-          GetSession()->RemoveNotification(seq_number);
-          ack.reset();
+      const bool is_waiting_for_new = UnackedCount < window;
+      if (is_waiting_for_new != IsWaitingForNew) {
+        const int new_fd = GetSession()->GetNewNotificationCounter().GetFd();
+        if (is_waiting_for_new) {
+          Epoll.Add(new_fd);
         } else {
-          /* The session has a notification for us to push. */
-          GetSession()->GetFirstNotification(seq_number)->Accept(visitor_t(this, ack));
+          Epoll.Remove(new_fd);
         }
+        IsWaitingForNew = is_waiting_for_new;
       }
-      if (polls[0].revents) {
+      /* See if anything has happened. */
+      size_t event_count = Epoll.Wait(3, 0);
+      if (!event_count) {
+        /* Nothing has, so park.  The reactor calls back on its own thread, where all we do is launch ourselves in a
+           fresh frame.  Until then, the callback holds the only reference to us we can be sure of. */
+        auto connection = static_pointer_cast<TConnection>(shared_from_this());
+        Server->ClientReactor.OnReady(Epoll.GetFd(), [connection] {
+          try {
+            if (!Fiber::TFrame::LocalFramePool) {
+              Fiber::TFrame::LocalFramePool = new TThreadLocalGlobalPoolManager<Fiber::TFrame, size_t, Fiber::TRunner *>::TThreadLocalPool(connection->Server->FramePoolManager.get());
+            }
+            size_t prev_assignment_count = std::atomic_fetch_add(&connection->Server->SlowAssignmentCounter, 1UL);
+            new TServeRunnable(connection->Server->SlowRunnerVec[prev_assignment_count % connection->Server->SlowRunnerVec.size()].get(), connection);
+          } catch (const exception &ex) {
+            syslog(LOG_ERR, "closing connection; can't resume serving it; %s", ex.what());
+          }
+        });
+        return;
+      }
+      bool client_ready = false, client_writable = false, ack_ready = false;
+      for (size_t i = 0; i < event_count; ++i) {
+        int fd, flags;
+        Epoll.GetEvent(i, fd, flags);
+        if (fd == client_fd) {
+          client_writable = (flags & EPOLLOUT) != 0;
+          client_ready = (flags & ~EPOLLOUT) != 0;
+        } else if (fd == AckFd) {
+          ack_ready = true;
+        }
+      }
+      if (client_writable) {
+        Device->FlushBacklog();
+      }
+      if (ack_ready) {
+        /* The client ack'd our oldest batch, and so everything before it.  The ack's fd closes with it, so take it out
+           of the epoll first. */
+        GetSession()->RemoveNotificationsThrough(Unacked.front().LastSeqNumber);
+        UnackedCount -= Unacked.front().Size;
+        Epoll.Remove(AckFd);
+        AckFd = -1;
+        Unacked.pop_front();
+      }
+      /* If it was a new notification that woke us, we'll push at the top of the loop. */
+      if (client_ready) {
         /* Loop until we've pulled all the incoming messages. */
         do {
           auto request = Read();
@@ -1421,7 +1580,6 @@ void TServer::TConnection::Run(TFd &fd) {
   }
 }
 
-
 shared_ptr<TServer::TConnection> TServer::TConnection::New(TServer *server, const Durable::TPtr<TSession> &session) {
   assert(server);
   assert(&session);
@@ -1462,6 +1620,7 @@ TServer::TConnection::TProtocol::TProtocol() {
   Register<TConnection, void, TUuid, seconds>(ServerRpc::SetTimeToLive, &TConnection::SetTimeToLive);
   Register<TConnection, TMethodResult, TUuid, vector<string>, TClosure>(ServerRpc::Try, &TConnection::Try);
   Register<TConnection, TMethodResult, TUuid, vector<string>, TClosure>(ServerRpc::TryTracked, &TConnection::TryTracked);
+  Register<TConnection, vector<TMethodResult>, vector<TMethodRequest>>(ServerRpc::TryMany, &TConnection::TryMany);
   Register<TConnection, TMethodResult, TUuid, vector<string>, TClosure, TUuid>(ServerRpc::DoInPast, &TConnection::DoInPast);
   Register<TConnection, void>(ServerRpc::BeginImport, &TConnection::BeginImport);
   Register<TConnection, void>(ServerRpc::EndImport, &TConnection::EndImport);
@@ -1470,7 +1629,14 @@ TServer::TConnection::TProtocol::TProtocol() {
 }
 
 TServer::TConnection::TConnection(TServer *server, const Durable::TPtr<TSession> &session)
-    : Rpc::TContext(TProtocol::Protocol), Server(server), Session(session) {}
+    : Rpc::TContext(TProtocol::Protocol), Server(server), Session(session), AckFd(-1), IsWaitingForNew(false),
+      UnackedCount(0), LastSentSeqNumber(0) {}
+
+TServer::TConnection::~TConnection() {
+  assert(this);
+  /* Our stream flushes as it goes, which can add to our device's backlog, which touches our epoll. */
+  BinaryIoStream.reset();
+}
 
 void TServer::TConnection::OnRelease(TConnection *connection) {
   assert(connection);
@@ -1556,7 +1722,8 @@ void TServer::TailGlobalPov() {
 
 string TServer::ImportCoreVector(const string &file_pattern, int64_t num_load_threads, int64_t num_merge_threads, int64_t merge_simultaneous_in) {
   /* these are the proposed steps:
-      1. write out all the data files in parallel to the file system, keeping track of them locally. They are not yet in the repo system
+      1. stream in all the import files in parallel, writing each out to the file system as sorted runs of at most Cmd.ImportRunSize
+         key/value pairs, keeping track of them locally. They are not yet in the repo system
       2. merge all our generated files from the file system iteratively till we have 1 file
       3. insert that 1 file into our repo system
      */
@@ -1633,7 +1800,6 @@ string TServer::ImportCoreVector(const string &file_pattern, int64_t num_load_th
         return;
       } else {
         string ext = File.substr(last_dot, File.size());
-        string usable_file;
         std::shared_ptr<Io::TInputProducer> producer;
         if (ext == string(".gz")) {
           producer = make_shared<Gz::TInputProducer>(File.c_str(), "r");
@@ -1643,39 +1809,65 @@ string TServer::ImportCoreVector(const string &file_pattern, int64_t num_load_th
           syslog(LOG_ERR, "Invalid import file [%s]", File.c_str());
           return;
         }
-        TMemoryLayer *mem_layer = new TMemoryLayer(Server->RepoManager.get());
+        auto global_repo = Server->GetGlobalRepo();
+        /* The data files we've written, one per sorted run, in sequence number order. */
+        std::vector<size_t> run_gen_id_vec;
+        /* The run we're collecting, if any, and the number of entries in it. */
+        TMemoryLayer *mem_layer = nullptr;
+        size_t num_run_entries = 0UL;
+        /* Sort the run we've been collecting and write it to disk in the global repo.  It stays out of the repo's
+           mapping; the merge phase below picks it up. */
+        auto write_run = [this, &global_repo, &run_gen_id_vec, &mem_layer, &num_run_entries]() {
+          std::vector<TUpdate::TEntry *> entry_vec;
+          entry_vec.reserve(num_run_entries);
+          for (TMemoryLayer::TUpdateCollection::TCursor update_csr(mem_layer->GetUpdateCollection()); update_csr; ++update_csr) {
+            for (TUpdate::TEntryCollection::TCursor entry_csr(update_csr->GetEntryCollection()); entry_csr; ++entry_csr) {
+              entry_vec.push_back(&*entry_csr);
+            }
+          }
+          std::sort(entry_vec.begin(), entry_vec.end(), [](const TUpdate::TEntry *lhs, const TUpdate::TEntry *rhs) {
+            return TMemoryLayer::TEntryOrder()(*lhs, *rhs);
+          });
+          for (auto entry : entry_vec) {
+            mem_layer->ImporterAppendEntry(entry);
+          }
+          size_t num_keys = 0UL;
+          TSequenceNumber saved_low_seq = 0UL, saved_high_seq = 0UL;
+          run_gen_id_vec.push_back(global_repo->WriteFile(mem_layer, StorageSpeed, saved_low_seq, saved_high_seq, num_keys, 0UL));
+          delete mem_layer;
+          mem_layer = nullptr;
+          num_run_entries = 0UL;
+        };
         try {
-          size_t num_entry_inserted = 0UL;
-          auto entry_sort_func = [](const TUpdate::TEntry *lhs, const TUpdate::TEntry *rhs) {
-            return lhs->GetEntryKey() <= rhs->GetEntryKey();
-          };
           /* read file */ {
             Io::TBinaryInputOnlyStream strm(producer);
-            Atom::TCoreVector core_vec(strm);
-            const vector<Atom::TCore> &cores_read = core_vec.GetCores();
-            if (cores_read.size() < 2) {
-              syslog(LOG_ERR, "Invalid import file [%s], must have number of transactions followed by file metadata", usable_file.c_str());
+            const string spool_template = Server->Cmd.ImportSpoolDir + "/orly_import_XXXXXX.tmp";
+            Atom::TCoreVectorReader reader(strm, spool_template.c_str());
+            if (reader.GetSize() < 2) {
+              syslog(LOG_ERR, "Invalid import file [%s], must have number of transactions followed by file metadata", File.c_str());
               return;
             }
+            Atom::TCore core;
+            auto read_core = [&reader, &core]() -> const Atom::TCore & {
+              if (!reader.TryRead(core)) {
+                syslog(LOG_ERR, "core vec size [%ld] exhausted", reader.GetSize());
+                throw std::runtime_error("core vector file corrupt");
+              }
+              return core;
+            };
 
             void *lhs_state_alloc = alloca(Sabot::State::GetMaxStateSize());
             void *rhs_state_alloc = alloca(Sabot::State::GetMaxStateSize());
             int64_t num_transactions;
-            Sabot::ToNative(*Sabot::State::TAny::TWrapper(cores_read[0].NewState(core_vec.GetArena(), lhs_state_alloc)), num_transactions);
+            Sabot::ToNative(*Sabot::State::TAny::TWrapper(read_core().NewState(reader.GetArena(), lhs_state_alloc)), num_transactions);
             syslog(LOG_INFO, "Importing [%ld] transactions from core vector file [%s]", num_transactions, File.c_str());
 
             if (!Server->TetrisManager->IsPlayerPaused(TSession::GlobalPovId)) {
               throw runtime_error("please call BeginImport() before attempting to import image files");
             }
 
-            size_t pos_in_vec = 2UL; /* start at the first transaction (skipping the metadata) */
-
-            auto check_pos = [&cores_read](size_t pos) {
-              if (pos >= cores_read.size()) {
-                syslog(LOG_ERR, "pos = [%ld], core vec size [%ld]", pos, cores_read.size());
-                throw std::runtime_error("core vector file corrupt");
-              }
-            };
+            /* skip the metadata */
+            read_core();
 
             Base::TUuid tx_id;
             Base::TUuid index_id;
@@ -1683,39 +1875,26 @@ string TServer::ImportCoreVector(const string &file_pattern, int64_t num_load_th
               Atom::TSuprena arena;
               TUpdate::TOpByKey op_by_key;
               /* transaction id */
-              check_pos(pos_in_vec);
-              Sabot::ToNative(*Sabot::State::TAny::TWrapper(cores_read[pos_in_vec].NewState(core_vec.GetArena(), lhs_state_alloc)), tx_id);
-              ++pos_in_vec;
+              Sabot::ToNative(*Sabot::State::TAny::TWrapper(read_core().NewState(reader.GetArena(), lhs_state_alloc)), tx_id);
               /* transaction metadata */
-              check_pos(pos_in_vec);
-              TKey tx_meta(cores_read[pos_in_vec], core_vec.GetArena());
-              ++pos_in_vec;
+              TKey tx_meta(read_core(), reader.GetArena());
               /* num kv pairs in transaction */
-              check_pos(pos_in_vec);
               int64_t num_kv;
-              Sabot::ToNative(*Sabot::State::TAny::TWrapper(cores_read[pos_in_vec].NewState(core_vec.GetArena(), lhs_state_alloc)), num_kv);
+              Sabot::ToNative(*Sabot::State::TAny::TWrapper(read_core().NewState(reader.GetArena(), lhs_state_alloc)), num_kv);
               assert(num_kv > 0);
-              ++pos_in_vec;
               /* for n kv pairs in transaction */
               for (int64_t n = 0; n < num_kv; ++n) {
-                check_pos(pos_in_vec);
-                Sabot::ToNative(*Sabot::State::TAny::TWrapper(cores_read[pos_in_vec].NewState(core_vec.GetArena(), lhs_state_alloc)), index_id);
-                ++pos_in_vec;
-
-                check_pos(pos_in_vec);
-                check_pos(pos_in_vec + 1);
+                Sabot::ToNative(*Sabot::State::TAny::TWrapper(read_core().NewState(reader.GetArena(), lhs_state_alloc)), index_id);
+                TKey key(read_core(), reader.GetArena());
+                TKey val(read_core(), reader.GetArena());
 
                 auto remap_pos = index_id_remapper.find(index_id);
                 if (remap_pos != index_id_remapper.end()) {
-                  TKey key(cores_read[pos_in_vec], core_vec.GetArena());
-                  TKey val(cores_read[pos_in_vec + 1], core_vec.GetArena());
                   op_by_key[TIndexKey(remap_pos->second, key)] = val;
                 } else {
-                  TKey key(cores_read[pos_in_vec], core_vec.GetArena());
-                  TKey val(cores_read[pos_in_vec + 1], core_vec.GetArena());
                   Atom::TSuprena temp_arena;
-                  Sabot::Type::TAny::TWrapper key_type_wrapper(key.GetCore().GetType(core_vec.GetArena(), key_type_alloc));
-                  Sabot::Type::TAny::TWrapper val_type_wrapper(val.GetCore().GetType(core_vec.GetArena(), val_type_alloc));
+                  Sabot::Type::TAny::TWrapper key_type_wrapper(key.GetCore().GetType(reader.GetArena(), key_type_alloc));
+                  Sabot::Type::TAny::TWrapper val_type_wrapper(val.GetCore().GetType(reader.GetArena(), val_type_alloc));
                   Atom::TCore key_core(&temp_arena, *key_type_wrapper);
                   Atom::TCore val_core(&temp_arena, *val_type_wrapper);
                   /* this does not exist yet, uncommon case: at this point we grab the lock, recheck against the master copy (possibly update it),
@@ -1742,44 +1921,35 @@ string TServer::ImportCoreVector(const string &file_pattern, int64_t num_load_th
                   } /* release lock */
                   op_by_key[TIndexKey(index_id, key)] = val;
                 }
-
-                ++pos_in_vec;
-                ++pos_in_vec;
               }
               TUpdate *update = new TUpdate(op_by_key, tx_meta, TKey(tx_id, &arena, lhs_state_alloc), lhs_state_alloc);
               update->SetSequenceNumber(SeqNum);
               ++SeqNum;
+              if (!mem_layer) {
+                mem_layer = new TMemoryLayer(Server->RepoManager.get());
+              }
               mem_layer->ImporterAppendUpdate(update);
-            }
-            producer.reset();
-          } /* finish reading file */
-          /* sort and fix the mem_layer */ {
-            std::vector<TUpdate::TEntry *> entry_vec;
-            entry_vec.reserve(num_entry_inserted);
-            for (TMemoryLayer::TUpdateCollection::TCursor update_csr(mem_layer->GetUpdateCollection()); update_csr; ++update_csr) {
-              for (TUpdate::TEntryCollection::TCursor entry_csr(update_csr->GetEntryCollection()); entry_csr; ++entry_csr) {
-                entry_vec.push_back(&*entry_csr);
+              /* once the run is full, sort it and write it out, so memory doesn't grow with the file */
+              num_run_entries += op_by_key.size();
+              if (num_run_entries >= Server->Cmd.ImportRunSize) {
+                write_run();
               }
             }
-            std::sort(entry_vec.begin(), entry_vec.end(), entry_sort_func);
-            for (auto entry : entry_vec) {
-              mem_layer->ImporterAppendEntry(entry);
+            if (mem_layer) {
+              write_run();
             }
-          }
-          /* write the mem layer to disk in the global repo */ {
-            auto global_repo = Server->GetGlobalRepo();
-
-            size_t num_keys = 0UL;
-            TSequenceNumber saved_low_seq = 0UL, saved_high_seq = 0UL;
-            size_t gen_id = global_repo->WriteFile(mem_layer, StorageSpeed, saved_low_seq, saved_high_seq, num_keys, 0UL);
-            delete mem_layer;
-            mem_layer = nullptr;
+          } /* finish reading file */
+          producer.reset();
+          /* hand our runs over in sequence number order */ {
             Sem.Pop();
             std::lock_guard<std::mutex> lock(Mut);
-            GenIdVec.push_back(gen_id);
+            GenIdVec.insert(GenIdVec.end(), run_gen_id_vec.begin(), run_gen_id_vec.end());
           }
         } catch (const exception &ex) {
           delete mem_layer;
+          for (size_t gen_id : run_gen_id_vec) {
+            global_repo->RemoveFile(gen_id);
+          }
           syslog(LOG_ERR, "Error while trying to import file %s : %s", File.c_str(), ex.what());
           return;
         }
@@ -2100,6 +2270,7 @@ void TServer::ServeClient(TFd &fd, const TAddress &client_address) {
   do {
     try {
       ++try_count;
+      ClientReactor.Wait(fd);
       THeader header;
       if (!TryReadExactly(fd, &header, sizeof(header))) {
         break;
@@ -2186,21 +2357,30 @@ void TServer::ServeClient(TFd &fd, const TAddress &client_address) {
     }
   } while (try_count < 3 && !connection);
   if (connection) {
-    Scheduler->Schedule(std::bind(&TConnection::Run, connection, std::move(fd)));
-    //connection->Run(fd);
+    /* Serve the connection right here, on our fiber, until it parks in ClientReactor.  From then on, it's launched in
+       a frame of its own whenever it has something to do. */
+    connection->Start(fd);
   }
 }
 
 template<uint64_t Length>
 constexpr uint64_t GetArrayLen(const char(&)[Length]) { return Length; }
 
+/* The most pipelined memcache requests we'll take off a connection and handle as one batch. */
+static const size_t MaxMemcacheBatchSize = 1024UL;
+
+/* The size of each of the in and out buffers of a memcache connection.  A batch is roughly what arrives in one read,
+   and its responses go out in a single write if they fit. */
+static constexpr uint64_t MemcacheBufferSize = 65536UL;
+
 void TServer::ServeMemcacheClient(TFd &&fd_original, const TAddress &client_address) {
   assert(this);
   assert(&fd_original);
   assert(&client_address);
 
   // NOTE: fd_original has it's ownership stolen at this point. Use of it will cause badness.
-  Strm::TFd<> strm(std::move(fd_original));
+  // NOTE: On the heap, as the buffers are too big for a fiber's stack.
+  auto strm = make_unique<Strm::TFd<MemcacheBufferSize, MemcacheBufferSize>>(std::move(fd_original));
 
   //TODO: This really should be a zero ttl
   const auto non_zero_ttl = std::chrono::seconds(15);
@@ -2237,12 +2417,17 @@ void TServer::ServeMemcacheClient(TFd &&fd_original, const TAddress &client_addr
   // Our input and output streams
   // TODO: We want TRequest to genericize the binary and text streams to one thing.
   // NOTE: We there should be no virtual calls in doing so.
-  Strm::Bin::TIn in(&strm);
-  Strm::Bin::TOut out(&strm);
+  Strm::Bin::TIn in(strm.get());
+  Strm::Bin::TOut out(strm.get());
+
+  // The requests in the current batch and, for each Get among them, the value we found (null if none).
+  std::vector<std::unique_ptr<Mynde::TRequest>> batch;
+  std::vector<std::unique_ptr<Mynde::TValue>> found;
 
   try {
     // TODO: Detect and handle eof without an exception?
 
+    ClientReactor.Wait(strm->GetFd());
     if (in.Peek() != Mynde::BinaryMagicRequest) {
       const char err_msg[] = "SERVER_ERROR text protocol is not supported.\r\n";
       out.Write(err_msg, GetArrayLen(err_msg));
@@ -2251,173 +2436,224 @@ void TServer::ServeMemcacheClient(TFd &&fd_original, const TAddress &client_addr
 
     bool Quit = false;
 
-    // Loop processing requets until we hit eof or explicitly get an exit command.
+    // Loop processing batches of requests until we hit eof or explicitly get an exit command.
     // TODO: Detect and handle eof without an exception?
     while(!Quit) {
       // TODO: We should probably wait for notifications from indy somewhere...
-      // NOTE: We make this on the heap so that we can pass it to the response generation thread
-      // We do the two threads because the protocol states that pending unread responses shouldn't block requests from
-      // being read / handled
-      Mynde::TRequest req(in);
-
-      size_t prev_assignment_count = std::atomic_fetch_add(&SlowAssignmentCounter, 1UL);
-      auto switch_to_runner =
-          make_unique<Indy::Fiber::TSwitchToRunner>(FastRunnerVec[prev_assignment_count % FastRunnerVec.size()].get());
-      // TODO: Build up the response in this. Call 'fire' when the whole response is built.
-      // TResponseBuilder resp(req);
-
-      if (req.GetFlags().Key && req.GetOpcode() != Mynde::TRequest::TOpcode::Get) {
-        // TODO: This needs to be a binary error message....
-        const char err_msg[] = "SERVER_ERROR Only Get is allowed to return the key (GetK, GetKQ).\r\n";
-        out.Write(err_msg, GetArrayLen(err_msg));
-        return;  // Closes the RAII connection
+      /* Wait for a request, then take every other one the client has already sent along with it.  Our clients pipeline
+         heavily, so this lets us handle them on a fast runner in one go and answer them all with one write. */
+      batch.clear();
+      if (!in.IsBuffered()) {
+        /* Park this fiber, not the runner, until the client sends something. */
+        ClientReactor.Wait(strm->GetFd());
       }
+      do {
+        batch.push_back(make_unique<Mynde::TRequest>(in));
+      } while (batch.size() < MaxMemcacheBatchSize && in.IsBuffered());
+      found.clear();
+      found.resize(batch.size());
+
+      /* Handle the requests in order, stopping after a quit or at a request we refuse, which ends the connection once
+         we've answered the ones before it. */
+      size_t num_handled = 0;
+      const char *err_msg = nullptr;
+      size_t err_msg_len = 0;
+      /* on a fast runner */ {
+        size_t prev_assignment_count = std::atomic_fetch_add(&SlowAssignmentCounter, 1UL);
+        Indy::Fiber::TSwitchToRunner switch_to_runner(FastRunnerVec[prev_assignment_count % FastRunnerVec.size()].get());
+        while (num_handled < batch.size() && !Quit && !err_msg) {
+          const Mynde::TRequest &req = *batch[num_handled];
+          if (req.GetFlags().Key && req.GetOpcode() != Mynde::TRequest::TOpcode::Get) {
+            // TODO: This needs to be a binary error message....
+            static const char key_err_msg[] = "SERVER_ERROR Only Get is allowed to return the key (GetK, GetKQ).\r\n";
+            err_msg = key_err_msg;
+            err_msg_len = GetArrayLen(key_err_msg);
+            break;
+          }
+          // TODO: Genericize memcache key -> indy key conversion (Make it a function)
+          switch (req.GetOpcode()) {
+            case Mynde::TRequest::TOpcode::Get: {
+              /* A run of gets shares one context. */
+              if (!context) {
+                context = make_unique<Indy::TContext>(repo, &context_arena);
+              }
 
-      Mynde::TResponseHeader hdr;
-      Zero(hdr);
-      hdr.Magic = Mynde::BinaryMagicResponse;
-      hdr.Opcode = req.GetBinaryOpcode();
-      hdr.Opaque = req.GetOpaque();
+              // TODO: Change keys and values to be start, limit based rather than doing this std::string marshalling
+              Mynde::TKey key{{req.GetKey().GetData(), req.GetKey().GetSize()}};
+
+              // Perform the Get
+              // TODO: We don't have any reason to go from atom -> Sabot
+              // TODO: The IndexKey has more stuff in it than we need / care about.
+              void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+              Indy::TIndexKey indy_index_key(
+                  Mynde::MemcachedIndexUuid,
+                  Indy::TKey(&context_arena, Sabot::State::TAny::TWrapper(Native::State::New(key, state_alloc))));
+              /* A single lookup: a key which isn't there comes back empty, with no arena. */
+              Indy::TKey response_value = (*context)[indy_index_key];
+              if (response_value.GetArena()) {
+                auto value = make_unique<Mynde::TValue>();
+                ToNative(*Sabot::State::TAny::TWrapper(response_value.GetState(state_alloc)), *value);
+                found[num_handled] = move(value);
+              }
+              ++num_handled;
+              break;
+            }
+            case Mynde::TRequest::TOpcode::Set: {
+              /* Coalesce this set and the ones right after it into a single update, in a single transaction.  A later
+                 set of the same key wins, just as if they'd been committed one at a time. */
+              Atom::TSuprena set_arena;
+              Indy::TUpdate::TOpByKey op_by_key;
+              size_t end = num_handled;
+              for (; end < batch.size(); ++end) {
+                const Mynde::TRequest &set_req = *batch[end];
+                if (set_req.GetOpcode() != Mynde::TRequest::TOpcode::Set || set_req.GetFlags().Key) {
+                  break;
+                }
 
+                // First 4 bytes are flags
+                uint32_t Flags = *(set_req.GetExtras().GetData());
 
-      // TODO: Genericize memcache key -> indy key conversion (Make it a function)
-      switch (req.GetOpcode()) {
-        case Mynde::TRequest::TOpcode::Get: {
-          if (!context) {
-            context = make_unique<Indy::TContext>(repo, &context_arena);
-          }
+                // Second 4 bytes are expiration
+                uint32_t Expiration = *(set_req.GetExtras().GetData() + 4);
+
+                // We currently only allow keys which have no timeout / are persistent
+                if (Expiration != 0) {
+                  break;
+                }
 
-          // TODO: Change keys and values to be start, limit based rather than doing this std::string marshalling
-          Mynde::TKey key{{req.GetKey().GetData(), req.GetKey().GetSize()}};
-
-          // Perform the Get
-          // TODO: We don't have any reason to go from atom -> Sabot
-          // TODO: The IndexKey has more stuff in it than we need / care about.
-          void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
-          Indy::TIndexKey indy_index_key(
-              Mynde::MemcachedIndexUuid,
-              Indy::TKey(&context_arena, Sabot::State::TAny::TWrapper(Native::State::New(key, state_alloc))));
-          if (req.GetFlags().Key) {
-            hdr.KeyLength = req.GetKey().GetSize();
+                Mynde::TKey key{{set_req.GetKey().GetData(), set_req.GetKey().GetSize()}};
+                Mynde::TValue value{{set_req.GetValue().GetData(), set_req.GetValue().GetSize()}, Flags};
+
+                void *state_alloc_1 = alloca(Sabot::State::GetMaxStateSize());
+                void *state_alloc_2 = alloca(Sabot::State::GetMaxStateSize());
+                op_by_key[Indy::TIndexKey(
+                    Mynde::MemcachedIndexUuid,
+                    Indy::TKey(&set_arena, Sabot::State::TAny::TWrapper(Native::State::New(key, state_alloc_1))))] =
+                    Indy::TKey(&set_arena, Sabot::State::TAny::TWrapper(Native::State::New(value, state_alloc_2)));
+              }
+              if (end == num_handled) {
+                // TODO: Return a proper binary error
+                // TODO: Throw an exception to close out the server ina  well logged way
+                static const char expiration_err_msg[] = "SERVER_ERROR Only keys without an expiration are allowed (Expiration = 0)";
+                err_msg = expiration_err_msg;
+                err_msg_len = GetArrayLen(expiration_err_msg);
+                break;
+              }
+
+              auto transaction = RepoManager->NewTransaction();
+              TUuid update_id(TUuid::Twister);
+
+              // TODO: The package_fq_name should be a constant somewhere.
+              // TODO: That we have to feed a package name and method name here seems like it might cause trouble later.
+              TMetaRecord meta_record(update_id,
+                                      TMetaRecord::TEntry(session->GetId(),
+                                                          session->GetUserId(),
+                                                          Orly::Mynde::PackageName,
+                                                          "set",
+                                                          {},
+                                                          {},
+                                                          Base::Chrono::CreateTimePnt(2014, 3, 23, 0, 0, 0, 0, 0),
+                                                          0));
+
+              void *state_alloc_1 = alloca(Sabot::State::GetMaxStateSize());
+              void *state_alloc_2 = alloca(Sabot::State::GetMaxStateSize());
+              auto update = Indy::TUpdate::NewUpdate(
+                  op_by_key,
+                  Indy::TKey(meta_record, &set_arena, state_alloc_1),
+                  Indy::TKey(update_id, &set_arena, state_alloc_2));
+              transaction->Push(repo, update);
+              transaction->Prepare();
+              transaction->CommitAction();
+              context.reset();
+              num_handled = end;
+              break;
+            }
+            case Mynde::TRequest::TOpcode::NoOp: {
+              context.reset();
+              ++num_handled;
+              break;
+            }
+            case Mynde::TRequest::TOpcode::Quit: {
+              Quit = true;
+              ++num_handled;
+              break;
+            }
+            default: {
+              syslog(LOG_INFO, "Memcache not implemented opcode: %02X", req.GetBinaryOpcode());
+              NOT_IMPLEMENTED();
+            }
           }
-          if (!context->Exists(indy_index_key)) {
-            syslog(LOG_INFO, "Get of unset key %s", std::get<0>(key).c_str());
-            hdr.Status = Mynde::TResponseStatus::KeyNotFound;
-            switch_to_runner.reset();
-            hdr.TotalBodyLength = hdr.KeyLength + 9;
-            if (!req.GetFlags().Quiet) {
+        }
+      }
+
+      /* Back on our own runner, write the responses, then send them all at once. */
+      for (size_t i = 0; i < num_handled; ++i) {
+        const Mynde::TRequest &req = *batch[i];
+        Mynde::TResponseHeader hdr;
+        Zero(hdr);
+        hdr.Magic = Mynde::BinaryMagicResponse;
+        hdr.Opcode = req.GetBinaryOpcode();
+        hdr.Opaque = req.GetOpaque();
+        switch (req.GetOpcode()) {
+          case Mynde::TRequest::TOpcode::Get: {
+            if (req.GetFlags().Key) {
+              hdr.KeyLength = req.GetKey().GetSize();
+            }
+            const Mynde::TValue *value = found[i].get();
+            if (!value) {
+              hdr.Status = Mynde::TResponseStatus::KeyNotFound;
+              hdr.TotalBodyLength = hdr.KeyLength + 9;
+              if (!req.GetFlags().Quiet) {
+                out << hdr;
+                if (req.GetFlags().Key) {
+                  out << req.GetKey();
+                }
+                const char not_found_msg[] = "Not found";
+                static_assert(GetArrayLen(not_found_msg) == 10, "Value is longer than expected...");
+                out.Write(not_found_msg, GetArrayLen(not_found_msg)-1);
+              }
+            } else {
+              static_assert(sizeof(value->Flags) == 4, "Sanity check the flags are indeed 4 bytes.");
+              hdr.ExtrasLength = 4;
+              hdr.TotalBodyLength = value->Value.size() + 4 + hdr.KeyLength;
               out << hdr;
+              out.WriteShallow(value->Flags);
               if (req.GetFlags().Key) {
                 out << req.GetKey();
               }
-              const char err_msg[] = "Not found";
-              static_assert(GetArrayLen(err_msg) == 10, "Value is longer than expected...");
-              out.Write(err_msg, GetArrayLen(err_msg)-1);
+              out.Write(value->Value.c_str(), value->Value.size());
             }
-          } else {
-            Indy::TKey response_value = (*context)[indy_index_key];
-            syslog(LOG_INFO, "Get of set key %s", std::get<0>(key).c_str());
-            Mynde::TValue value;
-            ToNative(*Sabot::State::TAny::TWrapper(response_value.GetState(state_alloc)), value);
-            static_assert(sizeof(value.Flags) == 4, "Sanity check the flags are indeed 4 bytes.");
-            hdr.ExtrasLength = 4;
-            hdr.TotalBodyLength = value.Value.size() + 4 + hdr.KeyLength;
-
-            switch_to_runner.reset();
-            out << hdr;
-            out.WriteShallow(value.Flags);
-            if (req.GetFlags().Key) {
-              out << req.GetKey();
-            }
-            out.Write(value.Value.c_str(), value.Value.size());
+            break;
           }
-          break;
-        }
-        case Mynde::TRequest::TOpcode::Set: {
+          case Mynde::TRequest::TOpcode::Set: {
+            //NOTE: We don't support cas, but we set the flag to 1 so that we pass some tests.
+            hdr.Cas = 1;
 
-          // First 4 bytes are flags
-          uint32_t Flags = *(req.GetExtras().GetData());
-
-          // Second 4 bytes are expiration
-          uint32_t Expiration = *(req.GetExtras().GetData() + 4);
-
-          // We currently only allow keys which have no timeout / are persistent
-          if (Expiration != 0) {
-            // TODO: Return a proper binary error
-            // TODO: Throw an exception to close out the server ina  well logged way
-            const char err_msg[] = "SERVER_ERROR Only keys without an expiration are allowed (Expiration = 0)";
-            out.Write(err_msg, GetArrayLen(err_msg));
-            return;
+            // TODO: This is a horrible place for this to live / refactor massively...
+            if (!req.GetFlags().Quiet) {
+              out << hdr;
+            }
+            break;
           }
-
-          Mynde::TKey key{{req.GetKey().GetData(), req.GetKey().GetSize()}};
-          Mynde::TValue value{{req.GetValue().GetData(), req.GetValue().GetSize()}, Flags};
-
-          syslog(LOG_INFO, "Set %s: %d %s", std::get<0>(key).c_str(), Flags, value.Value.c_str());
-
-          auto transaction = RepoManager->NewTransaction();
-          TUuid update_id(TUuid::Twister);
-
-          // TODO: The package_fq_name should be a constant somewhere.
-          // TODO: That we have to feed a package name and method name here seems like it might cause trouble later.
-          TMetaRecord meta_record(update_id,
-                                  TMetaRecord::TEntry(session->GetId(),
-                                                      session->GetUserId(),
-                                                      Orly::Mynde::PackageName,
-                                                      "set",
-                                                      {},
-                                                      {},
-                                                      Base::Chrono::CreateTimePnt(2014, 3, 23, 0, 0, 0, 0, 0),
-                                                      0));
-
-          void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
-          void *state_alloc_1 = alloca(Sabot::State::GetMaxStateSize());
-          void *state_alloc_2 = alloca(Sabot::State::GetMaxStateSize());
-          void *state_alloc_3 = alloca(Sabot::State::GetMaxStateSize());
-          auto update = Indy::TUpdate::NewUpdate(
-              TUpdate::TOpByKey{
-                  {Indy::TIndexKey(
-                       Mynde::MemcachedIndexUuid,
-                       Indy::TKey(&context_arena, Sabot::State::TAny::TWrapper(Native::State::New(key, state_alloc)))),
-                   Indy::TKey(&context_arena,
-                              Sabot::State::TAny::TWrapper(Native::State::New(value, state_alloc_1))), }},
-              Indy::TKey(meta_record, &context_arena, state_alloc_2),
-              Indy::TKey(update_id, &context_arena, state_alloc_3));
-          transaction->Push(repo, update);
-          transaction->Prepare();
-          transaction->CommitAction();
-
-          switch_to_runner.reset();
-
-          //NOTE: We don't support cas, but we set the flag to 1 so that we pass some tests.
-          hdr.Cas = 1;
-
-          // TODO: This is a horrible place for this to live / refactor massively...
-          if (!req.GetFlags().Quiet) {
+          case Mynde::TRequest::TOpcode::NoOp: {
             out << hdr;
+            break;
           }
-          context.reset();
-          break;
-        }
-        case Mynde::TRequest::TOpcode::NoOp: {
-          syslog(LOG_INFO, "Noop, %02X", hdr.Opcode);
-          context.reset();
-          out << hdr;
-          break;
-        }
-        case Mynde::TRequest::TOpcode::Quit: {
-          Quit = true;
-
-          if(!req.GetFlags().Quiet) {
-            out << hdr;
+          case Mynde::TRequest::TOpcode::Quit: {
+            if(!req.GetFlags().Quiet) {
+              out << hdr;
+            }
+            break;
+          }
+          default: {
+            assert(false);
           }
-          break;
-        }
-        default: {
-          syslog(LOG_INFO, "Memcache not implemented opcode: %02X", req.GetBinaryOpcode());
-          NOT_IMPLEMENTED();
         }
       }
+      if (err_msg) {
+        out.Write(err_msg, err_msg_len);
+        return;  // Closes the RAII connection
+      }
 
       //Flush output / force everything to be written.
       out.Flush();
@@ -2744,6 +2980,21 @@ void TIndyReporter::AddReport(std::stringstream &ss) const {
   ss << "Tetris Fail Transactions / s = " << (tetris_fail_count / elapsed_time) << endl;
   ss << "Tetris Rounds / s = " << (tetris_round_count / elapsed_time) << endl;
 
+  size_t bloom_reject_count = Disk::Util::TBloomFilter::RejectCount.exchange(0UL);
+  size_t bloom_false_positive_count = Disk::Util::TBloomFilter::FalsePositiveCount.exchange(0UL);
+  ss << "Bloom Filter Rejects / s = " << (bloom_reject_count / elapsed_time) << endl;
+  ss << "Bloom Filter False Positives / s = " << (bloom_false_positive_count / elapsed_time) << endl;
+
+  size_t row_cache_hit_count = Indy::TRowCache::HitCount.exchange(0UL);
+  size_t row_cache_miss_count = Indy::TRowCache::MissCount.exchange(0UL);
+  size_t row_cache_invalidation_count = Indy::TRowCache::InvalidationCount.exchange(0UL);
+  ss << "Row Cache Hits / s = " << (row_cache_hit_count / elapsed_time) << endl;
+  ss << "Row Cache Misses / s = " << (row_cache_miss_count / elapsed_time) << endl;
+  ss << "Row Cache Invalidations / s = " << (row_cache_invalidation_count / elapsed_time) << endl;
+  if (Server->RowCache) {
+    ss << "Row Cache Rows = " << Server->RowCache->GetRowCount() << endl;
+  }
+
   size_t tetris_timer_count = 0UL;
   double
     tetris_snapshot_min = 0.0,
@@ -2765,6 +3016,11 @@ void TIndyReporter::AddReport(std::stringstream &ss) const {
     tetris_commit_max = 0.0,
     tetris_commit_mean = 0.0,
     tetris_commit_sigma = 0.0;
+  double
+    tetris_promoted_min = 0.0,
+    tetris_promoted_max = 0.0,
+    tetris_promoted_mean = 0.0,
+    tetris_promoted_sigma = 0.0;
 
   {
     std::lock_guard<std::mutex> tetris_timer_lock(Server->TetrisManager->TetrisTimerLock);
@@ -2772,10 +3028,12 @@ void TIndyReporter::AddReport(std::stringstream &ss) const {
     Server->TetrisManager->TetrisSortCPUTime.Report(tetris_sort_min, tetris_sort_max, tetris_sort_mean, tetris_sort_sigma);
     Server->TetrisManager->TetrisPlayCPUTime.Report(tetris_play_min, tetris_play_max, tetris_play_mean, tetris_play_sigma);
     Server->TetrisManager->TetrisCommitCPUTime.Report(tetris_commit_min, tetris_commit_max, tetris_commit_mean, tetris_commit_sigma);
+    Server->TetrisManager->TetrisPromotedPerRound.Report(tetris_promoted_min, tetris_promoted_max, tetris_promoted_mean, tetris_promoted_sigma);
     Server->TetrisManager->TetrisSnapshotCPUTime.Reset();
     Server->TetrisManager->TetrisSortCPUTime.Reset();
     Server->TetrisManager->TetrisPlayCPUTime.Reset();
     Server->TetrisManager->TetrisCommitCPUTime.Reset();
+    Server->TetrisManager->TetrisPromotedPerRound.Reset();
   }
 
   if (tetris_timer_count) {
@@ -2795,6 +3053,9 @@ void TIndyReporter::AddReport(std::stringstream &ss) const {
        << "Tetris Commit CPU Min = " << tetris_commit_min << endl
        << "Tetris Commit CPU Max = " << tetris_commit_max << endl
        << "Tetris Commit CPU Mean = " << tetris_commit_mean << endl;
+    ss << "Tetris Promoted Per Round Min = " << tetris_promoted_min << endl
+       << "Tetris Promoted Per Round Max = " << tetris_promoted_max << endl
+       << "Tetris Promoted Per Round Mean = " << tetris_promoted_mean << endl;
   }
 
 
@@ -2870,3 +3131,22 @@ void TServer::TConnection::TConnectionRunnable::Compute() {
   delete this;
   //printf("~TConnectionRunnable finish\n");
 }
+
+TServer::TConnection::TServeRunnable::TServeRunnable(Fiber::TRunner *runner, const shared_ptr<TConnection> &connection)
+    : Connection(connection) {
+  FramePool = Fiber::TFrame::LocalFramePool;
+  Fiber::TFrame *frame = FramePool->Alloc();
+  try {
+    frame->Latch(runner, this, static_cast<TRunnable::TFunc>(&TServeRunnable::Serve));
+  } catch (...) {
+    FramePool->Free(frame);
+    throw;
+  }
+}
+
+void TServer::TConnection::TServeRunnable::Serve() {
+  assert(this);
+  Connection->Serve();
+  Fiber::FreeMyFrame(FramePool);
+  delete this;
+}
@@ -19,26 +19,32 @@
 #pragma once
 
 #include <cassert>
+#include <cstdint>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
 
 #include <base/class_traits.h>
 #include <base/debug_log.h>
+#include <base/epoll.h>
 #include <base/fd.h>
 #include <base/log.h>
 #include <base/scheduler.h>
 #include <base/timer_fd.h>
 #include <base/uuid.h>
+#include <io/device.h>
 #include <socket/address.h>
 #include <orly/durable/kit.h>
 #include <orly/indy/manager.h>
+#include <orly/indy/row_cache.h>
 #include <orly/indy/disk/durable_manager.h>
 #include <orly/indy/disk/indy_util_reporter.h>
 #include <orly/indy/disk/sim/mem_engine.h>
 #include <orly/indy/disk/util/disk_engine.h>
 #include <orly/indy/fiber/fiber.h>
 #include <orly/indy/fiber/jump_runnable.h>
+#include <orly/indy/fiber/reactor.h>
 #include <orly/notification/all.h>
 #include <orly/notification/pov_failure.h>
 #include <orly/notification/system_shutdown.h>
@@ -306,12 +312,44 @@ namespace Orly {
            priorities require root privileges). */
         bool NoRealtime;
 
+        /* If true, the disk controller drives devices with io_uring rather than aio. */
+        bool UseIoUring;
+
+        /* If true (and using io_uring), ask the kernel for a thread to poll the submission queues. */
+        bool IoUringSqPoll;
+
         /* Controls whether fsync is used when writing to disk */
         bool DoFsync;
 
         /* TODO */
         bool LogAssertionFailures;
 
+        /* The most children tetris will promote into a parent pov in a single round. */
+        size_t TetrisMaxBatchSize;
+
+        /* The most notifications a connection will have pushed to its client and not yet heard back about. */
+        size_t NotificationWindow;
+
+        /* The most point reads to cache for the global pov.  Zero turns the cache off. */
+        size_t RowCacheSize;
+
+        /* The longest, in microseconds, a connection may hold a reply unsent while it coalesces replies.  Zero turns
+           coalescing off.  See Rpc::TContext::SetMaxWriteDelay(). */
+        size_t RpcMaxWriteDelay;
+
+        /* How safe repos choose the disk layers to merge: "tiered" or "leveled".  See Indy::TCompactionPolicy. */
+        std::string CompactionPolicy;
+
+        /* The most disk layers the leveled compaction policy keeps in each level. */
+        size_t CompactionFilesPerLevel;
+
+        /* The most key/value pairs each of the importer's load threads holds in memory before it sorts them and writes
+           them out as a data file. */
+        size_t ImportRunSize;
+
+        /* The directory in which the importer spools the notes of the files it reads.  See Atom::TCoreVectorReader. */
+        std::string ImportSpoolDir;
+
         /******** Object Pools ********/
 
         /* TODO */
@@ -498,6 +536,12 @@ namespace Orly {
           return Session->Try(Server, pov_id, fq_name, closure);
         }
 
+        /* See <orly/protocol.h>. */
+        std::vector<TMethodResult> TryMany(const std::vector<TMethodRequest> &requests) {
+          assert(this);
+          return Session->TryMany(Server, requests);
+        }
+
         /* See <orly/protocol.h>. */
         TMethodResult TryTracked(const Base::TUuid &pov_id, const std::vector<std::string> &fq_name, const TClosure &closure) {
           assert(this);
@@ -534,10 +578,12 @@ namespace Orly {
           return Server->ImportCoreVector(file_pattern, num_load_threads, num_merge_threads, merge_simultaneous);
         }
 
-        /* Run the RPC I/O with the client.  This function is called by ServeClient() after the handshake has
-           been negotiated.  This function doesn't return until the client hangs up.  It will throw exceptions
-           if the client times out, commits a syntax error, or otherwise does something weird. */
-        void Run(Base::TFd &fd);
+        /* Start the RPC I/O with the client on the given socket.  This function is called by ServeClient() after the
+           handshake has been negotiated.  It serves whatever is ready and then returns, leaving the connection parked
+           in the server's reactor, where it holds no frame, until the client or the session has something more for
+           it.  The connection keeps itself alive while it's parked, so it lasts until the client hangs up, times
+           out, commits a syntax error, or otherwise does something weird. */
+        void Start(Base::TFd &fd);
 
         /* Run the given jump-runnable on the server's websockets runner. */
         void RunWs(Indy::Fiber::TJumpRunnable &&jump_runnable) {
@@ -590,9 +636,54 @@ namespace Orly {
 
         };  // TServer::TConnection::TProtocol
 
+        /* A batch of notifications we've pushed and the client hasn't yet acked. */
+        struct TUnacked {
+
+          /* Ready when the client acks. */
+          std::shared_ptr<Rpc::TFuture<void>> Ack;
+
+          /* The sequence number of the last notification in the batch.  The ack covers everything up to here. */
+          uint32_t LastSeqNumber;
+
+          /* The number of notifications in the batch. */
+          size_t Size;
+
+        };  // TServer::TConnection::TUnacked
+
+        /* Launched by the reactor, on a slow runner, to serve a parked connection which has something to do. */
+        class TServeRunnable
+            : public Indy::Fiber::TRunnable {
+          NO_COPY(TServeRunnable);
+          public:
+
+          /* Latch a frame from this thread's pool onto the given runner.  The frame holds a reference to the
+             connection until it has served it. */
+          TServeRunnable(Indy::Fiber::TRunner *runner, const std::shared_ptr<TConnection> &connection);
+
+          private:
+
+          /* Serve the connection, then free our frame and ourself. */
+          void Serve();
+
+          /* Where our frame came from, and so where it goes back to. */
+          Base::TThreadLocalGlobalPoolManager<Indy::Fiber::TFrame, size_t, Indy::Fiber::TRunner *>::TThreadLocalPool *FramePool;
+
+          /* The connection to serve. */
+          std::shared_ptr<TConnection> Connection;
+
+        };  // TServer::TConnection::TServeRunnable
+
         /* TODO */
         TConnection(TServer *server, const Durable::TPtr<TSession> &session);
 
+        /* Lets go of our stream first, as flushing it can touch our epoll. */
+        ~TConnection();
+
+        /* Serve the client and the session until neither has anything for us, then park ourselves in the server's
+           reactor and return.  If the client goes away, or we give up on it, we just return, and the connection
+           goes away once the last frame using it lets go. */
+        void Serve();
+
         /* TODO */
         static void OnRelease(TConnection *connection);
 
@@ -602,6 +693,24 @@ namespace Orly {
         /* TODO */
         const Durable::TPtr<TSession> Session;
 
+        /* The socket to the client.  Set by Start(). */
+        std::shared_ptr<Io::TDevice> Device;
+
+        /* Where we wait to be served.  It holds the client's socket, for reading and, while the socket has a backlog,
+           for writing; if AckFd isn't negative, the fd of the oldest batch's ack; and, if IsWaitingForNew, the fd of
+           the session's new-notification counter. */
+        Base::TEpoll Epoll;
+        int AckFd;
+        bool IsWaitingForNew;
+
+        /* The batches of notifications we've pushed but which the client hasn't acked, oldest first, and the total
+           number of notifications in them. */
+        std::deque<TUnacked> Unacked;
+        size_t UnackedCount;
+
+        /* The sequence number of the last notification we pushed. */
+        uint32_t LastSentSeqNumber;
+
       };  // TServer::TConnection
 
       /* Constructed by NewSession() and ResumeSession() to hold a session open for
@@ -774,6 +883,9 @@ namespace Orly {
       /* Used when not running in memory simulation mode. */
       std::unique_ptr<Indy::Disk::Util::TDiskEngine> DiskEngine;
 
+      /* Caches point reads for the repo manager, if we're caching.  Declared first so it goes last. */
+      std::unique_ptr<Indy::TRowCache> RowCache;
+
       /* TODO */
       std::unique_ptr<Orly::Indy::TManager> RepoManager;
 
@@ -816,6 +928,10 @@ namespace Orly {
       /* All our open connections. */
       std::unordered_map<Base::TUuid, std::weak_ptr<TConnection>> ConnectionBySessionId;
 
+      /* Parks client connections while their sockets are idle, so they don't pin runner threads.  RPC connections
+         don't even keep a frame while they're parked. */
+      Indy::Fiber::TReactor ClientReactor;
+
       /* TODO */
       std::unique_ptr<TIndyReporter> Reporter;
 
@@ -18,6 +18,9 @@
 
 #include <orly/server/session.h>
 
+#include <algorithm>
+#include <atomic>
+
 #include <orly/atom/suprena.h>
 #include <orly/indy/context.h>
 #include <orly/notification/all.h>
@@ -32,6 +35,169 @@ using namespace Orly::Atom;
 using namespace Orly::Notification;
 using namespace Orly::Server;
 
+/* The arena and argument map a read-only try works in.  Each runner keeps a free list of these, and a try borrows one
+   for as long as its call lasts, then clears it and gives it back.  That saves building a fresh arena and map, and
+   growing their tables, on every call.  It's a list rather than a single scratch per runner because a fiber may yield
+   mid-call and let another try run on the same runner.  Runners live as long as the server does, so we never free
+   the ones on the list. */
+class TReadScratch {
+  NO_COPY(TReadScratch);
+  public:
+
+  /* Borrow a scratch from this runner's free list, or make one if the list is empty. */
+  static TReadScratch *Borrow() {
+    TReadScratch *scratch = FreeList;
+    if (scratch) {
+      FreeList = scratch->Next;
+      --FreeCount;
+    } else {
+      scratch = new TReadScratch();
+    }
+    return scratch;
+  }
+
+  /* Clear the scratch and return it to this runner's free list, or delete it if the list is full. */
+  static void Return(TReadScratch *scratch) {
+    assert(scratch);
+    scratch->Arena.Clear();
+    if (FreeCount < MaxFreeCount) {
+      scratch->Next = FreeList;
+      FreeList = scratch;
+      ++FreeCount;
+    } else {
+      delete scratch;
+    }
+  }
+
+  /* Point the argument map at the closure's arguments.  If the map already holds the same names, as it will when the
+     same function was called last, we overwrite the values in place and allocate nothing. */
+  const Package::TArgMap &SetArgs(const TClosure &closure) {
+    assert(this);
+    auto arena = closure.GetArena().get();
+    const auto &core_by_name = closure.GetCoreByName();
+    if (Args.size() == core_by_name.size()) {
+      bool is_same = true;
+      for (const auto &item: core_by_name) {
+        auto iter = Args.find(item.first);
+        if (iter == Args.end()) {
+          is_same = false;
+          break;
+        }
+        iter->second = Indy::TKey(item.second, arena);
+      }
+      if (is_same) {
+        return Args;
+      }
+    }
+    Args.clear();
+    for (const auto &item: core_by_name) {
+      Args.insert(make_pair(item.first, Indy::TKey(item.second, arena)));
+    }
+    return Args;
+  }
+
+  /* The arena the call works in. */
+  TSuprena Arena;
+
+  private:
+
+  /* The most scratches a runner keeps on its free list. */
+  static const size_t MaxFreeCount = 64UL;
+
+  /* Use Borrow(). */
+  TReadScratch() : Next(nullptr) {}
+
+  /* See SetArgs(). */
+  Package::TArgMap Args;
+
+  /* The next scratch on the free list. */
+  TReadScratch *Next;
+
+  /* This runner's free list. */
+  static __thread TReadScratch *FreeList;
+
+  /* The length of FreeList. */
+  static __thread size_t FreeCount;
+
+};  // TReadScratch
+
+__thread TReadScratch *TReadScratch::FreeList = nullptr;
+
+__thread size_t TReadScratch::FreeCount = 0UL;
+
+/* One of the workers in a TryMany() batch.  It runs on a fast runner in a frame of its own, claiming the batch's
+   requests one at a time until none are left, and storing each result (or error).  When it runs out, it tells the
+   sync.  A batch has only a few workers, however many requests it holds, so a big batch can't drain the frame pool. */
+class TTryManyWorker
+    : public Indy::Fiber::TRunnable {
+  NO_COPY(TTryManyWorker);
+  public:
+
+  /* Do-little. */
+  TTryManyWorker()
+      : Server(nullptr), Session(nullptr), Requests(nullptr), Results(nullptr), Next(nullptr), Sync(nullptr) {}
+
+  /* Start the worker on the given runner.  The sync must be waiting for us.  The caller must keep the requests,
+     results and counter alive, and must not touch the results, until the sync completes. */
+  void Start(
+      Indy::Fiber::TRunner *runner, TSession::TServer *server, TSession *session,
+      const vector<TMethodRequest> &requests, vector<TMethodResult> &results, atomic<size_t> &next,
+      Indy::Fiber::TSafeSync &sync) {
+    assert(this);
+    assert(runner);
+    Server = server;
+    Session = session;
+    Requests = &requests;
+    Results = &results;
+    Next = &next;
+    Sync = &sync;
+    Indy::Fiber::TFrame *frame = Indy::Fiber::TFrame::LocalFramePool->Alloc();
+    try {
+      frame->Latch(runner, this, static_cast<Indy::Fiber::TRunnable::TFunc>(&TTryManyWorker::Run));
+    } catch (...) {
+      Indy::Fiber::TFrame::LocalFramePool->Free(frame);
+      throw;
+    }
+  }
+
+  private:
+
+  /* Runs in our own frame. */
+  void Run() {
+    assert(this);
+    for (size_t i = Next->fetch_add(1UL); i < Requests->size(); i = Next->fetch_add(1UL)) {
+      const TMethodRequest &request = (*Requests)[i];
+      TMethodResult &result = (*Results)[i];
+      try {
+        result = Session->Try(Server, request.GetPovId(), request.GetPackage(), request.GetClosure());
+      } catch (const exception &ex) {
+        TSuprena arena;
+        void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+        result = TMethodResult(&arena, TCore(string(ex.what()), &arena, state_alloc), TOpt<TTracker>(), true);
+      }
+    }
+    /* Once the sync completes, the caller may destroy us, so we mustn't touch our members after that. */
+    auto *sync = Sync;
+    Indy::Fiber::FreeMyFrame(Indy::Fiber::TFrame::LocalFramePool);
+    sync->Complete();
+  }
+
+  /* The server and session on whose behalf we run. */
+  TSession::TServer *Server;
+  TSession *Session;
+
+  /* The batch's methods to run, and where to put what they return. */
+  const vector<TMethodRequest> *Requests;
+  vector<TMethodResult> *Results;
+
+  /* The index of the next request to be claimed. */
+  atomic<size_t> *Next;
+
+  /* Told when we're done. */
+  Indy::Fiber::TSafeSync *Sync;
+
+};  // TTryManyWorker
+
 TMethodResult TSession::DoInPast(
     TServer */*server*/, const TUuid &/*pov_id*/, const vector<string> &/*fq_name*/, const TClosure &/*closure*/, const TUuid &/*tracking_id*/) {
   assert(this);
@@ -60,6 +226,19 @@ const TNotification *TSession::GetFirstNotification(uint32_t &seq_number) {
   return iter->second;
 }
 
+size_t TSession::GetNotificationsAfter(
+    uint32_t seq_number, size_t max_count, vector<pair<uint32_t, const TNotification *>> &notifications) const {
+  assert(this);
+  assert(&notifications);
+  lock_guard<mutex> lock(NotificationMutex);
+  size_t count = 0;
+  for (auto iter = NotificationBySeqNumber.upper_bound(seq_number);
+       iter != NotificationBySeqNumber.end() && count < max_count; ++iter, ++count) {
+    notifications.emplace_back(iter->first, iter->second);
+  }
+  return count;
+}
+
 TUuid TSession::NewFastPrivatePov(TServer *server, const TOpt<TUuid> &parent_pov_id, const seconds &time_to_live) {
   assert(this);
   assert(server);
@@ -100,6 +279,7 @@ uint32_t TSession::InsertNotification(TNotification *notification) {
   try {
     NotificationBySeqNumber.insert(make_pair(result, notification));
     NotificationSem.Push();
+    NewNotificationCounter.Push();
   } catch (...) {
     --NextSeqNumber;
     delete notification;
@@ -118,6 +298,17 @@ void TSession::RemoveNotification(uint32_t seq_number) {
   NotificationSem.Pop();
 }
 
+void TSession::RemoveNotificationsThrough(uint32_t seq_number) {
+  assert(this);
+  lock_guard<mutex> lock(NotificationMutex);
+  auto limit = NotificationBySeqNumber.upper_bound(seq_number);
+  for (auto iter = NotificationBySeqNumber.begin(); iter != limit; ++iter) {
+    delete iter->second;
+    NotificationSem.Pop();
+  }
+  NotificationBySeqNumber.erase(NotificationBySeqNumber.begin(), limit);
+}
+
 void TSession::SetTimeToLive(TServer *server, const TUuid &durable_id, const seconds &time_to_live) {
   assert(this);
   assert(server);
@@ -138,6 +329,69 @@ void TSession::SetUserId(TServer */*server*/, const TUuid &user_id) {
 TMethodResult TSession::Try(TServer *server, const TUuid &pov_id, const vector<string> &fq_name, const TClosure &closure) {
   assert(this);
   assert(Indy::Fiber::TRunner::LocalRunner);
+  auto func = server->GetPackageManager().Get(fq_name)->GetFunctionInfo(AsPiece(closure.GetMethodName()));
+  return func->HasEffects() ? TryWrite(server, pov_id, fq_name, closure, *func) : TryRead(server, pov_id, closure, *func);
+}
+
+TMethodResult TSession::TryRead(TServer *server, const TUuid &pov_id, const TClosure &closure, const Package::TFuncHolder &func) {
+  assert(this);
+  assert(&func);
+  if (!server->IsOnFastRunner()) {
+    size_t prev_assignment_count = std::atomic_fetch_add(&server->FastAssignmentCounter, 1UL);
+    Indy::Fiber::TSwitchToRunner RunnerSwitcher(server->FastRunnerVec[prev_assignment_count % server->FastRunnerVec.size()].get());
+    return TryRead(server, pov_id, closure, func);
+  }
+  Base::TTimer timer;
+  Base::TTimer call_timer;
+  timer.Start();
+  /* We borrow and return the scratch on this runner, so it goes back on the list it came from.  The scratch outlives
+     the contexts below, which refer to its arena. */
+  unique_ptr<TReadScratch, void (*)(TReadScratch *)> scratch(TReadScratch::Borrow(), TReadScratch::Return);
+  try {
+    const auto &prog_args = scratch->SetArgs(closure);
+    auto pov = server->GetDurableManager()->Open<TPov>(pov_id);
+    if (!pov) {
+      DEFINE_ERROR(error_t, runtime_error, "unknown pov_id");
+      THROW_ERROR(error_t) << pov_id;
+    }
+    AddPov(pov);
+    auto repo = pov->GetRepo(server);
+    Indy::TContext context(repo, &scratch->Arena);
+    Rt::TOpt<TUUID> user_id;
+    if (UserId) {
+      user_id = UserId->GetRaw();
+    }
+    TUUID session_id = GetId().GetRaw();
+    Indy::TIndyContext indy_context(user_id, session_id, context, &scratch->Arena, server->GetScheduler(),
+      Rt::TOpt<Base::Chrono::TTimePnt>(), Rt::TOpt<uint32_t>());
+    call_timer.Start();
+    TCore result_core = func.Call(indy_context, prog_args);
+    call_timer.Stop();
+    if (!indy_context.MoveEffects().empty()) {
+      DEFINE_ERROR(error_t, logic_error, "function marked as having no effects had effects");
+      THROW_ERROR(error_t) << closure.GetMethodName();
+    }
+    timer.Stop();
+    /* Acquire TryTime lock */ {
+      std::lock_guard<std::mutex> lock(TServer::TryTimeLock);
+      TServer::TryReadTimeCalc.Push(timer.Total());
+      TServer::TryReadCallTimerCalc.Push(call_timer.Total());
+      TServer::TryWalkerCountCalc.Push(context.GetWalkerCount());
+      TServer::TryWalkerConsTimerCalc.Push(context.GetPresentWalkConsTimer().Total());
+    }
+    /* This deep-copies the result out of the scratch arena. */
+    return TMethodResult(indy_context.GetArena(), result_core, TOpt<TTracker>());
+  } catch (const exception &ex) {
+    syslog(LOG_ERR, "Error in Session::Try : [%s]", ex.what());
+    throw;
+  }
+}
+
+TMethodResult TSession::TryWrite(
+    TServer *server, const TUuid &pov_id, const vector<string> &fq_name, const TClosure &closure,
+    const Package::TFuncHolder &func) {
+  assert(this);
+  assert(&func);
   size_t prev_assignment_count = std::atomic_fetch_add(&server->FastAssignmentCounter, 1UL);
   Indy::Fiber::TSwitchToRunner RunnerSwitcher(server->FastRunnerVec[prev_assignment_count % server->FastRunnerVec.size()].get());
   TCore result_core;
@@ -174,10 +428,9 @@ TMethodResult TSession::Try(TServer *server, const TUuid &pov_id, const vector<s
     Indy::TIndyContext indy_context(user_id, session_id, context, &my_arena, server->GetScheduler(),
       Rt::TOpt<Base::Chrono::TTimePnt>(), Rt::TOpt<uint32_t>());
     // Func it.
-    auto func = server->GetPackageManager().Get(fq_name)->GetFunctionInfo(AsPiece(closure.GetMethodName()));
     Package::TContext::TEffects effects;
     call_timer.Start();
-    result_core = func->Call(indy_context, prog_args);
+    result_core = func.Call(indy_context, prog_args);
     call_timer.Stop();
     effects = indy_context.MoveEffects();
     if (!effects.empty()) {
@@ -189,7 +442,14 @@ TMethodResult TSession::Try(TServer *server, const TUuid &pov_id, const vector<s
         Var::TVar val;
         if (!item.second->IsDelete()) {
           if (!item.second->IsFinal()) {
-            val = Var::ToVar(*Sabot::State::TAny::TWrapper(context[key].GetState(state_alloc_1)));
+            /* Most partial changes are field calls we can make on the stored core as it is. */
+            auto current = context[key];
+            TCore result;
+            if (item.second->TryApply(&my_arena, current.GetArena(), current.GetCore(), result)) {
+              op_by_key[key] = Indy::TKey(result, &my_arena);
+              continue;
+            }
+            val = Var::ToVar(*Sabot::State::TAny::TWrapper(current.GetState(state_alloc_1)));
           }
           item.second->Apply(val);
           op_by_key[key] =
@@ -290,6 +550,41 @@ TNotification *TSession::TryGetNotification(uint32_t seq_number) const {
   return (iter != NotificationBySeqNumber.end()) ? iter->second : nullptr;
 }
 
+vector<TMethodResult> TSession::TryMany(TServer *server, const vector<TMethodRequest> &requests) {
+  assert(this);
+  assert(server);
+  assert(&requests);
+  assert(Indy::Fiber::TFrame::LocalFramePool);
+  vector<TMethodResult> results(requests.size());
+  /* Run the calls on up to one worker per fast runner, each in a frame of its own, so a call which yields (to wait on
+     a disk, say) doesn't hold up the others.  The workers land on fast runners, so Try() runs the calls in place. */ {
+    const size_t num_workers = min(requests.size(), server->FastRunnerVec.size());
+    unique_ptr<TTryManyWorker[]> workers(new TTryManyWorker[num_workers]);
+    atomic<size_t> next(0UL);
+    Indy::Fiber::TSafeSync sync;
+    for (size_t i = 0; i < num_workers; ++i) {
+      sync.WaitForMore(1);
+      try {
+        size_t prev_assignment_count = std::atomic_fetch_add(&server->FastAssignmentCounter, 1UL);
+        workers[i].Start(
+            server->FastRunnerVec[prev_assignment_count % server->FastRunnerVec.size()].get(), server, this, requests,
+            results, next, sync);
+      } catch (...) {
+        sync.Complete();
+        /* The workers already running still point at our locals, so they must finish before we unwind.  If any
+           started, they'll get through the whole batch between them, so carry on with them alone. */
+        sync.Sync();
+        if (!i) {
+          throw;
+        }
+        return results;
+      }
+    }
+    sync.Sync();
+  }
+  return results;
+}
+
 TMethodResult TSession::TryTracked(TServer */*server*/, const TUuid &/*pov_id*/, const vector<string> &/*fq_name*/, const TClosure &/*closure*/) {
   assert(this);
   THROW_ERROR(TStubbed) << "TryTracked";
@@ -393,7 +688,13 @@ void TSession::RunInPrivateChildPov(TServer *server,
             Indy::TKey(Native::TTombstone::Tombstone, &child_arena, state_alloc_2);
       } else {
         if (!item.second->IsFinal()) {
-          val = Var::ToVar(*Sabot::State::TAny::TWrapper(context[key].GetState(state_alloc_1)));
+          auto current = context[key];
+          TCore result;
+          if (item.second->TryApply(&child_arena, current.GetArena(), current.GetCore(), result)) {
+            op_by_key[key] = Indy::TKey(result, &child_arena);
+            continue;
+          }
+          val = Var::ToVar(*Sabot::State::TAny::TWrapper(current.GetState(state_alloc_1)));
         }
         item.second->Apply(val);
         op_by_key[key] =
@@ -25,6 +25,7 @@
 #include <vector>
 
 #include <base/class_traits.h>
+#include <base/event_counter.h>
 #include <base/event_semaphore.h>
 #include <base/opt.h>
 #include <base/sigma_calc.h>
@@ -68,6 +69,17 @@ namespace Orly {
         /* TODO */
         virtual Base::TScheduler *GetScheduler() const = 0;
 
+        /* True iff. the calling fiber is running on one of our fast runners. */
+        bool IsOnFastRunner() const {
+          assert(this);
+          for (const auto &runner: FastRunnerVec) {
+            if (runner.get() == Indy::Fiber::TRunner::LocalRunner) {
+              return true;
+            }
+          }
+          return false;
+        }
+
         /* TODO */
         static Base::TSigmaCalc TryReadTimeCalc;
         static Base::TSigmaCalc TryReadCPUTimeCalc;
@@ -127,6 +139,11 @@ namespace Orly {
       /* TODO */
       const TNotification *GetFirstNotification(uint32_t &seq_number);
 
+      /* Append to the vector up to max_count pending notifications with sequence numbers greater than the one given, in
+         order of increasing sequence number.  Return the number appended.  Pass zero to start from the beginning. */
+      size_t GetNotificationsAfter(
+          uint32_t seq_number, size_t max_count, std::vector<std::pair<uint32_t, const TNotification *>> &notifications) const;
+
       /* TODO */
       virtual const char *GetKind() const noexcept override {
         assert(this);
@@ -146,6 +163,14 @@ namespace Orly {
         return NotificationSem;
       }
 
+      /* Pushed each time a notification is inserted.  The semaphore counts every pending notification, including
+         those already sent and waiting to be acked, so it can't tell a waiter that there's something new; this can.
+         Pop it before looking for new notifications, so none slips by between the look and the next wait. */
+      Base::TEventCounter &GetNewNotificationCounter() const {
+        assert(this);
+        return NewNotificationCounter;
+      }
+
       /* The id of the user who owns this session.  If the session is anonymous, this is unknown. */
       const Base::TOpt<Base::TUuid> &GetUserId() const {
         assert(this);
@@ -175,6 +200,10 @@ namespace Orly {
          If notification doesn't exist (never existed or has already been discarded), do nothing. */
       void RemoveNotification(uint32_t seq_number);
 
+      /* Remove every notification with a sequence number up to and including the one given.  This is how a cumulative
+         ack from the client lands. */
+      void RemoveNotificationsThrough(uint32_t seq_number);
+
       /* See <orly/protocol.h>. */
       void SetTimeToLive(TServer *server, const Base::TUuid &durable_id, const std::chrono::seconds &ttl);
 
@@ -190,6 +219,9 @@ namespace Orly {
       /* Return the notification with the given sequence number.  If there is no such notification, return null. */
       TNotification *TryGetNotification(uint32_t seq_number) const;
 
+      /* See <orly/protocol.h>. */
+      std::vector<TMethodResult> TryMany(TServer *server, const std::vector<TMethodRequest> &requests);
+
       /* See <orly/protocol.h>. */
       TMethodResult TryTracked(TServer *server, const Base::TUuid &pov_id, const std::vector<std::string> &fq_name, const TClosure &closure);
 
@@ -225,6 +257,15 @@ namespace Orly {
       bool RunTestBlock(const TUUID &parent_pov_id,
           const Package::TTestBlock &test_block, bool verbose);
 
+      /* The half of Try() for functions which can't have effects.  Runs on the current runner if it's a fast one, and
+         borrows its arena and argument map from a per-runner free list rather than building them afresh. */
+      TMethodResult TryRead(TServer *server, const Base::TUuid &pov_id, const TClosure &closure, const Package::TFuncHolder &func);
+
+      /* The half of Try() for functions which might have effects.  Commits them, if there are any, in a transaction. */
+      TMethodResult TryWrite(
+          TServer *server, const Base::TUuid &pov_id, const std::vector<std::string> &fq_name, const TClosure &closure,
+          const Package::TFuncHolder &func);
+
       /* Stream out. */
       virtual void Write(Io::TBinaryOutputStream &strm) const override;
 
@@ -250,6 +291,9 @@ namespace Orly {
       mutable std::mutex NotificationMutex;
       mutable Base::TEventSemaphore NotificationSem;
 
+      /* See accessor. */
+      mutable Base::TEventCounter NewNotificationCounter;
+
       /* Povs to keep alive while we're alive. */
       std::vector<Durable::TPtr<TPov>> Povs;
       std::mutex PovMutex;
@@ -119,6 +119,47 @@ FIXTURE(Streaming) {
   ValidateSession(session);
 }
 
+FIXTURE(CumulativeAck) {
+  auto manager = make_shared<TTestManager>(1000);
+  auto session = manager->New<TSession>(TUuid::Twister, seconds(60));
+  for (size_t i = 0; i < 5; ++i) {
+    session->InsertNotification(TSystemShutdown::New(seconds(i)));
+  }
+  vector<pair<uint32_t, const TNotification *>> notifications;
+  EXPECT_EQ(session->GetNotificationsAfter(0, 2, notifications), 2UL);
+  EXPECT_EQ(session->GetNotificationsAfter(2, 10, notifications), 3UL);
+  if (EXPECT_EQ(notifications.size(), 5UL)) {
+    for (size_t i = 0; i < 5; ++i) {
+      EXPECT_EQ(notifications[i].first, i + 1);
+    }
+  }
+  /* an ack of the 3rd covers the 1st and 2nd, too */
+  session->RemoveNotificationsThrough(3);
+  EXPECT_EQ(session->GetNotificationCount(), 2UL);
+  notifications.clear();
+  EXPECT_EQ(session->GetNotificationsAfter(0, 10, notifications), 2UL);
+  EXPECT_EQ(notifications.front().first, 4U);
+  session->RemoveNotificationsThrough(5);
+  EXPECT_EQ(session->GetNotificationCount(), 0UL);
+  EXPECT_FALSE(session->GetNotificationSem().GetFd().IsReadable());
+}
+
+FIXTURE(NewNotificationCounter) {
+  auto manager = make_shared<TTestManager>(1000);
+  auto session = manager->New<TSession>(TUuid::Twister, seconds(60));
+  auto &counter = session->GetNewNotificationCounter();
+  EXPECT_FALSE(counter.GetFd().IsReadable());
+  session->InsertNotification(TSystemShutdown::New(seconds(1)));
+  session->InsertNotification(TSystemShutdown::New(seconds(2)));
+  EXPECT_TRUE(counter.GetFd().IsReadable());
+  EXPECT_EQ(counter.Pop(), 2UL);
+  /* Unlike the semaphore, it goes quiet once popped, even though the notifications are still pending. */
+  EXPECT_FALSE(counter.GetFd().IsReadable());
+  EXPECT_TRUE(session->GetNotificationSem().GetFd().IsReadable());
+  session->InsertNotification(TSystemShutdown::New(seconds(3)));
+  EXPECT_TRUE(counter.GetFd().IsReadable());
+}
+
 #if 0
 class TTestServer final
     : public TSession::TServer {
@@ -74,6 +74,15 @@ void TTetrisManager::Part(const TUuid &parent_pov_id, const TUuid &child_pov_id)
   }
 }
 
+void TTetrisManager::Wake(const TUuid &parent_pov_id) {
+  assert(this);
+  Fiber::TFiberLock::TLock lock(FiberMutex);
+  auto iter = PlayerByParentPovId.find(parent_pov_id);
+  if (iter != PlayerByParentPovId.end()) {
+    iter->second->Wake();
+  }
+}
+
 void TTetrisManager::PausePlayer(const TUuid &parent_pov_id) {
   assert(this);
   //lock_guard<mutex> lock(Mutex);
@@ -101,6 +110,7 @@ void TTetrisManager::TPlayer::Join(const Base::TUuid &child_pov_id) {
   assert(this);
   ++ChildCount;
   OnJoin(child_pov_id);
+  Wake();
 }
 
 bool TTetrisManager::TPlayer::Part(const Base::TUuid &child_pov_id) {
@@ -117,6 +127,7 @@ void TTetrisManager::TPlayer::Pause() {
   /* Create a semaphore and wait for the player thread to push it. */
   Paused = true;
   PausedSync.WaitForMore(1);
+  Wake();
   PausedSync.Sync();
   //TEventSemaphore sem;
   //Paused = &sem;
@@ -127,12 +138,13 @@ void TTetrisManager::TPlayer::Stop() {
   assert(this);
   assert(!Stopped);
   /* Make a semaphore so we can know when the player has actually stopped. */
-  CanWork.Push();
   Stopped = true;
   StoppedSync.WaitForMore(1);
-  /* NOTE: After we set ChildCount to zero, the other thread could destroy this object at any time.
-     We must therefore not dereference 'this' from here down. */
+  /* The player may see it has no children as soon as we clear ChildCount, but it won't destroy this object until we
+     push CloseSem, so we can still wake it up safely. */
   ChildCount = 0;
+  Wake();
+  CloseSem.Push();
   /* Wait for the player thread to stop. */
   /* TODO FIX: clearly StoppedSync is referencing this... */
   StoppedSync.Sync();
@@ -149,7 +161,10 @@ void TTetrisManager::TPlayer::Unpause() {
 }
 
 void TTetrisManager::TPlayer::OnClose() {
-  CanWork.Push();
+  /* Our last child has parted, so wake up and self-destruct.  Once we push CloseSem, the player may destroy this
+     object at any time, so that's the last thing we do. */
+  Wake();
+  CloseSem.Push();
 }
 
 TTetrisManager::TPlayer::~TPlayer() {
@@ -162,7 +177,7 @@ TTetrisManager::TPlayer::~TPlayer() {
 }
 
 TTetrisManager::TPlayer::TPlayer(TTetrisManager *tetris_manager)
-    : TetrisManager(tetris_manager), ChildCount(1), Stopped(nullptr), /*Paused(nullptr), */ Paused(false), /*Unpaused(nullptr)*/ Unpaused(false) {
+    : TetrisManager(tetris_manager), ChildCount(1), Stopped(nullptr), /*Paused(nullptr), */ Paused(false), /*Unpaused(nullptr)*/ Unpaused(false), CanWork(false) {
   assert(tetris_manager);
   assert(Fiber::TFrame::LocalFramePool);
   FramePool = Fiber::TFrame::LocalFramePool;
@@ -172,7 +187,7 @@ TTetrisManager::TPlayer::TPlayer(TTetrisManager *tetris_manager)
 void TTetrisManager::TPlayer::Start(bool is_paused, bool is_master) {
   assert(this);
   if (is_master) {
-    CanWork.Push();
+    CanWork = true;
   }
   if (is_paused) {
     //TEventSemaphore sem;
@@ -205,8 +220,11 @@ void TTetrisManager::TPlayer::Main() {
   assert(this);
   try {
     //DEBUG_LOG("tetris player %p: entering Main()", this);
+    bool is_closed = false;
     /* wait to see if we're allowed to play tetris. This will trigger if we're master, if we just became master, or if this player should be destroyed. */
-    CanWork.Pop();
+    while (!CanWork && ChildCount) {
+      WakeSem.Pop();
+    }
     for (;;) {
       if (Paused) {
         PausedSync.Complete();
@@ -227,15 +245,23 @@ void TTetrisManager::TPlayer::Main() {
         DEBUG_LOG("tetris player %p: unpaused", this);
       } else if (ChildCount) {
         //DEBUG_LOG("tetris player %p: playing tetris; child_count = %ld", this, ChildCount);
-        Play();
-        if (usleep(0) < 0) {
+        if (!Play()) {
+          /* None of our children had anything to promote, so sleep until one of them gets a new update, a new child
+             joins, or we're paused, stopped, or closed. */
+          WakeSem.Pop();
+        } else if (usleep(0) < 0) {
           DEBUG_LOG("tetris player %p: signal detected", this);
           break;
         }
       } else {
+        is_closed = true;
         break;
       }
     }
+    /* Whoever took away our last child may not be done with us yet.  Wait until they are. */
+    if (is_closed) {
+      CloseSem.Pop();
+    }
     //DEBUG_LOG("tetris player %p: self-destructing", this);
     delete this;
     //DEBUG_LOG("tetris player %p: exiting Main()", this);
@@ -246,7 +272,13 @@ void TTetrisManager::TPlayer::Main() {
 }
 
 void TTetrisManager::TPlayer::BecomeMaster() {
-  CanWork.Push();
+  CanWork = true;
+  Wake();
+}
+
+void TTetrisManager::TPlayer::Wake() {
+  assert(this);
+  WakeSem.Push();
 }
 
 TTetrisManager::TTetrisManager(Base::TScheduler *scheduler,
@@ -51,6 +51,10 @@ namespace Orly {
          The player may or may not have stopped by the time this function returns. */
       void Part(const Base::TUuid &parent_pov_id, const Base::TUuid &child_pov_id);
 
+      /* Advise tetris that a child pov already joined to the given parent pov has a new update.  This wakes the parent's
+         player if it's asleep for want of anything to promote.  If the parent pov has no player, this does nothing. */
+      void Wake(const Base::TUuid &parent_pov_id);
+
       /* Cause the player for the given pov to stop playing.  The player will continue to
          exist and will continue to handle children joining and parting, but it will not
          attempt to make progress.  This function will not return until the player has
@@ -94,6 +98,10 @@ namespace Orly {
         /* TODO */
         void BecomeMaster();
 
+        /* Wake the player if it's asleep, so it plays another round.  Call this when something it might promote has
+           changed.  If it isn't asleep, it will play another round before it next sleeps. */
+        void Wake();
+
         protected:
 
         /* Caches the pointer to the tetris manager and gets ready to run but doesn't launch a job.
@@ -124,16 +132,18 @@ namespace Orly {
         /* Override to play tetris.  This function will be called repeatedly as long as we have children or
            until we are told to stop, so play as efficiently as possible.  This function runs in its own thread,
            separate from the threads which call OnJoin() and OnPart(), so use proper syncrhonization around any
-           data structures shared between these functions. */
-        virtual void Play() = 0;
+           data structures shared between these functions.
+           Return true if another round might make progress.  Return false if none of our children had anything to
+           offer; we will then sleep until something calls Wake(). */
+        virtual bool Play() = 0;
 
         /* Call this in the constructor of your derived player in order to launch the job which will play tetris. */
         void Start(bool is_paused, bool is_master);
 
         private:
 
-        /* Loops, calling Play(), as long as there are child points of view joined to us.
-           When last last child goes, this function deletes this player and exits. */
+        /* Loops, calling Play(), as long as there are child points of view joined to us, and sleeping whenever Play()
+           finds nothing to do.  When last last child goes, this function deletes this player and exits. */
         void Main();
 
         /* Our manager.  Never null. */
@@ -161,8 +171,16 @@ namespace Orly {
         bool Unpaused;
         Indy::Fiber::TSafeSync UnpausedSync;
 
-        /* TODO */
-        Base::TEventSemaphore CanWork;
+        /* True once we're allowed to play tetris, which is when we're master. */
+        bool CanWork;
+
+        /* Main() pops this to sleep and Wake() pushes it.  Every change Main() waits on, including our being stopped,
+           closed, paused, or made master, ends in a push. */
+        Indy::Fiber::TSingleSem WakeSem;
+
+        /* Stop() and OnClose() push this, as the very last thing they do to us, after taking away our last child.
+           Main() pops it before it destroys us, so it never pulls us out from under them. */
+        Indy::Fiber::TSingleSem CloseSem;
 
         /* The fiber frame used to run our logic. */
         Indy::Fiber::TFrame *TetrisFrame;
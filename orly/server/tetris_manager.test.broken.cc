@@ -75,6 +75,8 @@ class TTetrisManager final
         if (ParentPov) {
           TetrisManager->Join(ParentPov->Id, Id);
         }
+      } else if (ParentPov) {
+        TetrisManager->Wake(ParentPov->Id);
       }
       Values.push(value);
     }
@@ -254,7 +256,7 @@ class TTetrisManager final
     virtual void OnUnpause() override {}
 
     /* See our base class.  We play the tetris here. */
-    virtual void Play() override {
+    virtual bool Play() override {
       assert(this);
       /* Nab a copy of our set of child points of view.
          We have to take this copy and release the lock so that our
@@ -279,6 +281,7 @@ class TTetrisManager final
       if (popped) {
         ParentPov->Push(sum);
       }
+      return popped;
     }
 
     /* Our tetris manager. */
@@ -18,6 +18,7 @@
 
 #include <orly/var/mutation.h>
 
+#include <orly/atom/mutate.h>
 #include <orly/rt/mutate.h>
 #include <orly/var/new_sabot.h>
 #include <orly/var/util.h>
@@ -27,6 +28,10 @@ using namespace std;
 using namespace Orly;
 using namespace Orly::Var;
 
+bool TChange::TryApply(Atom::TCore::TExtensibleArena *, Atom::TCore::TArena *, const Atom::TCore &, Atom::TCore &) const {
+  return false;
+}
+
 TPtr<TObjChange> TObjChange::New(string key, const TPtr<TChange> &change) {
   return TPtr<TObjChange>(new TObjChange({{key, change}}));
 }
@@ -54,6 +59,26 @@ void TObjChange::Apply(TVar &var) const {
     */
 }
 
+bool TObjChange::TryApply(
+    Atom::TCore::TExtensibleArena *arena, Atom::TCore::TArena *that_arena, const Atom::TCore &that,
+    Atom::TCore &out) const {
+  assert(this);
+  const auto &changes = GetChanges();
+  bool success = true;
+  void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+  size_t change_count = Atom::TryMutateRecord(arena, state_alloc, out, that_arena, that,
+      [arena, that_arena, &changes, &success](const string &name, const Atom::TCore &field, Atom::TCore &new_field) {
+        auto iter = changes.find(name);
+        if (iter == changes.end()) {
+          return false;
+        }
+        success = success && iter->second->TryApply(arena, that_arena, field, new_field);
+        return true;
+      });
+  /* If we didn't find every field we meant to change, Apply() will throw about it. */
+  return success && change_count == changes.size();
+}
+
 TObjChange::TObjChange(TChanges &&changes) : TPartialChange(move(changes)) {}
 
 
@@ -127,6 +152,19 @@ void TMutation::Augment(const TPtr<const TChange> &) {
   throw Rt::TSystemError(HERE, "Conflicting updates to the same key. Applied a partial mutation and a full mutation to the same part of a key.");
 }
 
+bool TMutation::TryApply(
+    Atom::TCore::TExtensibleArena *arena, Atom::TCore::TArena *that_arena, const Atom::TCore &that,
+    Atom::TCore &out) const {
+  assert(this);
+  void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+  Atom::TCore rhs(arena, Sabot::State::TAny::TWrapper(Var::NewSabot(state_alloc, Rhs)));
+  if (Mutator == TMutator::Assign) {
+    out = rhs;
+    return true;
+  }
+  return Atom::TryMutate(arena, state_alloc, out, that_arena, that, Mutator, arena, rhs);
+}
+
 bool TMutation::IsDelete() const {
   assert(this);
   return false;
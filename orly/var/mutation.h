@@ -21,6 +21,7 @@
 #include <string>
 #include <utility>
 
+#include <orly/atom/kit2.h>
 #include <orly/rt/runtime_error.h>
 #include <orly/var/impl.h>
 #include <orly/shared_enum.h>
@@ -42,6 +43,13 @@ namespace Orly {
            place, rather a new TVar will be created and they will be swapped. */
         virtual void Apply(Var::TVar &var) const = 0;
 
+        /* Apply the change directly to the given core, without going through a TVar, and set out to the result, built in
+           the given arena, then return true.  If the change isn't one we can apply this way, return false and ignore out;
+           the caller should fall back to Apply(), which will also report any error.  See <orly/atom/mutate.h>. */
+        virtual bool TryApply(
+            Atom::TCore::TExtensibleArena *arena, Atom::TCore::TArena *that_arena, const Atom::TCore &that,
+            Atom::TCore &out) const;
+
         /* Augment the change with a new partial change. This throws at a complete mutation (We can't do a partial
            mutation of a complete mutation), and throws if the partial change has already been made. */
         virtual void Augment(const TPtr<const TChange> &change) = 0;
@@ -110,6 +118,11 @@ namespace Orly {
 
         void Apply(Var::TVar &var) const;
 
+        /* Handles records, if each of our changes to their fields can be applied directly. */
+        virtual bool TryApply(
+            Atom::TCore::TExtensibleArena *arena, Atom::TCore::TArena *that_arena, const Atom::TCore &that,
+            Atom::TCore &out) const override;
+
         private:
         TObjChange(TChanges &&changes);
       }; // TObjChange
@@ -154,6 +167,9 @@ namespace Orly {
         static TPtr<TMutation> New(TMutator mutator, const Var::TVar &rhs);
 
         void Apply(Var::TVar &var) const final;
+        bool TryApply(
+            Atom::TCore::TExtensibleArena *arena, Atom::TCore::TArena *that_arena, const Atom::TCore &that,
+            Atom::TCore &out) const final;
         void Augment(const TPtr<const TChange> &change) final;
         bool IsDelete() const final;
         bool IsFinal() const;
@@ -18,8 +18,11 @@
 
 #include <orly/var/mutation.h>
 
+#include <orly/atom/suprena.h>
 #include <orly/type/type_czar.h>
 #include <orly/var.h>
+#include <orly/var/new_sabot.h>
+#include <orly/var/sabot_to_var.h>
 
 #include <test/kit.h>
 
@@ -35,4 +38,36 @@ FIXTURE(Typical) {
   EXPECT_EQ(val.As<TList>()->GetVal().at(0), TVar(32l));
   EXPECT_EQ(val.As<TList>()->GetVal().at(1), TVar(2l));
   EXPECT_EQ(val.As<TList>()->GetVal().at(2), TVar(3l));
-}
\ No newline at end of file
+}
+/* Apply the change to the var both directly, on a core, and via Var, and expect the same result. */
+static bool ApplyBothWays(const TPtr<TChange> &change, const TVar &var) {
+  Atom::TSuprena that_arena, arena;
+  void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+  Atom::TCore that(&that_arena, Sabot::State::TAny::TWrapper(NewSabot(state_alloc, var)));
+  Atom::TCore out;
+  if (!change->TryApply(&arena, &that_arena, that, out)) {
+    return false;
+  }
+  TVar expected = var;
+  change->Apply(expected);
+  return EXPECT_TRUE(ToVar(*Sabot::State::TAny::TWrapper(out.NewState(&arena, state_alloc))) == expected);
+}
+
+FIXTURE(FieldCalls) {
+  const TVar obj = TVar::Obj({{"count", TVar(1l)}, {"name", TVar(std::string("mofo"))}, {"tags", TVar(std::vector<int64_t>{1})}});
+  EXPECT_TRUE(ApplyBothWays(TObjChange::New("count", TMutation::New(TMutator::Add, TVar(5l))), obj));
+  EXPECT_TRUE(ApplyBothWays(TObjChange::New("name", TMutation::New(TMutator::Add, TVar(std::string(" rules")))), obj));
+  EXPECT_TRUE(ApplyBothWays(TObjChange::New("tags", TMutation::New(TMutator::Add, TVar(std::vector<int64_t>{2, 3}))), obj));
+  EXPECT_TRUE(ApplyBothWays(TObjChange::New("count", TMutation::New(TMutator::Assign, TVar(7l))), obj));
+  /* Two fields at once. */
+  auto change = TObjChange::New("count", TMutation::New(TMutator::Sub, TVar(1l)));
+  change->Augment(TObjChange::New("name", TMutation::New(TMutator::Assign, TVar(std::string("x")))));
+  EXPECT_TRUE(ApplyBothWays(change, obj));
+  /* These go the long way. */
+  Atom::TSuprena arena;
+  void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+  Atom::TCore that(&arena, Sabot::State::TAny::TWrapper(NewSabot(state_alloc, obj))), out;
+  EXPECT_FALSE(TObjChange::New("count", TMutation::New(TMutator::Div, TVar(2l)))->TryApply(&arena, &arena, that, out));
+  EXPECT_FALSE(TObjChange::New("nope", TMutation::New(TMutator::Add, TVar(2l)))->TryApply(&arena, &arena, that, out));
+  EXPECT_FALSE(TListChange::New(0, TMutation::New(TMutator::Add, TVar(2l)))->TryApply(&arena, &arena, that, out));
+}
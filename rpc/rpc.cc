@@ -19,6 +19,7 @@
 #include <rpc/rpc.h>
 
 #include <poll.h>
+#include <syslog.h>
 
 #include <base/debug_log.h>
 #include <base/no_default_case.h>
@@ -72,6 +73,17 @@ shared_ptr<const TAnyRequest> TContext::Read() {
   return new_request;
 }
 
+void TContext::SetMaxWriteDelay(const chrono::microseconds &max_write_delay) {
+  assert(this);
+  lock_guard<recursive_mutex> lock(WriteLock);
+  MaxWriteDelay = max_write_delay;
+  if (!MaxWriteDelay.count() && IsUnflushed) {
+    GetBinaryIoStream().Flush();
+    IsUnflushed = false;
+    ++FlushCount;
+  }
+}
+
 void TContext::FailAllFutures(const string &error_msg) {
   assert(this);
   lock_guard<mutex> lock(FutureByRequestIdMutex);
@@ -81,6 +93,55 @@ void TContext::FailAllFutures(const string &error_msg) {
   }
 }
 
+TContext::TWriter::TWriter(TContext *context)
+    : Context(context), IsFinished(false) {
+  assert(context);
+  /* Count ourselves before we wait, so whoever holds the lock now knows we're coming. */
+  ++(context->WriterCount);
+  context->WriteLock.lock();
+}
+
+TContext::TWriter::~TWriter() {
+  assert(this);
+  /* If we didn't finish, perhaps because our write threw, and we were the last writer, then no one else is coming to
+     flush the messages the writers before us left for us. */
+  if (!IsFinished && --(Context->WriterCount) == 0 && Context->IsUnflushed) {
+    try {
+      Context->GetBinaryIoStream().Flush();
+      ++(Context->FlushCount);
+    } catch (const exception &ex) {
+      syslog(LOG_INFO, "rpc; discarding unflushed messages; %s", ex.what());
+    }
+    Context->IsUnflushed = false;
+  }
+  Context->WriteLock.unlock();
+}
+
+void TContext::TWriter::Finish() {
+  assert(this);
+  assert(!IsFinished);
+  IsFinished = true;
+  bool is_last = (--(Context->WriterCount) == 0);
+  ++(Context->MessageCount);
+  bool should_flush = is_last || !Context->MaxWriteDelay.count();
+  if (!should_flush) {
+    /* Someone is waiting to write after us, and they'll flush our message along with theirs, unless our messages
+       have been waiting too long already. */
+    auto now = chrono::steady_clock::now();
+    if (Context->IsUnflushed) {
+      should_flush = (now - Context->UnflushedSince >= Context->MaxWriteDelay);
+    } else {
+      Context->IsUnflushed = true;
+      Context->UnflushedSince = now;
+    }
+  }
+  if (should_flush) {
+    Context->GetBinaryIoStream().Flush();
+    Context->IsUnflushed = false;
+    ++(Context->FlushCount);
+  }
+}
+
 shared_ptr<TAnyFuture> TContext::PopFuture(TRequestId request_id) {
   assert(this);
   lock_guard<mutex> lock(FutureByRequestIdMutex);
@@ -159,7 +220,6 @@ void TAnyRequest::WriteError(TBinaryOutputStream &strm, TRequestId request_id, c
   assert(&strm);
   assert(&ex);
   strm << ErrorResultIntroducer << request_id << ex.what();
-  strm.Flush();
 }
 
 TAnyEntry::~TAnyEntry() {}
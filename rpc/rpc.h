@@ -95,6 +95,7 @@
 
 #include <atomic>
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <mutex>
@@ -202,21 +203,66 @@ namespace Rpc {
     template <typename TRet, typename... TArgs>
     std::shared_ptr<TFuture<TRet>> Write(TEntryId entry_id, TArgs &&... args);
 
+    /* Coalesce the messages we write, or, if the delay is zero (as it is by default), stop coalescing them.
+       Normally, we flush the stream after every message we write, requests and replies alike, which costs a write(2)
+       apiece.  When we coalesce, a writer who sees others waiting to write leaves its message in the stream for the
+       last of them to flush, so a burst of messages from many fibers or threads goes out in as few writes as the
+       stream's chunks allow.  A message waits no longer than the given delay, give or take the time to write one more
+       message, even if the writers never let up. */
+    void SetMaxWriteDelay(const std::chrono::microseconds &max_write_delay);
+
     protected:
 
     /* Cache the reference to our protocol and the shared pointer to our connection.
        The connection pointer may be null. */
     TContext(const TProtocol &protocol)
-        : Protocol(protocol), NextRequestId(1), UnhandledRequestCount(0) {}
+        : Protocol(protocol), NextRequestId(1), UnhandledRequestCount(0), WriterCount(0), MaxWriteDelay(0),
+          IsUnflushed(false), FlushCount(0), MessageCount(0) {}
 
     /* TODO */
     void FailAllFutures(const std::string &error_msg);
 
+    /* The number of times we've flushed the stream, and the number of messages we've written to it. */
+    size_t GetFlushCount() const {
+      assert(this);
+      return FlushCount;
+    }
+    size_t GetMessageCount() const {
+      assert(this);
+      return MessageCount;
+    }
+
     /* See accessor. */
     std::shared_ptr<Io::TBinaryIoStream> BinaryIoStream;
 
     private:
 
+    /* Holds the write lock while a writer writes a message, and decides, when the writer is done, whether to flush. */
+    class TWriter {
+      NO_COPY(TWriter);
+      public:
+
+      /* Count ourselves among the waiting writers, then wait our turn. */
+      TWriter(TContext *context);
+
+      /* Stop waiting, if we didn't finish, and give up the lock.  If we didn't finish and we're the last writer, we
+         flush whatever the writers before us left in the stream for us. */
+      ~TWriter();
+
+      /* Call after writing a whole message.  Flushes the stream unless we're coalescing and can leave the message
+         for someone else to flush. */
+      void Finish();
+
+      private:
+
+      /* The context whose stream we're writing. */
+      TContext *Context;
+
+      /* True once we've called Finish(). */
+      bool IsFinished;
+
+    };  // TWriter
+
     /* Find the future associated with the request id, erase it from our map, and return it.
        If there is no such future, throw TUnexpectedResult. */
     std::shared_ptr<TAnyFuture> PopFuture(TRequestId request_id);
@@ -240,6 +286,20 @@ namespace Rpc {
     /* A lock to prevent multiple writers to the outstream. */
     std::recursive_mutex WriteLock;
 
+    /* The number of writers who hold or are waiting for WriteLock. */
+    std::atomic_size_t WriterCount;
+
+    /* See SetMaxWriteDelay().  Covered by WriteLock. */
+    std::chrono::microseconds MaxWriteDelay;
+
+    /* True when there's a message in the stream which we haven't flushed, and, if so, when it went in.  Covered by
+       WriteLock. */
+    bool IsUnflushed;
+    std::chrono::steady_clock::time_point UnflushedSince;
+
+    /* See accessors.  Covered by WriteLock. */
+    size_t FlushCount, MessageCount;
+
     /* For access to WriteLock. */
     friend class TAnyRequest;
 
@@ -409,9 +469,9 @@ namespace Rpc {
     }
     assert(item.second);
     /* extra */ {
-      std::lock_guard<std::recursive_mutex> lock(WriteLock);
+      TWriter writer(this);
       strm << RequestIntroducer << item.first << entry_id << std::forward_as_tuple(args...);
-      strm.Flush();
+      writer.Finish();
     }
     assert(item.second);
     return item.second;
@@ -444,7 +504,8 @@ namespace Rpc {
     TAnyRequest(TRequestId id)
         : Id(id) {}
 
-    /* Write an error reply to the given stream such that it can be parsed by TMessageHandler::ReadMessage(). */
+    /* Write an error reply to the given stream such that it can be parsed by TMessageHandler::ReadMessage().  This
+       doesn't flush the stream; the caller must hold the context's write lock and decide that. */
     static void WriteError(Io::TBinaryOutputStream &strm, TRequestId request_id, const std::exception &ex);
 
     /* Write a non-void, non-error reply to the given stream such that it can be parsed by TMessageHandler::ReadMessage(). */
@@ -459,14 +520,15 @@ namespace Rpc {
       try {
         ret = Unpack(handler, context, args);
       } catch (const std::exception &ex) {
-        std::lock_guard<std::recursive_mutex> lock(context->WriteLock);
+        TContext::TWriter writer(context);
         WriteError(strm, request_id, ex);
+        writer.Finish();
         --(context->UnhandledRequestCount);
         return;
       }
-      std::lock_guard<std::recursive_mutex> lock(context->WriteLock);
+      TContext::TWriter writer(context);
       strm << NormalResultIntroducer << request_id << ret;
-      strm.Flush();
+      writer.Finish();
       --(context->UnhandledRequestCount);
     }
 
@@ -481,14 +543,15 @@ namespace Rpc {
       try {
         Unpack(handler, context, args);
       } catch (const std::exception &ex) {
-        std::lock_guard<std::recursive_mutex> lock(context->WriteLock);
+        TContext::TWriter writer(context);
         WriteError(strm, request_id, ex);
+        writer.Finish();
         --(context->UnhandledRequestCount);
         return;
       }
-      std::lock_guard<std::recursive_mutex> lock(context->WriteLock);
+      TContext::TWriter writer(context);
       strm << NormalResultIntroducer << request_id;
-      strm.Flush();
+      writer.Finish();
       --(context->UnhandledRequestCount);
     }
 
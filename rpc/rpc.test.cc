@@ -20,6 +20,7 @@
 
 #include <functional>
 #include <thread>
+#include <vector>
 
 #include <base/uuid.h>
 #include <io/device.h>
@@ -106,6 +107,9 @@ class TMathContext
     BinaryIoStream = make_shared<TBinaryIoStream>(Device);
   }
 
+  using TContext::GetFlushCount;
+  using TContext::GetMessageCount;
+
   void Shutdown() {
     IfLt0(shutdown(Device->GetFd(), SHUT_WR));
   }
@@ -277,4 +281,47 @@ FIXTURE(LargeReturn) {
   svr->Shutdown();
   bg_cli.join();
   bg_svr.join();
-}
\ No newline at end of file
+}
+
+FIXTURE(Coalesced) {
+  static const int NumThreads = 8, NumCallsPerThread = 1000;
+  shared_ptr<TMathContext> cli, svr;
+  MakeMathContexts(cli, svr);
+  cli->SetMaxWriteDelay(chrono::microseconds(1000));
+  thread bg_svr(bind(Run, svr)), bg_cli(Run, cli);
+  /* Each caller fires off all its requests before waiting for any of the results, so the callers are always
+     contending for the stream. */
+  vector<thread> callers;
+  vector<int> wrong(NumThreads, 0);
+  for (int i = 0; i < NumThreads; ++i) {
+    callers.emplace_back([&cli, &wrong, i] {
+      vector<shared_ptr<TFuture<int>>> results;
+      for (int j = 0; j < NumCallsPerThread; ++j) {
+        results.push_back(cli->Write<int>(TMathContext::AddId, i, j));
+      }
+      for (int j = 0; j < NumCallsPerThread; ++j) {
+        if (**results[j] != i + j) {
+          ++wrong[i];
+        }
+      }
+    });
+  }
+  for (auto &caller: callers) {
+    caller.join();
+  }
+  for (int i = 0; i < NumThreads; ++i) {
+    EXPECT_EQ(wrong[i], 0);
+  }
+  /* Every request went out, and the contending writers shared flushes. */
+  EXPECT_EQ(cli->GetMessageCount(), static_cast<size_t>(NumThreads * NumCallsPerThread));
+  EXPECT_LT(cli->GetFlushCount(), cli->GetMessageCount());
+  /* Turning coalescing off goes back to a flush per message. */
+  cli->SetMaxWriteDelay(chrono::microseconds(0));
+  const size_t flush_count = cli->GetFlushCount();
+  EXPECT_EQ(**(cli->Write<int>(TMathContext::AddId, 1, 2)), 3);
+  EXPECT_EQ(cli->GetFlushCount(), flush_count + 1);
+  cli->Shutdown();
+  svr->Shutdown();
+  bg_cli.join();
+  bg_svr.join();
+}
@@ -0,0 +1,224 @@
+/* <rpc/rpc.test.manual.cc>
+
+   Small-RPC throughput over a socketpair, with and without write coalescing.
+
+   A client with many caller threads fires small requests at a server, each caller waiting for its answer before it
+   asks again.  The server reads requests on one thread and answers them on a pool of others, so both ends have many
+   writers contending for one stream, as a busy connection does.  Each fixture runs the same load with a different
+   maximum write delay and reports calls per second and messages per flush, at both ends.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <rpc/rpc.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include <io/device.h>
+#include <test/kit.h>
+
+using namespace std;
+using namespace chrono;
+using namespace Base;
+using namespace Io;
+using namespace Rpc;
+using namespace Util;
+
+static const size_t NumCallers = 32UL;
+static const size_t NumWorkers = 8UL;
+static const size_t NumCallsPerCaller = 20000UL;
+
+class TEchoContext
+    : public TContext {
+  NO_COPY(TEchoContext);
+  public:
+
+  static const Rpc::TEntryId EchoId = 1001;
+
+  TEchoContext(TFd &&fd)
+      : TContext(TProtocol::Protocol), Device(make_shared<TDevice>(move(fd))) {
+    BinaryIoStream = make_shared<TBinaryIoStream>(Device);
+  }
+
+  void Shutdown() {
+    IfLt0(shutdown(Device->GetFd(), SHUT_WR));
+  }
+
+  using TContext::GetFlushCount;
+  using TContext::GetMessageCount;
+
+  private:
+
+  int64_t Echo(int64_t val) {
+    return val;
+  }
+
+  class TProtocol
+      : public Rpc::TProtocol {
+    NO_COPY(TProtocol);
+    public:
+
+    static const TProtocol Protocol;
+
+    private:
+
+    TProtocol() {
+      Register<TEchoContext, int64_t, int64_t>(EchoId, &TEchoContext::Echo);
+    }
+
+  };  // TProtocol
+
+  shared_ptr<TDevice> Device;
+
+};  // TEchoContext
+
+const TEchoContext::TProtocol TEchoContext::TProtocol::Protocol;
+
+/* Reads requests on one thread and serves them on a pool of others. */
+class TServer {
+  NO_COPY(TServer);
+  public:
+
+  TServer(const shared_ptr<TEchoContext> &context)
+      : Context(context), IsDone(false) {
+    for (size_t i = 0; i < NumWorkers; ++i) {
+      Workers.emplace_back(&TServer::Work, this);
+    }
+    Reader = thread(&TServer::Read, this);
+  }
+
+  ~TServer() {
+    Reader.join();
+    /* extra */ {
+      lock_guard<mutex> lock(Mutex);
+      IsDone = true;
+    }
+    Cond.notify_all();
+    for (auto &worker: Workers) {
+      worker.join();
+    }
+  }
+
+  private:
+
+  void Read() {
+    try {
+      for (;;) {
+        auto request = Context->Read();
+        if (request) {
+          /* extra */ {
+            lock_guard<mutex> lock(Mutex);
+            Requests.push_back(request);
+          }
+          Cond.notify_one();
+        }
+      }
+    } catch (...) {}
+  }
+
+  void Work() {
+    for (;;) {
+      shared_ptr<const TAnyRequest> request;
+      /* extra */ {
+        unique_lock<mutex> lock(Mutex);
+        while (Requests.empty() && !IsDone) {
+          Cond.wait(lock);
+        }
+        if (Requests.empty()) {
+          break;
+        }
+        request = Requests.front();
+        Requests.pop_front();
+      }
+      (*request)();
+    }
+  }
+
+  shared_ptr<TEchoContext> Context;
+
+  mutex Mutex;
+
+  condition_variable Cond;
+
+  deque<shared_ptr<const TAnyRequest>> Requests;
+
+  bool IsDone;
+
+  thread Reader;
+
+  vector<thread> Workers;
+
+};  // TServer
+
+static void ReadReplies(shared_ptr<TContext> context) {
+  try {
+    for (;;) {
+      context->Read();
+    }
+  } catch (...) {}
+}
+
+static void Bench(const char *name, const microseconds &max_write_delay) {
+  TFd fd_a, fd_b;
+  TFd::SocketPair(fd_a, fd_b, AF_UNIX, SOCK_STREAM, 0);
+  auto cli = make_shared<TEchoContext>(move(fd_a)), svr = make_shared<TEchoContext>(move(fd_b));
+  cli->SetMaxWriteDelay(max_write_delay);
+  svr->SetMaxWriteDelay(max_write_delay);
+  double secs;
+  /* extra */ {
+    TServer server(svr);
+    thread reader(ReadReplies, cli);
+    const auto start = steady_clock::now();
+    vector<thread> callers;
+    for (size_t i = 0; i < NumCallers; ++i) {
+      callers.emplace_back([&cli, i] {
+        for (size_t j = 0; j < NumCallsPerCaller; ++j) {
+          int64_t val = i * NumCallsPerCaller + j;
+          if (**(cli->Write<int64_t>(TEchoContext::EchoId, val)) != val) {
+            throw logic_error("bad echo");
+          }
+        }
+      });
+    }
+    for (auto &caller: callers) {
+      caller.join();
+    }
+    secs = duration_cast<duration<double>>(steady_clock::now() - start).count();
+    cli->Shutdown();
+    svr->Shutdown();
+    reader.join();
+  }
+  printf(
+      "%-10s %10.0f calls/s; %6.2f requests/flush; %6.2f replies/flush\n", name, NumCallers * NumCallsPerCaller / secs,
+      static_cast<double>(cli->GetMessageCount()) / cli->GetFlushCount(),
+      static_cast<double>(svr->GetMessageCount()) / svr->GetFlushCount());
+}
+
+FIXTURE(NoCoalescing) {
+  Bench("off", microseconds(0));
+}
+
+FIXTURE(Coalesce50us) {
+  Bench("50us", microseconds(50));
+}
+
+FIXTURE(Coalesce500us) {
+  Bench("500us", microseconds(500));
+}
@@ -20,6 +20,7 @@
 
 #include <sys/types.h>
 #include <fcntl.h>
+#include <unistd.h>
 
 #include <cstring>
 
@@ -57,4 +58,27 @@ FIXTURE(Unidirectional) {
 
   // It's nice to cleanup
   Util::Delete(filename);
+}
+
+FIXTURE(Buffered) {
+  int fds[2];
+  EXPECT_EQ(pipe(fds), 0);
+  Base::TFd read_fd(fds[0]), write_fd(fds[1]);
+  /* Write two bytes */ {
+    TFdDefault fd(std::move(write_fd));
+    Bin::TOut out(&fd);
+    out.Write("ab", 2);
+  }
+  TFdDefault fd(std::move(read_fd));
+  Bin::TIn in(&fd);
+  EXPECT_FALSE(in.IsBuffered());
+  char c;
+  in >> c;
+  EXPECT_EQ(c, 'a');
+  // The second byte came in with the first read.
+  EXPECT_TRUE(in.IsBuffered());
+  in >> c;
+  EXPECT_EQ(c, 'b');
+  // Nothing left, and we must say so without reading (which would see eof here, or block on a live socket).
+  EXPECT_FALSE(in.IsBuffered());
 }
\ No newline at end of file
@@ -90,6 +90,14 @@ namespace Strm {
         return !AtEnd;
       }
 
+      /* True iff. there is data left in our current workspace, which we can
+         consume without going back to our producer.  Unlike operator bool,
+         this never waits on the producer (a socket, say) for more data. */
+      bool IsBuffered() const {
+        assert(this);
+        return Cursor < Limit;
+      }
+
       protected:
 
       /* Attach to the given producer, which must be non-null.  The producer